@@ -0,0 +1,453 @@
+// 热点路径微基准测试：格式解析、帧复制、合成帧生成、编码线程到写入线程的数据包传递
+// 输入全部在内存中合成，结果可输出为JSON，在不同提交之间比较
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/micro_bench.hpp"
+#include "encode/frame_generator.hpp"
+#include "encode/frame_store.hpp"
+#include "encode/packet_pool.hpp"
+#include "encode/sweep_scheduler.hpp"
+#include "format/aac_parser.hpp"
+#include "format/mp4_parser.hpp"
+
+namespace {
+
+struct Resolution {
+    int width;
+    int height;
+};
+
+const Resolution kResolutions[] = {
+    {640, 360}, {1280, 720}, {1920, 1080}, {3840, 2160}
+};
+
+std::string resolutionParam(const Resolution& r) {
+    return std::to_string(r.width) + "x" + std::to_string(r.height);
+}
+
+// 连续的ADTS帧：AAC LC，44.1kHz，立体声，无CRC
+std::vector<uint8_t> makeAdtsStream(int frameBytes, int frameCount) {
+    std::vector<uint8_t> data(static_cast<size_t>(frameBytes) * frameCount, 0);
+    for (int i = 0; i < frameCount; ++i) {
+        uint8_t* h = data.data() + static_cast<size_t>(i) * frameBytes;
+        h[0] = 0xFF;
+        h[1] = 0xF1;
+        h[2] = (1 << 6) | (4 << 2);
+        h[3] = static_cast<uint8_t>((2 << 6) | ((frameBytes >> 11) & 0x03));
+        h[4] = static_cast<uint8_t>((frameBytes >> 3) & 0xFF);
+        h[5] = static_cast<uint8_t>(((frameBytes & 0x07) << 5) | 0x1F);
+        h[6] = 0xFC;
+    }
+    return data;
+}
+
+// 按MP4的box嵌套结构拼装字节流，只保证box头正确，内容填零
+class BoxWriter {
+public:
+    void leaf(const char* type, size_t payload) {
+        header(type, 8 + payload);
+        out_.insert(out_.end(), payload, 0);
+    }
+
+    void begin(const char* type) {
+        open_.push_back(out_.size());
+        header(type, 0);
+    }
+
+    void end() {
+        const size_t start = open_.back();
+        open_.pop_back();
+        const uint32_t size = static_cast<uint32_t>(out_.size() - start);
+        out_[start] = static_cast<uint8_t>(size >> 24);
+        out_[start + 1] = static_cast<uint8_t>(size >> 16);
+        out_[start + 2] = static_cast<uint8_t>(size >> 8);
+        out_[start + 3] = static_cast<uint8_t>(size);
+    }
+
+    std::vector<uint8_t> take() { return std::move(out_); }
+
+private:
+    void header(const char* type, size_t size) {
+        const uint32_t s = static_cast<uint32_t>(size);
+        const uint8_t bytes[8] = {
+            static_cast<uint8_t>(s >> 24), static_cast<uint8_t>(s >> 16),
+            static_cast<uint8_t>(s >> 8), static_cast<uint8_t>(s),
+            static_cast<uint8_t>(type[0]), static_cast<uint8_t>(type[1]),
+            static_cast<uint8_t>(type[2]), static_cast<uint8_t>(type[3])
+        };
+        out_.insert(out_.end(), bytes, bytes + 8);
+    }
+
+    std::vector<uint8_t> out_;
+    std::vector<size_t> open_;
+};
+
+// ftyp + moov（tracks个轨道，每个轨道samples个采样的索引表）+ mdat
+std::vector<uint8_t> makeMp4(int tracks, int samples, size_t mdatBytes) {
+    BoxWriter w;
+    w.leaf("ftyp", 16);
+    w.begin("moov");
+    w.leaf("mvhd", 100);
+    for (int t = 0; t < tracks; ++t) {
+        w.begin("trak");
+        w.leaf("tkhd", 84);
+        w.begin("edts");
+        w.leaf("elst", 20);
+        w.end();
+        w.begin("mdia");
+        w.leaf("mdhd", 24);
+        w.leaf("hdlr", 37);
+        w.begin("minf");
+        w.leaf("vmhd", 12);
+        w.begin("dinf");
+        w.leaf("dref", 20);
+        w.end();
+        w.begin("stbl");
+        w.leaf("stsd", 92);
+        w.leaf("stts", 16);
+        w.leaf("stss", 8 + 4 * (samples / 60 + 1));
+        w.leaf("stsc", 20);
+        w.leaf("stsz", 12 + 4 * samples);
+        w.leaf("stco", 8 + 4 * (samples / 30 + 1));
+        w.end();
+        w.end();
+        w.end();
+        w.end();
+    }
+    w.end();
+    w.leaf("mdat", mdatBytes);
+    return w.take();
+}
+
+void addAacCases(MicroBench& bench) {
+    static constexpr int kFrameCount = 1024;
+    for (int frameBytes : {128, 512, 1536}) {
+        MicroBench::Case c;
+        c.name = "aac.parse_adts_header";
+        c.params = "frame_bytes=" + std::to_string(frameBytes);
+        c.bytesPerIteration = static_cast<double>(frameBytes) * kFrameCount;
+        c.itemsPerIteration = kFrameCount;
+        c.setup = [frameBytes]() -> MicroBench::Body {
+            auto data = std::make_shared<std::vector<uint8_t>>(makeAdtsStream(frameBytes, kFrameCount));
+            return [data](uint64_t iterations) {
+                const uint8_t* base = data->data();
+                const int size = static_cast<int>(data->size());
+                AACParser::FrameInfo frame{};
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    int offset = 0;
+                    while (offset < size && AACParser::parseADTSHeader(base + offset, size - offset, frame)) {
+                        offset += frame.size;
+                    }
+                    doNotOptimize(offset);
+                }
+            };
+        };
+        bench.add(std::move(c));
+    }
+}
+
+void addMp4Cases(MicroBench& bench) {
+    static constexpr int kSamples = 1800;
+    static constexpr size_t kMdatBytes = 1 << 20;
+    for (int tracks : {1, 8, 64}) {
+        const auto sample = makeMp4(tracks, kSamples, kMdatBytes);
+        const auto probe = MP4Parser::parseBuffer(sample.data(), sample.size());
+        MicroBench::Case c;
+        c.name = "mp4.parse_boxes";
+        c.params = "tracks=" + std::to_string(tracks);
+        c.itemsPerIteration = static_cast<double>(probe.size());
+        c.setup = [tracks]() -> MicroBench::Body {
+            auto data = std::make_shared<std::vector<uint8_t>>(makeMp4(tracks, kSamples, kMdatBytes));
+            return [data](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    auto boxes = MP4Parser::parseBuffer(data->data(), data->size());
+                    doNotOptimize(boxes.data());
+                }
+            };
+        };
+        bench.add(std::move(c));
+    }
+}
+
+// 缓存中的一帧，按FrameLayout对齐
+struct CachedFrame {
+    explicit CachedFrame(const FrameLayout& l)
+        : layout(l)
+        , data(static_cast<uint8_t*>(av_malloc(l.size))) {
+        FrameGenerator(FrameGenerator::Pattern::StripeWave, layout).generate(0, data);
+    }
+    ~CachedFrame() { av_free(data); }
+
+    CachedFrame(const CachedFrame&) = delete;
+    CachedFrame& operator=(const CachedFrame&) = delete;
+
+    FrameLayout layout;
+    uint8_t* data;
+};
+
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+
+void addFrameCases(MicroBench& bench) {
+    for (const auto& r : kResolutions) {
+        const double frameBytes = static_cast<double>(r.width) * r.height * 3 / 2;
+
+        // encodeFrame的复制路径：缓存帧逐平面复制到编码器分配的AVFrame
+        MicroBench::Case copy;
+        copy.name = "frame.copy_to_avframe";
+        copy.params = resolutionParam(r);
+        copy.bytesPerIteration = frameBytes;
+        copy.setup = [r]() -> MicroBench::Body {
+            auto src = std::make_shared<CachedFrame>(FrameLayout::yuv420p(r.width, r.height));
+            std::shared_ptr<AVFrame> frame(av_frame_alloc(), FrameDeleter());
+            frame->format = AV_PIX_FMT_YUV420P;
+            frame->width = r.width;
+            frame->height = r.height;
+            if (av_frame_get_buffer(frame.get(), FrameLayout::kAlign) < 0) {
+                std::cerr << "无法分配帧缓冲" << std::endl;
+                std::exit(1);
+            }
+            return [src, frame](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    src->layout.copyToAVFrame(frame.get(), src->data);
+                    doNotOptimize(frame->data[0][0]);
+                }
+            };
+        };
+        bench.add(std::move(copy));
+
+        // encodeFrame的零复制路径：把缓存帧包装成引用计数AVFrame
+        MicroBench::Case wrap;
+        wrap.name = "frame.wrap_avframe";
+        wrap.params = resolutionParam(r);
+        wrap.bytesPerIteration = frameBytes;
+        wrap.setup = [r]() -> MicroBench::Body {
+            auto src = std::make_shared<CachedFrame>(FrameLayout::yuv420p(r.width, r.height));
+            std::shared_ptr<AVFrame> frame(av_frame_alloc(), FrameDeleter());
+            return [src, frame](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    src->layout.wrapAVFrame(frame.get(), src->data);
+                    doNotOptimize(frame->data[0]);
+                    av_frame_unref(frame.get());
+                }
+            };
+        };
+        bench.add(std::move(wrap));
+    }
+}
+
+void addGeneratorCases(MicroBench& bench) {
+    static constexpr int kDistinctFrames = 240;
+    const std::pair<const char*, FrameGenerator::Pattern> patterns[] = {
+        {"generator.stripe_wave", FrameGenerator::Pattern::StripeWave},
+        {"generator.diagonal_ramp", FrameGenerator::Pattern::DiagonalRamp},
+    };
+    for (const auto& pattern : patterns) {
+        for (const auto& r : kResolutions) {
+            MicroBench::Case c;
+            c.name = pattern.first;
+            c.params = resolutionParam(r);
+            c.bytesPerIteration = static_cast<double>(r.width) * r.height * 3 / 2;
+            const FrameGenerator::Pattern p = pattern.second;
+            c.setup = [r, p]() -> MicroBench::Body {
+                auto dst = std::make_shared<CachedFrame>(FrameLayout::yuv420p(r.width, r.height));
+                auto generator = std::make_shared<FrameGenerator>(p, dst->layout);
+                auto next = std::make_shared<int>(0);
+                return [dst, generator, next](uint64_t iterations) {
+                    for (uint64_t i = 0; i < iterations; ++i) {
+                        generator->generate(*next, dst->data);
+                        *next = (*next + 1) % kDistinctFrames;
+                        doNotOptimize(dst->data[0]);
+                    }
+                };
+            };
+            bench.add(std::move(c));
+        }
+    }
+}
+
+// 编码线程（addPacketToBuffer）到写入线程（writerThreadFunc）的数据包传递
+// 写入线程只读取首字节后归还，测量的是通道和缓冲池本身的开销
+class PacketHandoff {
+public:
+    PacketHandoff(int packetBytes, int consumerCpu)
+        : packetBytes_(packetBytes)
+        , channel_(kCapacity)
+        , packet_(av_packet_alloc()) {
+        consumer_ = std::thread([this, consumerCpu]() {
+            if (consumerCpu >= 0) {
+                MicroBench::pinCurrentThread(consumerCpu);
+            }
+            uint64_t sink = 0;
+            while (AVPacket* packet = channel_.receive()) {
+                sink += packet->data[0];
+                channel_.recycle(packet);
+                received_.fetch_add(1, std::memory_order_release);
+            }
+            doNotOptimize(sink);
+        });
+    }
+
+    ~PacketHandoff() {
+        channel_.close();
+        consumer_.join();
+        av_packet_free(&packet_);
+    }
+
+    void run(uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            packet_->buf = PacketPool::instance().acquire(packetBytes_ + AV_INPUT_BUFFER_PADDING_SIZE);
+            packet_->data = packet_->buf->data;
+            packet_->size = packetBytes_;
+            packet_->data[0] = static_cast<uint8_t>(sent_);
+            packet_->pts = static_cast<int64_t>(sent_);
+            packet_->dts = packet_->pts;
+            channel_.send(packet_);
+            ++sent_;
+        }
+        // 计时包含写入线程取空通道的时间
+        while (received_.load(std::memory_order_acquire) < sent_) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static constexpr size_t kCapacity = 512;  // 与编码测试的MAX_PACKETS一致
+
+    int packetBytes_;
+    PacketChannel channel_;
+    AVPacket* packet_;
+    uint64_t sent_{0};
+    std::atomic<uint64_t> received_{0};
+    std::thread consumer_;
+};
+
+void addHandoffCases(MicroBench& bench, int consumerCpu) {
+    // 典型的B帧、P帧和1080p关键帧大小
+    for (int packetBytes : {512, 16 * 1024, 256 * 1024}) {
+        MicroBench::Case c;
+        c.name = "writer.packet_handoff";
+        c.params = "packet_bytes=" + std::to_string(packetBytes);
+        c.setup = [packetBytes, consumerCpu]() -> MicroBench::Body {
+            auto handoff = std::make_shared<PacketHandoff>(packetBytes, consumerCpu);
+            return [handoff](uint64_t iterations) { handoff->run(iterations); };
+        };
+        bench.add(std::move(c));
+    }
+}
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项]\n"
+              << "  -o, --output <文件>       JSON结果文件\n"
+              << "  -f, --filter <子串>       只运行名称或参数包含该子串的用例\n"
+              << "  -r, --repetitions <N>     计入统计的重复次数，默认15\n"
+              << "  -w, --warmup <N>          校准后的预热次数，默认2\n"
+              << "  -t, --min-time <毫秒>     每次重复的最短时间，默认50\n"
+              << "  -c, --cpu <N>             绑定的CPU，-1表示不绑定，默认为第一个可用CPU\n"
+              << "  -l, --list                列出所有用例\n"
+              << "  -h, --help                显示帮助\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    MicroBench::Options options;
+    std::string output;
+    bool list = false;
+
+    const std::vector<int> cpus = SweepScheduler::availableCpus();
+    options.cpu = cpus.front();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) {
+            output = value();
+        } else if (!std::strcmp(arg, "-f") || !std::strcmp(arg, "--filter")) {
+            options.filter = value();
+        } else if (!std::strcmp(arg, "-r") || !std::strcmp(arg, "--repetitions")) {
+            options.repetitions = std::max(1, std::atoi(value()));
+        } else if (!std::strcmp(arg, "-w") || !std::strcmp(arg, "--warmup")) {
+            options.warmupRepetitions = std::max(0, std::atoi(value()));
+        } else if (!std::strcmp(arg, "-t") || !std::strcmp(arg, "--min-time")) {
+            options.minTime = std::max(1.0, std::atof(value())) / 1000.0;
+        } else if (!std::strcmp(arg, "-c") || !std::strcmp(arg, "--cpu")) {
+            options.cpu = std::atoi(value());
+        } else if (!std::strcmp(arg, "-l") || !std::strcmp(arg, "--list")) {
+            list = true;
+        } else {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    // 写入线程绑定到另一个CPU，模拟编码线程和写入线程并行的情况
+    int consumerCpu = -1;
+    if (options.cpu >= 0) {
+        for (int cpu : cpus) {
+            if (cpu != options.cpu) {
+                consumerCpu = cpu;
+                break;
+            }
+        }
+    }
+
+    MicroBench bench;
+    addAacCases(bench);
+    addMp4Cases(bench);
+    addFrameCases(bench);
+    addGeneratorCases(bench);
+    addHandoffCases(bench, consumerCpu);
+
+    if (list) {
+        for (const auto& c : bench.cases()) {
+            std::cout << c.name << " [" << c.params << "]" << std::endl;
+        }
+        return 0;
+    }
+
+    const auto results = bench.run(options);
+    if (results.empty()) {
+        std::cerr << "没有匹配的用例" << std::endl;
+        return 1;
+    }
+
+    if (!output.empty()) {
+        std::ofstream file(output, std::ios::binary);
+        if (!file) {
+            std::cerr << "无法创建结果文件: " << output << std::endl;
+            return 1;
+        }
+        MicroBench::writeJson(file, options, results);
+        std::cout << "结果已写入: " << output << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "micro_bench.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double timeBody(const MicroBench::Body& body, uint64_t iterations) {
+    const auto start = Clock::now();
+    body(iterations);
+    clobberMemory();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double medianOf(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    return buf;
+}
+
+// 按量级选择时间单位
+std::string formatNs(double ns) {
+    char buf[32];
+    if (ns >= 1e6) {
+        std::snprintf(buf, sizeof(buf), "%.3f ms", ns / 1e6);
+    } else if (ns >= 1e3) {
+        std::snprintf(buf, sizeof(buf), "%.3f us", ns / 1e3);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.1f ns", ns);
+    }
+    return buf;
+}
+
+}  // namespace
+
+bool MicroBench::pinCurrentThread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+MicroBench::Result MicroBench::measure(const Case& benchCase, const Options& options) {
+    static constexpr uint64_t kMaxIterations = uint64_t(1) << 32;
+
+    Result result;
+    result.name = benchCase.name;
+    result.params = benchCase.params;
+    result.bytesPerIteration = benchCase.bytesPerIteration;
+    result.itemsPerIteration = benchCase.itemsPerIteration;
+
+    const Body body = benchCase.setup();
+
+    // 校准：迭代次数翻倍直到单次重复达到minTime，校准过程同时起到预热作用
+    uint64_t iterations = 1;
+    for (;;) {
+        const double elapsed = timeBody(body, iterations);
+        if (elapsed >= options.minTime || iterations >= kMaxIterations) {
+            break;
+        }
+        // 按已测时间外推，最多放大10倍，避免首次运行受冷缓存影响时估计过大
+        const double scale = elapsed > 0 ? options.minTime * 1.2 / elapsed : 10.0;
+        iterations = std::min(kMaxIterations,
+            std::max(iterations * 2, static_cast<uint64_t>(iterations * std::min(scale, 10.0))));
+    }
+
+    for (int i = 0; i < options.warmupRepetitions; ++i) {
+        timeBody(body, iterations);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.repetitions);
+    for (int i = 0; i < options.repetitions; ++i) {
+        samples.push_back(timeBody(body, iterations) * 1e9 / iterations);
+    }
+
+    result.iterations = iterations;
+    result.repetitions = static_cast<int>(samples.size());
+    if (samples.empty()) {
+        return result;
+    }
+
+    result.min = *std::min_element(samples.begin(), samples.end());
+    result.max = *std::max_element(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.mean = sum / samples.size();
+    result.median = medianOf(samples);
+
+    std::vector<double> deviations;
+    deviations.reserve(samples.size());
+    for (double sample : samples) {
+        deviations.push_back(std::fabs(sample - result.median));
+    }
+    result.mad = medianOf(std::move(deviations));
+    return result;
+}
+
+std::vector<MicroBench::Result> MicroBench::run(const Options& options) const {
+    if (options.cpu >= 0 && !pinCurrentThread(options.cpu)) {
+        std::cerr << "无法绑定到CPU " << options.cpu << "，结果可能不稳定" << std::endl;
+    }
+
+    std::vector<Result> results;
+    for (const auto& benchCase : cases_) {
+        if (!options.filter.empty() &&
+            (benchCase.name + "/" + benchCase.params).find(options.filter) == std::string::npos) {
+            continue;
+        }
+
+        Result result = measure(benchCase, options);
+
+        std::cout << benchCase.name << " [" << benchCase.params << "] "
+                  << formatNs(result.median) << " ±" << formatNs(result.mad)
+                  << " (min " << formatNs(result.min) << ", " << result.iterations << " 次迭代 x "
+                  << result.repetitions << ")";
+        if (result.bytesPerIteration > 0) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.1f MB/s", result.bytesPerSecond() / 1e6);
+            std::cout << ", " << buf;
+        }
+        std::cout << std::endl;
+
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+void MicroBench::writeJson(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+    out << "{\n"
+        << "  \"options\": {\"cpu\": " << options.cpu
+        << ", \"warmup_repetitions\": " << options.warmupRepetitions
+        << ", \"repetitions\": " << options.repetitions
+        << ", \"min_time\": " << jsonNumber(options.minTime) << "},\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"name\": " << jsonString(r.name)
+            << ", \"params\": " << jsonString(r.params)
+            << ", \"median_ns\": " << jsonNumber(r.median)
+            << ", \"min_ns\": " << jsonNumber(r.min)
+            << ", \"mean_ns\": " << jsonNumber(r.mean)
+            << ", \"max_ns\": " << jsonNumber(r.max)
+            << ", \"mad_ns\": " << jsonNumber(r.mad)
+            << ", \"iterations\": " << r.iterations
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"bytes_per_second\": " << jsonNumber(r.bytesPerSecond())
+            << ", \"items_per_second\": " << jsonNumber(r.itemsPerSecond())
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 微基准测试框架：预热、自动校准迭代次数、多次重复取稳健统计量，可绑定CPU
+// 每个用例的输入在setup中一次性准备，计时只覆盖循环体
+class MicroBench {
+public:
+    // 运行iterations次被测代码
+    using Body = std::function<void(uint64_t iterations)>;
+    // 准备输入并返回循环体；循环体持有的状态在用例结束后释放
+    using Setup = std::function<Body()>;
+
+    struct Case {
+        std::string name;      // 被测路径，如 "aac.parse_adts_header"
+        std::string params;    // 输入规模，如 "frame_bytes=512"
+        double bytesPerIteration{0};  // 每次迭代处理的字节数，0表示不计算带宽
+        double itemsPerIteration{1};  // 每次迭代处理的条目数（帧、数据包、box）
+        Setup setup;
+    };
+
+    struct Options {
+        int warmupRepetitions = 2;     // 校准后额外的预热次数
+        int repetitions = 15;          // 计入统计的重复次数
+        double minTime = 0.05;         // 每次重复的最短时间（秒），用于校准迭代次数
+        int cpu = -1;                  // 绑定的CPU，-1表示不绑定
+        std::string filter;            // 只运行名称或参数包含该子串的用例
+    };
+
+    // 单个用例的统计结果，时间单位为纳秒/迭代
+    struct Result {
+        std::string name;
+        std::string params;
+        uint64_t iterations{0};  // 每次重复的迭代次数
+        int repetitions{0};
+        double min{0};
+        double median{0};
+        double mean{0};
+        double max{0};
+        double mad{0};           // 中位数绝对偏差
+        double bytesPerIteration{0};
+        double itemsPerIteration{1};
+
+        double bytesPerSecond() const { return median > 0 ? bytesPerIteration * 1e9 / median : 0; }
+        double itemsPerSecond() const { return median > 0 ? itemsPerIteration * 1e9 / median : 0; }
+    };
+
+    void add(Case benchCase) { cases_.push_back(std::move(benchCase)); }
+    const std::vector<Case>& cases() const { return cases_; }
+
+    // 依次运行匹配的用例，每个用例完成后打印一行摘要
+    std::vector<Result> run(const Options& options) const;
+
+    // 每个结果一行，字段顺序固定，便于不同提交之间直接diff
+    static void writeJson(std::ostream& out, const Options& options, const std::vector<Result>& results);
+
+    // 把当前线程绑定到指定CPU
+    static bool pinCurrentThread(int cpu);
+
+private:
+    static Result measure(const Case& benchCase, const Options& options);
+
+    std::vector<Case> cases_;
+};
+
+// 阻止编译器把基准测试中的计算结果当作无用代码删除
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
@@ -0,0 +1,176 @@
+#include "chunked_command.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encode/x264_param_test.hpp"
+#include "result_writer.hpp"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " chunked [选项]\n"
+              << "  -s, --source <路径>      输入源（图片序列目录、视频文件或.y4m/.yuv），默认使用合成帧\n"
+              << "  -d, --size <宽x高>       编码分辨率，默认1920x1080\n"
+              << "  -f, --frames <N>         编码帧数，默认300\n"
+              << "      --scene <名称>       场景配置：archive/vod/live，默认archive\n"
+              << "  -c, --crf <N>            覆盖场景配置的CRF\n"
+              << "  -k, --keyint <N>         覆盖场景配置的最大关键帧间隔（分段对齐的GOP长度）\n"
+              << "  -g, --gops <N>           每段包含的GOP数，默认1\n"
+              << "  -t, --threads <N>        每段编码器的线程数，默认1\n"
+              << "      --no-compare         不运行单实例编码对照\n"
+              << "      --fragmented         输出分片MP4（每个GOP一个分片），中断时已写完的部分仍可播放\n"
+              << "  -o, --output <文件>      结果文件（.csv输出CSV，否则输出JSON），默认chunked_results.json\n"
+              << "  -j, --core-budget <N>    并发编码使用的核心数，0表示全部可用CPU\n"
+              << "  -h, --help               显示帮助\n";
+}
+
+bool parseSize(const char* text, int& width, int& height) {
+    return std::sscanf(text, "%dx%d", &width, &height) == 2 && width > 0 && height > 0 &&
+           width % 2 == 0 && height % 2 == 0;
+}
+
+SweepRunner::Row makeRow(const char* mode, const X264ParamTest::TestConfig& config,
+                         const X264ParamTest::TestResult& result, const X264ParamTest::ChunkedResult& chunked,
+                         bool single) {
+    SweepRunner::Row row;
+    row.point.run = mode;
+    row.point.codec = "x264";
+    row.point.params = {
+        {"width", std::to_string(config.width)},
+        {"height", std::to_string(config.height)},
+        {"frames", std::to_string(config.frameCount)},
+        {"keyint", std::to_string(config.keyintMax)},
+        {"chunk_frames", std::to_string(single ? config.frameCount : chunked.chunkFrames)},
+    };
+    row.success = result.success;
+    row.error = result.errorMessage;
+    row.outputFile = result.outputFile;
+    row.metrics.emplace_back("chunks", single ? 1.0 : static_cast<double>(chunked.chunks));
+    row.metrics.emplace_back("encoding_time", result.encodingTime);
+    row.metrics.emplace_back("fps", result.fps);
+    row.metrics.emplace_back("bitrate", result.bitrate);
+    row.metrics.emplace_back("psnr", result.psnr);
+    row.metrics.emplace_back("ssim", result.ssim);
+    if (!single) {
+        row.metrics.emplace_back("speedup", chunked.speedup);
+        row.metrics.emplace_back("bitrate_cost", chunked.bitrateCost);
+        row.metrics.emplace_back("psnr_cost", chunked.psnrCost);
+        row.metrics.emplace_back("ssim_cost", chunked.ssimCost);
+    }
+    return row;
+}
+
+}  // namespace
+
+int runChunkedCommand(int argc, char* argv[]) {
+    X264ParamTest::TestConfig config = X264ParamTest::getArchiveConfig().config;
+    X264ParamTest::ChunkOptions options;
+    std::string output = "chunked_results.json";
+    std::string source;
+    int width = config.width;
+    int height = config.height;
+    int frames = config.frameCount;
+    int crf = -1;
+    int keyint = -1;
+    int threads = 1;
+    bool fragmented = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!std::strcmp(arg, "-s") || !std::strcmp(arg, "--source")) {
+            source = value();
+        } else if (!std::strcmp(arg, "-d") || !std::strcmp(arg, "--size")) {
+            if (!parseSize(value(), width, height)) {
+                std::cerr << "无效的分辨率: " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if (!std::strcmp(arg, "-f") || !std::strcmp(arg, "--frames")) {
+            frames = std::atoi(value());
+        } else if (!std::strcmp(arg, "--scene")) {
+            const std::string scene = value();
+            if (scene == "archive") {
+                config = X264ParamTest::getArchiveConfig().config;
+            } else if (scene == "vod") {
+                config = X264ParamTest::getVODConfig().config;
+            } else if (scene == "live") {
+                config = X264ParamTest::getLiveStreamConfig().config;
+            } else {
+                std::cerr << "未知的场景: " << scene << std::endl;
+                return 2;
+            }
+        } else if (!std::strcmp(arg, "-c") || !std::strcmp(arg, "--crf")) {
+            crf = std::atoi(value());
+        } else if (!std::strcmp(arg, "-k") || !std::strcmp(arg, "--keyint")) {
+            keyint = std::atoi(value());
+        } else if (!std::strcmp(arg, "-g") || !std::strcmp(arg, "--gops")) {
+            options.gopsPerChunk = std::atoi(value());
+        } else if (!std::strcmp(arg, "-t") || !std::strcmp(arg, "--threads")) {
+            threads = std::atoi(value());
+        } else if (!std::strcmp(arg, "--no-compare")) {
+            options.compareSingle = false;
+        } else if (!std::strcmp(arg, "--fragmented")) {
+            fragmented = true;
+        } else if (!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) {
+            output = value();
+        } else if (!std::strcmp(arg, "-j") || !std::strcmp(arg, "--core-budget")) {
+            options.coreBudget = std::atoi(value());
+        } else {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    // 场景配置可能出现在其他选项之后，最后再应用覆盖项
+    config.sourcePath = source;
+    config.width = width;
+    config.height = height;
+    config.frameCount = frames;
+    config.threads = threads;
+    if (crf >= 0) {
+        config.rateControl = X264ParamTest::RateControl::CRF;
+        config.crf = crf;
+    }
+    if (keyint > 0) {
+        config.keyintMax = keyint;
+    }
+    if (fragmented) {
+        config.mp4Mode = OutputSink::Mp4Mode::Fragmented;
+    }
+    if (config.frameCount <= 0 || options.gopsPerChunk <= 0 || config.threads <= 0) {
+        std::cerr << "帧数、每段GOP数和线程数必须为正数" << std::endl;
+        return 2;
+    }
+
+    const X264ParamTest::ChunkedResult result = X264ParamTest::runChunkedTest(config, options);
+    if (!result.chunked.success) {
+        return 1;
+    }
+
+    std::vector<SweepRunner::Row> rows;
+    rows.push_back(makeRow("chunked", config, result.chunked, result, false));
+    if (options.compareSingle) {
+        rows.push_back(makeRow("single", config, result.single, result, true));
+    }
+    if (!ResultWriter::write(output, rows)) {
+        return 1;
+    }
+    std::cout << "结果已写入: " << output << std::endl;
+    return 0;
+}
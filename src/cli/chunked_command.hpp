@@ -0,0 +1,4 @@
+#pragma once
+
+// chunked子命令：按GOP分段并行编码一个输入源，拼接为一个MP4，并与单实例编码比较吞吐和码率/画质代价
+int runChunkedCommand(int argc, char* argv[]);
@@ -0,0 +1,155 @@
+#include "ladder_command.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encode/per_title_ladder.hpp"
+#include "encode/result_cache.hpp"
+#include "result_writer.hpp"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " ladder [选项]\n"
+              << "  -s, --source <路径>      输入源（图片序列目录、视频文件或.y4m/.yuv），默认使用合成帧\n"
+              << "  -d, --display <宽x高>    显示分辨率，默认1920x1080\n"
+              << "  -f, --frames <N>         每个点编码的帧数，默认300\n"
+              << "  -r, --rungs <N>          阶梯档数，默认5\n"
+              << "  -m, --margin <dB>        区间两端距凸包都超过此值时不再细化，默认0.5\n"
+              << "      --ssim               按SSIM选点，默认按PSNR\n"
+              << "  -o, --output <文件>      结果文件（.csv输出CSV，否则输出JSON），默认ladder_results.json\n"
+              << "  -j, --core-budget <N>    并发编码使用的核心数，0表示全部可用CPU\n"
+              << "      --cache-dir <目录>   结果缓存目录，默认" << ResultCache::defaultDirectory() << "\n"
+              << "      --no-cache           不读写结果缓存，全部重新编码\n"
+              << "  -h, --help               显示帮助\n";
+}
+
+bool parseResolution(const char* text, PerTitleLadder::Resolution& resolution) {
+    int width = 0;
+    int height = 0;
+    if (std::sscanf(text, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0 ||
+        width % 2 != 0 || height % 2 != 0) {
+        return false;
+    }
+    resolution.width = width;
+    resolution.height = height;
+    return true;
+}
+
+SweepRunner::Row makeRow(const PerTitleLadder::Point& point, const PerTitleLadder::Options& options) {
+    SweepRunner::Row row;
+    row.point.run = "ladder";
+    row.point.codec = "x264";
+    row.point.params = {
+        {"width", std::to_string(point.resolution.width)},
+        {"height", std::to_string(point.resolution.height)},
+        {"crf", std::to_string(point.crf)},
+        {"display_width", std::to_string(options.base.width)},
+        {"display_height", std::to_string(options.base.height)},
+    };
+    row.success = point.result.success;
+    row.error = point.result.errorMessage;
+    row.outputFile = point.result.outputFile;
+    row.metrics.emplace_back("encoding_time", point.result.encodingTime);
+    row.metrics.emplace_back("fps", point.result.fps);
+    row.metrics.emplace_back("bitrate", point.result.bitrate);
+    row.metrics.emplace_back("psnr", point.result.psnr);
+    row.metrics.emplace_back("ssim", point.result.ssim);
+    row.metrics.emplace_back("on_hull", point.onHull ? 1.0 : 0.0);
+    row.metrics.emplace_back("rung", point.rung);
+    return row;
+}
+
+}  // namespace
+
+int runLadderCommand(int argc, char* argv[]) {
+    PerTitleLadder::Options options;
+    std::string output = "ladder_results.json";
+    bool useCache = true;
+    std::string cacheDir = ResultCache::defaultDirectory();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!std::strcmp(arg, "-s") || !std::strcmp(arg, "--source")) {
+            options.base.sourcePath = value();
+        } else if (!std::strcmp(arg, "-d") || !std::strcmp(arg, "--display")) {
+            PerTitleLadder::Resolution display;
+            if (!parseResolution(value(), display)) {
+                std::cerr << "无效的显示分辨率: " << argv[i] << std::endl;
+                return 2;
+            }
+            options.base.width = display.width;
+            options.base.height = display.height;
+        } else if (!std::strcmp(arg, "-f") || !std::strcmp(arg, "--frames")) {
+            options.base.frameCount = std::atoi(value());
+        } else if (!std::strcmp(arg, "-r") || !std::strcmp(arg, "--rungs")) {
+            options.rungs = std::atoi(value());
+        } else if (!std::strcmp(arg, "-m") || !std::strcmp(arg, "--margin")) {
+            options.pruneMargin = std::atof(value());
+        } else if (!std::strcmp(arg, "--ssim")) {
+            options.useSsim = true;
+        } else if (!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) {
+            output = value();
+        } else if (!std::strcmp(arg, "-j") || !std::strcmp(arg, "--core-budget")) {
+            options.coreBudget = std::atoi(value());
+        } else if (!std::strcmp(arg, "--cache-dir")) {
+            cacheDir = value();
+        } else if (!std::strcmp(arg, "--no-cache")) {
+            useCache = false;
+        } else {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.base.frameCount <= 0 || options.rungs <= 0) {
+        std::cerr << "帧数和阶梯档数必须为正数" << std::endl;
+        return 2;
+    }
+
+    const ResultCache cache(cacheDir);
+    if (useCache) {
+        options.cache = &cache;
+    }
+    const PerTitleLadder::Result result = PerTitleLadder::run(options);
+    if (result.points.empty()) {
+        return 1;
+    }
+
+    std::vector<SweepRunner::Row> rows;
+    rows.reserve(result.points.size());
+    for (const auto& point : result.points) {
+        rows.push_back(makeRow(point, options));
+    }
+    if (!ResultWriter::write(output, rows)) {
+        return 1;
+    }
+
+    std::cout << "码率阶梯:" << std::endl;
+    for (size_t index : result.ladder) {
+        const auto& point = result.points[index];
+        std::cout << "  " << point.resolution.width << "x" << point.resolution.height
+                  << " CRF " << point.crf
+                  << "  码率 " << point.result.bitrate / 1000.0 << " kbps"
+                  << "  PSNR " << point.result.psnr << " dB"
+                  << "  SSIM " << point.result.ssim << std::endl;
+    }
+    std::cout << "结果已写入: " << output << std::endl;
+    return result.ladder.empty() ? 3 : 0;
+}
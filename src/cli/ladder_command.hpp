@@ -0,0 +1,4 @@
+#pragma once
+
+// ladder子命令：对一个输入源搜索分辨率×CRF的码率-质量凸包，输出全部编码点和选出的码率阶梯
+int runLadderCommand(int argc, char* argv[]);
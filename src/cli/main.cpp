@@ -0,0 +1,156 @@
+// 无界面的参数扫描工具：读取JSON/INI扫描描述，运行编码测试，输出JSON/CSV结果
+// 不依赖Qt，可在无显示环境的测试服务器上运行
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "encode/history_store.hpp"
+#include "encode/result_cache.hpp"
+#include "chunked_command.hpp"
+#include "ladder_command.hpp"
+#include "result_writer.hpp"
+#include "search_command.hpp"
+#include "sweep_runner.hpp"
+#include "sweep_spec.hpp"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " <扫描描述.json|.ini> [选项]\n"
+              << "      " << program << " ladder [选项]   按内容搜索码率阶梯，详见 ladder --help\n"
+              << "      " << program << " search [选项]   逐次减半搜索最优参数，详见 search --help\n"
+              << "      " << program << " chunked [选项]  按GOP分段并行编码并与单实例编码比较，详见 chunked --help\n"
+              << "  -o, --output <文件>      结果文件（.csv输出CSV，否则输出JSON），覆盖描述中的output，默认sweep_results.json\n"
+              << "  -j, --core-budget <N>    并发扫描使用的核心数，0表示全部可用CPU\n"
+              << "  -n, --dry-run            只展开并校验测试点，不运行编码\n"
+              << "      --cache-dir <目录>   结果缓存目录，默认" << ResultCache::defaultDirectory() << "\n"
+              << "      --no-cache           不读写结果缓存，全部重新编码\n"
+              << "      --history <文件>     编码历史文件，默认" << HistoryStore::defaultPath() << "\n"
+              << "      --no-history         不把结果写入编码历史\n"
+              << "  -h, --help               显示帮助\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && !std::strcmp(argv[1], "ladder")) {
+        return runLadderCommand(argc - 1, argv + 1);
+    }
+    if (argc > 1 && !std::strcmp(argv[1], "search")) {
+        return runSearchCommand(argc - 1, argv + 1);
+    }
+    if (argc > 1 && !std::strcmp(argv[1], "chunked")) {
+        return runChunkedCommand(argc - 1, argv + 1);
+    }
+
+    std::string specPath;
+    std::string output;
+    int coreBudget = -1;
+    bool dryRun = false;
+    bool useCache = true;
+    std::string cacheDir = ResultCache::defaultDirectory();
+    bool useHistory = true;
+    std::string historyPath = HistoryStore::defaultPath();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) {
+            output = value();
+        } else if (!std::strcmp(arg, "-j") || !std::strcmp(arg, "--core-budget")) {
+            coreBudget = std::atoi(value());
+        } else if (!std::strcmp(arg, "-n") || !std::strcmp(arg, "--dry-run")) {
+            dryRun = true;
+        } else if (!std::strcmp(arg, "--cache-dir")) {
+            cacheDir = value();
+        } else if (!std::strcmp(arg, "--no-cache")) {
+            useCache = false;
+        } else if (!std::strcmp(arg, "--history")) {
+            historyPath = value();
+        } else if (!std::strcmp(arg, "--no-history")) {
+            useHistory = false;
+        } else if (arg[0] == '-') {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        } else if (specPath.empty()) {
+            specPath = arg;
+        } else {
+            std::cerr << "只能指定一个扫描描述文件" << std::endl;
+            return 2;
+        }
+    }
+
+    if (specPath.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    SweepSpec spec;
+    if (!SweepSpec::load(specPath, spec)) {
+        return 1;
+    }
+    if (!output.empty()) {
+        spec.output = output;
+    }
+    if (coreBudget >= 0) {
+        spec.coreBudget = coreBudget;
+    }
+
+    const auto points = spec.expand();
+    std::cout << "扫描描述: " << specPath << ", " << points.size() << " 个测试点" << std::endl;
+    if (!SweepRunner::validate(points)) {
+        return 1;
+    }
+
+    if (dryRun) {
+        for (const auto& point : points) {
+            std::cout << point.run << " [" << point.codec << "]";
+            for (const auto& param : point.params) {
+                std::cout << ' ' << param.first << '=' << param.second;
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+
+    // 配置、输入和编码器版本都相同的测试点直接使用缓存的结果
+    const ResultCache cache(cacheDir);
+    HistoryStore history(historyPath);
+    const auto rows = SweepRunner::run(points, spec.coreBudget, useCache ? &cache : nullptr,
+                                       useHistory ? &history : nullptr);
+
+    int failed = 0;
+    for (const auto& row : rows) {
+        if (!row.success) {
+            ++failed;
+        }
+    }
+
+    // 编码过程的日志输出到stdout，结果总是写入文件
+    if (spec.output.empty()) {
+        spec.output = "sweep_results.json";
+    }
+    if (!ResultWriter::write(spec.output, rows)) {
+        return 1;
+    }
+    std::cout << "结果已写入: " << spec.output << std::endl;
+
+    if (failed > 0) {
+        std::cerr << failed << " 个测试点失败" << std::endl;
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "result_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out + "\"";
+}
+
+// JSON不支持inf/nan，写为null
+std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    return buf;
+}
+
+std::string csvField(const std::string& s) {
+    if (s.find_first_of(",\"\n\r") == std::string::npos) {
+        return s;
+    }
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// 按首次出现的顺序收集所有键
+template <typename Get>
+std::vector<std::string> collectKeys(const std::vector<SweepRunner::Row>& rows, Get get) {
+    std::vector<std::string> keys;
+    for (const auto& row : rows) {
+        for (const auto& item : get(row)) {
+            if (std::find(keys.begin(), keys.end(), item.first) == keys.end()) {
+                keys.push_back(item.first);
+            }
+        }
+    }
+    return keys;
+}
+
+}  // namespace
+
+bool ResultWriter::write(const std::string& path, const std::vector<SweepRunner::Row>& rows) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法创建结果文件: " << path << std::endl;
+        return false;
+    }
+
+    const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        writeCsv(file, rows);
+    } else {
+        writeJson(file, rows);
+    }
+    return static_cast<bool>(file);
+}
+
+void ResultWriter::writeJson(std::ostream& out, const std::vector<SweepRunner::Row>& rows) {
+    out << "[\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const auto& row = rows[i];
+        out << "  {\"run\": " << jsonString(row.point.run)
+            << ", \"codec\": " << jsonString(row.point.codec)
+            << ", \"params\": {";
+        for (size_t p = 0; p < row.point.params.size(); ++p) {
+            out << (p ? ", " : "") << jsonString(row.point.params[p].first)
+                << ": " << jsonString(row.point.params[p].second);
+        }
+        out << "}, \"success\": " << (row.success ? "true" : "false")
+            << ", \"error\": " << jsonString(row.error)
+            << ", \"output_file\": " << jsonString(row.outputFile)
+            << ", \"metrics\": {";
+        for (size_t m = 0; m < row.metrics.size(); ++m) {
+            out << (m ? ", " : "") << jsonString(row.metrics[m].first)
+                << ": " << jsonNumber(row.metrics[m].second);
+        }
+        out << "}}" << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+void ResultWriter::writeCsv(std::ostream& out, const std::vector<SweepRunner::Row>& rows) {
+    const auto paramKeys = collectKeys(rows, [](const SweepRunner::Row& row) -> const auto& {
+        return row.point.params;
+    });
+    const auto metricKeys = collectKeys(rows, [](const SweepRunner::Row& row) -> const auto& {
+        return row.metrics;
+    });
+
+    out << "run,codec";
+    for (const auto& key : paramKeys) {
+        out << ',' << csvField(key);
+    }
+    out << ",success,error,output_file";
+    for (const auto& key : metricKeys) {
+        out << ',' << csvField(key);
+    }
+    out << '\n';
+
+    for (const auto& row : rows) {
+        out << csvField(row.point.run) << ',' << csvField(row.point.codec);
+        for (const auto& key : paramKeys) {
+            const std::string* value = row.point.find(key);
+            out << ',' << (value ? csvField(*value) : std::string());
+        }
+        out << ',' << (row.success ? 1 : 0) << ',' << csvField(row.error) << ',' << csvField(row.outputFile);
+        for (const auto& key : metricKeys) {
+            out << ',';
+            for (const auto& metric : row.metrics) {
+                if (metric.first == key && std::isfinite(metric.second)) {
+                    char buf[32];
+                    std::snprintf(buf, sizeof(buf), "%.6g", metric.second);
+                    out << buf;
+                    break;
+                }
+            }
+        }
+        out << '\n';
+    }
+}
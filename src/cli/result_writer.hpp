@@ -0,0 +1,20 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sweep_runner.hpp"
+
+// 把扫描结果写成机器可读的格式
+class ResultWriter {
+public:
+    // 按扩展名选择格式：.csv为CSV，其余为JSON
+    static bool write(const std::string& path, const std::vector<SweepRunner::Row>& rows);
+
+    // JSON数组，每个测试点一个对象：{run, codec, params{...}, success, error, output_file, metrics{...}}
+    static void writeJson(std::ostream& out, const std::vector<SweepRunner::Row>& rows);
+
+    // CSV：固定列 + 所有测试点参数的并集 + 所有指标的并集
+    static void writeCsv(std::ostream& out, const std::vector<SweepRunner::Row>& rows);
+};
@@ -0,0 +1,175 @@
+#include "search_command.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encode/param_search.hpp"
+#include "encode/result_cache.hpp"
+#include "result_writer.hpp"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " search -p <参数> [-p <参数> ...] [选项]\n"
+              << "  -p, --param <name=lo:hi[:step]|name=v1,v2,...>\n"
+              << "                           要搜索的TestConfig字段，如 crf=18:30:2、preset=veryfast,medium,slow\n"
+              << "                           支持crf/qp/bitrate/preset/tune/threads/keyintMax/bframes/refs/meRange/\n"
+              << "                           weightedPred/cabac（单遍编码，不支持fastFirstPass）\n"
+              << "                           crf/qp/bitrate共用码率控制，只能搜索其中一个\n"
+              << "      --maximize <指标>    最大化的指标：psnr/ssim/fps/bitrate，默认ssim\n"
+              << "      --minimize <指标>    最小化的指标\n"
+              << "      --min-fps <N>        编码速度下限\n"
+              << "      --max-bitrate <bps>  码率上限\n"
+              << "  -n, --candidates <N>     第一轮的候选配置数，默认27\n"
+              << "  -e, --eta <N>            每轮保留1/eta，帧数乘以eta，默认3\n"
+              << "      --min-frames <N>     第一轮的最少帧数，默认10\n"
+              << "      --seed <N>           随机取样种子，默认1\n"
+              << "  -s, --source <路径>      输入源，默认使用合成帧\n"
+              << "  -d, --size <宽x高>       编码分辨率，默认1920x1080\n"
+              << "  -f, --frames <N>         最后一轮的帧数，默认300\n"
+              << "  -o, --output <文件>      结果文件（.csv输出CSV，否则输出JSON），默认search_results.json\n"
+              << "  -j, --core-budget <N>    并发编码使用的核心数，0表示全部可用CPU\n"
+              << "      --cache-dir <目录>   结果缓存目录，默认" << ResultCache::defaultDirectory() << "\n"
+              << "      --no-cache           不读写结果缓存，全部重新编码\n"
+              << "  -h, --help               显示帮助\n";
+}
+
+SweepRunner::Row makeRow(const ParamSearch::Evaluation& evaluation, const ParamSearch::Options& options,
+                         bool best) {
+    SweepRunner::Row row;
+    row.point.run = "search";
+    row.point.codec = "x264";
+    for (size_t i = 0; i < options.parameters.size(); ++i) {
+        const auto& name = options.parameters[i].name;
+        row.point.params.emplace_back(name, ParamSearch::formatValue(name, evaluation.values[i]));
+    }
+    row.point.params.emplace_back("frames", std::to_string(evaluation.frames));
+    row.success = evaluation.result.success;
+    row.error = evaluation.result.errorMessage;
+    row.outputFile = evaluation.result.outputFile;
+    row.metrics.emplace_back("round", evaluation.round);
+    row.metrics.emplace_back("encoding_time", evaluation.result.encodingTime);
+    row.metrics.emplace_back("fps", evaluation.result.fps);
+    row.metrics.emplace_back("bitrate", evaluation.result.bitrate);
+    row.metrics.emplace_back("psnr", evaluation.result.psnr);
+    row.metrics.emplace_back("ssim", evaluation.result.ssim);
+    row.metrics.emplace_back("feasible", evaluation.feasible ? 1.0 : 0.0);
+    row.metrics.emplace_back("best", best ? 1.0 : 0.0);
+    return row;
+}
+
+}  // namespace
+
+int runSearchCommand(int argc, char* argv[]) {
+    ParamSearch::Options options;
+    std::string output = "search_results.json";
+    bool useCache = true;
+    std::string cacheDir = ResultCache::defaultDirectory();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!std::strcmp(arg, "-p") || !std::strcmp(arg, "--param")) {
+            ParamSearch::Parameter parameter;
+            std::string error;
+            if (!ParamSearch::parseParameter(value(), options.parameters, parameter, error)) {
+                std::cerr << error << std::endl;
+                return 2;
+            }
+            options.parameters.push_back(parameter);
+        } else if (!std::strcmp(arg, "--maximize") || !std::strcmp(arg, "--minimize")) {
+            options.objective.maximize = !std::strcmp(arg, "--maximize");
+            if (!ParamSearch::parseMetric(value(), options.objective.metric)) {
+                std::cerr << "未知指标: " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if (!std::strcmp(arg, "--min-fps")) {
+            options.objective.minFps = std::atof(value());
+        } else if (!std::strcmp(arg, "--max-bitrate")) {
+            options.objective.maxBitrate = std::atof(value());
+        } else if (!std::strcmp(arg, "-n") || !std::strcmp(arg, "--candidates")) {
+            options.candidates = std::atoi(value());
+        } else if (!std::strcmp(arg, "-e") || !std::strcmp(arg, "--eta")) {
+            options.eta = std::atoi(value());
+        } else if (!std::strcmp(arg, "--min-frames")) {
+            options.minFrames = std::atoi(value());
+        } else if (!std::strcmp(arg, "--seed")) {
+            options.seed = static_cast<unsigned>(std::strtoul(value(), nullptr, 10));
+        } else if (!std::strcmp(arg, "-s") || !std::strcmp(arg, "--source")) {
+            options.base.sourcePath = value();
+        } else if (!std::strcmp(arg, "-d") || !std::strcmp(arg, "--size")) {
+            int width = 0;
+            int height = 0;
+            if (std::sscanf(value(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0 ||
+                width % 2 != 0 || height % 2 != 0) {
+                std::cerr << "无效的分辨率: " << argv[i] << std::endl;
+                return 2;
+            }
+            options.base.width = width;
+            options.base.height = height;
+        } else if (!std::strcmp(arg, "-f") || !std::strcmp(arg, "--frames")) {
+            options.base.frameCount = std::atoi(value());
+        } else if (!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) {
+            output = value();
+        } else if (!std::strcmp(arg, "-j") || !std::strcmp(arg, "--core-budget")) {
+            options.coreBudget = std::atoi(value());
+        } else if (!std::strcmp(arg, "--cache-dir")) {
+            cacheDir = value();
+        } else if (!std::strcmp(arg, "--no-cache")) {
+            useCache = false;
+        } else {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.parameters.empty()) {
+        std::cerr << "至少需要一个 -p 参数" << std::endl;
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.base.frameCount <= 0 || options.candidates <= 0 || options.minFrames <= 0) {
+        std::cerr << "帧数和候选数必须为正数" << std::endl;
+        return 2;
+    }
+
+    const ResultCache cache(cacheDir);
+    if (useCache) {
+        options.cache = &cache;
+    }
+    const ParamSearch::Result result = ParamSearch::run(options);
+    if (result.evaluations.empty()) {
+        return 1;
+    }
+
+    std::vector<SweepRunner::Row> rows;
+    rows.reserve(result.evaluations.size());
+    for (size_t i = 0; i < result.evaluations.size(); ++i) {
+        rows.push_back(makeRow(result.evaluations[i], options, static_cast<int>(i) == result.best));
+    }
+    if (!ResultWriter::write(output, rows)) {
+        return 1;
+    }
+    std::cout << "结果已写入: " << output << std::endl;
+
+    // 最优配置不满足约束时返回非零，便于脚本判断
+    if (result.best < 0 || !result.evaluations[static_cast<size_t>(result.best)].feasible) {
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// search子命令：在给定的参数范围内用逐次减半搜索满足约束的最优x264配置
+int runSearchCommand(int argc, char* argv[]);
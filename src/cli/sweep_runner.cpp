@@ -0,0 +1,463 @@
+#include "sweep_runner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <type_traits>
+
+#include "encode/history_store.hpp"
+#include "encode/vp8_param_test.hpp"
+#include "encode/x264_param_test.hpp"
+#include "encode/x265_param_test.hpp"
+
+namespace {
+
+// 读取测试点参数，记录已使用的键，最后报告拼写错误等未知参数
+class ParamReader {
+public:
+    explicit ParamReader(const SweepSpec::Point& point) : point_(point) {}
+
+    bool getInt(const char* key, int& out) {
+        const std::string* value = take(key);
+        if (!value) {
+            return true;
+        }
+        char* end = nullptr;
+        double number = std::strtod(value->c_str(), &end);
+        if (end == value->c_str() || *end != '\0') {
+            return fail(std::string("参数 ") + key + " 不是数字: " + *value);
+        }
+        out = static_cast<int>(number);
+        return true;
+    }
+
+    bool getDouble(const char* key, double& out) {
+        const std::string* value = take(key);
+        if (!value) {
+            return true;
+        }
+        char* end = nullptr;
+        out = std::strtod(value->c_str(), &end);
+        if (end == value->c_str() || *end != '\0') {
+            return fail(std::string("参数 ") + key + " 不是数字: " + *value);
+        }
+        return true;
+    }
+
+    bool getBool(const char* key, bool& out) {
+        const std::string* value = take(key);
+        if (!value) {
+            return true;
+        }
+        const std::string v = lower(*value);
+        if (v == "true" || v == "1" || v == "yes" || v == "on") {
+            out = true;
+        } else if (v == "false" || v == "0" || v == "no" || v == "off") {
+            out = false;
+        } else {
+            return fail(std::string("参数 ") + key + " 不是布尔值: " + *value);
+        }
+        return true;
+    }
+
+    bool getString(const char* key, std::string& out) {
+        const std::string* value = take(key);
+        if (value) {
+            out = *value;
+        }
+        return true;
+    }
+
+    // names[i]对应枚举值i
+    template <typename Enum, size_t N>
+    bool getEnum(const char* key, const char* const (&names)[N], Enum& out) {
+        const std::string* value = take(key);
+        if (!value) {
+            return true;
+        }
+        const std::string v = lower(*value);
+        for (size_t i = 0; i < N; ++i) {
+            if (v == names[i]) {
+                out = static_cast<Enum>(i);
+                return true;
+            }
+        }
+        std::string message = std::string("参数 ") + key + " 的取值无效: " + *value + "，可选:";
+        for (const char* name : names) {
+            message += std::string(" ") + name;
+        }
+        return fail(message);
+    }
+
+    const std::string* peek(const char* key) const { return point_.find(key); }
+
+    // 所有参数都已读取，否则报告未知参数
+    bool finish() {
+        for (const auto& param : point_.params) {
+            if (!used_.count(param.first)) {
+                return fail("参数 " + param.first + " 对编码器 " + point_.codec + " 无效");
+            }
+        }
+        return error_.empty();
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    static std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    const std::string* take(const char* key) {
+        const std::string* value = point_.find(key);
+        if (value) {
+            used_.insert(key);
+        }
+        return value;
+    }
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    const SweepSpec::Point& point_;
+    std::set<std::string> used_;
+    std::string error_;
+};
+
+const char* const kPresetNames[] = {
+    "ultrafast", "superfast", "veryfast", "faster", "fast",
+    "medium", "slow", "slower", "veryslow", "placebo"
+};
+const char* const kX264TuneNames[] = {
+    "none", "film", "animation", "grain", "stillimage",
+    "psnr", "ssim", "fastdecode", "zerolatency"
+};
+const char* const kX265TuneNames[] = {
+    "none", "psnr", "ssim", "grain", "zerolatency", "fastdecode", "animation"
+};
+const char* const kRateControlNames[] = {"crf", "cqp", "abr", "cbr"};
+const char* const kVp8PresetNames[] = {"best", "good", "realtime"};
+const char* const kVp8RateControlNames[] = {"cq", "cbr", "vbr"};
+const char* const kSinkNames[] = {"null", "memory", "file", "mux"};
+const char* const kMp4ModeNames[] = {"standard", "fragmented", "faststart"};
+
+bool buildX264(const SweepSpec::Point& point, X264ParamTest::TestConfig& config, std::string& error) {
+    ParamReader reader(point);
+    reader.getInt("width", config.width);
+    reader.getInt("height", config.height);
+    reader.getInt("display_width", config.displayWidth);
+    reader.getInt("display_height", config.displayHeight);
+    reader.getInt("frames", config.frameCount);
+    reader.getInt("fps", config.fps);
+    reader.getInt("threads", config.threads);
+    reader.getEnum("preset", kPresetNames, config.preset);
+    reader.getEnum("tune", kX264TuneNames, config.tune);
+    reader.getEnum("rate_control", kRateControlNames, config.rateControl);
+
+    // crf/qp/bitrate共用存储，只读取当前码率控制模式对应的参数
+    switch (config.rateControl) {
+        case X264ParamTest::RateControl::CRF: reader.getInt("crf", config.crf); break;
+        case X264ParamTest::RateControl::CQP: reader.getInt("qp", config.qp); break;
+        case X264ParamTest::RateControl::ABR:
+        case X264ParamTest::RateControl::CBR: reader.getInt("bitrate", config.bitrate); break;
+    }
+
+    reader.getInt("keyint", config.keyintMax);
+    reader.getInt("bframes", config.bframes);
+    reader.getInt("refs", config.refs);
+    reader.getInt("me_range", config.meRange);
+    reader.getBool("fast_first_pass", config.fastFirstPass);
+    reader.getBool("weighted_pred", config.weightedPred);
+    reader.getBool("cabac", config.cabac);
+    reader.getBool("vfr", config.vfr);
+    reader.getBool("measure_quality", config.measureQuality);
+    reader.getBool("zero_copy", config.zeroCopy);
+    reader.getString("source", config.sourcePath);
+    reader.getBool("direct_io", config.directIo);
+    reader.getBool("paced", config.paced);
+    reader.getEnum("sink", kSinkNames, config.sink);
+    reader.getBool("direct_output", config.directOutput);
+    reader.getEnum("mp4_mode", kMp4ModeNames, config.mp4Mode);
+
+    bool ok = reader.finish();
+    error = reader.error();
+    return ok;
+}
+
+bool buildX265(const SweepSpec::Point& point, X265ParamTest::TestConfig& config, std::string& error) {
+    ParamReader reader(point);
+    reader.getInt("width", config.width);
+    reader.getInt("height", config.height);
+    reader.getInt("frames", config.frameCount);
+    reader.getInt("fps", config.fps);
+    reader.getInt("threads", config.threads);
+    reader.getEnum("preset", kPresetNames, config.preset);
+    reader.getEnum("tune", kX265TuneNames, config.tune);
+    reader.getEnum("rate_control", kRateControlNames, config.rateControl);
+    reader.getInt("crf", config.crf);
+    reader.getInt("qp", config.qp);
+    reader.getInt("bitrate", config.bitrate);
+    reader.getInt("keyint", config.keyintMax);
+    reader.getInt("bframes", config.bFrameCount);
+    if (const std::string* bframes = reader.peek("bframes")) {
+        config.bFrames = std::atoi(bframes->c_str()) > 0;
+    }
+    reader.getInt("refs", config.refFrames);
+    reader.getBool("weighted_pred", config.weightedPred);
+    reader.getBool("aq_mode", config.aqMode);
+    reader.getInt("aq_strength", config.aqStrength);
+    reader.getBool("psy_rd", config.psyRd);
+    reader.getDouble("psy_rd_strength", config.psyRdStrength);
+    reader.getBool("measure_quality", config.measureQuality);
+    reader.getBool("zero_copy", config.zeroCopy);
+    reader.getString("source", config.sourcePath);
+    reader.getBool("direct_io", config.directIo);
+    reader.getEnum("sink", kSinkNames, config.sink);
+    reader.getBool("direct_output", config.directOutput);
+
+    bool ok = reader.finish();
+    error = reader.error();
+    return ok;
+}
+
+bool buildVp8(const SweepSpec::Point& point, VP8ParamTest::TestConfig& config, std::string& error) {
+    ParamReader reader(point);
+    reader.getInt("width", config.width);
+    reader.getInt("height", config.height);
+    reader.getInt("frames", config.frames);
+    reader.getInt("fps", config.fps);
+    reader.getInt("threads", config.threads);
+    reader.getEnum("preset", kVp8PresetNames, config.preset);
+    reader.getEnum("rate_control", kVp8RateControlNames, config.rate_control);
+    reader.getInt("bitrate", config.bitrate);
+    reader.getInt("keyint", config.keyint);
+    reader.getInt("qmin", config.qmin);
+    reader.getInt("qmax", config.qmax);
+    reader.getInt("cq_level", config.cq_level);
+
+    int speed = static_cast<int>(config.speed);
+    reader.getInt("speed", speed);
+    if (speed < 0 || speed > static_cast<int>(VP8ParamTest::Speed::SPEED_16)) {
+        error = "参数 speed 超出范围 0-16";
+        return false;
+    }
+    config.speed = static_cast<VP8ParamTest::Speed>(speed);
+
+    reader.getBool("measure_quality", config.measure_quality);
+    reader.getBool("zero_copy", config.zero_copy);
+    reader.getString("source", config.source_path);
+    reader.getBool("direct_io", config.direct_io);
+    reader.getEnum("sink", kSinkNames, config.sink);
+    reader.getBool("direct_output", config.direct_output);
+
+    bool ok = reader.finish();
+    error = reader.error();
+    return ok;
+}
+
+template <typename Result>
+void addQualityMetrics(SweepRunner::Row& row, const Result& result) {
+    row.metrics.emplace_back("encoding_time", result.encodingTime);
+    row.metrics.emplace_back("fps", result.fps);
+    row.metrics.emplace_back("bitrate", result.bitrate);
+    row.metrics.emplace_back("psnr", result.psnr);
+    row.metrics.emplace_back("ssim", result.ssim);
+    row.metrics.emplace_back("psnr_y", result.psnrY);
+    row.metrics.emplace_back("psnr_u", result.psnrU);
+    row.metrics.emplace_back("psnr_v", result.psnrV);
+    row.metrics.emplace_back("quality_time", result.qualityTime);
+}
+
+// 输出阶段的耗时和字节数，与sink=null的结果对比即为输出带来的开销
+void addOutputMetrics(SweepRunner::Row& row, const OutputSink::Stats& output) {
+    row.metrics.emplace_back("output_bytes", static_cast<double>(output.bytes));
+    row.metrics.emplace_back("file_bytes", static_cast<double>(output.fileBytes));
+    row.metrics.emplace_back("output_open_ms", output.openTime * 1000);
+    row.metrics.emplace_back("output_write_time", output.writeTime);
+    row.metrics.emplace_back("output_write_p99_ms", output.write.summary().p99 * 1000);
+    row.metrics.emplace_back("output_close_ms", output.closeTime * 1000);
+    row.metrics.emplace_back("output_cpu_time", output.cpuTime);
+    row.metrics.emplace_back("output_mib_per_s", output.bytesPerSecond() / (1024.0 * 1024.0));
+    row.metrics.emplace_back("output_io_wait_time", output.ioWaitTime);
+}
+
+// 单帧耗时和输入到数据包延迟的分布，单位毫秒，各编码器使用相同的指标名
+void addFrameMetrics(SweepRunner::Row& row, const LatencyHistogram& frame, const LatencyHistogram& delay) {
+    const auto total = frame.summary();
+    row.metrics.emplace_back("frame_p50_ms", total.p50 * 1000);
+    row.metrics.emplace_back("frame_p90_ms", total.p90 * 1000);
+    row.metrics.emplace_back("frame_p99_ms", total.p99 * 1000);
+    row.metrics.emplace_back("frame_p999_ms", total.p999 * 1000);
+    row.metrics.emplace_back("frame_max_ms", total.max * 1000);
+    row.metrics.emplace_back("delay_p50_ms", delay.summary().p50 * 1000);
+    row.metrics.emplace_back("delay_p99_ms", delay.summary().p99 * 1000);
+    row.metrics.emplace_back("delay_max_ms", delay.summary().max * 1000);
+}
+
+SweepRunner::Row makeRow(const SweepSpec::Point& point, const X264ParamTest::TestResult& result) {
+    SweepRunner::Row row;
+    row.point = point;
+    row.success = result.success;
+    row.error = result.errorMessage;
+    row.outputFile = result.outputFile;
+    addQualityMetrics(row, result);
+    row.metrics.emplace_back("source_wait_time", result.sourceWaitTime);
+    row.metrics.emplace_back("encoded_bytes", static_cast<double>(result.encodedBytes));
+
+    addFrameMetrics(row, result.latency.total, result.latency.delay);
+
+    // 输入帧到对应数据包延迟的分解，单位毫秒
+    const auto& delay = result.frameDelay;
+    row.metrics.emplace_back("reorder_mean_ms", delay.reorder.summary().mean * 1000);
+    row.metrics.emplace_back("lookahead_mean_ms", delay.lookahead.summary().mean * 1000);
+    row.metrics.emplace_back("compute_mean_ms", delay.compute.summary().mean * 1000);
+    addOutputMetrics(row, result.output);
+
+    // 实时节奏输入的截止时间统计
+    if (result.pacing.enabled) {
+        const auto& pacing = result.pacing;
+        row.metrics.emplace_back("deadline_misses", pacing.deadlineMisses);
+        row.metrics.emplace_back("miss_ratio", pacing.missRatio());
+        row.metrics.emplace_back("late_p99_ms", pacing.lateness.summary().p99 * 1000);
+        row.metrics.emplace_back("max_backlog", pacing.maxBacklog);
+        row.metrics.emplace_back("final_backlog", pacing.finalBacklog);
+        row.metrics.emplace_back("backlog_growth", pacing.backlogGrowth);
+        row.metrics.emplace_back("realtime", pacing.realtime ? 1.0 : 0.0);
+    }
+    return row;
+}
+
+SweepRunner::Row makeRow(const SweepSpec::Point& point, const X265ParamTest::TestResult& result) {
+    SweepRunner::Row row;
+    row.point = point;
+    row.success = result.success;
+    row.error = result.errorMessage;
+    row.outputFile = result.outputFile;
+    addQualityMetrics(row, result);
+    row.metrics.emplace_back("source_wait_time", result.sourceWaitTime);
+    row.metrics.emplace_back("encoded_bytes", static_cast<double>(result.encodedBytes));
+    addFrameMetrics(row, result.latency.total, result.latency.delay);
+    addOutputMetrics(row, result.output);
+    return row;
+}
+
+SweepRunner::Row makeRow(const SweepSpec::Point& point, const VP8ParamTest::TestResult& result) {
+    SweepRunner::Row row;
+    row.point = point;
+    row.success = result.success;
+    row.error = result.error;
+    row.outputFile = result.output_file;
+    row.metrics.emplace_back("encoding_time", result.encoding_time);
+    row.metrics.emplace_back("fps", result.fps);
+    row.metrics.emplace_back("bitrate", result.bitrate);
+    row.metrics.emplace_back("psnr", result.psnr);
+    row.metrics.emplace_back("ssim", result.ssim);
+    row.metrics.emplace_back("psnr_y", result.psnr_y);
+    row.metrics.emplace_back("psnr_u", result.psnr_u);
+    row.metrics.emplace_back("psnr_v", result.psnr_v);
+    row.metrics.emplace_back("quality_time", result.quality_time);
+    row.metrics.emplace_back("source_wait_time", result.source_wait_time);
+    row.metrics.emplace_back("encoded_bytes", static_cast<double>(result.encoded_bytes));
+    addFrameMetrics(row, result.latency.total, result.latency.delay);
+    addOutputMetrics(row, result.output);
+    return row;
+}
+
+// 运行同一编码器的所有测试点，结果写回rows中对应的位置
+template <typename Test, typename Build>
+void runGroup(const std::vector<SweepSpec::Point>& points, const std::string& codec,
+              Build build, int coreBudget, const ResultCache* cache, HistoryStore* history,
+              std::vector<SweepRunner::Row>& rows) {
+    std::vector<typename Test::TestConfig> configs;
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].codec != codec) {
+            continue;
+        }
+        typename Test::TestConfig config;
+        std::string error;
+        if (!build(points[i], config, error)) {
+            rows[i].point = points[i];
+            rows[i].error = error;
+            continue;
+        }
+        configs.push_back(config);
+        indices.push_back(i);
+    }
+    if (configs.empty()) {
+        return;
+    }
+
+    std::cout << "运行 " << codec << ": " << configs.size() << " 个配置" << std::endl;
+    const auto results = Test::runConfigs(configs, coreBudget, cache);
+    for (size_t k = 0; k < results.size(); ++k) {
+        rows[indices[k]] = makeRow(points[indices[k]], results[k]);
+        if (!history || !rows[indices[k]].success) {
+            continue;
+        }
+        // 成功的测试点写入编码历史，与界面中的编码记录放在一起
+        if constexpr (std::is_same_v<Test, X264ParamTest>) {
+            history->append(HistoryStore::fromX264(configs[k], results[k]));
+        } else if constexpr (std::is_same_v<Test, X265ParamTest>) {
+            history->append(HistoryStore::fromX265(configs[k], results[k]));
+        } else if constexpr (std::is_same_v<Test, VP8ParamTest>) {
+            history->append(HistoryStore::fromVp8(configs[k], results[k]));
+        }
+    }
+}
+
+bool checkPoint(const SweepSpec::Point& point, std::string& error) {
+    if (point.codec == "x264") {
+        X264ParamTest::TestConfig config;
+        return buildX264(point, config, error);
+    }
+    if (point.codec == "x265") {
+        X265ParamTest::TestConfig config;
+        return buildX265(point, config, error);
+    }
+    if (point.codec == "vp8") {
+        VP8ParamTest::TestConfig config;
+        return buildVp8(point, config, error);
+    }
+    error = "未知的编码器: " + (point.codec.empty() ? std::string("(未指定)") : point.codec);
+    return false;
+}
+
+}  // namespace
+
+bool SweepRunner::validate(const std::vector<SweepSpec::Point>& points) {
+    bool ok = true;
+    for (size_t i = 0; i < points.size(); ++i) {
+        std::string error;
+        if (!checkPoint(points[i], error)) {
+            std::cerr << "测试点 " << i << " (" << points[i].run << "): " << error << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+std::vector<SweepRunner::Row> SweepRunner::run(const std::vector<SweepSpec::Point>& points, int coreBudget,
+                                               const ResultCache* cache, HistoryStore* history) {
+    std::vector<Row> rows(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        rows[i].point = points[i];
+        std::string error;
+        if (!checkPoint(points[i], error)) {
+            rows[i].error = error;
+        }
+    }
+
+    runGroup<X264ParamTest>(points, "x264", buildX264, coreBudget, cache, history, rows);
+    runGroup<X265ParamTest>(points, "x265", buildX265, coreBudget, cache, history, rows);
+    runGroup<VP8ParamTest>(points, "vp8", buildVp8, coreBudget, cache, history, rows);
+    return rows;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sweep_spec.hpp"
+
+class HistoryStore;
+class ResultCache;
+
+// 把扫描描述中的测试点转换为各编码器的TestConfig，并发运行并收集结果
+class SweepRunner {
+public:
+    // 单个测试点的结果，指标按输出顺序排列
+    struct Row {
+        SweepSpec::Point point;
+        bool success{false};
+        std::string error;
+        std::string outputFile;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    // 校验所有测试点的参数，不运行编码
+    static bool validate(const std::vector<SweepSpec::Point>& points);
+
+    // 按编码器分组，每组通过对应的runConfigs在核心预算内并发运行
+    // 指定cache时x264/VP8的测试点先查结果缓存（x265暂不缓存）
+    // 指定history时成功的x264/VP8测试点追加到编码历史
+    static std::vector<Row> run(const std::vector<SweepSpec::Point>& points, int coreBudget,
+                                const ResultCache* cache = nullptr, HistoryStore* history = nullptr);
+};
@@ -0,0 +1,463 @@
+#include "sweep_spec.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+using ParamList = std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+// 只保留扫描描述需要的JSON子集：标量统一保存为文本
+struct JsonValue {
+    enum class Type { Null, Scalar, Array, Object };
+    Type type{Type::Null};
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value)) {
+            return false;
+        }
+        skipSpace();
+        return pos_ == text_.size() || fail("多余的内容");
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            size_t line = 1 + std::count(text_.begin(), text_.begin() + std::min(pos_, text_.size()), '\n');
+            error_ = message + " (第" + std::to_string(line) + "行)";
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size()) {
+            char c = text_[pos_];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                ++pos_;
+            } else if (c == '/' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '/') {
+                // 允许//注释，方便在扫描描述中写说明
+                while (pos_ < text_.size() && text_[pos_] != '\n') {
+                    ++pos_;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            return fail("意外的文件结尾");
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            return parseObject(value);
+        }
+        if (c == '[') {
+            return parseArray(value);
+        }
+        value.type = JsonValue::Type::Scalar;
+        if (c == '"') {
+            return parseString(value.text);
+        }
+        // 数字、true/false/null
+        size_t start = pos_;
+        while (pos_ < text_.size() &&
+               (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                text_[pos_] == '-' || text_[pos_] == '+' || text_[pos_] == '.')) {
+            ++pos_;
+        }
+        if (pos_ == start) {
+            return fail(std::string("无法识别的字符 '") + c + "'");
+        }
+        value.text = text_.substr(start, pos_ - start);
+        if (value.text == "null") {
+            value.type = JsonValue::Type::Null;
+            value.text.clear();
+        }
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        ++pos_;  // 跳过引号
+        out.clear();
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            char e = text_[pos_++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) {
+                        return fail("无效的\\u转义");
+                    }
+                    unsigned code = std::strtoul(text_.substr(pos_, 4).c_str(), nullptr, 16);
+                    pos_ += 4;
+                    // 按UTF-8编码（不处理代理对）
+                    if (code < 0x80) {
+                        out += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        out += static_cast<char>(0xC0 | (code >> 6));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        out += static_cast<char>(0xE0 | (code >> 12));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        if (pos_ >= text_.size()) {
+            return fail("字符串没有结束");
+        }
+        ++pos_;
+        return true;
+    }
+
+    bool parseArray(JsonValue& value) {
+        value.type = JsonValue::Type::Array;
+        ++pos_;
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            value.items.emplace_back();
+            if (!parseValue(value.items.back())) {
+                return false;
+            }
+            skipSpace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == ']') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("数组中缺少 ',' 或 ']'");
+            }
+        }
+    }
+
+    bool parseObject(JsonValue& value) {
+        value.type = JsonValue::Type::Object;
+        ++pos_;
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            skipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') {
+                return fail("对象的键必须是字符串");
+            }
+            std::string key;
+            if (!parseString(key)) {
+                return false;
+            }
+            skipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != ':') {
+                return fail("缺少 ':'");
+            }
+            ++pos_;
+            value.members.emplace_back(key, JsonValue());
+            if (!parseValue(value.members.back().second)) {
+                return false;
+            }
+            skipSpace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == '}') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("对象中缺少 ',' 或 '}'");
+            }
+        }
+    }
+
+    const std::string& text_;
+    size_t pos_{0};
+    std::string error_;
+};
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string toLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> result;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+// 同名参数后出现的覆盖先出现的
+void setParam(ParamList& params, const std::string& key, std::vector<std::string> values) {
+    for (auto& param : params) {
+        if (param.first == key) {
+            param.second = std::move(values);
+            return;
+        }
+    }
+    params.emplace_back(key, std::move(values));
+}
+
+bool collectParams(const JsonValue& object, ParamList& params, std::string& codec, std::string& name) {
+    for (const auto& member : object.members) {
+        const std::string key = toLower(member.first);
+        const JsonValue& value = member.second;
+        std::vector<std::string> values;
+        if (value.type == JsonValue::Type::Scalar) {
+            values.push_back(value.text);
+        } else if (value.type == JsonValue::Type::Array) {
+            for (const auto& item : value.items) {
+                if (item.type != JsonValue::Type::Scalar) {
+                    std::cerr << "参数 " << member.first << " 的取值必须是标量" << std::endl;
+                    return false;
+                }
+                values.push_back(item.text);
+            }
+        } else if (value.type == JsonValue::Type::Object) {
+            std::cerr << "参数 " << member.first << " 不能是对象" << std::endl;
+            return false;
+        } else {
+            continue;
+        }
+
+        if (key == "codec") {
+            codec = values.empty() ? std::string() : toLower(values.front());
+        } else if (key == "name") {
+            name = values.empty() ? std::string() : values.front();
+        } else {
+            setParam(params, key, std::move(values));
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+const std::string* SweepSpec::Point::find(const std::string& key) const {
+    for (const auto& param : params) {
+        if (param.first == key) {
+            return &param.second;
+        }
+    }
+    return nullptr;
+}
+
+bool SweepSpec::load(const std::string& path, SweepSpec& spec) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法打开扫描描述文件: " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    const std::string lower = toLower(path);
+    const bool isIni = lower.size() >= 4 &&
+        (lower.compare(lower.size() - 4, 4, ".ini") == 0 ||
+         (lower.size() >= 5 && lower.compare(lower.size() - 5, 5, ".conf") == 0));
+    return isIni ? parseIni(buffer.str(), spec) : parseJson(buffer.str(), spec);
+}
+
+bool SweepSpec::parseJson(const std::string& text, SweepSpec& spec) {
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.parse(root)) {
+        std::cerr << "JSON解析失败: " << parser.error() << std::endl;
+        return false;
+    }
+    if (root.type != JsonValue::Type::Object) {
+        std::cerr << "扫描描述必须是JSON对象" << std::endl;
+        return false;
+    }
+
+    for (const auto& member : root.members) {
+        const std::string key = toLower(member.first);
+        const JsonValue& value = member.second;
+        if (key == "output" && value.type == JsonValue::Type::Scalar) {
+            spec.output = value.text;
+        } else if (key == "core_budget" && value.type == JsonValue::Type::Scalar) {
+            spec.coreBudget = std::atoi(value.text.c_str());
+        } else if (key == "defaults" && value.type == JsonValue::Type::Object) {
+            std::string ignoredCodec;
+            std::string ignoredName;
+            if (!collectParams(value, spec.defaults_, ignoredCodec, ignoredName)) {
+                return false;
+            }
+        } else if (key == "runs" && value.type == JsonValue::Type::Array) {
+            for (const auto& item : value.items) {
+                if (item.type != JsonValue::Type::Object) {
+                    std::cerr << "runs中的每一项必须是对象" << std::endl;
+                    return false;
+                }
+                Run run;
+                if (!collectParams(item, run.params, run.codec, run.name)) {
+                    return false;
+                }
+                spec.runs.push_back(std::move(run));
+            }
+        } else {
+            std::cerr << "忽略未知的顶层字段: " << member.first << std::endl;
+        }
+    }
+    return true;
+}
+
+bool SweepSpec::parseIni(const std::string& text, SweepSpec& spec) {
+    std::stringstream stream(text);
+    std::string line;
+    int lineNumber = 0;
+
+    // 当前节：nullptr表示顶层，否则为defaults或某个run的参数
+    ParamList* section = nullptr;
+    Run* run = nullptr;
+
+    while (std::getline(stream, line)) {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                std::cerr << "INI第" << lineNumber << "行: 节名缺少 ']'" << std::endl;
+                return false;
+            }
+            const std::string name = trim(line.substr(1, line.size() - 2));
+            const std::string lower = toLower(name);
+            if (lower == "defaults") {
+                section = &spec.defaults_;
+                run = nullptr;
+            } else if (lower == "run" || lower.compare(0, 4, "run ") == 0 || lower.compare(0, 4, "run.") == 0) {
+                spec.runs.emplace_back();
+                run = &spec.runs.back();
+                run->name = lower.size() > 4 ? trim(name.substr(4)) : std::string();
+                section = &run->params;
+            } else {
+                std::cerr << "INI第" << lineNumber << "行: 未知的节 [" << name << "]" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "INI第" << lineNumber << "行: 缺少 '='" << std::endl;
+            return false;
+        }
+        const std::string key = toLower(trim(line.substr(0, eq)));
+        const std::string value = trim(line.substr(eq + 1));
+
+        if (!section) {
+            if (key == "output") {
+                spec.output = value;
+            } else if (key == "core_budget") {
+                spec.coreBudget = std::atoi(value.c_str());
+            } else {
+                std::cerr << "忽略未知的顶层字段: " << key << std::endl;
+            }
+        } else if (run && key == "codec") {
+            run->codec = toLower(value);
+        } else if (run && key == "name") {
+            run->name = value;
+        } else {
+            setParam(*section, key, splitList(value));
+        }
+    }
+    return true;
+}
+
+std::vector<SweepSpec::Point> SweepSpec::expand() const {
+    std::vector<Point> points;
+
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const Run& run = runs[r];
+        ParamList params = defaults_;
+        for (const auto& param : run.params) {
+            setParam(params, param.first, param.second);
+        }
+        params.erase(std::remove_if(params.begin(), params.end(),
+                                    [](const auto& p) { return p.second.empty(); }),
+                     params.end());
+
+        // 笛卡尔积：最后一个参数变化最快
+        std::vector<size_t> index(params.size(), 0);
+        while (true) {
+            Point point;
+            point.run = run.name.empty() ? "run" + std::to_string(r) : run.name;
+            point.codec = run.codec;
+            for (size_t i = 0; i < params.size(); ++i) {
+                point.params.emplace_back(params[i].first, params[i].second[index[i]]);
+            }
+            points.push_back(std::move(point));
+
+            size_t i = params.size();
+            while (i > 0) {
+                --i;
+                if (++index[i] < params[i].second.size()) {
+                    break;
+                }
+                index[i] = 0;
+                if (i == 0) {
+                    i = SIZE_MAX;
+                    break;
+                }
+            }
+            if (params.empty() || i == SIZE_MAX) {
+                break;
+            }
+        }
+    }
+    return points;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// 参数扫描描述：从JSON或INI文件读取，每个参数可以给出多个取值，展开为笛卡尔积
+//
+// JSON:
+//   {
+//     "output": "results.json",
+//     "core_budget": 8,
+//     "defaults": { "width": 1920, "height": 1080, "frames": 300 },
+//     "runs": [
+//       { "name": "x264-crf", "codec": "x264", "preset": ["veryfast", "medium"], "crf": [18, 23, 28] },
+//       { "codec": "vp8", "rate_control": "vbr", "bitrate": [1000000, 2000000] }
+//     ]
+//   }
+//
+// INI（逗号分隔多个取值，[defaults]对所有run生效）:
+//   output = results.csv
+//   core_budget = 8
+//   [defaults]
+//   frames = 300
+//   [run x264-crf]
+//   codec = x264
+//   crf = 18, 23, 28
+class SweepSpec {
+public:
+    using Param = std::pair<std::string, std::string>;
+
+    // 一组参数，多个取值的参数按出现顺序展开
+    struct Run {
+        std::string name;
+        std::string codec;      // x264 / x265 / vp8
+        std::vector<std::pair<std::string, std::vector<std::string>>> params;
+    };
+
+    // 展开后的单个测试点
+    struct Point {
+        std::string run;
+        std::string codec;
+        std::vector<Param> params;
+
+        // 查找参数，不存在时返回nullptr
+        const std::string* find(const std::string& key) const;
+    };
+
+    std::string output;         // 结果文件，扩展名为.csv时输出CSV，否则输出JSON
+    int coreBudget{0};          // 并发扫描使用的核心数，0表示全部可用CPU
+    std::vector<Run> runs;
+
+    // 按扩展名（.json/.ini/.conf）解析，失败时输出错误并返回false
+    static bool load(const std::string& path, SweepSpec& spec);
+    static bool parseJson(const std::string& text, SweepSpec& spec);
+    static bool parseIni(const std::string& text, SweepSpec& spec);
+
+    // 展开所有run，defaults中的参数被run中的同名参数覆盖
+    std::vector<Point> expand() const;
+
+private:
+    std::vector<std::pair<std::string, std::vector<std::string>>> defaults_;
+};
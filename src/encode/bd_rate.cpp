@@ -0,0 +1,435 @@
+#include "bd_rate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace {
+
+// 分段三次Hermite插值，斜率按Fritsch-Carlson方法选取，保持数据的单调性
+class Pchip {
+public:
+    // x严格递增，至少2个点
+    void fit(const std::vector<std::pair<double, double>>& points) {
+        const size_t n = points.size();
+        x_.resize(n);
+        y_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            x_[i] = points[i].first;
+            y_[i] = points[i].second;
+        }
+
+        std::vector<double> h(n - 1), delta(n - 1);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            h[i] = x_[i + 1] - x_[i];
+            delta[i] = (y_[i + 1] - y_[i]) / h[i];
+        }
+
+        d_.assign(n, 0.0);
+        if (n == 2) {
+            d_[0] = d_[1] = delta[0];
+            return;
+        }
+
+        // 内部点：相邻割线同号时取加权调和平均，否则为极值点，斜率为0
+        for (size_t i = 1; i + 1 < n; ++i) {
+            if (delta[i - 1] * delta[i] <= 0) {
+                continue;
+            }
+            const double w1 = 2 * h[i] + h[i - 1];
+            const double w2 = h[i] + 2 * h[i - 1];
+            d_[i] = (w1 + w2) / (w1 / delta[i - 1] + w2 / delta[i]);
+        }
+
+        d_[0] = endSlope(h[0], h[1], delta[0], delta[1]);
+        d_[n - 1] = endSlope(h[n - 2], h[n - 3], delta[n - 2], delta[n - 3]);
+    }
+
+    double minX() const { return x_.front(); }
+    double maxX() const { return x_.back(); }
+
+    // [a, b]上的积分，区间需在数据范围内
+    double integrate(double a, double b) const {
+        double sum = 0.0;
+        for (size_t k = 0; k + 1 < x_.size(); ++k) {
+            const double lo = std::max(a, x_[k]);
+            const double hi = std::min(b, x_[k + 1]);
+            if (hi <= lo) {
+                continue;
+            }
+            const double h = x_[k + 1] - x_[k];
+            sum += h * (antiderivative(k, (hi - x_[k]) / h) - antiderivative(k, (lo - x_[k]) / h));
+        }
+        return sum;
+    }
+
+private:
+    // 三点公式估计端点斜率，并限制为不破坏单调性
+    static double endSlope(double h0, double h1, double delta0, double delta1) {
+        double d = ((2 * h0 + h1) * delta0 - h0 * delta1) / (h0 + h1);
+        if (d * delta0 <= 0) {
+            d = 0.0;
+        } else if (delta0 * delta1 <= 0 && std::fabs(d) > 3 * std::fabs(delta0)) {
+            d = 3 * delta0;
+        }
+        return d;
+    }
+
+    // 第k段Hermite多项式对t∈[0,1]的原函数（按单位区间归一化）
+    double antiderivative(size_t k, double t) const {
+        const double h = x_[k + 1] - x_[k];
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const double t4 = t3 * t;
+        const double h00 = t4 / 2 - t3 + t;
+        const double h10 = t4 / 4 - 2 * t3 / 3 + t2 / 2;
+        const double h01 = -t4 / 2 + t3;
+        const double h11 = t4 / 4 - t3 / 3;
+        return y_[k] * h00 + h * d_[k] * h10 + y_[k + 1] * h01 + h * d_[k + 1] * h11;
+    }
+
+    std::vector<double> x_, y_, d_;
+};
+
+// 按x排序，x相同的点取y的平均
+std::vector<std::pair<double, double>> prepare(std::vector<std::pair<double, double>> points) {
+    std::sort(points.begin(), points.end());
+    std::vector<std::pair<double, double>> merged;
+    size_t i = 0;
+    while (i < points.size()) {
+        size_t j = i;
+        double sum = 0.0;
+        while (j < points.size() && points[j].first == points[i].first) {
+            sum += points[j].second;
+            ++j;
+        }
+        merged.emplace_back(points[i].first, sum / (j - i));
+        i = j;
+    }
+    return merged;
+}
+
+// 两条曲线在重叠区间上的平均差（test - anchor）
+bool averageDifference(const std::vector<std::pair<double, double>>& anchorPoints,
+                       const std::vector<std::pair<double, double>>& testPoints,
+                       double& difference, double& low, double& high, std::string& error) {
+    const auto anchor = prepare(anchorPoints);
+    const auto test = prepare(testPoints);
+    if (anchor.size() < 2 || test.size() < 2) {
+        error = "每组至少需要2个不同的点";
+        return false;
+    }
+
+    Pchip anchorCurve, testCurve;
+    anchorCurve.fit(anchor);
+    testCurve.fit(test);
+
+    low = std::max(anchorCurve.minX(), testCurve.minX());
+    high = std::min(anchorCurve.maxX(), testCurve.maxX());
+    if (high <= low) {
+        return false;
+    }
+
+    difference = (testCurve.integrate(low, high) - anchorCurve.integrate(low, high)) / (high - low);
+    return true;
+}
+
+std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+// 解析字段开头的数值（允许带单位，如"1000 kbps"）
+bool parseNumber(const std::string& field, double& value) {
+    const char* begin = field.c_str();
+    char* end = nullptr;
+    value = std::strtod(begin, &end);
+    return end != begin && std::isfinite(value);
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return s;
+}
+
+// 各导出格式中的指标列名
+const char* const kBitrateKbpsColumns[] = {"码率(kbps)"};
+const char* const kBitrateBpsColumns[] = {"bitrate"};
+const char* const kPsnrColumns[] = {"psnr"};
+const char* const kSsimColumns[] = {"ssim"};
+const char* const kFpsColumns[] = {"速度(fps)", "编码速度", "fps"};
+// 每行取值都不同的列，不作为分组条件
+const char* const kExcludedColumns[] = {
+    "时间", "编码时间", "编码时间(s)", "encoding_time", "quality_time", "source_wait_time",
+    "output_file", "error"
+};
+
+// 参数扫描的CSV中参数列在output_file之前，指标列在其后，参数与指标可能同名（如bitrate、fps）
+// 有output_file列时只在其后查找指标列
+size_t metricSectionStart(const std::vector<std::string>& columns) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (lower(columns[i]) == "output_file") {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+template <size_t N>
+int findColumn(const std::vector<std::string>& columns, const char* const (&names)[N]) {
+    const size_t start = metricSectionStart(columns);
+    for (const char* name : names) {
+        for (size_t i = start; i < columns.size(); ++i) {
+            if (lower(columns[i]) == name) {
+                return static_cast<int>(i);
+            }
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+BdRate::Result BdRate::compare(const std::vector<Point>& anchor, const std::vector<Point>& test) {
+    Result result;
+
+    // 质量作为log10(码率)的函数，码率(对数)作为质量的函数
+    auto collect = [](const std::vector<Point>& points,
+                      std::vector<std::pair<double, double>>& byRate,
+                      std::vector<std::pair<double, double>>& byQuality) {
+        for (const auto& p : points) {
+            if (p.bitrate > 0 && std::isfinite(p.bitrate) && std::isfinite(p.quality)) {
+                const double logRate = std::log10(p.bitrate);
+                byRate.emplace_back(logRate, p.quality);
+                byQuality.emplace_back(p.quality, logRate);
+            }
+        }
+    };
+
+    std::vector<std::pair<double, double>> anchorByRate, anchorByQuality;
+    std::vector<std::pair<double, double>> testByRate, testByQuality;
+    collect(anchor, anchorByRate, anchorByQuality);
+    collect(test, testByRate, testByQuality);
+
+    double qualityDiff = 0.0;
+    double logLow = 0.0;
+    double logHigh = 0.0;
+    if (!averageDifference(anchorByRate, testByRate, qualityDiff, logLow, logHigh, result.error)) {
+        if (result.error.empty()) {
+            result.error = "两组的码率区间没有重叠";
+        }
+        return result;
+    }
+
+    double logRateDiff = 0.0;
+    if (!averageDifference(anchorByQuality, testByQuality, logRateDiff,
+                           result.qualityLow, result.qualityHigh, result.error)) {
+        if (result.error.empty()) {
+            result.error = "两组的质量区间没有重叠";
+        }
+        return result;
+    }
+
+    result.valid = true;
+    result.quality = qualityDiff;
+    result.rate = (std::pow(10.0, logRateDiff) - 1.0) * 100.0;
+    result.bitrateLow = std::pow(10.0, logLow);
+    result.bitrateHigh = std::pow(10.0, logHigh);
+    return result;
+}
+
+bool RateQualityTable::loadCsv(const std::string& path, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        if (error) {
+            *error = "无法打开文件: " + path;
+        }
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parseCsv(buffer.str(), error);
+}
+
+bool RateQualityTable::parseCsv(const std::string& text, std::string* error) {
+    columns_.clear();
+    rows_.clear();
+
+    std::istringstream in(text);
+    std::string line;
+    bool header = true;
+    int bitrateColumn = -1;
+    double bitrateScale = 1.0;
+    int psnrColumn = -1;
+    int ssimColumn = -1;
+    int fpsColumn = -1;
+
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (header && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            line.erase(0, 3);
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        auto fields = splitCsvLine(line);
+        if (header) {
+            header = false;
+            columns_ = std::move(fields);
+            bitrateColumn = findColumn(columns_, kBitrateKbpsColumns);
+            if (bitrateColumn < 0) {
+                bitrateColumn = findColumn(columns_, kBitrateBpsColumns);
+                bitrateScale = 1.0 / 1000.0;
+            }
+            psnrColumn = findColumn(columns_, kPsnrColumns);
+            ssimColumn = findColumn(columns_, kSsimColumns);
+            fpsColumn = findColumn(columns_, kFpsColumns);
+            if (bitrateColumn < 0 || (psnrColumn < 0 && ssimColumn < 0)) {
+                if (error) {
+                    *error = "CSV中没有码率或PSNR/SSIM列";
+                }
+                return false;
+            }
+            continue;
+        }
+
+        fields.resize(columns_.size());
+        Row row;
+        double value = 0.0;
+        if (parseNumber(fields[bitrateColumn], value)) {
+            row.bitrate = value * bitrateScale;
+        }
+        if (psnrColumn >= 0 && parseNumber(fields[psnrColumn], value)) {
+            row.psnr = value;
+        }
+        if (ssimColumn >= 0 && parseNumber(fields[ssimColumn], value)) {
+            row.ssim = value;
+        }
+        if (fpsColumn >= 0 && parseNumber(fields[fpsColumn], value) && value > 0) {
+            row.secondsPerFrame = 1.0 / value;
+        }
+        row.fields = std::move(fields);
+        rows_.push_back(std::move(row));
+    }
+
+    if (columns_.empty()) {
+        if (error) {
+            *error = "CSV文件为空";
+        }
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::pair<std::string, std::vector<std::string>>> RateQualityTable::groupColumns() const {
+    static constexpr size_t kMaxGroupValues = 16;
+
+    const int metricColumns[] = {
+        findColumn(columns_, kBitrateKbpsColumns), findColumn(columns_, kBitrateBpsColumns),
+        findColumn(columns_, kPsnrColumns), findColumn(columns_, kSsimColumns),
+        findColumn(columns_, kFpsColumns)
+    };
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> groups;
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        if (std::find(std::begin(metricColumns), std::end(metricColumns), static_cast<int>(c)) !=
+                std::end(metricColumns) ||
+            std::find(std::begin(kExcludedColumns), std::end(kExcludedColumns), lower(columns_[c])) !=
+                std::end(kExcludedColumns)) {
+            continue;
+        }
+
+        std::vector<std::string> values;
+        std::set<std::string> seen;
+        for (const auto& row : rows_) {
+            if (seen.insert(row.fields[c]).second) {
+                values.push_back(row.fields[c]);
+            }
+        }
+        if (values.size() >= 2 && values.size() <= kMaxGroupValues) {
+            groups.emplace_back(columns_[c], std::move(values));
+        }
+    }
+    return groups;
+}
+
+std::vector<BdRate::Point> RateQualityTable::curve(Metric metric, const std::string& column,
+                                                   const std::string& value) const {
+    const int index = columnIndex(column);
+    std::vector<BdRate::Point> points;
+    for (const auto& row : rows_) {
+        if (!matches(row, index, value) || row.bitrate <= 0) {
+            continue;
+        }
+        const double quality = metric == Metric::PSNR ? row.psnr : row.ssim;
+        if (quality > 0) {
+            points.push_back({row.bitrate, quality});
+        }
+    }
+    return points;
+}
+
+double RateQualityTable::secondsPerFrame(const std::string& column, const std::string& value) const {
+    const int index = columnIndex(column);
+    double sum = 0.0;
+    int count = 0;
+    for (const auto& row : rows_) {
+        if (matches(row, index, value) && row.secondsPerFrame > 0) {
+            sum += row.secondsPerFrame;
+            ++count;
+        }
+    }
+    return count > 0 ? sum / count : -1.0;
+}
+
+bool RateQualityTable::matches(const Row& row, int columnIndex, const std::string& value) const {
+    if (columnIndex == kAllRows) {
+        return true;
+    }
+    return columnIndex >= 0 && row.fields[columnIndex] == value;
+}
+
+int RateQualityTable::columnIndex(const std::string& column) const {
+    if (column.empty()) {
+        return kAllRows;
+    }
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        if (columns_[i] == column) {
+            return static_cast<int>(i);
+        }
+    }
+    return kUnknownColumn;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Bjøntegaard delta：比较两组码率-质量曲线
+// 曲线用分段三次Hermite插值（PCHIP，保持单调，不会在点之间过冲），在两组的重叠区间上积分求平均差
+class BdRate {
+public:
+    // 码率单位不限，两组一致即可；质量为PSNR(dB)或SSIM
+    struct Point {
+        double bitrate{0.0};
+        double quality{0.0};
+    };
+
+    struct Result {
+        bool valid{false};
+        std::string error;
+        double rate{0.0};          // BD-rate：相同质量下测试组相对锚点的码率变化(%)，负数表示节省
+        double quality{0.0};       // BD-PSNR/BD-SSIM：相同码率下测试组的质量差，正数表示更好
+        double qualityLow{0.0};    // 计算BD-rate使用的质量重叠区间
+        double qualityHigh{0.0};
+        double bitrateLow{0.0};    // 计算质量差使用的码率重叠区间
+        double bitrateHigh{0.0};
+    };
+
+    // 每组至少2个码率不同的点，4个以上结果才可靠；码率相同的点取质量平均
+    static Result compare(const std::vector<Point>& anchor, const std::vector<Point>& test);
+};
+
+// 码率-质量结果表：读取编码历史（exportEncodingHistory）或参数扫描（videolab_bench）导出的CSV
+// 按列名识别码率、PSNR、SSIM和速度，其余列可作为分组条件，从同一文件中选出不同配置的曲线
+class RateQualityTable {
+public:
+    enum class Metric {
+        PSNR,
+        SSIM
+    };
+
+    struct Row {
+        std::vector<std::string> fields;
+        double bitrate{0.0};          // kbps
+        double psnr{0.0};
+        double ssim{0.0};
+        double secondsPerFrame{-1.0};  // 编码每帧耗时，未知为负
+    };
+
+    bool loadCsv(const std::string& path, std::string* error = nullptr);
+    bool parseCsv(const std::string& text, std::string* error = nullptr);
+
+    const std::vector<std::string>& columns() const { return columns_; }
+    const std::vector<Row>& rows() const { return rows_; }
+
+    // 可作为分组条件的列（指标列以外、有2到16种取值的列）及其取值，按首次出现的顺序
+    std::vector<std::pair<std::string, std::vector<std::string>>> groupColumns() const;
+
+    // 选出column列等于value的行的曲线，column为空时选出全部行，码率或质量缺失的行被忽略
+    std::vector<BdRate::Point> curve(Metric metric, const std::string& column = {},
+                                     const std::string& value = {}) const;
+
+    // 选中行的平均每帧编码耗时，没有速度数据时返回负数
+    double secondsPerFrame(const std::string& column = {}, const std::string& value = {}) const;
+
+private:
+    static constexpr int kAllRows = -1;        // 未指定分组列
+    static constexpr int kUnknownColumn = -2;  // 分组列不存在，不选出任何行
+
+    bool matches(const Row& row, int columnIndex, const std::string& value) const;
+    int columnIndex(const std::string& column) const;
+
+    std::vector<std::string> columns_;
+    std::vector<Row> rows_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "result_cache.hpp"
+#include "sweep_scheduler.hpp"
+
+// 并发运行一组编码配置：按核心预算同时调度多个编码（coreBudget为0时使用全部可用CPU），结果顺序与configs一致
+// 指定cache时先查缓存，只编码未命中的配置，成功的结果写回缓存
+// threads不大于0的配置先按核心预算确定线程数，缓存键和编码都使用实际的线程数
+// 各编码器通过Traits提供单次测试和结果的缓存格式：
+//   struct Traits {
+//       using Config = ...;   // 含threads，不大于0时由调度器分配
+//       using Result = ...;   // 含success
+//       static constexpr int kResultsVersion = 1;  // 加入缓存键，测试方法或结果字段变化时递增，旧条目自然失效
+//       static Result run(const Config& config);
+//       static std::string cacheKey(const Config& config);  // 覆盖Config的全部字段，空串表示不缓存
+//       static ResultCache::Fields toCacheFields(const Result& result);
+//       static bool fromCacheFields(const ResultCache::Fields& fields, Result& result);
+//   };
+class ConfigRunner {
+public:
+    template <typename Traits>
+    static std::vector<typename Traits::Result> run(const std::vector<typename Traits::Config>& configs,
+                                                    int coreBudget, const ResultCache* cache) {
+        using Config = typename Traits::Config;
+        using Result = typename Traits::Result;
+
+        // 自动线程数只取决于预算和自动配置的个数，与缓存命中无关，同样的扫描得到同样的键
+        int autoJobs = 0;
+        for (const auto& config : configs) {
+            if (config.threads <= 0) {
+                ++autoJobs;
+            }
+        }
+        const int autoThreads = SweepScheduler::autoThreads(coreBudget, autoJobs);
+        std::vector<Config> resolved = configs;
+        for (auto& config : resolved) {
+            if (config.threads <= 0) {
+                config.threads = autoThreads;
+            }
+        }
+
+        std::vector<Result> results(configs.size());
+        std::vector<std::string> keys(configs.size());
+        std::vector<bool> cached(configs.size(), false);
+        std::vector<SweepScheduler::Job> jobs;
+        jobs.reserve(configs.size());
+
+        size_t hits = 0;
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (cache) {
+                keys[i] = Traits::cacheKey(resolved[i]);
+                ResultCache::Fields fields;
+                if (!keys[i].empty() && cache->load(keys[i], fields) && Traits::fromCacheFields(fields, results[i])) {
+                    cached[i] = true;
+                    ++hits;
+                    continue;
+                }
+                results[i] = Result();
+            }
+
+            SweepScheduler::Job job;
+            job.threads = resolved[i].threads;
+            job.run = [&resolved, &results, i](int) {
+                results[i] = Traits::run(resolved[i]);
+            };
+            jobs.push_back(std::move(job));
+        }
+
+        if (cache) {
+            std::cout << "结果缓存: 命中 " << hits << "/" << configs.size() << " 个配置" << std::endl;
+        }
+
+        SweepScheduler::Options options;
+        options.coreBudget = coreBudget;
+        SweepScheduler(options).run(jobs);
+
+        if (cache) {
+            for (size_t i = 0; i < configs.size(); ++i) {
+                if (!cached[i] && !keys[i].empty() && results[i].success) {
+                    cache->store(keys[i], Traits::toCacheFields(results[i]));
+                }
+            }
+        }
+        return results;
+    }
+};
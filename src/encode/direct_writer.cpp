@@ -0,0 +1,337 @@
+#include "direct_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+namespace {
+
+// O_DIRECT要求偏移、长度和缓冲区地址按逻辑块对齐
+constexpr size_t kBlockSize = 4096;
+
+size_t alignUp(size_t value) {
+    return (value + kBlockSize - 1) / kBlockSize * kBlockSize;
+}
+
+}  // namespace
+
+struct DirectFileWriter::Ring {
+#ifdef HAVE_LIBURING
+    io_uring ring;
+#endif
+};
+
+DirectFileWriter::DirectFileWriter() = default;
+
+DirectFileWriter::~DirectFileWriter() {
+    release();
+}
+
+bool DirectFileWriter::open(const std::string& path, const Options& options) {
+    release();
+    options_ = options;
+    options_.bufferSize = alignUp(std::max(options_.bufferSize, kBlockSize));
+    options_.bufferCount = std::max<size_t>(options_.bufferCount, 1);
+    stats_ = Stats();
+    failed_ = false;
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (options_.directIo) {
+        fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        stats_.directIo = fd_ >= 0;
+        if (fd_ < 0) {
+            std::cerr << "文件系统不支持O_DIRECT，改用普通写入" << std::endl;
+        }
+    }
+    if (fd_ < 0) {
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0) {
+            std::cerr << "无法打开输出文件: " << path << " - " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    patchFd_ = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (patchFd_ < 0) {
+        std::cerr << "无法打开输出文件: " << path << " - " << std::strerror(errno) << std::endl;
+        release();
+        return false;
+    }
+
+    // 预分配不改变文件长度，close时截断到实际长度会释放多余的块
+    if (options_.preallocate > 0) {
+        stats_.preallocated = fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0,
+                                        static_cast<off_t>(options_.preallocate)) == 0;
+    }
+
+#ifdef HAVE_LIBURING
+    if (options_.bufferCount > 1) {
+        ring_ = std::make_unique<Ring>();
+        int ret = io_uring_queue_init(static_cast<unsigned>(options_.bufferCount), &ring_->ring, 0);
+        if (ret < 0) {
+            std::cerr << "io_uring初始化失败，改用pwrite: " << std::strerror(-ret) << std::endl;
+            ring_.reset();
+        }
+    }
+#endif
+    stats_.ioUring = ring_ != nullptr;
+
+    // 同步写入时缓冲区在提交返回后即可复用，只需要一个
+    const size_t count = ring_ ? options_.bufferCount : 1;
+    buffers_.resize(count);
+    for (auto& buffer : buffers_) {
+        buffer.data = static_cast<uint8_t*>(std::aligned_alloc(kBlockSize, options_.bufferSize));
+        if (!buffer.data) {
+            std::cerr << "无法分配写入缓冲区" << std::endl;
+            release();
+            return false;
+        }
+    }
+    current_ = 0;
+    fill_ = 0;
+    bufferOffset_ = 0;
+    return true;
+}
+
+bool DirectFileWriter::write(uint64_t offset, const uint8_t* data, size_t size) {
+    if (fd_ < 0 || failed_) {
+        return false;
+    }
+
+    // 空洞以零填充
+    while (offset > this->size()) {
+        const size_t gap = static_cast<size_t>(
+            std::min<uint64_t>(offset - this->size(), options_.bufferSize - fill_));
+        std::memset(buffers_[current_].data + fill_, 0, gap);
+        fill_ += gap;
+        if (fill_ == options_.bufferSize && !submitCurrent(fill_)) {
+            return false;
+        }
+    }
+
+    // 落在已写入范围内的部分为回写
+    if (offset < this->size()) {
+        const size_t head = static_cast<size_t>(std::min<uint64_t>(size, this->size() - offset));
+        if (!patch(offset, data, head)) {
+            return false;
+        }
+        data += head;
+        size -= head;
+    }
+
+    while (size > 0) {
+        const size_t copy = std::min(size, options_.bufferSize - fill_);
+        std::memcpy(buffers_[current_].data + fill_, data, copy);
+        fill_ += copy;
+        data += copy;
+        size -= copy;
+        if (fill_ == options_.bufferSize && !submitCurrent(fill_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DirectFileWriter::patch(uint64_t offset, const uint8_t* data, size_t size) {
+    // 当前缓冲区中的部分直接修改
+    if (offset + size > bufferOffset_) {
+        const uint64_t start = std::max(offset, bufferOffset_);
+        const size_t skip = static_cast<size_t>(start - offset);
+        std::memcpy(buffers_[current_].data + (start - bufferOffset_), data + skip, size - skip);
+        size = skip;
+    }
+    if (size == 0) {
+        return true;
+    }
+
+    // 已提交的部分：等在途写入完成，避免与之交错
+    ++stats_.patches;
+    if (!waitAll()) {
+        return false;
+    }
+    while (size > 0) {
+        ssize_t n = pwrite(patchFd_, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "回写输出文件失败: " << std::strerror(errno) << std::endl;
+            failed_ = true;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool DirectFileWriter::submitCurrent(size_t length) {
+    Buffer& buffer = buffers_[current_];
+    buffer.offset = bufferOffset_;
+    buffer.length = length;
+    ++stats_.submits;
+
+#ifdef HAVE_LIBURING
+    if (ring_) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_->ring);
+        if (sqe) {
+            io_uring_prep_write(sqe, fd_, buffer.data, static_cast<unsigned>(length), buffer.offset);
+            io_uring_sqe_set_data(sqe, &buffer);
+            int ret = io_uring_submit(&ring_->ring);
+            if (ret < 0) {
+                std::cerr << "io_uring提交失败: " << std::strerror(-ret) << std::endl;
+                failed_ = true;
+                return false;
+            }
+            buffer.inFlight = true;
+        }
+    }
+#endif
+    if (!buffer.inFlight && !writeSync(buffer.data, length, buffer.offset)) {
+        return false;
+    }
+
+    bufferOffset_ += length;
+    fill_ = 0;
+    current_ = (current_ + 1) % buffers_.size();
+    return waitFor(current_);
+}
+
+bool DirectFileWriter::waitFor(size_t index) {
+    if (!buffers_[index].inFlight) {
+        return true;
+    }
+#ifdef HAVE_LIBURING
+    auto start = std::chrono::steady_clock::now();
+    while (buffers_[index].inFlight) {
+        io_uring_cqe* cqe = nullptr;
+        int ret = io_uring_wait_cqe(&ring_->ring, &cqe);
+        if (ret == -EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            std::cerr << "等待io_uring完成失败: " << std::strerror(-ret) << std::endl;
+            failed_ = true;
+            return false;
+        }
+        Buffer* done = static_cast<Buffer*>(io_uring_cqe_get_data(cqe));
+        const int res = cqe->res;
+        io_uring_cqe_seen(&ring_->ring, cqe);
+        done->inFlight = false;
+
+        // 失败（包括O_DIRECT被拒绝）或只写了一部分时，剩余部分同步写入
+        const size_t written = res > 0 ? static_cast<size_t>(res) : 0;
+        if (res < 0 && res != -EINVAL) {
+            std::cerr << "写入输出文件失败: " << std::strerror(-res) << std::endl;
+            failed_ = true;
+        } else if (written < done->length &&
+                   !writeSync(done->data + written, done->length - written, done->offset + written)) {
+            failed_ = true;
+        }
+    }
+    stats_.waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
+    return !failed_;
+}
+
+bool DirectFileWriter::waitAll() {
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        if (!waitFor(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DirectFileWriter::writeSync(const uint8_t* data, size_t length, uint64_t offset) {
+    auto start = std::chrono::steady_clock::now();
+    while (length > 0) {
+        ssize_t n = pwrite(fd_, data, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EINVAL && stats_.directIo) {
+            // 文件系统接受了O_DIRECT但不支持对齐写入，改用普通写入
+            std::cerr << "O_DIRECT写入失败，改用普通写入" << std::endl;
+            int flags = fcntl(fd_, F_GETFL);
+            if (flags >= 0 && fcntl(fd_, F_SETFL, flags & ~O_DIRECT) == 0) {
+                stats_.directIo = false;
+                continue;
+            }
+        }
+        if (n < 0) {
+            std::cerr << "写入输出文件失败: " << std::strerror(errno) << std::endl;
+            failed_ = true;
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    stats_.waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool DirectFileWriter::close() {
+    if (fd_ < 0) {
+        return true;
+    }
+
+    // 最后不足一块的数据补零后整块写入，再截断到实际长度
+    const uint64_t length = size();
+    bool ok = !failed_;
+    if (ok && fill_ > 0) {
+        const size_t padded = alignUp(fill_);
+        std::memset(buffers_[current_].data + fill_, 0, padded - fill_);
+        ok = submitCurrent(padded);
+    }
+    ok = waitAll() && ok;
+    if (ok && ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+        std::cerr << "截断输出文件失败: " << std::strerror(errno) << std::endl;
+        ok = false;
+    }
+    // O_DIRECT不保证设备缓存和元数据落盘
+    if (ok && fdatasync(fd_) != 0) {
+        std::cerr << "同步输出文件失败: " << std::strerror(errno) << std::endl;
+        ok = false;
+    }
+    bufferOffset_ = length;
+    fill_ = 0;
+    release();
+    return ok;
+}
+
+void DirectFileWriter::release() {
+    if (ring_) {
+        // 放弃的写入也要等完成，之后才能释放缓冲区
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            waitFor(i);
+        }
+#ifdef HAVE_LIBURING
+        io_uring_queue_exit(&ring_->ring);
+#endif
+        ring_.reset();
+    }
+    for (auto& buffer : buffers_) {
+        std::free(buffer.data);
+    }
+    buffers_.clear();
+    if (patchFd_ >= 0) {
+        ::close(patchFd_);
+        patchFd_ = -1;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
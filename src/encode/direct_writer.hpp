@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 编码输出的批量写入：按到达顺序把数据合并进大块对齐缓冲区，整块以O_DIRECT提交
+// 编译时找到liburing则通过io_uring异步提交，多个缓冲区同时在途；否则（或初始化失败时）同步pwrite
+// 非追加位置的写入（复用器回写文件头、索引等）：仍在缓冲区中的部分直接修改，
+// 已提交的部分等在途写入完成后用普通描述符pwrite
+// 非线程安全，open/write/close应在同一线程中调用（或由调用方保证先后顺序）
+class DirectFileWriter {
+public:
+    struct Options {
+        size_t bufferSize = 4 << 20;  // 每个缓冲区的大小，按4KiB对齐
+        size_t bufferCount = 4;       // 缓冲区数，即io_uring最多在途的写入数
+        uint64_t preallocate = 0;     // fallocate预分配的字节数，0表示不预分配
+        bool directIo = true;         // 使用O_DIRECT，文件系统不支持时退回普通写入
+    };
+
+    struct Stats {
+        uint64_t submits{0};      // 提交的整块写入次数
+        uint64_t patches{0};      // 回写已提交区域的次数
+        double waitTime{0.0};     // 等待缓冲区写完的时间(秒)
+        bool directIo{false};     // 实际是否使用了O_DIRECT
+        bool ioUring{false};      // 实际是否使用了io_uring
+        bool preallocated{false}; // fallocate是否成功
+    };
+
+    DirectFileWriter();
+    ~DirectFileWriter();
+
+    DirectFileWriter(const DirectFileWriter&) = delete;
+    DirectFileWriter& operator=(const DirectFileWriter&) = delete;
+
+    bool open(const std::string& path, const Options& options);
+    bool open(const std::string& path) { return open(path, Options()); }
+
+    // 在offset处写入size字节；offset等于size()时追加，大于时以零填充空洞
+    bool write(uint64_t offset, const uint8_t* data, size_t size);
+    bool append(const uint8_t* data, size_t length) { return write(size(), data, length); }
+
+    // 写出剩余数据，截断到实际长度并落盘
+    bool close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    uint64_t size() const { return bufferOffset_ + fill_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Buffer {
+        uint8_t* data{nullptr};
+        bool inFlight{false};
+        uint64_t offset{0};
+        size_t length{0};
+    };
+    struct Ring;
+
+    // 提交当前缓冲区的前length字节（块对齐），然后切换到下一个空闲缓冲区
+    bool submitCurrent(size_t length);
+    // 等待buffers_[index]写完
+    bool waitFor(size_t index);
+    bool waitAll();
+    // 同步写入，O_DIRECT被拒绝时去掉O_DIRECT后重试
+    bool writeSync(const uint8_t* data, size_t length, uint64_t offset);
+    bool patch(uint64_t offset, const uint8_t* data, size_t size);
+    void release();
+
+    Options options_;
+    Stats stats_;
+    int fd_{-1};        // 整块写入，可能带O_DIRECT
+    int patchFd_{-1};   // 回写已提交区域使用的普通描述符
+    std::vector<Buffer> buffers_;
+    size_t current_{0};
+    size_t fill_{0};             // 当前缓冲区中的数据量
+    uint64_t bufferOffset_{0};   // 当前缓冲区在文件中的位置，总是块对齐
+    std::unique_ptr<Ring> ring_;
+    bool failed_{false};
+};
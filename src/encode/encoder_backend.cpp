@@ -0,0 +1,652 @@
+#include "encoder_backend.hpp"
+#include "frame_generator.hpp"
+#include "frame_source.hpp"
+#include "sweep_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+std::string errorString(int error) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(error, errbuf, sizeof(errbuf));
+    return errbuf;
+}
+
+// 按布局缩放一帧YUV420P，sws为空或尺寸变化时重新创建
+bool scaleFrame(SwsContext*& sws, const FrameLayout& srcLayout, const uint8_t* src,
+                const FrameLayout& dstLayout, uint8_t* dst) {
+    sws = sws_getCachedContext(sws, srcLayout.width, srcLayout.height, AV_PIX_FMT_YUV420P,
+                               dstLayout.width, dstLayout.height, AV_PIX_FMT_YUV420P,
+                               SWS_LANCZOS, nullptr, nullptr, nullptr);
+    if (!sws) {
+        return false;
+    }
+    const uint8_t* srcPlanes[4] = {srcLayout.plane(src, 0), srcLayout.plane(src, 1), srcLayout.plane(src, 2), nullptr};
+    const int srcLinesizes[4] = {srcLayout.linesize[0], srcLayout.linesize[1], srcLayout.linesize[2], 0};
+    uint8_t* dstPlanes[4] = {dstLayout.plane(dst, 0), dstLayout.plane(dst, 1), dstLayout.plane(dst, 2), nullptr};
+    const int dstLinesizes[4] = {dstLayout.linesize[0], dstLayout.linesize[1], dstLayout.linesize[2], 0};
+    sws_scale(sws, srcPlanes, srcLinesizes, 0, srcLayout.height, dstPlanes, dstLinesizes);
+    return true;
+}
+
+}  // namespace
+
+std::string EncodeSource::defaultCacheDir() {
+    const char* home = getenv("HOME");
+    return home ? std::string(home) + "/frame_cache" : std::string();
+}
+
+EncodeSource::~EncodeSource() {
+    close();
+}
+
+bool EncodeSource::open(const std::string& path, const FrameLayout& layout, int frames, const Options& options) {
+    close();
+    layout_ = layout;
+    const int displayWidth = options.displayWidth > 0 ? options.displayWidth : layout.width;
+    const int displayHeight = options.displayHeight > 0 ? options.displayHeight : layout.height;
+    scaled_ = displayWidth != layout.width || displayHeight != layout.height;
+    sourceLayout_ = scaled_ ? FrameLayout::yuv420p(displayWidth, displayHeight) : layout_;
+
+    // Y4M/原始YUV由预读线程流式读取，内存占用与帧数无关
+    if (YuvStreamReader::isStreamable(path)) {
+        YuvStreamReader::Options streamOptions;
+        streamOptions.directIo = options.directIo;
+        if (!stream_.open(path, sourceLayout_, frames, streamOptions)) {
+            std::cerr << "无法打开流式输入" << std::endl;
+            return false;
+        }
+        if (scaled_) {
+            scaledFrame_.resize(layout_.size);
+        }
+        streaming_ = true;
+        open_ = true;
+        return true;
+    }
+
+    // 所有帧放入一个预分配的映射文件，按编码器需要的行宽对齐；缩放时源帧另放一个
+    const size_t count = static_cast<size_t>(std::max(frames, 0));
+    if (!cache_.open(options.cacheDir, layout_.size, count) ||
+        (scaled_ && !reference_.open(options.cacheDir, sourceLayout_.size, count))) {
+        std::cerr << "无法创建帧缓存" << std::endl;
+        close();
+        return false;
+    }
+    FrameStore& target = scaled_ ? reference_ : cache_;
+
+    const size_t threadCount = std::max<size_t>(SweepScheduler::availableCpus().size(), 1);
+    if (!path.empty()) {
+        FrameSource source(path, sourceLayout_, threadCount);
+        if (!source.load(count, [&target](size_t i) { return target.frame(i); }, options.progress)) {
+            close();
+            return false;
+        }
+    } else {
+        // 合成帧只取决于帧序号，按线程均分生成
+        const FrameGenerator generator(FrameGenerator::Pattern::StripeWave, sourceLayout_);
+        const size_t workers = std::min(threadCount, std::max<size_t>(count, 1));
+        std::mutex progressMutex;
+        size_t completed = 0;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < workers; ++t) {
+            threads.emplace_back([&, t]() {
+                SweepScheduler::releaseCurrentThread();
+                for (size_t i = t; i < count; i += workers) {
+                    generator.generate(static_cast<int>(i), target.frame(i));
+                    if (options.progress) {
+                        std::lock_guard<std::mutex> lock(progressMutex);
+                        options.progress(++completed, count);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    if (scaled_ && !downscale(threadCount)) {
+        close();
+        return false;
+    }
+
+    cache_.adviseSequential();
+    open_ = true;
+    return true;
+}
+
+bool EncodeSource::downscale(size_t threadCount) {
+    const size_t total = cache_.frameCount();
+    threadCount = std::max<size_t>(1, std::min(threadCount, total));
+
+    // 每个线程处理连续的一段帧，各自持有缩放上下文
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([this, &ok, t, total, threadCount]() {
+            SweepScheduler::releaseCurrentThread();
+            SwsContext* sws = nullptr;
+            for (size_t i = total * t / threadCount; i < total * (t + 1) / threadCount && ok; ++i) {
+                if (!scaleFrame(sws, sourceLayout_, reference_.frame(i), layout_, cache_.frame(i))) {
+                    ok = false;
+                }
+            }
+            sws_freeContext(sws);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (!ok) {
+        std::cerr << "无法创建缩放上下文" << std::endl;
+        return false;
+    }
+    reference_.adviseSequential();
+    return true;
+}
+
+void EncodeSource::close() {
+    cache_.close();
+    reference_.close();
+    stream_.close();
+    if (sws_) {
+        sws_freeContext(sws_);
+        sws_ = nullptr;
+    }
+    scaled_ = false;
+    streaming_ = false;
+    open_ = false;
+}
+
+const uint8_t* EncodeSource::next(size_t index) {
+    if (!streaming_) {
+        if (index >= cache_.frameCount()) {
+            return nullptr;
+        }
+        cache_.readAhead(index);
+        return cache_.frame(index);
+    }
+
+    const uint8_t* data = stream_.next();
+    if (!data || !scaled_) {
+        return data;
+    }
+    // 编码器在send_frame时复制输入，缩小后的帧可以复用同一个缓冲
+    if (!scaleFrame(sws_, sourceLayout_, data, layout_, scaledFrame_.data())) {
+        return nullptr;
+    }
+    return scaledFrame_.data();
+}
+
+const uint8_t* EncodeSource::sourceFrame(size_t index, std::vector<uint8_t>& buffer) const {
+    if (streaming_) {
+        // 预读缓冲区中的帧可能已被覆盖，直接从文件读取
+        buffer.resize(sourceLayout_.size);
+        return stream_.readFrameAt(index, buffer.data()) ? buffer.data() : nullptr;
+    }
+    const FrameStore& store = scaled_ ? reference_ : cache_;
+    return index < store.frameCount() ? store.frame(index) : nullptr;
+}
+
+bool EncodeSource::fillPlanes(const uint8_t* data, QualityAnalyzer::SourcePlanes& planes) const {
+    if (!data) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        planes.data[i] = sourceLayout_.plane(data, i);
+        planes.linesize[i] = sourceLayout_.linesize[i];
+    }
+    return true;
+}
+
+bool EncodeSource::planes(int64_t pts, QualityAnalyzer::SourcePlanes& planes) {
+    return pts >= 0 && fillPlanes(sourceFrame(static_cast<size_t>(pts), qualitySource_), planes);
+}
+
+EncodeSource::Reader::~Reader() {
+    if (sws_) {
+        sws_freeContext(sws_);
+    }
+}
+
+const uint8_t* EncodeSource::Reader::frame(size_t index) {
+    if (!source_.streaming_) {
+        return index < source_.cache_.frameCount() ? source_.cache_.frame(index) : nullptr;
+    }
+
+    // 预读线程只能顺序读取，按下标直接读取源文件
+    const uint8_t* data = source_.sourceFrame(index, frame_);
+    if (!data || !source_.scaled_) {
+        return data;
+    }
+    scaled_.resize(source_.layout_.size);
+    if (!scaleFrame(sws_, source_.sourceLayout_, data, source_.layout_, scaled_.data())) {
+        return nullptr;
+    }
+    return scaled_.data();
+}
+
+bool EncodeSource::Reader::planes(int64_t index, QualityAnalyzer::SourcePlanes& planes) {
+    return index >= 0 && source_.fillPlanes(source_.sourceFrame(static_cast<size_t>(index), quality_), planes);
+}
+
+// 实时节奏输入：按帧率的墙钟时刻放出帧，记录积压和错过的截止时间
+class EncoderBackend::Pacer {
+public:
+    Pacer(int fps, PacingStats& stats)
+        : interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(1.0 / fps)))
+        , stats_(stats)
+    {
+        stats_ = PacingStats();
+        stats_.enabled = true;
+    }
+
+    void start() { start_ = std::chrono::steady_clock::now(); }
+
+    // 等到第index帧到达；已经落后时立即返回，并记录已到达但未送入的帧数
+    void waitForFrame(int index) {
+        const auto release = start_ + interval_ * index;
+        auto now = std::chrono::steady_clock::now();
+        if (now < release) {
+            std::this_thread::sleep_until(release);
+            now = std::chrono::steady_clock::now();
+        }
+        const int arrived = static_cast<int>((now - start_) / interval_) + 1;
+        const int backlog = std::max(0, arrived - index - 1);
+        stats_.maxBacklog = std::max(stats_.maxBacklog, backlog);
+        stats_.finalBacklog = backlog;
+
+        const double t = std::chrono::duration<double>(now - start_).count();
+        sumT_ += t;
+        sumTT_ += t * t;
+        sumB_ += backlog;
+        sumTB_ += t * backlog;
+    }
+
+    // 第index帧处理完毕，截止时间为下一帧到达的时刻
+    void finishFrame(int index) {
+        const auto deadline = start_ + interval_ * (index + 1);
+        const auto now = std::chrono::steady_clock::now();
+        ++stats_.frames;
+        if (now > deadline) {
+            ++stats_.deadlineMisses;
+            stats_.lateness.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline).count()));
+        }
+    }
+
+    void finish() {
+        const double n = stats_.frames;
+        const double denominator = n * sumTT_ - sumT_ * sumT_;
+        stats_.backlogGrowth = n > 1 && denominator > 0 ? (n * sumTB_ - sumT_ * sumB_) / denominator : 0.0;
+        stats_.realtime = stats_.missRatio() <= kMaxMissRatio && stats_.finalBacklog <= 1;
+    }
+
+private:
+    static constexpr double kMaxMissRatio = 0.01;
+
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point start_;
+    PacingStats& stats_;
+    double sumT_{0.0};
+    double sumTT_{0.0};
+    double sumB_{0.0};
+    double sumTB_{0.0};
+};
+
+EncoderBackend::EncoderBackend() = default;
+
+EncoderBackend::~EncoderBackend() {
+    close();
+}
+
+void EncoderBackend::setBaseParameters(AVCodecContext* ctx, int width, int height, int fps, int threads) {
+    ctx->width = width;
+    ctx->height = height;
+    ctx->time_base = AVRational{1, fps > 0 ? fps : 25};
+    ctx->framerate = AVRational{fps > 0 ? fps : 25, 1};
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->codec_type = AVMEDIA_TYPE_VIDEO;
+    ctx->thread_count = threads;
+}
+
+bool EncoderBackend::open(const char* encoderName, const Options& options, const Configure& configure,
+                          const std::string& outputFile, QualityAnalyzer::SourceProvider source) {
+    close();
+    options_ = options;
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(encoderName);
+    if (!codec) {
+        std::cerr << "找不到编码器: " << encoderName << std::endl;
+        return false;
+    }
+    ctx_ = avcodec_alloc_context3(codec);
+    if (!ctx_) {
+        std::cerr << "无法分配编码器上下文" << std::endl;
+        return false;
+    }
+
+    setBaseParameters(ctx_, options_.width, options_.height, options_.fps, options_.threads);
+    if (configure && !configure(ctx_)) {
+        std::cerr << "设置编码参数失败: " << encoderName << std::endl;
+        return false;
+    }
+
+    // 封装格式要求全局头时参数集放入extradata，见OutputSink::needsGlobalHeader
+    if (options_.globalHeader ||
+        (!options_.collectPackets && OutputSink::needsGlobalHeader(options_.sink, outputFile))) {
+        ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    // 数据包缓冲从共享池中分配
+    PacketPool::install(ctx_);
+
+    int ret = avcodec_open2(ctx_, codec, nullptr);
+    if (ret < 0) {
+        std::cerr << "无法打开编码器: " << errorString(ret) << std::endl;
+        return false;
+    }
+
+    frame_ = av_frame_alloc();
+    packet_ = av_packet_alloc();
+    if (!frame_ || !packet_) {
+        std::cerr << "无法分配帧或包" << std::endl;
+        return false;
+    }
+
+    // 零拷贝模式下frame_只作为外壳，每帧指向源数据
+    layout_ = FrameLayout::yuv420p(options_.width, options_.height);
+    if (!options_.zeroCopy) {
+        frame_->format = ctx_->pix_fmt;
+        frame_->width = ctx_->width;
+        frame_->height = ctx_->height;
+        ret = av_frame_get_buffer(frame_, 0);
+        if (ret < 0) {
+            std::cerr << "无法分配帧缓冲区: " << errorString(ret) << std::endl;
+            return false;
+        }
+    }
+
+    // 打开输出，null/memory不需要输出文件；分段编码的数据包另行收集
+    if (!options_.collectPackets) {
+        sink_ = OutputSink::create(options_.sink, options_.directOutput, options_.mp4Mode);
+        if (!sink_ || !sink_->open(ctx_, outputFile, options_.expectedBytes)) {
+            std::cerr << "无法打开输出: " << OutputSink::kindToString(options_.sink) << std::endl;
+            return false;
+        }
+    }
+
+    // 画质在显示分辨率下评估，编码分辨率较小时解码结果先放大
+    if (options_.measureQuality && source) {
+        bool started = quality_.start(ctx_->codec_id, options_.width, options_.height, std::move(source),
+                                      options_.displayWidth, options_.displayHeight);
+        if (!started) {
+            std::cerr << "画质评估启动失败，PSNR/SSIM将不可用" << std::endl;
+        }
+    }
+
+    metrics_ = Metrics();
+    submitTimes_.clear();
+    submitTimes_.reserve(std::max(options_.frames, 0));
+    if (options_.frameLatency) {
+        metrics_.frameLatency.reserve(std::max(options_.frames, 0));
+    }
+    maxEmittedPts_ = -1;
+    writeFailed_ = false;
+    if (sink_) {
+        packets_.reset();
+        writerThread_ = std::thread(&EncoderBackend::writerThreadFunc, this);
+    }
+    startTime_ = std::chrono::steady_clock::now();
+    if (options_.paced && options_.fps > 0) {
+        pacer_ = std::make_unique<Pacer>(options_.fps, metrics_.pacing);
+        pacer_->start();
+    }
+    return true;
+}
+
+bool EncoderBackend::encodeFrame(const uint8_t* data) {
+    if (!ctx_ || !frame_ || !packet_ || (!sink_ && !options_.collectPackets)) {
+        return false;
+    }
+
+    // 源帧已经取出，等到它按节奏到达的时刻
+    const int index = metrics_.frames;
+    if (data && pacer_) {
+        pacer_->waitForFrame(index);
+    }
+
+    const auto totalStart = std::chrono::steady_clock::now();
+    AVFrame* input = nullptr;
+    if (data) {
+        if (options_.zeroCopy) {
+            // 以引用计数缓冲包装源帧，不复制数据
+            if (!layout_.wrapAVFrame(frame_, data)) {
+                return false;
+            }
+        } else {
+            if (av_frame_make_writable(frame_) < 0) {
+                return false;
+            }
+            layout_.copyToAVFrame(frame_, data);
+        }
+        frame_->pts = metrics_.frames++;
+        input = frame_;
+    }
+
+    const auto sendStart = std::chrono::steady_clock::now();
+    if (input) {
+        submitTimes_.push_back(sendStart);
+    } else {
+        flushTime_ = sendStart;
+    }
+    int ret = avcodec_send_frame(ctx_, input);
+    if (input && options_.zeroCopy) {
+        // 编码器已持有所需的引用，释放外壳对源帧的引用
+        av_frame_unref(frame_);
+    }
+    if (ret < 0) {
+        std::cerr << "发送帧到编码器失败: " << errorString(ret) << std::endl;
+        return false;
+    }
+    const auto sendEnd = std::chrono::steady_clock::now();
+    if (input) {
+        metrics_.latency.copy.recordSeconds(std::chrono::duration<double>(sendStart - totalStart).count());
+        metrics_.latency.send.recordSeconds(std::chrono::duration<double>(sendEnd - sendStart).count());
+    }
+
+    if (!receivePackets(!data)) {
+        return false;
+    }
+
+    const auto totalEnd = std::chrono::steady_clock::now();
+    metrics_.latency.receive.recordSeconds(std::chrono::duration<double>(totalEnd - sendEnd).count());
+    if (input) {
+        metrics_.latency.total.recordSeconds(std::chrono::duration<double>(totalEnd - totalStart).count());
+        if (pacer_) {
+            pacer_->finishFrame(index);
+        }
+    }
+    updateRates();
+    return true;
+}
+
+bool EncoderBackend::receivePackets(bool flushing) {
+    while (true) {
+        int ret = avcodec_receive_packet(ctx_, packet_);
+        if (ret == AVERROR(EAGAIN) || (ret == AVERROR_EOF && flushing)) {
+            return true;
+        }
+        if (ret < 0) {
+            std::cerr << "接收编码包失败: " << errorString(ret) << std::endl;
+            return false;
+        }
+
+        recordDelay(packet_, flushing);
+        metrics_.encodedBytes += static_cast<uint64_t>(packet_->size);
+
+        // 画质评估使用编码器时间基下的pts，需在交给写入线程之前提交
+        if (quality_.isRunning()) {
+            quality_.submitPacket(packet_);
+        }
+
+        if (options_.collectPackets) {
+            // 分段编码：保留编码器时间基下的数据包，所有段完成后再拼接
+            AVPacket* copy = av_packet_alloc();
+            if (!copy) {
+                std::cerr << "无法分配数据包" << std::endl;
+                return false;
+            }
+            av_packet_move_ref(copy, packet_);
+            collected_.push_back(copy);
+            continue;
+        }
+
+        // 交给写入线程输出，时间戳由OutputSink转换
+        if (!packets_.send(packet_)) {
+            std::cerr << "添加包到写入缓冲区失败" << std::endl;
+            return false;
+        }
+        av_packet_unref(packet_);
+    }
+}
+
+void EncoderBackend::recordDelay(const AVPacket* packet, bool flushing) {
+    const auto now = std::chrono::steady_clock::now();
+    const int64_t pts = packet->pts;
+    if (pts < 0 || pts >= static_cast<int64_t>(submitTimes_.size())) {
+        return;
+    }
+
+    // 数据包按解码顺序取出，已取出的最大pts就是编码此帧前必须先编码的最远的后续帧
+    maxEmittedPts_ = std::max(maxEmittedPts_, pts);
+    const int64_t anchor = maxEmittedPts_;
+    const int64_t trigger = static_cast<int64_t>(submitTimes_.size()) - 1;
+    const auto submitted = submitTimes_[pts];
+    const auto anchorSubmitted = submitTimes_[anchor];
+    const auto triggered = std::max(flushing ? flushTime_ : submitTimes_[trigger], anchorSubmitted);
+
+    auto seconds = [](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double>(d).count();
+    };
+    FrameLatency latency;
+    latency.pts = pts;
+    latency.keyframe = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+    latency.reorderFrames = static_cast<int>(anchor - pts);
+    latency.bufferedFrames = static_cast<int>(trigger - anchor);
+    latency.total = seconds(now - submitted);
+    latency.reorder = seconds(anchorSubmitted - submitted);
+    latency.lookahead = seconds(triggered - anchorSubmitted);
+    latency.compute = seconds(now - triggered);
+
+    metrics_.latency.delay.recordSeconds(latency.total);
+    metrics_.frameDelay.reorder.recordSeconds(latency.reorder);
+    metrics_.frameDelay.lookahead.recordSeconds(latency.lookahead);
+    metrics_.frameDelay.compute.recordSeconds(latency.compute);
+    if (options_.frameLatency) {
+        metrics_.frameLatency.push_back(latency);
+    }
+}
+
+void EncoderBackend::updateRates() {
+    metrics_.encodingTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+    metrics_.fps = metrics_.encodingTime > 0.0 ? metrics_.frames / metrics_.encodingTime : 0.0;
+    // 码率按视频时长而不是编码耗时计算
+    metrics_.bitrate = metrics_.frames > 0
+        ? metrics_.encodedBytes * 8.0 * options_.fps / metrics_.frames
+        : 0.0;
+}
+
+bool EncoderBackend::finish() {
+    if (!sink_ && !options_.collectPackets) {
+        return false;
+    }
+    if (pacer_) {
+        pacer_->finish();
+        pacer_.reset();
+    }
+
+    // 停止写入线程，写文件尾并落盘（计入编码时间，便于比较各种输出方式）
+    bool ok = true;
+    if (sink_) {
+        packets_.close();
+        if (writerThread_.joinable()) {
+            writerThread_.join();
+        }
+        ok = !writeFailed_ && sink_->close();
+        if (!ok) {
+            std::cerr << "写入输出失败" << std::endl;
+        }
+        metrics_.output = sink_->stats();
+    }
+    updateRates();
+
+    // 等待画质评估完成
+    if (quality_.isRunning()) {
+        metrics_.quality = quality_.finish();
+    }
+    return ok;
+}
+
+std::vector<AVPacket*> EncoderBackend::takePackets() {
+    std::vector<AVPacket*> packets;
+    packets.swap(collected_);
+    return packets;
+}
+
+EncoderBackend::Metrics EncoderBackend::snapshot() const {
+    Metrics current;
+    current.frames = metrics_.frames;
+    current.encodedBytes = metrics_.encodedBytes;
+    current.encodingTime = metrics_.encodingTime;
+    current.fps = metrics_.fps;
+    current.bitrate = metrics_.bitrate;
+    current.quality = quality_.snapshot();
+    return current;
+}
+
+void EncoderBackend::close() {
+    packets_.close();
+    if (writerThread_.joinable()) {
+        writerThread_.join();
+    }
+    if (ctx_) {
+        avcodec_free_context(&ctx_);
+    }
+    if (frame_) {
+        av_frame_free(&frame_);
+    }
+    if (packet_) {
+        av_packet_free(&packet_);
+    }
+    for (AVPacket* packet : collected_) {
+        av_packet_free(&packet);
+    }
+    collected_.clear();
+    pacer_.reset();
+    sink_.reset();
+}
+
+void EncoderBackend::writerThreadFunc() {
+    // 作业绑定的CPU只运行编码线程
+    SweepScheduler::releaseCurrentThread();
+    while (AVPacket* packet = packets_.receive()) {
+        // 写入失败后继续取空通道，避免编码线程阻塞
+        if (!writeFailed_ && !sink_->write(packet)) {
+            writeFailed_ = true;
+        }
+        packets_.recycle(packet);
+    }
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_source.hpp"
+#include "frame_store.hpp"
+#include "latency_histogram.hpp"
+#include "output_sink.hpp"
+#include "packet_pool.hpp"
+#include "quality_metrics.hpp"
+#include "yuv_stream_reader.hpp"
+
+struct SwsContext;
+
+// 编码输入：Y4M/原始YUV由预读线程流式读取；图片序列、视频文件和合成帧预先放入映射文件缓存
+// 显示分辨率与编码分辨率不同时，源帧按显示分辨率准备，缩小后编码，画质评估取显示分辨率的源帧
+class EncodeSource {
+public:
+    struct Options {
+        bool directIo = false;   // 流式读取时使用O_DIRECT
+        std::string cacheDir;    // 帧缓存文件所在目录，为空时使用匿名映射
+        int displayWidth = 0;    // 显示分辨率，0表示与编码分辨率相同
+        int displayHeight = 0;
+        FrameSource::ProgressCallback progress;  // 准备帧缓存的进度，在准备线程中调用
+    };
+
+    // ~/frame_cache，未设置HOME时为空
+    static std::string defaultCacheDir();
+
+    EncodeSource() = default;
+    ~EncodeSource();
+
+    EncodeSource(const EncodeSource&) = delete;
+    EncodeSource& operator=(const EncodeSource&) = delete;
+
+    // layout为编码分辨率的布局，path为空时生成合成帧（移动条纹叠加波浪，各编码器相同）
+    bool open(const std::string& path, const FrameLayout& layout, int frames, const Options& options);
+    void close();
+
+    bool isOpen() const { return open_; }
+    bool streaming() const { return streaming_; }
+    bool scaled() const { return scaled_; }
+    const FrameLayout& layout() const { return layout_; }
+    const FrameLayout& sourceLayout() const { return sourceLayout_; }  // 显示分辨率
+
+    // 按顺序取编码用的第index帧（编码分辨率），流式输入时返回的帧在下一次调用之前有效
+    const uint8_t* next(size_t index);
+
+    // 画质评估线程取第pts帧的源数据（显示分辨率），流式输入时从文件重新读取
+    bool planes(int64_t pts, QualityAnalyzer::SourcePlanes& planes);
+
+    // 等待流式输入帧就绪的时间(秒)
+    double waitTime() const { return streaming_ ? stream_.stats().waitTime : 0.0; }
+
+    // 按下标读取帧的游标，分段编码时每段一个，多个游标可在不同线程中同时使用
+    // frame由编码线程调用，planes由画质评估线程调用
+    class Reader {
+    public:
+        explicit Reader(const EncodeSource& source) : source_(source) {}
+        ~Reader();
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // 第index帧（编码分辨率），返回的帧在下一次调用之前有效
+        const uint8_t* frame(size_t index);
+        bool planes(int64_t index, QualityAnalyzer::SourcePlanes& planes);
+
+    private:
+        const EncodeSource& source_;
+        std::vector<uint8_t> frame_;    // 流式输入时读取的源帧
+        std::vector<uint8_t> scaled_;   // 缩小后的帧
+        std::vector<uint8_t> quality_;  // 画质评估线程读取的源帧
+        SwsContext* sws_{nullptr};
+    };
+
+private:
+    // 第index帧的源数据（显示分辨率），流式输入时读入buffer
+    const uint8_t* sourceFrame(size_t index, std::vector<uint8_t>& buffer) const;
+    bool fillPlanes(const uint8_t* data, QualityAnalyzer::SourcePlanes& planes) const;
+
+    // 把reference_中的全部帧缩小到cache_，按线程均分
+    bool downscale(size_t threadCount);
+
+    FrameLayout layout_;
+    FrameLayout sourceLayout_;
+    FrameStore cache_;      // 编码分辨率的帧
+    FrameStore reference_;  // 缩放时显示分辨率的源帧
+    YuvStreamReader stream_;
+    std::vector<uint8_t> scaledFrame_;    // 流式输入时当前帧缩小后的数据
+    SwsContext* sws_{nullptr};
+    std::vector<uint8_t> qualitySource_;  // 流式输入时画质评估线程重新读取的源帧
+    bool scaled_{false};
+    bool streaming_{false};
+    bool open_{false};
+};
+
+// 与编码器无关的单实例编码流程：输入帧 → 编码器 → 输出 → 指标
+// 公共参数（分辨率、按fps的时间基、像素格式、线程数）、零拷贝/复制输入、取包循环、
+// 写入线程、实时节奏输入、画质评估和各阶段计时都在这里实现，各编码器只通过Traits提供参数映射：
+//   struct Traits {
+//       using Config = ...;
+//       static constexpr const char* kEncoder = "libx265";              // avcodec编码器名
+//       static EncoderBackend::Options options(const Config& config);  // 公共参数
+//       static bool configure(AVCodecContext* ctx, const Config& config);  // 特有参数，avcodec_open2之前调用
+//   };
+// 非线程安全，open/encodeFrame/finish应在同一线程中调用
+class EncoderBackend {
+public:
+    struct Options {
+        int width = 1920;
+        int height = 1080;
+        int fps = 30;
+        int threads = 0;
+        int frames = 0;                 // 预计帧数，只用于预留逐帧记录
+        bool zeroCopy = true;           // 直接提交源帧，false时逐行复制
+        bool measureQuality = true;     // 是否计算PSNR/SSIM
+        int displayWidth = 0;           // 画质评估的参考分辨率，0表示与编码分辨率相同
+        int displayHeight = 0;
+        bool paced = false;             // 按fps的墙钟时刻逐帧送入编码器，统计每帧是否在下一帧到达前编完
+        bool frameLatency = false;      // 保留逐帧延迟记录（Metrics::frameLatency）
+        OutputSink::Kind sink = OutputSink::Kind::Null;
+        bool collectPackets = false;    // 数据包保留在内存中由takePackets取走，不打开输出（分段编码）
+        bool globalHeader = false;      // 参数集放入extradata而不在码流中重复；mux输出按封装格式自动设置
+        bool directOutput = false;      // file/mux输出使用预分配+大块O_DIRECT批量写入
+        OutputSink::Mp4Mode mp4Mode = OutputSink::Mp4Mode::Standard;
+        uint64_t expectedBytes = 0;     // 批量写入时预分配的文件大小，0表示不预分配
+    };
+
+    // 各阶段单帧耗时分布，同一阶段的直方图可跨测试合并；写入阶段见OutputSink::Stats::write
+    struct Latency {
+        LatencyHistogram copy;      // 准备输入帧（零拷贝包装或逐行复制）
+        LatencyHistogram send;      // avcodec_send_frame
+        LatencyHistogram receive;   // avcodec_receive_packet循环
+        LatencyHistogram total;     // encodeFrame整体
+        LatencyHistogram delay;     // 单帧从送入编码器到取出对应数据包
+
+        void merge(const Latency& other) {
+            copy.merge(other.copy);
+            send.merge(other.send);
+            receive.merge(other.receive);
+            total.merge(other.total);
+            delay.merge(other.delay);
+        }
+    };
+
+    // 单帧从送入编码器到取出对应数据包的延迟，按pts把数据包对应到输入帧
+    // 设anchor为此帧之前（含）取出的数据包中最大的pts，即编码此帧前必须先编码的最远的后续帧，
+    // trigger为取出数据包时最后送入的帧（刷新阶段为开始刷新的时刻），则
+    // total = reorder + lookahead + compute
+    struct FrameLatency {
+        int64_t pts{0};
+        bool keyframe{false};
+        int reorderFrames{0};   // anchor - pts，B帧重排序需要提前编码的后续帧数
+        int bufferedFrames{0};  // trigger - anchor，前瞻和帧线程额外缓冲的后续帧数
+        double total{0.0};      // 送入到取出数据包（秒）
+        double reorder{0.0};    // 送入到anchor送入：等待B帧的后向参考帧
+        double lookahead{0.0};  // anchor送入到trigger送入：前瞻（rc-lookahead）和帧线程缓冲
+        double compute{0.0};    // trigger送入到取出数据包：所需输入都已到达后的编码耗时
+    };
+
+    // 输入到数据包延迟的分解，合计见Latency::delay
+    struct FrameDelay {
+        LatencyHistogram reorder;
+        LatencyHistogram lookahead;
+        LatencyHistogram compute;
+
+        void merge(const FrameDelay& other) {
+            reorder.merge(other.reorder);
+            lookahead.merge(other.lookahead);
+            compute.merge(other.compute);
+        }
+    };
+
+    // 实时节奏输入的统计：第i帧在start+i/fps到达，截止时间为下一帧到达的时刻，
+    // encodeFrame返回（编码器已处理完该帧并取出可用的数据包）即视为完成
+    struct PacingStats {
+        bool enabled{false};
+        int frames{0};
+        int deadlineMisses{0};      // 超过截止时间才完成的帧数
+        int maxBacklog{0};          // 已到达但尚未送入编码器的最多帧数
+        int finalBacklog{0};        // 送入最后一帧时的积压帧数
+        double backlogGrowth{0.0};  // 积压帧数对时间的线性回归斜率(帧/秒)，持续为正说明跟不上
+        LatencyHistogram lateness;  // 错过截止时间的帧超出的时间
+        bool realtime{false};       // 能否持续实时：错过比例不超过1%且最后没有积压
+
+        double missRatio() const { return frames > 0 ? static_cast<double>(deadlineMisses) / frames : 0.0; }
+    };
+
+    struct Metrics {
+        int frames{0};                 // 送入编码器的帧数
+        uint64_t encodedBytes{0};      // 编码器输出的码流字节数，不含封装开销
+        double encodingTime{0.0};      // 从打开编码器到输出关闭（秒）
+        double fps{0.0};               // 编码速度
+        double bitrate{0.0};           // 按码流字节数和视频时长(frames/fps)计算(bps)
+        Latency latency;
+        FrameDelay frameDelay;
+        std::vector<FrameLatency> frameLatency;  // 按取出顺序，Options::frameLatency为false时为空
+        PacingStats pacing;            // Options::paced为false时enabled为false
+        QualityAnalyzer::Summary quality;
+        OutputSink::Stats output;      // finish之后有效
+    };
+
+    EncoderBackend();
+    ~EncoderBackend();
+
+    EncoderBackend(const EncoderBackend&) = delete;
+    EncoderBackend& operator=(const EncoderBackend&) = delete;
+
+    // 设置各编码器共用的上下文参数，时间基为1/fps
+    static void setBaseParameters(AVCodecContext* ctx, int width, int height, int fps, int threads);
+
+    // 按Traits打开编码器；outputFile只对file/mux输出有效，source为空时不做画质评估
+    template <typename Traits>
+    bool open(const typename Traits::Config& config, const std::string& outputFile,
+              QualityAnalyzer::SourceProvider source) {
+        return open(Traits::kEncoder, Traits::options(config),
+                    [&config](AVCodecContext* ctx) { return Traits::configure(ctx, config); },
+                    outputFile, std::move(source));
+    }
+
+    using Configure = std::function<bool(AVCodecContext* ctx)>;
+    bool open(const char* encoderName, const Options& options, const Configure& configure,
+              const std::string& outputFile, QualityAnalyzer::SourceProvider source);
+
+    // 编码一帧（按layout()排列），data为空时刷新编码器
+    // 实时节奏输入时先等到该帧的到达时刻
+    bool encodeFrame(const uint8_t* data);
+
+    // 停止写入线程、关闭输出并等待画质评估，返回输出是否全部写入成功
+    bool finish();
+
+    // 编码过程中的进度：帧数、字节数、速度、码率和画质的当前值
+    Metrics snapshot() const;
+    const Metrics& metrics() const { return metrics_; }
+
+    // collectPackets时取走编码器时间基下的数据包，由调用方释放
+    std::vector<AVPacket*> takePackets();
+
+    const FrameLayout& layout() const { return layout_; }
+    const AVCodecContext* context() const { return ctx_; }
+
+    void close();
+
+private:
+    class Pacer;
+
+    bool receivePackets(bool flushing);
+    void recordDelay(const AVPacket* packet, bool flushing);
+    void updateRates();
+    void writerThreadFunc();
+
+    Options options_;
+    AVCodecContext* ctx_{nullptr};
+    AVFrame* frame_{nullptr};
+    AVPacket* packet_{nullptr};
+    FrameLayout layout_;
+
+    // 输出：由写入线程调用
+    std::unique_ptr<OutputSink> sink_;
+    static constexpr size_t kMaxPackets = 512;
+    PacketChannel packets_{kMaxPackets};  // 编码线程写入，写入线程读取
+    std::thread writerThread_;
+    bool writeFailed_{false};  // 写入线程停止后读取
+    std::vector<AVPacket*> collected_;  // collectPackets时保留的数据包
+
+    QualityAnalyzer quality_;
+    std::unique_ptr<Pacer> pacer_;
+
+    // submitTimes_[pts]为该帧送入编码器的时刻，flushTime_为开始刷新的时刻
+    std::vector<std::chrono::steady_clock::time_point> submitTimes_;
+    std::chrono::steady_clock::time_point flushTime_;
+    int64_t maxEmittedPts_{-1};
+    std::chrono::steady_clock::time_point startTime_;
+    Metrics metrics_;
+};
@@ -0,0 +1,81 @@
+#include "frame_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+FrameGenerator::FrameGenerator(Pattern pattern, const FrameLayout& layout)
+    : pattern_(pattern)
+    , layout_(layout) {
+}
+
+void FrameGenerator::generate(int frameIndex, uint8_t* dst) const {
+    const int lumaCount = layout_.width + layout_.height;
+    const int chromaCount = layout_.planeWidth(1) + layout_.planeHeight(1);
+
+    // 每个线程复用自己的查找表
+    thread_local std::vector<uint8_t> tables;
+    tables.resize(static_cast<size_t>(lumaCount) + 2 * static_cast<size_t>(chromaCount));
+    uint8_t* yTable = tables.data();
+    uint8_t* uTable = yTable + lumaCount;
+    uint8_t* vTable = uTable + chromaCount;
+
+    fillLumaTable(frameIndex, yTable, lumaCount);
+    fillChromaTables(frameIndex, uTable, vTable, chromaCount);
+
+    fillPlane(layout_.plane(dst, 0), layout_.linesize[0],
+              layout_.planeWidth(0), layout_.planeHeight(0), yTable);
+    fillPlane(layout_.plane(dst, 1), layout_.linesize[1],
+              layout_.planeWidth(1), layout_.planeHeight(1), uTable);
+    fillPlane(layout_.plane(dst, 2), layout_.linesize[2],
+              layout_.planeWidth(2), layout_.planeHeight(2), vTable);
+}
+
+void FrameGenerator::fillLumaTable(int frameIndex, uint8_t* table, int count) const {
+    switch (pattern_) {
+        case Pattern::StripeWave: {
+            const int patternSize = 32;
+            for (int d = 0; d < count; ++d) {
+                // 条纹与波浪效果
+                int stripe = ((d + frameIndex * 4) / patternSize) & 1;
+                float wave = std::sin((d + frameIndex * 3) * 0.02f) * 64.0f;
+                float value = 128.0f + stripe * 64.0f + wave;
+                table[d] = static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f));
+            }
+            break;
+        }
+        case Pattern::DiagonalRamp:
+            for (int d = 0; d < count; ++d) {
+                table[d] = static_cast<uint8_t>((d + frameIndex) % 255);
+            }
+            break;
+    }
+}
+
+void FrameGenerator::fillChromaTables(int frameIndex, uint8_t* uTable, uint8_t* vTable, int count) const {
+    switch (pattern_) {
+        case Pattern::StripeWave:
+            for (int d = 0; d < count; ++d) {
+                // U分量 - 蓝色变化，V分量 - 红色变化
+                float colorPhase = (d + frameIndex * 2) * 0.1f;
+                uTable[d] = static_cast<uint8_t>(128.0f + 64.0f * std::sin(colorPhase));
+                vTable[d] = static_cast<uint8_t>(128.0f + 64.0f * std::cos(colorPhase));
+            }
+            break;
+        case Pattern::DiagonalRamp:
+            for (int d = 0; d < count; ++d) {
+                // 色度采样点位于亮度的偶数行列，对应亮度对角线序号2d
+                int pattern = (2 * d + frameIndex) % 255;
+                uTable[d] = static_cast<uint8_t>(128 + pattern / 2);
+                vTable[d] = static_cast<uint8_t>(128 - pattern / 2);
+            }
+            break;
+    }
+}
+
+void FrameGenerator::fillPlane(uint8_t* plane, int linesize, int width, int height, const uint8_t* table) {
+    // 每行是查找表的一段连续数据，memcpy已使用AVX2/SSE2实现
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(plane + static_cast<size_t>(y) * linesize, table + y, width);
+    }
+}
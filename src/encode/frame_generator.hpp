@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "frame_store.hpp"
+
+// 合成测试帧生成器
+// 测试图案只取决于x+y，每帧先计算一张对角线查找表，每一行就是表中连续的一段，直接复制到目标缓冲区
+// 输出只取决于帧序号，与调用线程数无关
+class FrameGenerator {
+public:
+    enum class Pattern {
+        StripeWave,     // 移动条纹叠加波浪，彩色相位变化（各编码器测试的合成输入）
+        DiagonalRamp    // 移动的对角渐变（只用于生成速度的对比基准）
+    };
+
+    FrameGenerator(Pattern pattern, const FrameLayout& layout);
+
+    // 生成第frameIndex帧，按layout写入dst，可在多个线程中同时调用
+    void generate(int frameIndex, uint8_t* dst) const;
+
+    const FrameLayout& layout() const { return layout_; }
+
+private:
+    // 按对角线序号d=x+y填充查找表
+    void fillLumaTable(int frameIndex, uint8_t* table, int count) const;
+    void fillChromaTables(int frameIndex, uint8_t* uTable, uint8_t* vTable, int count) const;
+
+    // 用查找表填充平面：第y行等于table[y, y+width)
+    static void fillPlane(uint8_t* plane, int linesize, int width, int height, const uint8_t* table);
+
+    Pattern pattern_;
+    FrameLayout layout_;
+};
@@ -0,0 +1,358 @@
+#include "frame_source.hpp"
+#include "sweep_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+bool hasImageExtension(const std::filesystem::path& file) {
+    std::string ext = file.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+}
+
+// 文件名为纯数字时返回该数字，否则返回-1
+long long numericStem(const std::filesystem::path& file) {
+    const std::string stem = file.stem().string();
+    if (stem.empty() || stem.size() > 18 ||
+        !std::all_of(stem.begin(), stem.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return -1;
+    }
+    return std::stoll(stem);
+}
+
+}  // namespace
+
+FrameSource::FrameSource(const std::string& path, const FrameLayout& layout, size_t workerCount)
+    : path_(path)
+    , layout_(layout)
+    , workerCount_(workerCount > 0 ? workerCount : SweepScheduler::availableCpus().size()) {
+}
+
+bool FrameSource::isImageSequence(const std::string& path) {
+    std::error_code ec;
+    return std::filesystem::is_directory(path, ec);
+}
+
+std::vector<std::string> FrameSource::listImages(const std::string& directory) {
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file() && hasImageExtension(entry.path())) {
+            files.push_back(entry.path());
+        }
+    }
+
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+        long long na = numericStem(a);
+        long long nb = numericStem(b);
+        if (na >= 0 && nb >= 0) {
+            return na < nb;
+        }
+        return a.filename() < b.filename();
+    });
+
+    std::vector<std::string> result;
+    result.reserve(files.size());
+    for (const auto& file : files) {
+        result.push_back(file.string());
+    }
+    return result;
+}
+
+bool FrameSource::load(size_t frameCount, const SlotProvider& slot, const ProgressCallback& progress) {
+    decodedFrames_ = 0;
+    if (frameCount == 0) {
+        return true;
+    }
+
+    bool ok = isImageSequence(path_)
+        ? loadImageSequence(frameCount, slot, progress)
+        : loadVideo(frameCount, slot, progress);
+    if (!ok || decodedFrames_ == 0) {
+        std::cerr << "无法从输入源解码帧: " << path_ << std::endl;
+        return false;
+    }
+
+    // 源帧数不足时循环复制
+    if (decodedFrames_ < frameCount) {
+        std::cout << "输入源只有 " << decodedFrames_ << " 帧，循环使用" << std::endl;
+        for (size_t i = decodedFrames_; i < frameCount; ++i) {
+            std::memcpy(slot(i), slot(i % decodedFrames_), layout_.size);
+            if (progress) {
+                progress(i + 1, frameCount);
+            }
+        }
+    }
+    return true;
+}
+
+bool FrameSource::loadImageSequence(size_t frameCount, const SlotProvider& slot,
+                                    const ProgressCallback& progress) {
+    const std::vector<std::string> files = listImages(path_);
+    if (files.empty()) {
+        std::cerr << "目录中没有图片: " << path_ << std::endl;
+        return false;
+    }
+
+    const size_t count = std::min(files.size(), frameCount);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> completed{0};
+    std::atomic<bool> failed{false};
+    std::mutex progressMutex;
+
+    auto worker = [&]() {
+        SweepScheduler::releaseCurrentThread();
+        SwsContext* sws = nullptr;
+        while (!failed) {
+            size_t index = next.fetch_add(1);
+            if (index >= count) {
+                break;
+            }
+
+            AVFrame* frame = decodeImage(files[index]);
+            if (!frame || !convert(frame, slot(index), &sws)) {
+                std::cerr << "无法解码图片: " << files[index] << std::endl;
+                failed = true;
+            }
+            av_frame_free(&frame);
+
+            size_t done = completed.fetch_add(1) + 1;
+            if (progress) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                progress(done, frameCount);
+            }
+        }
+        sws_freeContext(sws);
+    };
+
+    // 每张图片独立解码，按图片并行
+    std::vector<std::thread> threads;
+    const size_t threadCount = std::min(workerCount_, count);
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    decodedFrames_ = failed ? 0 : count;
+    return !failed;
+}
+
+bool FrameSource::loadVideo(size_t frameCount, const SlotProvider& slot,
+                            const ProgressCallback& progress) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, path_.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "无法打开输入文件: " << path_ << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+        std::cerr << "无法读取流信息: " << path_ << std::endl;
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+
+    const AVCodec* codec = nullptr;
+    int streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    AVCodecContext* decoderCtx = streamIndex >= 0 && codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!decoderCtx ||
+        avcodec_parameters_to_context(decoderCtx, formatCtx->streams[streamIndex]->codecpar) < 0) {
+        std::cerr << "找不到可解码的视频流: " << path_ << std::endl;
+        avcodec_free_context(&decoderCtx);
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+
+    // 帧级多线程解码，线程数由解码器自动确定
+    decoderCtx->thread_count = 0;
+    decoderCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    if (avcodec_open2(decoderCtx, codec, nullptr) < 0) {
+        std::cerr << "无法打开解码器: " << path_ << std::endl;
+        avcodec_free_context(&decoderCtx);
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+
+    // 解码线程产生帧，转换线程池并行完成缩放
+    struct Task {
+        size_t index;
+        AVFrame* frame;
+    };
+    std::queue<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable spaceReady;
+    bool finished = false;
+    std::atomic<bool> failed{false};
+    size_t completed = 0;
+    const size_t maxQueued = workerCount_ * 2;
+
+    auto worker = [&]() {
+        SweepScheduler::releaseCurrentThread();
+        SwsContext* sws = nullptr;
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskReady.wait(lock, [&] { return !tasks.empty() || finished; });
+                if (tasks.empty()) {
+                    break;
+                }
+                task = tasks.front();
+                tasks.pop();
+            }
+            spaceReady.notify_one();
+
+            if (!convert(task.frame, slot(task.index), &sws)) {
+                failed = true;
+            }
+            av_frame_free(&task.frame);
+
+            if (progress) {
+                std::lock_guard<std::mutex> lock(mutex);
+                progress(++completed, frameCount);
+            }
+        }
+        sws_freeContext(sws);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workerCount_; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    size_t index = 0;
+
+    // 取出解码器中已完成的帧交给转换线程
+    auto drain = [&]() {
+        while (index < frameCount && !failed) {
+            if (avcodec_receive_frame(decoderCtx, frame) < 0) {
+                break;
+            }
+            AVFrame* decoded = av_frame_alloc();
+            av_frame_move_ref(decoded, frame);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                spaceReady.wait(lock, [&] { return tasks.size() < maxQueued; });
+                tasks.push({index++, decoded});
+            }
+            taskReady.notify_one();
+        }
+    };
+
+    while (index < frameCount && !failed && av_read_frame(formatCtx, packet) >= 0) {
+        if (packet->stream_index == streamIndex) {
+            // 解码器输入已满时先取出已完成的帧，再重新送入同一个包；其他错误（损坏的包）跳过该包
+            int ret = avcodec_send_packet(decoderCtx, packet);
+            while (ret == AVERROR(EAGAIN) && index < frameCount && !failed) {
+                drain();
+                ret = avcodec_send_packet(decoderCtx, packet);
+            }
+            if (ret >= 0) {
+                drain();
+            }
+        }
+        av_packet_unref(packet);
+    }
+    if (index < frameCount && !failed) {
+        avcodec_send_packet(decoderCtx, nullptr);
+        drain();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    taskReady.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&decoderCtx);
+    avformat_close_input(&formatCtx);
+
+    decodedFrames_ = failed ? 0 : index;
+    return !failed;
+}
+
+AVFrame* FrameSource::decodeImage(const std::string& file) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, file.c_str(), nullptr, nullptr) < 0) {
+        return nullptr;
+    }
+
+    AVFrame* result = nullptr;
+    AVCodecContext* decoderCtx = nullptr;
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    const AVCodec* codec = nullptr;
+
+    int streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIndex >= 0 && codec && (decoderCtx = avcodec_alloc_context3(codec)) &&
+        avcodec_parameters_to_context(decoderCtx, formatCtx->streams[streamIndex]->codecpar) >= 0) {
+        // 并行度来自同时解码多张图片，单张图片使用单线程
+        decoderCtx->thread_count = 1;
+        if (avcodec_open2(decoderCtx, codec, nullptr) >= 0) {
+            while (!result && av_read_frame(formatCtx, packet) >= 0) {
+                if (packet->stream_index == streamIndex &&
+                    avcodec_send_packet(decoderCtx, packet) >= 0 &&
+                    avcodec_receive_frame(decoderCtx, frame) >= 0) {
+                    std::swap(result, frame);
+                }
+                av_packet_unref(packet);
+            }
+            if (!result) {
+                avcodec_send_packet(decoderCtx, nullptr);
+                if (avcodec_receive_frame(decoderCtx, frame) >= 0) {
+                    std::swap(result, frame);
+                }
+            }
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&decoderCtx);
+    avformat_close_input(&formatCtx);
+    return result;
+}
+
+bool FrameSource::convert(const AVFrame* frame, uint8_t* dst, SwsContext** sws) const {
+    if (!frame || !dst) {
+        return false;
+    }
+
+    *sws = sws_getCachedContext(*sws, frame->width, frame->height,
+                                static_cast<AVPixelFormat>(frame->format),
+                                layout_.width, layout_.height, AV_PIX_FMT_YUV420P,
+                                SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (!*sws) {
+        return false;
+    }
+
+    uint8_t* planes[4] = {layout_.plane(dst, 0), layout_.plane(dst, 1), layout_.plane(dst, 2), nullptr};
+    int linesizes[4] = {layout_.linesize[0], layout_.linesize[1], layout_.linesize[2], 0};
+    sws_scale(*sws, frame->data, frame->linesize, 0, frame->height, planes, linesizes);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "frame_store.hpp"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+struct SwsContext;
+
+// 真实内容输入源：图片序列目录（如datas/frames）或任意FFmpeg可读的视频文件
+// 解码后缩放为配置尺寸的yuv420p，直接写入帧缓存
+class FrameSource {
+public:
+    // 返回第index帧在帧缓存中的位置（按layout排列）
+    using SlotProvider = std::function<uint8_t*(size_t index)>;
+    using ProgressCallback = std::function<void(size_t completed, size_t total)>;
+
+    // workerCount为0时按可用CPU数确定转换线程数，转换线程不继承调用线程的CPU绑定
+    FrameSource(const std::string& path, const FrameLayout& layout, size_t workerCount = 0);
+
+    // 解码frameCount帧写入帧缓存，源帧数不足时循环使用已解码的帧
+    bool load(size_t frameCount, const SlotProvider& slot, const ProgressCallback& progress = nullptr);
+
+    // 实际解码的源帧数（不含循环复制的帧）
+    size_t decodedFrames() const { return decodedFrames_; }
+
+    static bool isImageSequence(const std::string& path);
+
+    // 列出目录中的图片文件，按文件名中的数字排序（0.jpg, 1.jpg, 2.jpg, ..., 10.jpg）
+    static std::vector<std::string> listImages(const std::string& directory);
+
+private:
+    // 图片序列：每个线程独立解码不同的图片
+    bool loadImageSequence(size_t frameCount, const SlotProvider& slot, const ProgressCallback& progress);
+
+    // 视频文件：帧级多线程解码，转换线程池完成缩放和像素格式转换
+    bool loadVideo(size_t frameCount, const SlotProvider& slot, const ProgressCallback& progress);
+
+    // 解码单个图片文件
+    static AVFrame* decodeImage(const std::string& file);
+
+    // 缩放并转换为yuv420p写入dst
+    bool convert(const AVFrame* frame, uint8_t* dst, SwsContext** sws) const;
+
+    std::string path_;
+    FrameLayout layout_;
+    size_t workerCount_;
+    size_t decodedFrames_{0};
+};
@@ -0,0 +1,210 @@
+#include "frame_store.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace {
+
+// 预读窗口的目标大小
+constexpr size_t kReadAheadBytes = 64 * 1024 * 1024;
+
+size_t pageSize() {
+    static const size_t size = [] {
+        long value = sysconf(_SC_PAGESIZE);
+        return value > 0 ? static_cast<size_t>(value) : size_t(4096);
+    }();
+    return size;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 同一进程内多个实例使用不同的文件名
+std::string uniqueCacheFile(const std::string& cacheDir) {
+    static std::atomic<unsigned> counter{0};
+    return cacheDir + "/frames_" + std::to_string(getpid()) + "_" +
+           std::to_string(counter.fetch_add(1)) + ".yuv";
+}
+
+// 缓存内存由FrameStore管理，引用计数归零时无需释放
+void releaseNothing(void*, uint8_t*) {}
+
+}  // namespace
+
+FrameLayout FrameLayout::yuv420p(int width, int height) {
+    FrameLayout layout;
+    layout.width = width;
+    layout.height = height;
+    layout.linesize[0] = static_cast<int>(alignUp(width, kAlign));
+    layout.linesize[1] = static_cast<int>(alignUp(width / 2, kAlign));
+    layout.linesize[2] = layout.linesize[1];
+    layout.offset[0] = 0;
+    layout.offset[1] = static_cast<size_t>(layout.linesize[0]) * height;
+    layout.offset[2] = layout.offset[1] + static_cast<size_t>(layout.linesize[1]) * (height / 2);
+    // 末尾保留一个对齐单位，SIMD读取最后一行时不会越界
+    layout.size = layout.offset[2] + static_cast<size_t>(layout.linesize[2]) * (height / 2) + kAlign;
+    return layout;
+}
+
+void FrameLayout::copyFromPacked(uint8_t* dst, const uint8_t* src) const {
+    const uint8_t* srcPlane = src;
+    for (int i = 0; i < 3; ++i) {
+        av_image_copy_plane(plane(dst, i), linesize[i],
+                            srcPlane, planeWidth(i),
+                            planeWidth(i), planeHeight(i));
+        srcPlane += static_cast<size_t>(planeWidth(i)) * planeHeight(i);
+    }
+}
+
+void FrameLayout::copyToAVFrame(AVFrame* frame, const uint8_t* src) const {
+    for (int i = 0; i < 3; ++i) {
+        av_image_copy_plane(frame->data[i], frame->linesize[i],
+                            plane(src, i), linesize[i],
+                            planeWidth(i), planeHeight(i));
+    }
+}
+
+bool FrameLayout::wrapAVFrame(AVFrame* frame, const uint8_t* src) const {
+    av_frame_unref(frame);
+
+    frame->buf[0] = av_buffer_create(const_cast<uint8_t*>(src), size,
+                                     releaseNothing, nullptr, AV_BUFFER_FLAG_READONLY);
+    if (!frame->buf[0]) {
+        return false;
+    }
+
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    for (int i = 0; i < 3; ++i) {
+        frame->data[i] = const_cast<uint8_t*>(plane(src, i));
+        frame->linesize[i] = linesize[i];
+    }
+    return true;
+}
+
+FrameStore::FrameStore() = default;
+
+FrameStore::~FrameStore() {
+    close();
+}
+
+bool FrameStore::open(const std::string& cacheDir, size_t frameSize, size_t frameCount) {
+    close();
+
+    if (frameSize == 0 || frameCount == 0) {
+        std::cerr << "帧存储参数无效" << std::endl;
+        return false;
+    }
+
+    const size_t slotSize = alignUp(frameSize, pageSize());
+    const size_t totalSize = slotSize * frameCount;
+
+    void* mapping = MAP_FAILED;
+    bool fileBacked = false;
+
+    if (!cacheDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+
+        std::string path = uniqueCacheFile(cacheDir);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd >= 0) {
+            // 预先分配磁盘空间，避免写入过程中出现空洞和碎片
+            int err = posix_fallocate(fd, 0, static_cast<off_t>(totalSize));
+            if (err == EINVAL || err == EOPNOTSUPP) {
+                err = ftruncate(fd, static_cast<off_t>(totalSize)) == 0 ? 0 : errno;
+            }
+
+            if (err == 0) {
+                mapping = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                fileBacked = mapping != MAP_FAILED;
+            } else {
+                std::cerr << "无法分配帧缓存文件: " << std::strerror(err) << std::endl;
+            }
+
+            ::close(fd);
+            unlink(path.c_str());
+        } else {
+            std::cerr << "无法创建帧缓存文件 " << path << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    if (mapping == MAP_FAILED) {
+        mapping = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "无法映射帧缓存: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    base_ = static_cast<uint8_t*>(mapping);
+    mappedSize_ = totalSize;
+    frameSize_ = frameSize;
+    slotSize_ = slotSize;
+    frameCount_ = frameCount;
+    readAheadFrames_ = std::max<size_t>(1, kReadAheadBytes / slotSize);
+    fileBacked_ = fileBacked;
+    return true;
+}
+
+void FrameStore::close() {
+    if (base_) {
+        munmap(base_, mappedSize_);
+        base_ = nullptr;
+    }
+    mappedSize_ = 0;
+    frameSize_ = 0;
+    slotSize_ = 0;
+    frameCount_ = 0;
+    fileBacked_ = false;
+}
+
+uint8_t* FrameStore::frame(size_t index) {
+    if (!base_ || index >= frameCount_) {
+        return nullptr;
+    }
+    return base_ + index * slotSize_;
+}
+
+const uint8_t* FrameStore::frame(size_t index) const {
+    if (!base_ || index >= frameCount_) {
+        return nullptr;
+    }
+    return base_ + index * slotSize_;
+}
+
+void FrameStore::adviseSequential() const {
+    advise(0, frameCount_, MADV_SEQUENTIAL);
+    advise(0, readAheadFrames_ * 2, MADV_WILLNEED);
+}
+
+void FrameStore::readAhead(size_t index) const {
+    if (index % readAheadFrames_ != 0) {
+        return;
+    }
+    advise(index + readAheadFrames_, readAheadFrames_, MADV_WILLNEED);
+}
+
+void FrameStore::advise(size_t firstFrame, size_t count, int advice) const {
+    if (!base_ || firstFrame >= frameCount_) {
+        return;
+    }
+    count = std::min(count, frameCount_ - firstFrame);
+    // 槽位按页对齐，起始地址满足madvise的对齐要求
+    madvise(base_ + firstFrame * slotSize_, count * slotSize_, advice);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// YUV420P帧在缓存中的布局：各平面行宽按64字节对齐，与libavcodec分配的帧一致
+// 编码器可以直接读取缓存中的帧，无需逐行复制
+struct FrameLayout {
+    static constexpr int kAlign = 64;
+
+    int width{0};
+    int height{0};
+    int linesize[3]{0, 0, 0};
+    size_t offset[3]{0, 0, 0};
+    size_t size{0};  // 含末尾填充的总大小
+
+    static FrameLayout yuv420p(int width, int height);
+
+    const uint8_t* plane(const uint8_t* frame, int index) const { return frame + offset[index]; }
+    uint8_t* plane(uint8_t* frame, int index) const { return frame + offset[index]; }
+    int planeWidth(int index) const { return index == 0 ? width : width / 2; }
+    int planeHeight(int index) const { return index == 0 ? height : height / 2; }
+
+    // 从紧凑排列（无行填充）的YUV420P数据复制到布局中
+    void copyFromPacked(uint8_t* dst, const uint8_t* src) const;
+
+    // 复制到已分配缓冲的AVFrame
+    void copyToAVFrame(AVFrame* frame, const uint8_t* src) const;
+
+    // 将缓存中的帧包装为只读的引用计数AVFrame，不复制数据
+    // 缓存内存由调用方管理，必须在编码器释放该帧之前保持有效
+    bool wrapAVFrame(AVFrame* frame, const uint8_t* src) const;
+};
+
+// 帧存储：所有帧放在一块预分配的内存映射区域中
+// 每帧占用一个按页对齐的槽位，读取时直接返回映射区内的指针，不再逐帧打开文件
+class FrameStore {
+public:
+    FrameStore();
+    ~FrameStore();
+
+    FrameStore(const FrameStore&) = delete;
+    FrameStore& operator=(const FrameStore&) = delete;
+
+    // 在cacheDir下创建并映射缓存文件，cacheDir为空或文件创建失败时使用匿名映射
+    // 缓存文件映射后立即删除，进程退出时自动回收，多个测试同时运行互不影响
+    bool open(const std::string& cacheDir, size_t frameSize, size_t frameCount);
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    bool isFileBacked() const { return fileBacked_; }
+    size_t frameSize() const { return frameSize_; }
+    size_t slotSize() const { return slotSize_; }
+    size_t frameCount() const { return frameCount_; }
+
+    // 获取帧数据指针，越界返回nullptr
+    uint8_t* frame(size_t index);
+    const uint8_t* frame(size_t index) const;
+
+    // 帧生成完成后调用：按顺序读取提示，并预读第一个窗口
+    void adviseSequential() const;
+
+    // 顺序读取时调用：每跨过一个预读窗口，提示内核预读下一个窗口
+    void readAhead(size_t index) const;
+
+private:
+    void advise(size_t firstFrame, size_t count, int advice) const;
+
+    uint8_t* base_{nullptr};
+    size_t mappedSize_{0};
+    size_t frameSize_{0};
+    size_t slotSize_{0};
+    size_t frameCount_{0};
+    size_t readAheadFrames_{1};  // 预读窗口大小（帧）
+    bool fileBacked_{false};
+};
@@ -0,0 +1,538 @@
+#include "history_store.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'V', 'L', 'H', 'I', 'S', 'T', '\0', '\1'};
+constexpr uint32_t kVersion = 1;
+
+// 索引字段
+enum IndexField {
+    kCodecIndex = 1,
+    kPresetIndex = 2,
+    kRateControlIndex = 3,
+    kResolutionIndex = 4
+};
+
+int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 本地日期距Unix纪元的天数
+int64_t localDay(int64_t millis) {
+    const time_t seconds = static_cast<time_t>(millis / 1000);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    return static_cast<int64_t>(timegm(&local)) / 86400;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, bytes, size);
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 打开文件并加排他锁；加锁期间文件可能被erase替换，此时重新打开
+int openLocked(const std::string& path) {
+    for (;;) {
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return -1;
+        }
+        if (flock(fd, LOCK_EX) != 0) {
+            close(fd);
+            return -1;
+        }
+        struct stat opened{};
+        struct stat current{};
+        if (fstat(fd, &opened) == 0 && stat(path.c_str(), &current) == 0 &&
+            opened.st_ino == current.st_ino && opened.st_dev == current.st_dev) {
+            return fd;
+        }
+        close(fd);
+    }
+}
+
+}  // namespace
+
+void HistoryStore::Record::setOutputFile(const std::string& path) {
+    std::memset(outputFile, 0, sizeof(outputFile));
+    std::memcpy(outputFile, path.data(), std::min(path.size(), sizeof(outputFile) - 1));
+}
+
+HistoryStore::HistoryStore(std::string path)
+    : path_(std::move(path))
+{
+}
+
+HistoryStore::~HistoryStore() {
+    unmap();
+}
+
+std::string HistoryStore::defaultPath() {
+    if (const char* xdg = getenv("XDG_DATA_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/videolab/history.vlh";
+    }
+    const char* home = getenv("HOME");
+    return home ? std::string(home) + "/.local/share/videolab/history.vlh" : std::string("history.vlh");
+}
+
+uint32_t HistoryStore::checksum(const Record& record) {
+    // FNV-1a，覆盖checksum之前的全部字节
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(Record, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint64_t HistoryStore::indexKey(int field, int codec, int64_t value) {
+    return (static_cast<uint64_t>(field) << 56) | (static_cast<uint64_t>(codec & 0xff) << 48) |
+           (static_cast<uint64_t>(value) & 0xffffffffffffull);
+}
+
+bool HistoryStore::append(Record record) {
+    if (record.timestamp == 0) {
+        record.timestamp = nowMillis();
+    }
+    record.checksum = checksum(record);
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+
+    const int fd = openLocked(path_);
+    if (fd < 0) {
+        std::cerr << "无法打开编码历史: " << path_ << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    struct stat st{};
+    fstat(fd, &st);
+    off_t size = st.st_size;
+    if (size < static_cast<off_t>(sizeof(Header))) {
+        // 新文件：写入文件头
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.recordSize = sizeof(Record);
+        ok = ftruncate(fd, 0) == 0 && writeAll(fd, &header, sizeof(header));
+        size = sizeof(Header);
+    } else {
+        Header header{};
+        ok = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+             std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.recordSize == sizeof(Record);
+        if (!ok) {
+            std::cerr << "编码历史文件格式不符，不写入: " << path_ << std::endl;
+        }
+    }
+
+    // 上次写入中断留下的半条记录截掉，保证记录按定长对齐
+    const off_t aligned = sizeof(Header) + (size - static_cast<off_t>(sizeof(Header))) / sizeof(Record) * sizeof(Record);
+    if (ok && aligned != size) {
+        ok = ftruncate(fd, aligned) == 0;
+    }
+    if (ok) {
+        ok = pwrite(fd, &record, sizeof(record), aligned) == static_cast<ssize_t>(sizeof(record));
+    }
+    close(fd);
+    return ok;
+}
+
+bool HistoryStore::erase(int codec) {
+    const int fd = openLocked(path_);
+    if (fd < 0) {
+        return false;
+    }
+
+    // 在持有锁的文件上读取全部记录，保留其余编码器的记录写入临时文件后替换
+    struct stat st{};
+    fstat(fd, &st);
+    std::vector<Record> kept;
+    Header header{};
+    bool ok = true;
+    if (st.st_size >= static_cast<off_t>(sizeof(Header)) && codec >= 0) {
+        ok = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        const size_t count = (static_cast<size_t>(st.st_size) - sizeof(Header)) / sizeof(Record);
+        Record record;
+        for (size_t i = 0; ok && i < count; ++i) {
+            ok = pread(fd, &record, sizeof(record), static_cast<off_t>(sizeof(Header) + i * sizeof(Record))) ==
+                 static_cast<ssize_t>(sizeof(record));
+            if (ok && record.codec != codec && record.checksum == checksum(record)) {
+                kept.push_back(record);
+            }
+        }
+    } else {
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.recordSize = sizeof(Record);
+    }
+
+    const std::string temporary = path_ + ".tmp." + std::to_string(getpid());
+    if (ok) {
+        const int out = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        ok = out >= 0 && writeAll(out, &header, sizeof(header)) &&
+             (kept.empty() || writeAll(out, kept.data(), kept.size() * sizeof(Record)));
+        if (out >= 0) {
+            ok = close(out) == 0 && ok;
+        }
+        ok = ok && rename(temporary.c_str(), path_.c_str()) == 0;
+        if (!ok) {
+            unlink(temporary.c_str());
+        }
+    }
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmap();
+    return ok;
+}
+
+void HistoryStore::unmap() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), mappedSize_);
+    }
+    data_ = nullptr;
+    mappedSize_ = 0;
+    count_ = 0;
+    indexed_ = 0;
+    monotonic_ = true;
+    valid_.clear();
+    index_.clear();
+}
+
+bool HistoryStore::refresh() {
+    struct stat st{};
+    if (stat(path_.c_str(), &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        unmap();
+        return true;
+    }
+
+    const size_t fileSize = static_cast<size_t>(st.st_size);
+    if (data_ && (fileSize < mappedSize_ || static_cast<uint64_t>(st.st_ino) != inode_)) {
+        // 文件被erase替换，重新建立索引
+        unmap();
+    }
+
+    if (fileSize != mappedSize_) {
+        const int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        void* data = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        const auto* header = static_cast<const Header*>(data);
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->recordSize != sizeof(Record)) {
+            munmap(data, fileSize);
+            std::cerr << "编码历史文件格式不符: " << path_ << std::endl;
+            return false;
+        }
+
+        if (data_) {
+            munmap(const_cast<uint8_t*>(data_), mappedSize_);
+        }
+        data_ = static_cast<const uint8_t*>(data);
+        mappedSize_ = fileSize;
+        inode_ = static_cast<uint64_t>(st.st_ino);
+        count_ = (fileSize - sizeof(Header)) / sizeof(Record);
+        madvise(data, fileSize, MADV_RANDOM);
+    }
+
+    // 增量建立索引
+    valid_.resize(count_, 0);
+    for (size_t i = indexed_; i < count_; ++i) {
+        const Record& record = at(i);
+        if (record.checksum != checksum(record)) {
+            continue;
+        }
+        valid_[i] = 1;
+        const auto id = static_cast<uint32_t>(i);
+        index_[indexKey(kCodecIndex, 0, record.codec)].push_back(id);
+        index_[indexKey(kPresetIndex, record.codec, record.preset)].push_back(id);
+        index_[indexKey(kRateControlIndex, record.codec, record.rateControl)].push_back(id);
+        index_[indexKey(kResolutionIndex, 0, (record.width << 16) | record.height)].push_back(id);
+        if (i > 0 && valid_[i - 1] && record.timestamp < at(i - 1).timestamp) {
+            monotonic_ = false;
+        }
+    }
+    indexed_ = count_;
+    return true;
+}
+
+size_t HistoryStore::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh();
+    return count_;
+}
+
+const HistoryStore::Record& HistoryStore::at(size_t index) const {
+    return reinterpret_cast<const Record*>(data_ + sizeof(Header))[index];
+}
+
+bool HistoryStore::matches(const Record& record, const Filter& filter) const {
+    return (filter.codec < 0 || record.codec == filter.codec) &&
+           (filter.preset < 0 || record.preset == filter.preset) &&
+           (filter.rateControl < 0 || record.rateControl == filter.rateControl) &&
+           (filter.width <= 0 || record.width == filter.width) &&
+           (filter.height <= 0 || record.height == filter.height) &&
+           record.timestamp >= filter.from && record.timestamp < filter.to;
+}
+
+std::vector<uint32_t> HistoryStore::queryLocked(const Filter& filter, size_t limit) {
+    refresh();
+
+    // 候选集：设置的等值条件中最短的倒排表；都没有设置时为全部记录（时间戳递增时按二分缩小范围）
+    static const std::vector<uint32_t> kEmpty;
+    const std::vector<uint32_t>* candidates = nullptr;
+    auto consider = [&](bool enabled, uint64_t key) {
+        if (!enabled) {
+            return;
+        }
+        auto it = index_.find(key);
+        const std::vector<uint32_t>* list = it == index_.end() ? &kEmpty : &it->second;
+        if (!candidates || list->size() < candidates->size()) {
+            candidates = list;
+        }
+    };
+    consider(filter.codec >= 0, indexKey(kCodecIndex, 0, filter.codec));
+    consider(filter.codec >= 0 && filter.preset >= 0, indexKey(kPresetIndex, filter.codec, filter.preset));
+    consider(filter.codec >= 0 && filter.rateControl >= 0,
+             indexKey(kRateControlIndex, filter.codec, filter.rateControl));
+    consider(filter.width > 0 && filter.height > 0,
+             indexKey(kResolutionIndex, 0, (filter.width << 16) | filter.height));
+
+    std::vector<uint32_t> result;
+    auto collect = [&](uint32_t id) {
+        if (valid_[id] && matches(at(id), filter)) {
+            result.push_back(id);
+        }
+    };
+
+    if (candidates) {
+        for (uint32_t id : *candidates) {
+            collect(id);
+        }
+    } else {
+        size_t begin = 0;
+        size_t end = count_;
+        if (monotonic_) {
+            // 第一条时间戳不小于t的记录
+            auto lowerBound = [this](int64_t t) {
+                size_t lo = 0;
+                size_t hi = count_;
+                while (lo < hi) {
+                    const size_t mid = (lo + hi) / 2;
+                    if (at(mid).timestamp < t) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                return lo;
+            };
+            begin = lowerBound(filter.from);
+            end = lowerBound(filter.to);
+        }
+        for (size_t i = begin; i < end; ++i) {
+            collect(static_cast<uint32_t>(i));
+        }
+    }
+
+    if (limit > 0 && result.size() > limit) {
+        result.erase(result.begin(), result.end() - static_cast<std::ptrdiff_t>(limit));
+    }
+    return result;
+}
+
+std::vector<uint32_t> HistoryStore::query(const Filter& filter, size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queryLocked(filter, limit);
+}
+
+HistoryStore::Aggregate HistoryStore::aggregate(const Filter& filter) {
+    auto groups = aggregateBy(filter, GroupBy::Preset);
+    Aggregate total;
+    double fps = 0, bitrate = 0, psnr = 0, ssim = 0;
+    for (const auto& group : groups) {
+        const Aggregate& a = group.second;
+        if (total.count == 0) {
+            total.minBitrate = a.minBitrate;
+        }
+        fps += a.meanFps * a.count;
+        bitrate += a.meanBitrate * a.count;
+        psnr += a.meanPsnr * a.count;
+        ssim += a.meanSsim * a.count;
+        total.count += a.count;
+        total.maxPsnr = std::max(total.maxPsnr, a.maxPsnr);
+        total.maxSsim = std::max(total.maxSsim, a.maxSsim);
+        total.minBitrate = std::min(total.minBitrate, a.minBitrate);
+        total.maxBitrate = std::max(total.maxBitrate, a.maxBitrate);
+    }
+    if (total.count > 0) {
+        total.meanFps = fps / total.count;
+        total.meanBitrate = bitrate / total.count;
+        total.meanPsnr = psnr / total.count;
+        total.meanSsim = ssim / total.count;
+    }
+    return total;
+}
+
+std::vector<std::pair<int64_t, HistoryStore::Aggregate>> HistoryStore::aggregateBy(const Filter& filter,
+                                                                                   GroupBy group) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::vector<uint32_t> ids = queryLocked(filter, 0);
+
+    // 先累加总和，最后除以个数得到均值；按键排序输出
+    std::vector<std::pair<int64_t, Aggregate>> groups;
+    std::unordered_map<int64_t, size_t> slots;
+    for (uint32_t id : ids) {
+        const Record& record = at(id);
+        int64_t key = 0;
+        switch (group) {
+            case GroupBy::Preset: key = record.preset; break;
+            case GroupBy::RateControl: key = record.rateControl; break;
+            case GroupBy::Resolution: key = (static_cast<int64_t>(record.width) << 16) | record.height; break;
+            case GroupBy::Day: key = localDay(record.timestamp); break;
+        }
+
+        auto slot = slots.find(key);
+        if (slot == slots.end()) {
+            slot = slots.emplace(key, groups.size()).first;
+            Aggregate first;
+            first.minBitrate = record.bitrate;
+            groups.emplace_back(key, first);
+        }
+        Aggregate& a = groups[slot->second].second;
+        ++a.count;
+        a.meanFps += record.fps;
+        a.meanBitrate += record.bitrate;
+        a.meanPsnr += record.psnr;
+        a.meanSsim += record.ssim;
+        a.maxPsnr = std::max(a.maxPsnr, record.psnr);
+        a.maxSsim = std::max(a.maxSsim, record.ssim);
+        a.minBitrate = std::min(a.minBitrate, record.bitrate);
+        a.maxBitrate = std::max(a.maxBitrate, record.bitrate);
+    }
+
+    for (auto& entry : groups) {
+        Aggregate& a = entry.second;
+        a.meanFps /= a.count;
+        a.meanBitrate /= a.count;
+        a.meanPsnr /= a.count;
+        a.meanSsim /= a.count;
+    }
+    std::sort(groups.begin(), groups.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return groups;
+}
+
+HistoryStore::Record HistoryStore::fromX264(const X264ParamTest::TestConfig& config,
+                                            const X264ParamTest::TestResult& result) {
+    Record record;
+    record.codec = static_cast<uint8_t>(Codec::X264);
+    record.preset = static_cast<uint8_t>(config.preset);
+    record.tune = static_cast<uint8_t>(config.tune);
+    record.rateControl = static_cast<uint8_t>(config.rateControl);
+    record.width = static_cast<uint16_t>(config.width);
+    record.height = static_cast<uint16_t>(config.height);
+    record.frameCount = config.frameCount;
+    record.threads = config.threads;
+    record.rateValue = config.crf;
+    record.keyint = config.keyintMax;
+    record.bframes = config.bframes;
+    record.refs = config.refs;
+    record.meRange = config.meRange;
+    record.flags = (config.fastFirstPass ? FastFirstPass : 0u) | (config.weightedPred ? WeightedPred : 0u) |
+                   (config.cabac ? Cabac : 0u) | (config.zeroCopy ? ZeroCopy : 0u);
+    record.encodingTime = result.encodingTime;
+    record.fps = result.fps;
+    record.bitrate = result.bitrate;
+    record.psnr = result.psnr;
+    record.ssim = result.ssim;
+    record.setOutputFile(result.outputFile);
+    return record;
+}
+
+HistoryStore::Record HistoryStore::fromX265(const X265ParamTest::TestConfig& config,
+                                            const X265ParamTest::TestResult& result) {
+    using RateControl = X265ParamTest::RateControl;
+
+    Record record;
+    record.codec = static_cast<uint8_t>(Codec::X265);
+    record.preset = static_cast<uint8_t>(config.preset);
+    record.tune = static_cast<uint8_t>(config.tune);
+    record.rateControl = static_cast<uint8_t>(config.rateControl);
+    record.width = static_cast<uint16_t>(config.width);
+    record.height = static_cast<uint16_t>(config.height);
+    record.frameCount = config.frameCount;
+    record.threads = config.threads;
+    switch (config.rateControl) {
+        case RateControl::CRF: record.rateValue = config.crf; break;
+        case RateControl::CQP: record.rateValue = config.qp; break;
+        case RateControl::ABR:
+        case RateControl::CBR: record.rateValue = config.bitrate * 1000; break;  // kbps转为bps
+    }
+    record.keyint = config.keyintMax;
+    record.bframes = config.bFrames ? config.bFrameCount : 0;
+    record.refs = config.refFrames;
+    record.flags = (config.weightedPred ? WeightedPred : 0u) | (config.zeroCopy ? ZeroCopy : 0u);
+    record.encodingTime = result.encodingTime;
+    record.fps = result.fps;
+    record.bitrate = result.bitrate;
+    record.psnr = result.psnr;
+    record.ssim = result.ssim;
+    record.setOutputFile(result.outputFile);
+    return record;
+}
+
+HistoryStore::Record HistoryStore::fromVp8(const VP8ParamTest::TestConfig& config,
+                                           const VP8ParamTest::TestResult& result) {
+    Record record;
+    record.codec = static_cast<uint8_t>(Codec::VP8);
+    record.preset = static_cast<uint8_t>(config.preset);
+    record.tune = static_cast<uint8_t>(config.speed);
+    record.rateControl = static_cast<uint8_t>(config.rate_control);
+    record.width = static_cast<uint16_t>(config.width);
+    record.height = static_cast<uint16_t>(config.height);
+    record.frameCount = config.frames;
+    record.threads = config.threads;
+    record.rateValue = config.rate_control == VP8ParamTest::RateControl::CQ ? config.cq_level : config.bitrate;
+    record.keyint = config.keyint;
+    record.qmin = config.qmin;
+    record.qmax = config.qmax;
+    record.flags = config.zero_copy ? ZeroCopy : 0u;
+    record.encodingTime = result.encoding_time;
+    record.fps = result.fps;
+    record.bitrate = result.bitrate;
+    record.psnr = result.psnr;
+    record.ssim = result.ssim;
+    return record;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vp8_param_test.hpp"
+#include "x264_param_test.hpp"
+#include "x265_param_test.hpp"
+
+// 编码历史：只追加的定长二进制日志，读取时映射到内存
+// 界面、命令行扫描写入同一个文件；追加时加文件锁，读取方发现文件变长后重新映射并增量建立索引
+// 索引（编码器、预设、码率控制、分辨率）只在内存中，首次查询时建立，数万条记录只需几毫秒
+class HistoryStore {
+public:
+    enum class Codec : uint8_t {
+        X264 = 1,
+        X265 = 2,
+        VP8 = 3
+    };
+
+    // Record::flags中的位
+    static constexpr uint32_t FastFirstPass = 1u << 0;
+    static constexpr uint32_t WeightedPred = 1u << 1;
+    static constexpr uint32_t Cabac = 1u << 2;
+    static constexpr uint32_t ZeroCopy = 1u << 3;
+
+    // 定长记录，按文件中的布局排列，不同编码器的枚举取各自TestConfig中的序号
+    struct Record {
+        int64_t timestamp{0};     // Unix时间，毫秒
+        uint8_t codec{0};
+        uint8_t preset{0};
+        uint8_t tune{0};          // x264/x265为Tune，VP8为speed
+        uint8_t rateControl{0};
+        uint16_t width{0};
+        uint16_t height{0};
+        int32_t frameCount{0};
+        int32_t threads{0};
+        int32_t rateValue{0};     // CRF/QP/码率(bps)/CQ，取决于rateControl
+        int32_t keyint{0};
+        int32_t bframes{0};
+        int32_t refs{0};
+        int32_t meRange{0};
+        int32_t qmin{0};
+        int32_t qmax{0};
+        uint32_t flags{0};
+        double encodingTime{0.0};
+        double fps{0.0};
+        double bitrate{0.0};      // bps
+        double psnr{0.0};
+        double ssim{0.0};
+        char outputFile[152]{};   // 超长的路径被截断
+        uint32_t reserved{0};
+        uint32_t checksum{0};     // 前面所有字节的校验，写入一半的记录在读取时被跳过
+
+        void setOutputFile(const std::string& path);
+    };
+    static_assert(sizeof(Record) == 256, "历史记录必须是定长的256字节");
+
+    // 查询条件，未设置的条件不参与过滤
+    struct Filter {
+        int codec{-1};
+        int preset{-1};
+        int rateControl{-1};
+        int width{0};
+        int height{0};
+        int64_t from{0};                                      // 起始时间（毫秒，含）
+        int64_t to{std::numeric_limits<int64_t>::max()};      // 结束时间（毫秒，不含）
+    };
+
+    struct Aggregate {
+        size_t count{0};
+        double meanFps{0.0};
+        double meanBitrate{0.0};
+        double meanPsnr{0.0};
+        double meanSsim{0.0};
+        double maxPsnr{0.0};
+        double maxSsim{0.0};
+        double minBitrate{0.0};
+        double maxBitrate{0.0};
+    };
+
+    enum class GroupBy {
+        Preset,
+        RateControl,
+        Resolution,  // 键为 width << 16 | height
+        Day          // 键为本地日期的天数（Unix纪元起）
+    };
+
+    explicit HistoryStore(std::string path = defaultPath());
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    // $XDG_DATA_HOME/videolab/history.vlh，未设置时为~/.local/share/videolab/history.vlh
+    static std::string defaultPath();
+
+    const std::string& path() const { return path_; }
+
+    // 追加一条记录，timestamp为0时填入当前时间
+    bool append(Record record);
+
+    // 删除一个编码器的全部记录（codec为-1时删除全部），重写文件后替换
+    bool erase(int codec = -1);
+
+    // 文件中的记录数（包括校验失败的记录）
+    size_t size();
+    const Record& at(size_t index) const;
+
+    // 满足条件的记录下标，按写入顺序；limit不为0时只返回最新的limit条
+    std::vector<uint32_t> query(const Filter& filter, size_t limit = 0);
+    Aggregate aggregate(const Filter& filter);
+    std::vector<std::pair<int64_t, Aggregate>> aggregateBy(const Filter& filter, GroupBy group);
+
+    static Record fromX264(const X264ParamTest::TestConfig& config, const X264ParamTest::TestResult& result);
+    static Record fromX265(const X265ParamTest::TestConfig& config, const X265ParamTest::TestResult& result);
+    static Record fromVp8(const VP8ParamTest::TestConfig& config, const VP8ParamTest::TestResult& result);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint8_t reserved[48];
+    };
+    static_assert(sizeof(Header) == 64, "文件头必须是64字节");
+
+    static uint32_t checksum(const Record& record);
+    static uint64_t indexKey(int field, int codec, int64_t value);
+
+    // 文件变长时重新映射，并为新增的记录建立索引；调用方持有mutex_
+    bool refresh();
+    void unmap();
+    bool matches(const Record& record, const Filter& filter) const;
+    std::vector<uint32_t> queryLocked(const Filter& filter, size_t limit);
+
+    std::string path_;
+    std::mutex mutex_;
+    const uint8_t* data_{nullptr};
+    size_t mappedSize_{0};
+    uint64_t inode_{0};     // 已映射文件的inode，文件被替换时重新映射
+    size_t count_{0};       // 已映射的完整记录数
+    size_t indexed_{0};     // 已建立索引的记录数
+    bool monotonic_{true};  // 时间戳是否按写入顺序递增，是则时间范围用二分查找
+    std::vector<uint8_t> valid_;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> index_;
+};
@@ -0,0 +1,163 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+size_t LatencyHistogram::bucketIndex(uint64_t nanos) {
+    if (nanos < kSubBucketCount) {
+        return static_cast<size_t>(nanos);
+    }
+
+    // 最高的kSubBucketBits位作为尾数，其余位数作为指数
+    const int msb = 63 - __builtin_clzll(nanos);
+    const int shift = msb - (kSubBucketBits - 1);
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    const uint64_t mantissa = nanos >> shift;  // [64, 128)
+    return static_cast<size_t>(kSubBucketCount + (shift - 1) * kSubBucketHalf + (mantissa - kSubBucketHalf));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const uint64_t offset = index - kSubBucketCount;
+    const int shift = static_cast<int>(offset / kSubBucketHalf) + 1;
+    const uint64_t mantissa = kSubBucketHalf + offset % kSubBucketHalf;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    ++counts_[bucketIndex(nanos)];
+    ++count_;
+    sum_ += nanos;
+    min_ = std::min(min_, nanos);
+    max_ = std::max(max_, nanos);
+}
+
+void LatencyHistogram::recordSeconds(double seconds) {
+    record(seconds > 0.0 ? static_cast<uint64_t>(std::llround(seconds * 1e9)) : 0);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram();
+}
+
+double LatencyHistogram::mean() const {
+    return count_ > 0 ? static_cast<double>(sum_) / count_ / 1e9 : 0.0;
+}
+
+double LatencyHistogram::min() const {
+    return count_ > 0 ? min_ / 1e9 : 0.0;
+}
+
+double LatencyHistogram::max() const {
+    return max_ / 1e9;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+
+    // 第rank个样本（从1开始）所在的桶
+    p = std::clamp(p, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            // 桶上界不超过实际最大值
+            return std::min(bucketUpperBound(i), max_) / 1e9;
+        }
+    }
+    return max_ / 1e9;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Summary s;
+    s.count = count_;
+    s.mean = mean();
+    s.min = min();
+    s.p50 = percentile(50.0);
+    s.p90 = percentile(90.0);
+    s.p99 = percentile(99.0);
+    s.p999 = percentile(99.9);
+    s.max = max();
+    return s;
+}
+
+std::string LatencyHistogram::format() const {
+    const Summary s = summary();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3)
+        << "n=" << s.count
+        << " avg=" << s.mean * 1000
+        << " p50=" << s.p50 * 1000
+        << " p90=" << s.p90 * 1000
+        << " p99=" << s.p99 * 1000
+        << " p99.9=" << s.p999 * 1000
+        << " max=" << s.max * 1000 << " ms";
+    return out.str();
+}
+
+std::string LatencyHistogram::serialize() const {
+    std::ostringstream out;
+    out << count_ << ' ' << sum_ << ' ' << min_ << ' ' << max_ << ' ';
+    bool first = true;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        if (counts_[i] == 0) {
+            continue;
+        }
+        if (!first) {
+            out << ',';
+        }
+        out << i << ':' << counts_[i];
+        first = false;
+    }
+    return out.str();
+}
+
+bool LatencyHistogram::deserialize(const std::string& text) {
+    LatencyHistogram parsed;
+    std::istringstream in(text);
+    if (!(in >> parsed.count_ >> parsed.sum_ >> parsed.min_ >> parsed.max_)) {
+        return false;
+    }
+
+    // 桶列表可以为空（没有样本）
+    std::string buckets;
+    in >> buckets;
+    std::istringstream list(buckets);
+    std::string item;
+    uint64_t total = 0;
+    while (std::getline(list, item, ',')) {
+        size_t index = 0;
+        unsigned long long count = 0;
+        if (std::sscanf(item.c_str(), "%zu:%llu", &index, &count) != 2 || index >= kBucketCount) {
+            return false;
+        }
+        parsed.counts_[index] = count;
+        total += count;
+    }
+    if (total != parsed.count_) {
+        return false;
+    }
+
+    *this = parsed;
+    return true;
+}
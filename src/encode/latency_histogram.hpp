@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// 对数线性延迟直方图（HDR Histogram的简化形式）
+// 每个2的幂区间再线性分为64个子桶，相对误差不超过1/64，记录范围1ns到约73分钟
+// 记录为O(1)，不分配内存；同一配置的直方图可直接合并
+// 非线程安全，每个线程记录自己的直方图，结束后合并
+class LatencyHistogram {
+public:
+    // 常用分位数汇总，单位秒
+    struct Summary {
+        uint64_t count{0};
+        double mean{0.0};
+        double min{0.0};
+        double p50{0.0};
+        double p90{0.0};
+        double p99{0.0};
+        double p999{0.0};
+        double max{0.0};
+    };
+
+    void record(uint64_t nanos);
+    void recordSeconds(double seconds);
+
+    // 合并另一个直方图的全部样本
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double mean() const;
+    double min() const;
+    double max() const;
+
+    // 分位数（0-100），返回所在桶的上界，单位秒
+    double percentile(double p) const;
+
+    Summary summary() const;
+
+    // 单行文本：count/mean/p50/p90/p99/p99.9/max，单位毫秒
+    std::string format() const;
+
+    // 无损的紧凑文本形式，只列出非空桶："count sum min max 桶:计数,..."，用于结果缓存
+    std::string serialize() const;
+    bool deserialize(const std::string& text);
+
+private:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr uint64_t kSubBucketCount = 1ull << kSubBucketBits;     // 线性区间[0, 128)
+    static constexpr uint64_t kSubBucketHalf = kSubBucketCount / 2;         // 每个对数区间的子桶数
+    static constexpr int kMaxShift = 36;                                    // 最大记录值约2^42ns
+    static constexpr size_t kBucketCount = kSubBucketCount + kMaxShift * kSubBucketHalf;
+
+    static size_t bucketIndex(uint64_t nanos);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<uint64_t, kBucketCount> counts_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t min_{UINT64_MAX};
+    uint64_t max_{0};
+};
@@ -0,0 +1,492 @@
+#include "output_sink.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "direct_writer.hpp"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double threadCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec * 1e-9;
+}
+
+DirectFileWriter::Options writerOptions(uint64_t expectedBytes) {
+    DirectFileWriter::Options options;
+    options.preallocate = expectedBytes;
+    return options;
+}
+
+void copyWriterStats(const DirectFileWriter& writer, OutputSink::Stats& stats) {
+    stats.ioWaitTime = writer.stats().waitTime;
+    stats.directIo = writer.stats().directIo;
+    stats.ioUring = writer.stats().ioUring;
+}
+
+std::string errorString(int err) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, errbuf, sizeof(errbuf));
+    return errbuf;
+}
+
+uint64_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+class NullSink : public OutputSink {
+public:
+    NullSink() : OutputSink(Kind::Null) {}
+
+protected:
+    bool doOpen(const AVCodecContext*, const std::string&, uint64_t) override { return true; }
+    bool doWrite(AVPacket*) override { return true; }
+    bool doClose() override { return true; }
+};
+
+// 数据按到达顺序追加到一块连续内存，只计复制和扩容的开销
+class MemorySink : public OutputSink {
+public:
+    MemorySink() : OutputSink(Kind::Memory) {}
+
+protected:
+    bool doOpen(const AVCodecContext* encoder, const std::string&, uint64_t) override {
+        buffer_.clear();
+        // 按目标码率预留约10秒的数据，CRF等模式下由vector自行扩容
+        if (encoder->bit_rate > 0) {
+            buffer_.reserve(static_cast<size_t>(encoder->bit_rate / 8 * 10));
+        }
+        return true;
+    }
+
+    bool doWrite(AVPacket* packet) override {
+        buffer_.insert(buffer_.end(), packet->data, packet->data + packet->size);
+        return true;
+    }
+
+    bool doClose() override {
+        std::vector<uint8_t>().swap(buffer_);
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+// 原始码流直接写入文件，关闭时fdatasync，计入写盘开销
+// H.264等为Annex B码流直接拼接；VP8/VP9没有起始码，按IVF格式加上文件头和帧头
+// direct时由DirectFileWriter合并成大块写入
+class FileSink : public OutputSink {
+public:
+    explicit FileSink(bool direct) : OutputSink(Kind::File), direct_(direct) {}
+    ~FileSink() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+protected:
+    bool doOpen(const AVCodecContext* encoder, const std::string& path, uint64_t expectedBytes) override {
+        path_ = path;
+        if (direct_) {
+            if (!writer_.open(path, writerOptions(expectedBytes))) {
+                return false;
+            }
+        } else {
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd_ < 0) {
+                std::cerr << "无法打开输出文件: " << path << " - " << std::strerror(errno) << std::endl;
+                return false;
+            }
+        }
+
+        const char* fourcc = encoder->codec_id == AV_CODEC_ID_VP8 ? "VP80"
+                           : encoder->codec_id == AV_CODEC_ID_VP9 ? "VP90"
+                           : nullptr;
+        ivf_ = fourcc != nullptr;
+        ivfFrames_ = 0;
+        if (!ivf_) {
+            return true;
+        }
+
+        // IVF文件头：32字节，小端；帧数在关闭时回写
+        uint8_t header[32] = {'D', 'K', 'I', 'F'};
+        putLe(header + 4, 0, 2);    // 版本
+        putLe(header + 6, 32, 2);   // 文件头长度
+        std::memcpy(header + 8, fourcc, 4);
+        putLe(header + 12, static_cast<uint64_t>(encoder->width), 2);
+        putLe(header + 14, static_cast<uint64_t>(encoder->height), 2);
+        putLe(header + 16, static_cast<uint64_t>(encoder->time_base.den), 4);
+        putLe(header + 20, static_cast<uint64_t>(encoder->time_base.num), 4);
+        putLe(header + 24, 0, 4);
+        putLe(header + 28, 0, 4);
+        return append(header, sizeof(header));
+    }
+
+    bool doWrite(AVPacket* packet) override {
+        if (ivf_) {
+            // IVF帧头：4字节帧长 + 8字节pts（编码器时间基）
+            uint8_t header[12];
+            putLe(header, static_cast<uint64_t>(packet->size), 4);
+            putLe(header + 4, static_cast<uint64_t>(packet->pts), 8);
+            if (!append(header, sizeof(header))) {
+                return false;
+            }
+            ++ivfFrames_;
+        }
+        return append(packet->data, static_cast<size_t>(packet->size));
+    }
+
+    bool doClose() override {
+        bool ok = true;
+        if (ivf_) {
+            uint8_t frames[4];
+            putLe(frames, ivfFrames_, 4);
+            ok = writeAt(24, frames, sizeof(frames));
+        }
+
+        if (direct_) {
+            ok = writer_.close() && ok;
+            copyWriterStats(writer_, stats_);
+            stats_.fileBytes = fileSize(path_);
+            return ok;
+        }
+        if (fdatasync(fd_) != 0) {
+            std::cerr << "同步输出文件失败: " << std::strerror(errno) << std::endl;
+            ok = false;
+        }
+        ok = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+        stats_.fileBytes = fileSize(path_);
+        return ok;
+    }
+
+private:
+    static void putLe(uint8_t* dst, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            dst[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    bool append(const uint8_t* data, size_t size) {
+        if (direct_) {
+            return writer_.append(data, size);
+        }
+        while (size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "写入输出文件失败: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t size) {
+        if (direct_) {
+            return writer_.write(offset, data, size);
+        }
+        if (pwrite(fd_, data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+            std::cerr << "回写输出文件失败: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool direct_;
+    DirectFileWriter writer_;
+    int fd_{-1};
+    std::string path_;
+    bool ivf_{false};
+    uint64_t ivfFrames_{0};
+};
+
+// 由libavformat按扩展名选择封装格式，时间戳在此从编码器时间基转换到流的时间基
+// direct时复用器通过自定义AVIOContext写入DirectFileWriter，回写文件头等随机写入由它处理
+class MuxSink : public OutputSink {
+public:
+    MuxSink(bool direct, Mp4Mode mp4Mode) : OutputSink(Kind::Mux), direct_(direct), mp4Mode_(mp4Mode) {}
+    ~MuxSink() override { release(); }
+
+protected:
+    bool doOpen(const AVCodecContext* encoder, const std::string& path, uint64_t expectedBytes) override {
+        int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, nullptr, path.c_str());
+        if (ret < 0 || !formatCtx_) {
+            std::cerr << "无法推断输出格式: " << path << std::endl;
+            return false;
+        }
+
+        AVDictionary* options = nullptr;
+        const bool mp4 = applyMp4Mode(mp4Mode_, formatCtx_, &options);
+        customIo_ = direct_;
+        if (customIo_ && mp4 && mp4Mode_ == Mp4Mode::FastStart) {
+            // faststart在写文件尾时按路径重新读取整个文件，批量写入的缓冲中的数据对它不可见
+            std::cerr << "faststart输出不支持批量写入，改用普通写入" << std::endl;
+            customIo_ = false;
+        }
+
+        if (customIo_) {
+            if (!writer_.open(path, writerOptions(expectedBytes))) {
+                av_dict_free(&options);
+                return false;
+            }
+            auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+            if (!buffer) {
+                std::cerr << "无法分配输出缓冲区" << std::endl;
+                av_dict_free(&options);
+                return false;
+            }
+            formatCtx_->pb = avio_alloc_context(buffer, kAvioBufferSize, 1, this, nullptr, writePacket, seek);
+            if (!formatCtx_->pb) {
+                av_free(buffer);
+                std::cerr << "无法创建输出上下文" << std::endl;
+                av_dict_free(&options);
+                return false;
+            }
+            formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+            position_ = 0;
+        } else {
+            ret = avio_open(&formatCtx_->pb, path.c_str(), AVIO_FLAG_WRITE);
+            if (ret < 0) {
+                std::cerr << "无法打开输出文件: " << path << " - " << errorString(ret) << std::endl;
+                av_dict_free(&options);
+                return false;
+            }
+        }
+
+        stream_ = avformat_new_stream(formatCtx_, nullptr);
+        ret = stream_ ? avcodec_parameters_from_context(stream_->codecpar, encoder) : AVERROR(ENOMEM);
+        if (ret < 0) {
+            std::cerr << "无法创建视频流" << std::endl;
+            av_dict_free(&options);
+            return false;
+        }
+        stream_->time_base = encoder->time_base;
+        timeBase_ = encoder->time_base;
+
+        ret = avformat_write_header(formatCtx_, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            std::cerr << "无法写入文件头: " << errorString(ret) << std::endl;
+            return false;
+        }
+        path_ = path;
+        return true;
+    }
+
+    bool doWrite(AVPacket* packet) override {
+        packet->stream_index = stream_->index;
+        av_packet_rescale_ts(packet, timeBase_, stream_->time_base);
+        // 复用器接管数据包的引用
+        int ret = av_interleaved_write_frame(formatCtx_, packet);
+        if (ret < 0) {
+            std::cerr << "写入数据包失败: " << errorString(ret) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool doClose() override {
+        bool ok = true;
+        int ret = av_write_trailer(formatCtx_);
+        if (ret < 0) {
+            std::cerr << "写入文件尾失败: " << errorString(ret) << std::endl;
+            ok = false;
+        }
+        release();
+
+        if (customIo_) {
+            ok = writer_.close() && ok;
+            copyWriterStats(writer_, stats_);
+            stats_.fileBytes = fileSize(path_);
+            return ok;
+        }
+
+        // avio没有暴露文件描述符，重新打开后同步同一个文件
+        int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || fdatasync(fd) != 0) {
+            std::cerr << "同步输出文件失败: " << std::strerror(errno) << std::endl;
+            ok = false;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        stats_.fileBytes = fileSize(path_);
+        return ok;
+    }
+
+private:
+    static constexpr int kAvioBufferSize = 256 * 1024;
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    static int writePacket(void* opaque, const uint8_t* data, int size) {
+#else
+    static int writePacket(void* opaque, uint8_t* data, int size) {
+#endif
+        auto* self = static_cast<MuxSink*>(opaque);
+        if (!self->writer_.write(static_cast<uint64_t>(self->position_), data, static_cast<size_t>(size))) {
+            return AVERROR(EIO);
+        }
+        self->position_ += size;
+        return size;
+    }
+
+    static int64_t seek(void* opaque, int64_t offset, int whence) {
+        auto* self = static_cast<MuxSink*>(opaque);
+        const int64_t size = static_cast<int64_t>(self->writer_.size());
+        if (whence & AVSEEK_SIZE) {
+            return size;
+        }
+        switch (whence & ~AVSEEK_FORCE) {
+            case SEEK_SET: self->position_ = offset; break;
+            case SEEK_CUR: self->position_ += offset; break;
+            case SEEK_END: self->position_ = size + offset; break;
+            default: return AVERROR(EINVAL);
+        }
+        return self->position_;
+    }
+
+    void release() {
+        if (formatCtx_) {
+            if (formatCtx_->pb && customIo_) {
+                // 自定义AVIOContext的缓冲可能已被重新分配，按上下文中的指针释放
+                av_freep(&formatCtx_->pb->buffer);
+                avio_context_free(&formatCtx_->pb);
+            } else if (formatCtx_->pb) {
+                avio_closep(&formatCtx_->pb);
+            }
+            avformat_free_context(formatCtx_);
+            formatCtx_ = nullptr;
+        }
+        stream_ = nullptr;
+    }
+
+    bool direct_;
+    Mp4Mode mp4Mode_;
+    bool customIo_{false};  // 实际通过DirectFileWriter写入
+    DirectFileWriter writer_;
+    int64_t position_{0};
+    AVFormatContext* formatCtx_{nullptr};
+    AVStream* stream_{nullptr};
+    AVRational timeBase_{1, 25};
+    std::string path_;
+};
+
+}  // namespace
+
+std::unique_ptr<OutputSink> OutputSink::create(Kind kind, bool directWriter, Mp4Mode mp4Mode) {
+    switch (kind) {
+        case Kind::Null:   return std::make_unique<NullSink>();
+        case Kind::Memory: return std::make_unique<MemorySink>();
+        case Kind::File:   return std::make_unique<FileSink>(directWriter);
+        case Kind::Mux:    return std::make_unique<MuxSink>(directWriter, mp4Mode);
+    }
+    return nullptr;
+}
+
+const char* OutputSink::kindToString(Kind kind) {
+    switch (kind) {
+        case Kind::Null:   return "null";
+        case Kind::Memory: return "memory";
+        case Kind::File:   return "file";
+        case Kind::Mux:    return "mux";
+        default:           return "unknown";
+    }
+}
+
+const char* OutputSink::mp4ModeToString(Mp4Mode mode) {
+    switch (mode) {
+        case Mp4Mode::Standard:   return "standard";
+        case Mp4Mode::Fragmented: return "fragmented";
+        case Mp4Mode::FastStart:  return "faststart";
+        default:                  return "unknown";
+    }
+}
+
+bool OutputSink::needsGlobalHeader(Kind kind, const std::string& path) {
+    if (kind != Kind::Mux || path.empty()) {
+        return false;
+    }
+    const AVOutputFormat* format = av_guess_format(nullptr, path.c_str(), nullptr);
+    return format && (format->flags & AVFMT_GLOBALHEADER);
+}
+
+bool OutputSink::applyMp4Mode(Mp4Mode mode, AVFormatContext* formatCtx, AVDictionary** options) {
+    const char* name = formatCtx && formatCtx->oformat ? formatCtx->oformat->name : nullptr;
+    if (!name || (std::strcmp(name, "mp4") != 0 && std::strcmp(name, "mov") != 0)) {
+        return false;
+    }
+    switch (mode) {
+        case Mp4Mode::Standard:
+            break;
+        case Mp4Mode::Fragmented:
+            // 在每个关键帧处开始新分片；分片写完后立即交给文件，而不是留在avio缓冲中
+            av_dict_set(options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+            formatCtx->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+            break;
+        case Mp4Mode::FastStart:
+            av_dict_set(options, "movflags", "faststart", 0);
+            break;
+    }
+    return true;
+}
+
+bool OutputSink::open(const AVCodecContext* encoder, const std::string& path, uint64_t expectedBytes) {
+    if (writesFile(kind_) && path.empty()) {
+        std::cerr << "输出方式 " << kindToString(kind_) << " 需要输出文件" << std::endl;
+        return false;
+    }
+    stats_ = Stats();
+    auto start = std::chrono::steady_clock::now();
+    open_ = doOpen(encoder, path, expectedBytes);
+    stats_.openTime = secondsSince(start);
+    return open_;
+}
+
+bool OutputSink::write(AVPacket* packet) {
+    const int size = packet->size;
+    const double cpuStart = threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    bool ok = doWrite(packet);
+    double elapsed = secondsSince(start);
+    stats_.cpuTime += threadCpuSeconds() - cpuStart;
+    stats_.write.recordSeconds(elapsed);
+    stats_.writeTime += elapsed;
+    if (ok) {
+        ++stats_.packets;
+        stats_.bytes += static_cast<uint64_t>(size);
+    }
+    return ok;
+}
+
+bool OutputSink::close() {
+    if (!open_) {
+        return true;
+    }
+    open_ = false;
+    const double cpuStart = threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    bool ok = doClose();
+    stats_.closeTime = secondsSince(start);
+    stats_.cpuTime += threadCpuSeconds() - cpuStart;
+    return ok;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "latency_histogram.hpp"
+
+// 编码数据包的输出去向，每次运行选择一种
+// 依次比较null、memory、file、mux的结果，可把吞吐拆成编码器本身、复制、写盘和封装各自的开销
+// open/write/close都在内部计时；write由写入线程调用，stats()需在close之后读取
+class OutputSink {
+public:
+    enum class Kind {
+        Null,    // 丢弃数据包，只测编码器
+        Memory,  // 复制到内存缓冲区
+        File,    // 原始码流直接写入文件（VP8/VP9为IVF），不经过libavformat
+        Mux      // 按文件扩展名封装（MP4/WebM等）
+    };
+
+    // MP4封装方式，只对输出为MP4/MOV的mux有效
+    enum class Mp4Mode {
+        Standard,    // moov在文件尾，写完文件尾之前文件不可播放
+        Fragmented,  // 每个GOP一个分片（moof+mdat），moov在文件头，只追加写入，中断时已写完的分片仍可用
+        FastStart    // 写完文件尾后把moov移到文件头（需要重写整个文件），播放时不必先读文件尾
+    };
+
+    struct Stats {
+        uint64_t packets{0};
+        uint64_t bytes{0};        // 写入的码流字节数，不含封装开销
+        uint64_t fileBytes{0};    // 最终文件大小，不写文件时为0
+        double openTime{0.0};     // 打开文件、写文件头(秒)
+        double writeTime{0.0};    // 全部数据包的写入耗时(秒)
+        double closeTime{0.0};    // 写文件尾并落盘(秒)
+        double cpuTime{0.0};      // 写入和关闭占用的线程CPU时间(秒)，主要是写入线程
+        double ioWaitTime{0.0};   // 批量写入时等待块写完的时间(秒)
+        bool directIo{false};     // 批量写入实际使用了O_DIRECT
+        bool ioUring{false};      // 批量写入实际使用了io_uring
+        LatencyHistogram write;   // 单个数据包的写入耗时
+
+        double totalTime() const { return openTime + writeTime + closeTime; }
+        // 写入和关闭期间的输出速度(字节/秒)
+        double bytesPerSecond() const {
+            const double time = writeTime + closeTime;
+            return time > 0.0 ? static_cast<double>(fileBytes > 0 ? fileBytes : bytes) / time : 0.0;
+        }
+    };
+
+    virtual ~OutputSink() = default;
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // directWriter为true时file/mux改用DirectFileWriter：预分配文件，合并成大块对齐缓冲区，
+    // 以O_DIRECT经io_uring（或pwrite）提交；null/memory忽略此参数
+    // FastStart需要重新读取整个文件，此时mux不使用批量写入
+    static std::unique_ptr<OutputSink> create(Kind kind, bool directWriter = false,
+                                              Mp4Mode mp4Mode = Mp4Mode::Standard);
+    static const char* kindToString(Kind kind);
+    static const char* mp4ModeToString(Mp4Mode mode);
+
+    // 输出格式为MP4/MOV时按mode设置movflags（写入options）和分片后立即刷新，其他格式不变
+    // 返回是否为MP4/MOV
+    static bool applyMp4Mode(Mp4Mode mode, AVFormatContext* formatCtx, AVDictionary** options);
+    static bool writesFile(Kind kind) { return kind == Kind::File || kind == Kind::Mux; }
+
+    // 按path推断的封装格式是否要求全局头（MP4/MKV等），是时编码器需在avcodec_open2之前设置
+    // AV_CODEC_FLAG_GLOBAL_HEADER，把参数集放入extradata；否则分片MP4的moov在第一个数据包之前写出，
+    // 其中的解码器配置（avcC/hvcC）为空，文件无法解码
+    static bool needsGlobalHeader(Kind kind, const std::string& path);
+
+    Kind kind() const { return kind_; }
+
+    // 按编码器参数打开输出（avcodec_open2之后调用），path只对File/Mux有效
+    // expectedBytes为预计的输出大小，批量写入时用于预分配文件，0表示不预分配
+    bool open(const AVCodecContext* encoder, const std::string& path, uint64_t expectedBytes = 0);
+
+    // 写入一个编码器时间基下的数据包，可能取走packet的引用
+    bool write(AVPacket* packet);
+
+    // 写文件尾并把数据刷到磁盘，未打开时直接返回true
+    bool close();
+
+    const Stats& stats() const { return stats_; }
+
+protected:
+    explicit OutputSink(Kind kind) : kind_(kind) {}
+
+    virtual bool doOpen(const AVCodecContext* encoder, const std::string& path, uint64_t expectedBytes) = 0;
+    virtual bool doWrite(AVPacket* packet) = 0;
+    virtual bool doClose() = 0;
+
+    Stats stats_;
+
+private:
+    Kind kind_;
+    bool open_{false};
+};
@@ -0,0 +1,111 @@
+#include "packet_pool.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+PacketPool& PacketPool::instance() {
+    static PacketPool pool;
+    return pool;
+}
+
+PacketPool::PacketPool() {
+    for (size_t i = 0; i < kClassCount; ++i) {
+        pools_[i] = av_buffer_pool_init(size_t(1) << (kMinClassShift + i), nullptr);
+    }
+}
+
+PacketPool::~PacketPool() {
+    // 仍被引用的缓冲会在释放时由FFmpeg回收
+    for (auto& pool : pools_) {
+        av_buffer_pool_uninit(&pool);
+    }
+}
+
+AVBufferRef* PacketPool::acquire(size_t size) {
+    size_t index = 0;
+    while (index < kClassCount && (size_t(1) << (kMinClassShift + index)) < size) {
+        ++index;
+    }
+
+    if (index < kClassCount && pools_[index]) {
+        return av_buffer_pool_get(pools_[index]);
+    }
+    return av_buffer_alloc(size);
+}
+
+void PacketPool::install(AVCodecContext* ctx) {
+    ctx->get_encode_buffer = &PacketPool::getEncodeBuffer;
+}
+
+int PacketPool::getEncodeBuffer(AVCodecContext*, AVPacket* packet, int) {
+    const size_t size = static_cast<size_t>(packet->size);
+    packet->buf = instance().acquire(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!packet->buf) {
+        return AVERROR(ENOMEM);
+    }
+    packet->data = packet->buf->data;
+    std::memset(packet->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return 0;
+}
+
+PacketChannel::PacketChannel(size_t capacity)
+    : packets_(capacity)
+    , freePackets_(capacity) {
+}
+
+PacketChannel::~PacketChannel() {
+    drain();
+}
+
+bool PacketChannel::send(AVPacket* packet) {
+    AVPacket* shell = nullptr;
+    if (!freePackets_.tryPop(shell)) {
+        shell = av_packet_alloc();
+        if (!shell) {
+            return false;
+        }
+    }
+
+    // 编码器输出的包通常已有引用计数，这里只在极少数情况下复制
+    if (av_packet_make_refcounted(packet) < 0) {
+        av_packet_free(&shell);
+        return false;
+    }
+    av_packet_move_ref(shell, packet);
+
+    if (!packets_.push(shell)) {
+        av_packet_free(&shell);
+        return false;
+    }
+    return true;
+}
+
+AVPacket* PacketChannel::receive() {
+    AVPacket* packet = nullptr;
+    if (!packets_.pop(packet)) {
+        return nullptr;
+    }
+    return packet;
+}
+
+void PacketChannel::recycle(AVPacket* packet) {
+    av_packet_unref(packet);
+    if (!freePackets_.tryPush(packet)) {
+        av_packet_free(&packet);
+    }
+}
+
+void PacketChannel::reset() {
+    drain();
+    packets_.reset();
+}
+
+void PacketChannel::drain() {
+    AVPacket* packet = nullptr;
+    while (packets_.tryPop(packet)) {
+        av_packet_free(&packet);
+    }
+    while (freePackets_.tryPop(packet)) {
+        av_packet_free(&packet);
+    }
+}
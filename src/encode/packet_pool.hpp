@@ -0,0 +1,70 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+}
+
+#include <array>
+#include <cstddef>
+
+#include "spsc_ring.hpp"
+
+// 编码数据包缓冲池：按大小分级的AVBufferPool，进程内所有编码器共享
+// 缓冲在引用计数归零后回到池中，跨帧、跨测试重复使用
+class PacketPool {
+public:
+    static PacketPool& instance();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // 获取至少size字节的缓冲，超出最大分级时直接分配
+    AVBufferRef* acquire(size_t size);
+
+    // 安装到编码器上下文，编码器输出的数据包从池中分配（需在avcodec_open2之前调用）
+    static void install(AVCodecContext* ctx);
+
+    // AVCodecContext::get_encode_buffer回调
+    static int getEncodeBuffer(AVCodecContext* ctx, AVPacket* packet, int flags);
+
+private:
+    PacketPool();
+    ~PacketPool();
+
+    static constexpr size_t kMinClassShift = 12;  // 4 KiB
+    static constexpr size_t kClassCount = 15;     // 最大 64 MiB
+
+    std::array<AVBufferPool*, kClassCount> pools_{};
+};
+
+// 编码线程到写入线程的数据包通道
+// 只转移引用，不复制数据；AVPacket外壳由写入线程归还后循环使用
+class PacketChannel {
+public:
+    explicit PacketChannel(size_t capacity);
+    ~PacketChannel();
+
+    PacketChannel(const PacketChannel&) = delete;
+    PacketChannel& operator=(const PacketChannel&) = delete;
+
+    // 生产者：转移packet的引用，调用后packet为空；通道已关闭时返回false
+    bool send(AVPacket* packet);
+
+    // 消费者：阻塞等待下一个数据包，关闭且取空后返回nullptr
+    AVPacket* receive();
+
+    // 消费者：数据包用完后归还外壳
+    void recycle(AVPacket* packet);
+
+    void close() { packets_.close(); }
+
+    // 重新打开，调用时双方都不能在使用通道
+    void reset();
+
+private:
+    void drain();
+
+    SpscRing<AVPacket*> packets_;      // 待写入的数据包
+    SpscRing<AVPacket*> freePackets_;  // 写入线程归还的空外壳
+};
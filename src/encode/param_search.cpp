@@ -0,0 +1,368 @@
+#include "param_search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+
+namespace {
+
+const char* const kPresetNames[] = {
+    "ultrafast", "superfast", "veryfast", "faster", "fast",
+    "medium", "slow", "slower", "veryslow", "placebo"
+};
+const char* const kTuneNames[] = {
+    "none", "film", "animation", "grain", "stillimage",
+    "psnr", "ssim", "fastdecode", "zerolatency"
+};
+
+template <size_t N>
+int findName(const char* const (&names)[N], const std::string& text) {
+    for (size_t i = 0; i < N; ++i) {
+        if (text == names[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool parseInt(const std::string& text, const std::string& name, int& value) {
+    if (name == "preset" && (value = findName(kPresetNames, text)) >= 0) {
+        return true;
+    }
+    if (name == "tune" && (value = findName(kTuneNames, text)) >= 0) {
+        return true;
+    }
+    char* end = nullptr;
+    const long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// crf/qp/bitrate共用TestConfig中的同一个字段，各自切换码率控制模式
+bool isRateControl(const std::string& name) {
+    return name == "crf" || name == "qp" || name == "bitrate";
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+}  // namespace
+
+ParamSearch::Options::Options() {
+    // 搜索只比较码率、画质和速度，不需要输出文件
+    base.sink = OutputSink::Kind::Null;
+}
+
+bool ParamSearch::apply(const std::string& name, int value, X264ParamTest::TestConfig& config) {
+    using RateControl = X264ParamTest::RateControl;
+
+    // crf/qp/bitrate共用存储，同时切换到对应的码率控制模式
+    if (name == "crf") {
+        config.rateControl = RateControl::CRF;
+        config.crf = value;
+    } else if (name == "qp") {
+        config.rateControl = RateControl::CQP;
+        config.qp = value;
+    } else if (name == "bitrate") {
+        if (config.rateControl != RateControl::CBR) {
+            config.rateControl = RateControl::ABR;
+        }
+        config.bitrate = value;
+    } else if (name == "preset") {
+        if (value < 0 || value >= static_cast<int>(std::size(kPresetNames))) return false;
+        config.preset = static_cast<X264ParamTest::Preset>(value);
+    } else if (name == "tune") {
+        if (value < 0 || value >= static_cast<int>(std::size(kTuneNames))) return false;
+        config.tune = static_cast<X264ParamTest::Tune>(value);
+    } else if (name == "threads") {
+        config.threads = value;
+    } else if (name == "keyintMax") {
+        config.keyintMax = value;
+    } else if (name == "bframes") {
+        config.bframes = value;
+    } else if (name == "refs") {
+        config.refs = value;
+    } else if (name == "meRange") {
+        config.meRange = value;
+    } else if (name == "weightedPred") {
+        config.weightedPred = value != 0;
+    } else if (name == "cabac") {
+        config.cabac = value != 0;
+    } else {
+        // fastFirstPass只影响两遍编码的首遍，单遍测试中没有效果，不作为搜索维度
+        return false;
+    }
+    return true;
+}
+
+bool ParamSearch::parseParameter(const std::string& text, const std::vector<Parameter>& existing,
+                                 Parameter& parameter, std::string& error) {
+    const size_t equals = text.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        error = "参数格式应为 name=lo:hi[:step] 或 name=v1,v2,...: " + text;
+        return false;
+    }
+    parameter.name = text.substr(0, equals);
+    parameter.values.clear();
+    const std::string spec = text.substr(equals + 1);
+
+    X264ParamTest::TestConfig probe;
+    if (!apply(parameter.name, 0, probe)) {
+        error = "不支持搜索的参数: " + parameter.name;
+        return false;
+    }
+    for (const auto& other : existing) {
+        if (other.name == parameter.name) {
+            error = "参数重复: " + parameter.name;
+            return false;
+        }
+        // 后写入的值会覆盖前一个并切换模式，组合起来的网格没有意义
+        if (isRateControl(other.name) && isRateControl(parameter.name)) {
+            error = "只能搜索一个码率控制参数: " + other.name + " 与 " + parameter.name;
+            return false;
+        }
+    }
+
+    const std::vector<std::string> range = split(spec, ':');
+    if (range.size() == 2 || range.size() == 3) {
+        int low = 0;
+        int high = 0;
+        int step = 1;
+        if (!parseInt(range[0], parameter.name, low) || !parseInt(range[1], parameter.name, high) ||
+            (range.size() == 3 && !parseInt(range[2], parameter.name, step)) || step <= 0 || high < low) {
+            error = "无效的取值范围: " + text;
+            return false;
+        }
+        for (int value = low; value <= high; value += step) {
+            parameter.values.push_back(value);
+        }
+    } else {
+        for (const auto& item : split(spec, ',')) {
+            int value = 0;
+            if (!parseInt(item, parameter.name, value)) {
+                error = "无效的取值: " + parameter.name + "=" + item;
+                return false;
+            }
+            parameter.values.push_back(value);
+        }
+    }
+
+    for (int value : parameter.values) {
+        if (!apply(parameter.name, value, probe)) {
+            error = "取值超出范围: " + parameter.name + "=" + std::to_string(value);
+            return false;
+        }
+    }
+    if (parameter.values.empty()) {
+        error = "参数没有取值: " + parameter.name;
+        return false;
+    }
+    return true;
+}
+
+bool ParamSearch::parseMetric(const std::string& text, Metric& metric) {
+    if (text == "psnr") metric = Metric::PSNR;
+    else if (text == "ssim") metric = Metric::SSIM;
+    else if (text == "fps") metric = Metric::FPS;
+    else if (text == "bitrate") metric = Metric::Bitrate;
+    else return false;
+    return true;
+}
+
+const char* ParamSearch::metricName(Metric metric) {
+    switch (metric) {
+        case Metric::PSNR: return "psnr";
+        case Metric::SSIM: return "ssim";
+        case Metric::FPS: return "fps";
+        case Metric::Bitrate: return "bitrate";
+    }
+    return "unknown";
+}
+
+std::string ParamSearch::formatValue(const std::string& name, int value) {
+    if (name == "preset" && value >= 0 && value < static_cast<int>(std::size(kPresetNames))) {
+        return kPresetNames[value];
+    }
+    if (name == "tune" && value >= 0 && value < static_cast<int>(std::size(kTuneNames))) {
+        return kTuneNames[value];
+    }
+    return std::to_string(value);
+}
+
+std::string ParamSearch::describe(const std::vector<Parameter>& parameters, const std::vector<int>& values) {
+    std::ostringstream out;
+    for (size_t i = 0; i < parameters.size() && i < values.size(); ++i) {
+        if (i > 0) {
+            out << ' ';
+        }
+        out << parameters[i].name << '=' << formatValue(parameters[i].name, values[i]);
+    }
+    return out.str();
+}
+
+double ParamSearch::score(const Objective& objective, const X264ParamTest::TestResult& result, bool& feasible) {
+    feasible = false;
+    if (!result.success) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // 不满足约束时按超出的比例排序，越接近约束越好
+    double violation = 0.0;
+    if (objective.minFps > 0 && result.fps < objective.minFps) {
+        violation += (objective.minFps - result.fps) / objective.minFps;
+    }
+    if (objective.maxBitrate > 0 && result.bitrate > objective.maxBitrate) {
+        violation += (result.bitrate - objective.maxBitrate) / objective.maxBitrate;
+    }
+    if (violation > 0) {
+        return -violation;
+    }
+
+    feasible = true;
+    double value = 0.0;
+    switch (objective.metric) {
+        case Metric::PSNR: value = result.psnr; break;
+        case Metric::SSIM: value = result.ssim; break;
+        case Metric::FPS: value = result.fps; break;
+        case Metric::Bitrate: value = result.bitrate; break;
+    }
+    return objective.maximize ? value : -value;
+}
+
+ParamSearch::Result ParamSearch::run(const Options& options) {
+    Result result;
+    if (options.parameters.empty()) {
+        std::cerr << "没有要搜索的参数" << std::endl;
+        return result;
+    }
+
+    const int eta = std::max(2, options.eta);
+    const int fullFrames = options.base.frameCount;
+
+    result.gridSize = 1;
+    for (const auto& parameter : options.parameters) {
+        result.gridSize *= parameter.values.size();
+    }
+
+    // 候选配置：网格不大于候选数时取全部，否则不重复地随机取样
+    auto decode = [&](size_t index) {
+        std::vector<int> values(options.parameters.size());
+        for (size_t i = options.parameters.size(); i-- > 0;) {
+            const auto& choices = options.parameters[i].values;
+            values[i] = choices[index % choices.size()];
+            index /= choices.size();
+        }
+        return values;
+    };
+
+    const size_t candidateCount = std::min(result.gridSize, static_cast<size_t>(std::max(1, options.candidates)));
+    std::vector<std::vector<int>> survivors;
+    if (candidateCount == result.gridSize) {
+        for (size_t i = 0; i < result.gridSize; ++i) {
+            survivors.push_back(decode(i));
+        }
+    } else {
+        std::mt19937_64 rng(options.seed);
+        std::uniform_int_distribution<size_t> pick(0, result.gridSize - 1);
+        std::set<size_t> chosen;
+        while (chosen.size() < candidateCount) {
+            chosen.insert(pick(rng));
+        }
+        for (size_t index : chosen) {
+            survivors.push_back(decode(index));
+        }
+    }
+
+    // 减半轮数：候选数每轮除以eta直到剩下1个；第一轮帧数为完整帧数除以eta^轮数
+    int rounds = 0;
+    for (size_t count = survivors.size(); count > 1; count = (count + eta - 1) / eta) {
+        ++rounds;
+    }
+
+    for (int round = 0; round <= rounds && !survivors.empty(); ++round) {
+        int frames = fullFrames;
+        for (int i = round; i < rounds; ++i) {
+            frames /= eta;
+        }
+        frames = std::min(fullFrames, std::max(options.minFrames, frames));
+
+        std::cout << "\n参数搜索第 " << round + 1 << "/" << rounds + 1 << " 轮: "
+                  << survivors.size() << " 个配置, 每个 " << frames << " 帧" << std::endl;
+
+        std::vector<X264ParamTest::TestConfig> configs;
+        configs.reserve(survivors.size());
+        for (const auto& values : survivors) {
+            X264ParamTest::TestConfig config = options.base;
+            config.frameCount = frames;
+            for (size_t i = 0; i < values.size(); ++i) {
+                apply(options.parameters[i].name, values[i], config);
+            }
+            configs.push_back(config);
+        }
+
+        const auto results = X264ParamTest::runConfigs(configs, options.coreBudget, options.cache);
+        const size_t first = result.evaluations.size();
+        for (size_t i = 0; i < survivors.size(); ++i) {
+            Evaluation evaluation;
+            evaluation.values = survivors[i];
+            evaluation.round = round;
+            evaluation.frames = frames;
+            evaluation.result = results[i];
+            evaluation.score = score(options.objective, results[i], evaluation.feasible);
+            result.evaluations.push_back(evaluation);
+            result.encodedFrames += static_cast<size_t>(frames);
+        }
+
+        // 按得分排序，保留前1/eta进入下一轮
+        std::vector<size_t> order(survivors.size());
+        std::iota(order.begin(), order.end(), first);
+        // 满足约束的配置总是排在前面
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            const auto& lhs = result.evaluations[a];
+            const auto& rhs = result.evaluations[b];
+            if (lhs.feasible != rhs.feasible) {
+                return lhs.feasible;
+            }
+            return lhs.score > rhs.score;
+        });
+
+        if (round == rounds) {
+            result.best = static_cast<int>(order.front());
+            break;
+        }
+
+        const size_t keep = (survivors.size() + eta - 1) / eta;
+        std::vector<std::vector<int>> next;
+        for (size_t i = 0; i < keep; ++i) {
+            next.push_back(result.evaluations[order[i]].values);
+        }
+        survivors = std::move(next);
+    }
+
+    const size_t exhaustiveFrames = result.gridSize * static_cast<size_t>(fullFrames);
+    std::cout << "\n参数搜索完成: 编码 " << result.encodedFrames << " 帧，穷举网格需要 "
+              << exhaustiveFrames << " 帧" << std::endl;
+    if (result.best >= 0) {
+        const auto& best = result.evaluations[static_cast<size_t>(result.best)];
+        std::cout << "最优配置: " << describe(options.parameters, best.values)
+                  << (best.feasible ? "" : "（不满足约束）") << std::endl;
+    }
+    return result;
+}
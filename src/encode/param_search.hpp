@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "x264_param_test.hpp"
+
+// 自适应参数搜索：用逐次减半（successive halving）代替穷举网格
+// 从参数空间中取一批候选配置，先用少量帧编码全部候选，只保留最好的1/eta，
+// 帧数乘以eta后继续，直到剩下一个配置用完整帧数编码
+class ParamSearch {
+public:
+    // 一个可搜索的TestConfig字段及其候选取值，字段名与TestConfig成员同名
+    // preset/tune取枚举序号，bool字段取0/1
+    struct Parameter {
+        std::string name;
+        std::vector<int> values;
+    };
+
+    enum class Metric {
+        PSNR,
+        SSIM,
+        FPS,
+        Bitrate
+    };
+
+    // 目标：最大化（或最小化）一个指标，满足速度和码率约束
+    struct Objective {
+        Metric metric{Metric::SSIM};
+        bool maximize{true};
+        double minFps{0.0};       // 编码速度下限，0表示不限制
+        double maxBitrate{0.0};   // 码率上限(bps)，0表示不限制
+    };
+
+    struct Options {
+        X264ParamTest::TestConfig base;  // 未搜索的字段取此值，frameCount为最后一轮的帧数；默认不写输出
+        std::vector<Parameter> parameters;
+        Objective objective;
+        int candidates{27};      // 第一轮的候选数，不超过网格大小
+        int eta{3};              // 每轮保留1/eta，帧数乘以eta
+        int minFrames{10};       // 第一轮的最少帧数
+        unsigned seed{1};        // 网格大于候选数时随机取样的种子
+        int coreBudget{0};       // 并发编码使用的核心数，0表示全部可用CPU
+        const ResultCache* cache{nullptr};  // 结果缓存，为空时总是重新编码
+
+        Options();
+    };
+
+    struct Evaluation {
+        std::vector<int> values;  // 与Options::parameters一一对应
+        int round{0};
+        int frames{0};
+        X264ParamTest::TestResult result;
+        double score{0.0};        // 越大越好；不满足约束时为负的超出比例，排在所有满足约束的配置之后
+        bool feasible{false};
+    };
+
+    struct Result {
+        std::vector<Evaluation> evaluations;  // 所有编码，按轮次排列
+        int best{-1};                         // 最后一轮最好的配置在evaluations中的下标，没有时为-1
+        size_t gridSize{0};                   // 完整网格的配置数
+        size_t encodedFrames{0};              // 实际编码的总帧数
+    };
+
+    static Result run(const Options& options);
+
+    // 把一组取值写入配置，字段名不支持时返回false
+    static bool apply(const std::string& name, int value, X264ParamTest::TestConfig& config);
+
+    // 解析"name=lo:hi[:step]"或"name=v1,v2,..."，preset/tune也可用名称（如veryfast）
+    // 与existing中的参数重名，或与其同时搜索多个码率控制维度（crf/qp/bitrate）时失败
+    static bool parseParameter(const std::string& text, const std::vector<Parameter>& existing,
+                               Parameter& parameter, std::string& error);
+
+    static bool parseMetric(const std::string& text, Metric& metric);
+    static const char* metricName(Metric metric);
+
+    // preset/tune输出名称，其余输出数字
+    static std::string formatValue(const std::string& name, int value);
+
+    // 用一组取值描述配置，如"crf=23 bframes=3"
+    static std::string describe(const std::vector<Parameter>& parameters, const std::vector<int>& values);
+
+private:
+    static double score(const Objective& objective, const X264ParamTest::TestResult& result, bool& feasible);
+};
@@ -0,0 +1,265 @@
+#include "per_title_ladder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+constexpr double kMaxSsimDb = 100.0;  // SSIM为1时的上限，避免无穷大
+
+double logRate(const PerTitleLadder::Point& point) {
+    return std::log10(std::max(point.result.bitrate, 1.0));
+}
+
+}  // namespace
+
+PerTitleLadder::Options::Options()
+    : base(X264ParamTest::getVODConfig().config)
+    , resolutions{{1920, 1080}, {1280, 720}, {960, 540}, {640, 360}, {480, 270}}
+{
+    base.threads = 0;
+    // 只比较码率和画质，不需要输出文件
+    base.sink = OutputSink::Kind::Null;
+    for (int crf = 18; crf <= 40; crf += 2) {
+        crfs.push_back(crf);
+    }
+}
+
+double PerTitleLadder::ssimToDb(double ssim) {
+    if (ssim >= 1.0) {
+        return kMaxSsimDb;
+    }
+    return std::min(kMaxSsimDb, -10.0 * std::log10(1.0 - ssim));
+}
+
+PerTitleLadder::Result PerTitleLadder::run(const Options& options) {
+    Result result;
+
+    const int displayWidth = options.base.width;
+    const int displayHeight = options.base.height;
+
+    // 只在显示分辨率以内编码，分辨率从高到低，CRF从小到大
+    std::vector<Resolution> resolutions;
+    for (const auto& resolution : options.resolutions) {
+        if (resolution.width > 0 && resolution.height > 0 &&
+            resolution.width <= displayWidth && resolution.height <= displayHeight) {
+            resolutions.push_back(resolution);
+        }
+    }
+    if (resolutions.empty()) {
+        resolutions.push_back({displayWidth, displayHeight});
+    }
+    std::sort(resolutions.begin(), resolutions.end(), [](const Resolution& a, const Resolution& b) {
+        return a.width * a.height > b.width * b.height;
+    });
+
+    std::vector<int> crfs = options.crfs;
+    std::sort(crfs.begin(), crfs.end());
+    crfs.erase(std::unique(crfs.begin(), crfs.end()), crfs.end());
+    if (crfs.empty()) {
+        std::cerr << "没有候选CRF" << std::endl;
+        return result;
+    }
+    result.gridSize = resolutions.size() * crfs.size();
+
+    // grid[r][c]为已编码点在points中的下标，未编码为-1
+    std::vector<std::vector<int>> grid(resolutions.size(), std::vector<int>(crfs.size(), -1));
+    std::vector<Point> points;
+
+    auto encode = [&](const std::vector<std::pair<size_t, size_t>>& cells) {
+        std::vector<X264ParamTest::TestConfig> configs;
+        configs.reserve(cells.size());
+        for (const auto& cell : cells) {
+            X264ParamTest::TestConfig config = options.base;
+            config.width = resolutions[cell.first].width;
+            config.height = resolutions[cell.first].height;
+            config.displayWidth = displayWidth;
+            config.displayHeight = displayHeight;
+            config.rateControl = X264ParamTest::RateControl::CRF;
+            config.crf = crfs[cell.second];
+            config.measureQuality = true;
+            configs.push_back(config);
+        }
+
+        const auto results = X264ParamTest::runConfigs(configs, options.coreBudget, options.cache);
+        for (size_t i = 0; i < cells.size(); ++i) {
+            Point point;
+            point.resolution = resolutions[cells[i].first];
+            point.crf = crfs[cells[i].second];
+            point.result = results[i];
+            point.quality = options.useSsim ? ssimToDb(point.result.ssim) : point.result.psnr;
+            grid[cells[i].first][cells[i].second] = static_cast<int>(points.size());
+            points.push_back(point);
+        }
+        result.encodes += cells.size();
+    };
+
+    // 粗扫：每个分辨率编码CRF两端及每隔两档的一个点
+    std::vector<std::pair<size_t, size_t>> pending;
+    for (size_t r = 0; r < resolutions.size(); ++r) {
+        for (size_t c = 0; c < crfs.size(); ++c) {
+            if (c % 3 == 0 || c + 1 == crfs.size()) {
+                pending.emplace_back(r, c);
+            }
+        }
+    }
+
+    // 细化：相邻两个已编码CRF之间还有未编码的档位，且任一端靠近凸包时，编码中间档位
+    // 两端都远离凸包的区间被剪掉，中间的点在同一分辨率的码率-质量曲线上，不会越过凸包
+    for (int round = 0; !pending.empty(); ++round) {
+        std::cout << "凸包搜索第 " << round + 1 << " 轮: " << pending.size() << " 个编码" << std::endl;
+        encode(pending);
+        pending.clear();
+
+        const std::vector<size_t> hull = upperHull(points);
+        if (hull.empty()) {
+            break;
+        }
+
+        auto nearHull = [&](int index) {
+            const Point& point = points[static_cast<size_t>(index)];
+            return point.result.success &&
+                   hullDistance(points, hull, point) <= options.pruneMargin;
+        };
+
+        for (size_t r = 0; r < resolutions.size(); ++r) {
+            int previous = -1;
+            for (size_t c = 0; c < crfs.size(); ++c) {
+                if (grid[r][c] < 0) {
+                    continue;
+                }
+                if (previous >= 0 && c - static_cast<size_t>(previous) > 1 &&
+                    (nearHull(grid[r][static_cast<size_t>(previous)]) || nearHull(grid[r][c]))) {
+                    pending.emplace_back(r, (static_cast<size_t>(previous) + c) / 2);
+                }
+                previous = static_cast<int>(c);
+            }
+        }
+    }
+
+    std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        const int areaA = a.resolution.width * a.resolution.height;
+        const int areaB = b.resolution.width * b.resolution.height;
+        return areaA != areaB ? areaA > areaB : a.crf < b.crf;
+    });
+    result.points = std::move(points);
+    result.hull = upperHull(result.points);
+    result.ladder = selectLadder(result.points, result.hull, options.rungs);
+
+    for (size_t index : result.hull) {
+        result.points[index].onHull = true;
+    }
+    for (size_t rung = 0; rung < result.ladder.size(); ++rung) {
+        result.points[result.ladder[rung]].rung = static_cast<int>(rung);
+    }
+
+    std::cout << "凸包搜索完成: 编码 " << result.encodes << "/" << result.gridSize
+              << " 个点，凸包 " << result.hull.size() << " 个点，阶梯 " << result.ladder.size() << " 档"
+              << std::endl;
+    return result;
+}
+
+std::vector<size_t> PerTitleLadder::upperHull(const std::vector<Point>& points) {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].result.success && points[i].result.bitrate > 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const double rateA = logRate(points[a]);
+        const double rateB = logRate(points[b]);
+        return rateA != rateB ? rateA < rateB : points[a].quality > points[b].quality;
+    });
+
+    // Pareto前沿：码率升高时质量必须严格升高
+    std::vector<size_t> frontier;
+    double best = -std::numeric_limits<double>::infinity();
+    for (size_t index : order) {
+        if (points[index].quality > best) {
+            best = points[index].quality;
+            frontier.push_back(index);
+        }
+    }
+
+    // 单调链求上凸包：保留右转的点
+    std::vector<size_t> hull;
+    for (size_t index : frontier) {
+        const double x = logRate(points[index]);
+        const double y = points[index].quality;
+        while (hull.size() >= 2) {
+            const Point& a = points[hull[hull.size() - 2]];
+            const Point& b = points[hull.back()];
+            const double cross = (logRate(b) - logRate(a)) * (y - a.quality) -
+                                 (b.quality - a.quality) * (x - logRate(a));
+            if (cross < 0) {
+                break;
+            }
+            hull.pop_back();
+        }
+        hull.push_back(index);
+    }
+    return hull;
+}
+
+double PerTitleLadder::hullDistance(const std::vector<Point>& points, const std::vector<size_t>& hull,
+                                    const Point& point) {
+    const double x = logRate(point);
+    const Point& first = points[hull.front()];
+    const Point& last = points[hull.back()];
+    if (x <= logRate(first)) {
+        return first.quality - point.quality;
+    }
+    if (x >= logRate(last)) {
+        return last.quality - point.quality;
+    }
+
+    // 凸包顶点之间线性插值
+    for (size_t i = 1; i < hull.size(); ++i) {
+        const Point& a = points[hull[i - 1]];
+        const Point& b = points[hull[i]];
+        if (x <= logRate(b)) {
+            const double t = (x - logRate(a)) / (logRate(b) - logRate(a));
+            return a.quality + t * (b.quality - a.quality) - point.quality;
+        }
+    }
+    return last.quality - point.quality;
+}
+
+std::vector<size_t> PerTitleLadder::selectLadder(const std::vector<Point>& points,
+                                                 const std::vector<size_t>& hull, int rungs) {
+    if (rungs <= 0 || hull.empty()) {
+        return {};
+    }
+    if (hull.size() <= static_cast<size_t>(rungs)) {
+        return hull;
+    }
+
+    // 目标码率在凸包码率范围内按对数均匀分布，每档取最近的尚未选中的凸包顶点
+    const double low = logRate(points[hull.front()]);
+    const double high = logRate(points[hull.back()]);
+    std::vector<bool> used(hull.size(), false);
+    std::vector<size_t> ladder;
+    for (int rung = 0; rung < rungs; ++rung) {
+        const double target = rungs == 1 ? high : low + (high - low) * rung / (rungs - 1);
+        size_t nearest = hull.size();
+        double nearestDistance = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < hull.size(); ++i) {
+            const double distance = std::abs(logRate(points[hull[i]]) - target);
+            if (!used[i] && distance < nearestDistance) {
+                nearest = i;
+                nearestDistance = distance;
+            }
+        }
+        used[nearest] = true;
+    }
+
+    for (size_t i = 0; i < hull.size(); ++i) {
+        if (used[i]) {
+            ladder.push_back(hull[i]);
+        }
+    }
+    return ladder;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "x264_param_test.hpp"
+
+// 按内容制定码率阶梯（per-title）：在编码分辨率×CRF网格上编码，求码率-质量上凸包，
+// 只细化靠近凸包的CRF区间，远离凸包的区间不再编码，最后在凸包上按对数码率均匀选出阶梯
+// 画质总是在显示分辨率下评估：源帧按显示分辨率准备，缩小后编码，解码后放大回显示分辨率比较
+class PerTitleLadder {
+public:
+    struct Resolution {
+        int width{0};
+        int height{0};
+    };
+
+    struct Options {
+        X264ParamTest::TestConfig base;       // 编码参数，width/height为显示分辨率；默认不写输出
+        std::vector<Resolution> resolutions;  // 候选编码分辨率，超过显示分辨率的被忽略
+        std::vector<int> crfs;                // 候选CRF
+        int rungs{5};                         // 阶梯档数
+        bool useSsim{false};                  // 按SSIM选点，否则按PSNR
+        double pruneMargin{0.5};              // 区间两端距凸包都超过此值(dB)时不再细化
+        int coreBudget{0};                    // 并发编码使用的核心数，0表示全部可用CPU
+        const ResultCache* cache{nullptr};    // 结果缓存，为空时总是重新编码
+
+        Options();
+    };
+
+    struct Point {
+        Resolution resolution;
+        int crf{0};
+        X264ParamTest::TestResult result;
+        double quality{0.0};  // 用于求凸包的质量，PSNR(dB)或换算为dB的SSIM
+        bool onHull{false};
+        int rung{-1};         // 阶梯中的档位，按码率从低到高，不在阶梯中为-1
+    };
+
+    struct Result {
+        std::vector<Point> points;   // 实际编码的点，按分辨率从高到低、CRF从小到大
+        std::vector<size_t> hull;    // 凸包上的点在points中的下标，按码率从低到高
+        std::vector<size_t> ladder;  // 阶梯各档在points中的下标，按码率从低到高
+        size_t gridSize{0};          // 完整网格的点数
+        size_t encodes{0};           // 实际编码次数
+    };
+
+    static Result run(const Options& options);
+
+    // SSIM换算为dB：-10·log10(1-SSIM)，与PSNR使用同一个剪枝阈值
+    static double ssimToDb(double ssim);
+
+private:
+    // 码率-质量上凸包：先取Pareto前沿，再在(log10码率, 质量)平面上求上凸包
+    static std::vector<size_t> upperHull(const std::vector<Point>& points);
+
+    // 点到凸包的质量距离，凸包码率范围以外按端点计算
+    static double hullDistance(const std::vector<Point>& points, const std::vector<size_t>& hull,
+                               const Point& point);
+
+    static std::vector<size_t> selectLadder(const std::vector<Point>& points,
+                                            const std::vector<size_t>& hull, int rungs);
+};
@@ -0,0 +1,541 @@
+#include "quality_metrics.hpp"
+#include "sweep_scheduler.hpp"
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define QUALITY_METRICS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using SseKernel = uint64_t (*)(const uint8_t*, int, const uint8_t*, int, int, int);
+// 一行4x4块的统计量：s1=Σa, s2=Σb, ss=Σa²+Σb², s12=Σab
+using SsimRowKernel = void (*)(const uint8_t*, int, const uint8_t*, int, int, int32_t (*)[4]);
+
+uint64_t sseScalar(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height) {
+    uint64_t total = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* ra = a + static_cast<ptrdiff_t>(y) * strideA;
+        const uint8_t* rb = b + static_cast<ptrdiff_t>(y) * strideB;
+        uint64_t row = 0;
+        for (int x = 0; x < width; ++x) {
+            int d = ra[x] - rb[x];
+            row += d * d;
+        }
+        total += row;
+    }
+    return total;
+}
+
+void ssimRowScalar(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, int32_t (*sums)[4]) {
+    for (int bx = 0; bx < blocks; ++bx) {
+        int32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+        for (int y = 0; y < 4; ++y) {
+            const uint8_t* ra = a + y * strideA + bx * 4;
+            const uint8_t* rb = b + y * strideB + bx * 4;
+            for (int x = 0; x < 4; ++x) {
+                int va = ra[x];
+                int vb = rb[x];
+                s1 += va;
+                s2 += vb;
+                ss += va * va + vb * vb;
+                s12 += va * vb;
+            }
+        }
+        sums[bx][0] = s1;
+        sums[bx][1] = s2;
+        sums[bx][2] = ss;
+        sums[bx][3] = s12;
+    }
+}
+
+#ifdef QUALITY_METRICS_X86
+__attribute__((target("sse2")))
+uint64_t sseSSE2(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height) {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t total = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* ra = a + static_cast<ptrdiff_t>(y) * strideA;
+        const uint8_t* rb = b + static_cast<ptrdiff_t>(y) * strideB;
+        // 每行单独累加，8K宽度下32位通道也不会溢出
+        __m128i acc = zero;
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ra + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + x));
+            __m128i dlo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(dlo, dlo));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(dhi, dhi));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        uint64_t row = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        for (; x < width; ++x) {
+            int d = ra[x] - rb[x];
+            row += d * d;
+        }
+        total += row;
+    }
+    return total;
+}
+
+__attribute__((target("avx2")))
+uint64_t sseAVX2(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height) {
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t total = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* ra = a + static_cast<ptrdiff_t>(y) * strideA;
+        const uint8_t* rb = b + static_cast<ptrdiff_t>(y) * strideB;
+        __m256i acc = zero;
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ra + x));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb + x));
+            // 通道内解包，只求和所以顺序无关
+            __m256i dlo = _mm256_sub_epi16(_mm256_unpacklo_epi8(va, zero), _mm256_unpacklo_epi8(vb, zero));
+            __m256i dhi = _mm256_sub_epi16(_mm256_unpackhi_epi8(va, zero), _mm256_unpackhi_epi8(vb, zero));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(dlo, dlo));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(dhi, dhi));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        uint64_t row = 0;
+        for (uint32_t lane : lanes) {
+            row += lane;
+        }
+        for (; x < width; ++x) {
+            int d = ra[x] - rb[x];
+            row += d * d;
+        }
+        total += row;
+    }
+    return total;
+}
+
+// 把4组成对求和的32位通道整理成每个块的[s1, s2, ss, s12]
+__attribute__((target("sse2")))
+inline void storeBlockSums(__m128i s1, __m128i s2, __m128i ss, __m128i s12, int32_t (*out)[4]) {
+    s1 = _mm_add_epi32(s1, _mm_srli_epi64(s1, 32));
+    s2 = _mm_add_epi32(s2, _mm_srli_epi64(s2, 32));
+    ss = _mm_add_epi32(ss, _mm_srli_epi64(ss, 32));
+    s12 = _mm_add_epi32(s12, _mm_srli_epi64(s12, 32));
+    __m128i lo = _mm_unpacklo_epi32(s1, s2);   // [s1_0, s2_0, x, x]
+    __m128i hi = _mm_unpackhi_epi32(s1, s2);   // [s1_1, s2_1, x, x]
+    __m128i lo2 = _mm_unpacklo_epi32(ss, s12);
+    __m128i hi2 = _mm_unpackhi_epi32(ss, s12);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0]), _mm_unpacklo_epi64(lo, lo2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1]), _mm_unpacklo_epi64(hi, hi2));
+}
+
+__attribute__((target("sse2")))
+void ssimRowSSE2(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, int32_t (*sums)[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    int bx = 0;
+    // 每次处理两个4x4块（8个像素宽）
+    for (; bx + 2 <= blocks; bx += 2) {
+        __m128i s1 = zero, s2 = zero, ss = zero, s12 = zero;
+        for (int y = 0; y < 4; ++y) {
+            __m128i va = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + y * strideA + bx * 4)), zero);
+            __m128i vb = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + y * strideB + bx * 4)), zero);
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(va, ones));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(vb, ones));
+            ss = _mm_add_epi32(ss, _mm_add_epi32(_mm_madd_epi16(va, va), _mm_madd_epi16(vb, vb)));
+            s12 = _mm_add_epi32(s12, _mm_madd_epi16(va, vb));
+        }
+        // 通道0..1属于块0，通道2..3属于块1
+        storeBlockSums(s1, s2, ss, s12, sums + bx);
+    }
+    if (bx < blocks) {
+        ssimRowScalar(a + bx * 4, strideA, b + bx * 4, strideB, blocks - bx, sums + bx);
+    }
+}
+
+__attribute__((target("avx2")))
+void ssimRowAVX2(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, int32_t (*sums)[4]) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    int bx = 0;
+    // 每次处理四个4x4块（16个像素宽）
+    for (; bx + 4 <= blocks; bx += 4) {
+        __m256i s1 = _mm256_setzero_si256();
+        __m256i s2 = s1, ss = s1, s12 = s1;
+        for (int y = 0; y < 4; ++y) {
+            __m256i va = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * strideA + bx * 4)));
+            __m256i vb = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * strideB + bx * 4)));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(va, ones));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(vb, ones));
+            ss = _mm256_add_epi32(ss, _mm256_add_epi32(_mm256_madd_epi16(va, va), _mm256_madd_epi16(vb, vb)));
+            s12 = _mm256_add_epi32(s12, _mm256_madd_epi16(va, vb));
+        }
+        // 低128位对应块0/1，高128位对应块2/3
+        storeBlockSums(_mm256_castsi256_si128(s1), _mm256_castsi256_si128(s2),
+                       _mm256_castsi256_si128(ss), _mm256_castsi256_si128(s12), sums + bx);
+        storeBlockSums(_mm256_extracti128_si256(s1, 1), _mm256_extracti128_si256(s2, 1),
+                       _mm256_extracti128_si256(ss, 1), _mm256_extracti128_si256(s12, 1), sums + bx + 2);
+    }
+    if (bx < blocks) {
+        ssimRowSSE2(a + bx * 4, strideA, b + bx * 4, strideB, blocks - bx, sums + bx);
+    }
+}
+#endif
+
+SseKernel selectSseKernel() {
+#ifdef QUALITY_METRICS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return sseAVX2;
+    if (__builtin_cpu_supports("sse2")) return sseSSE2;
+#endif
+    return sseScalar;
+}
+
+SsimRowKernel selectSsimRowKernel() {
+#ifdef QUALITY_METRICS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ssimRowAVX2;
+    if (__builtin_cpu_supports("sse2")) return ssimRowSSE2;
+#endif
+    return ssimRowScalar;
+}
+
+// 8x8窗口（四个4x4块）的SSIM，常数与x264一致
+inline float ssimWindow(int32_t s1, int32_t s2, int32_t ss, int32_t s12) {
+    static const int32_t kC1 = static_cast<int32_t>(.01 * .01 * 255 * 255 * 64 + .5);
+    static const int32_t kC2 = static_cast<int32_t>(.03 * .03 * 255 * 255 * 64 * 63 + .5);
+    int32_t vars = ss * 64 - s1 * s1 - s2 * s2;
+    int32_t covar = s12 * 64 - s1 * s2;
+    return static_cast<float>(2 * s1 * s2 + kC1) * static_cast<float>(2 * covar + kC2)
+         / (static_cast<float>(s1 * s1 + s2 * s2 + kC1) * static_cast<float>(vars + kC2));
+}
+
+} // namespace
+
+uint64_t QualityAnalyzer::computeSSE(const uint8_t* a, int strideA,
+                                     const uint8_t* b, int strideB,
+                                     int width, int height) {
+    static const SseKernel kernel = selectSseKernel();
+    return kernel(a, strideA, b, strideB, width, height);
+}
+
+double QualityAnalyzer::computeSSIM(const uint8_t* a, int strideA,
+                                    const uint8_t* b, int strideB,
+                                    int width, int height) {
+    static const SsimRowKernel rowKernel = selectSsimRowKernel();
+
+    int blocksX = width / 4;
+    int blocksY = height / 4;
+    if (blocksX < 2 || blocksY < 2) {
+        return 1.0;
+    }
+
+    // 滚动保存相邻两行块的统计量
+    std::vector<int32_t> buffer(static_cast<size_t>(blocksX) * 4 * 2);
+    auto* prev = reinterpret_cast<int32_t (*)[4]>(buffer.data());
+    auto* curr = prev + blocksX;
+
+    rowKernel(a, strideA, b, strideB, blocksX, prev);
+
+    double total = 0.0;
+    for (int by = 1; by < blocksY; ++by) {
+        rowKernel(a + static_cast<ptrdiff_t>(by) * 4 * strideA, strideA,
+                  b + static_cast<ptrdiff_t>(by) * 4 * strideB, strideB,
+                  blocksX, curr);
+        float rowSum = 0.0f;
+        for (int bx = 0; bx + 1 < blocksX; ++bx) {
+            rowSum += ssimWindow(
+                prev[bx][0] + prev[bx + 1][0] + curr[bx][0] + curr[bx + 1][0],
+                prev[bx][1] + prev[bx + 1][1] + curr[bx][1] + curr[bx + 1][1],
+                prev[bx][2] + prev[bx + 1][2] + curr[bx][2] + curr[bx + 1][2],
+                prev[bx][3] + prev[bx + 1][3] + curr[bx][3] + curr[bx + 1][3]);
+        }
+        total += rowSum;
+        std::swap(prev, curr);
+    }
+
+    return total / (static_cast<double>(blocksX - 1) * (blocksY - 1));
+}
+
+double QualityAnalyzer::sseToPSNR(uint64_t sse, uint64_t pixels) {
+    if (sse == 0 || pixels == 0) {
+        return 100.0;
+    }
+    double psnr = 10.0 * std::log10(255.0 * 255.0 * static_cast<double>(pixels) / static_cast<double>(sse));
+    return std::min(psnr, 100.0);
+}
+
+QualityAnalyzer::QualityAnalyzer() = default;
+
+QualityAnalyzer::~QualityAnalyzer() {
+    if (running_) {
+        finish();
+    }
+    cleanup();
+}
+
+bool QualityAnalyzer::start(AVCodecID codecId, int width, int height, SourceProvider provider,
+                            int referenceWidth, int referenceHeight) {
+    if (running_) {
+        finish();
+    }
+    cleanup();
+
+    const AVCodec* codec = avcodec_find_decoder(codecId);
+    if (!codec) {
+        std::cerr << "画质评估：找不到解码器" << std::endl;
+        return false;
+    }
+
+    decoderCtx_ = avcodec_alloc_context3(codec);
+    if (!decoderCtx_) {
+        std::cerr << "画质评估：无法分配解码器上下文" << std::endl;
+        return false;
+    }
+    // 评估线程本身已与编码并行，解码器保持单线程避免抢占编码器CPU
+    decoderCtx_->thread_count = 1;
+
+    int ret = avcodec_open2(decoderCtx_, codec, nullptr);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        std::cerr << "画质评估：无法打开解码器: " << errbuf << std::endl;
+        cleanup();
+        return false;
+    }
+
+    decodedFrame_ = av_frame_alloc();
+    if (!decodedFrame_) {
+        cleanup();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    provider_ = std::move(provider);
+    decodedCount_ = 0;
+
+    if (referenceWidth <= 0 || referenceHeight <= 0) {
+        referenceWidth = width;
+        referenceHeight = height;
+    }
+    referenceLayout_ = FrameLayout::yuv420p(referenceWidth, referenceHeight);
+    upscale_ = referenceWidth != width || referenceHeight != height;
+    if (upscale_) {
+        // 按播放端的方式用双三次插值放大到显示分辨率
+        sws_ = sws_getContext(width, height, AV_PIX_FMT_YUV420P,
+                              referenceWidth, referenceHeight, AV_PIX_FMT_YUV420P,
+                              SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!sws_) {
+            std::cerr << "画质评估：无法创建缩放上下文" << std::endl;
+            cleanup();
+            return false;
+        }
+        upscaled_.resize(referenceLayout_.size);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(resultMutex_);
+        frameResults_.clear();
+        sumPsnrY_ = sumPsnrU_ = sumPsnrV_ = sumPsnr_ = sumSsim_ = 0.0;
+        analysisTime_ = 0.0;
+    }
+
+    running_ = true;
+    workerThread_ = std::thread(&QualityAnalyzer::workerFunc, this);
+    return true;
+}
+
+bool QualityAnalyzer::submitPacket(const AVPacket* packet) {
+    if (!running_ || !packet) {
+        return false;
+    }
+
+    AVPacket* ref = av_packet_alloc();
+    if (!ref) {
+        return false;
+    }
+    if (av_packet_ref(ref, packet) < 0) {
+        av_packet_free(&ref);
+        return false;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        spaceCv_.wait(lock, [this]() { return packetQueue_.size() < kMaxQueuedPackets; });
+        packetQueue_.push(ref);
+    }
+    queueCv_.notify_one();
+    return true;
+}
+
+QualityAnalyzer::Summary QualityAnalyzer::finish() {
+    if (running_) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            packetQueue_.push(nullptr);
+        }
+        queueCv_.notify_one();
+        if (workerThread_.joinable()) {
+            workerThread_.join();
+        }
+        running_ = false;
+    }
+    return snapshot();
+}
+
+QualityAnalyzer::Summary QualityAnalyzer::snapshot() const {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    Summary summary;
+    summary.frames = static_cast<int>(frameResults_.size());
+    summary.analysisTime = analysisTime_;
+    if (summary.frames > 0) {
+        summary.psnrY = sumPsnrY_ / summary.frames;
+        summary.psnrU = sumPsnrU_ / summary.frames;
+        summary.psnrV = sumPsnrV_ / summary.frames;
+        summary.psnr = sumPsnr_ / summary.frames;
+        summary.ssim = sumSsim_ / summary.frames;
+    }
+    return summary;
+}
+
+void QualityAnalyzer::workerFunc() {
+    // 画质评估不占用编码作业绑定的CPU
+    SweepScheduler::releaseCurrentThread();
+    while (true) {
+        AVPacket* packet = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this]() { return !packetQueue_.empty(); });
+            packet = packetQueue_.front();
+            packetQueue_.pop();
+        }
+        spaceCv_.notify_one();
+
+        auto busyStart = std::chrono::steady_clock::now();
+        bool flushing = (packet == nullptr);
+
+        int ret = avcodec_send_packet(decoderCtx_, packet);
+        if (ret < 0 && ret != AVERROR_EOF) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            std::cerr << "画质评估：解码失败: " << errbuf << std::endl;
+        }
+        if (packet) {
+            av_packet_free(&packet);
+        }
+
+        while (avcodec_receive_frame(decoderCtx_, decodedFrame_) >= 0) {
+            scoreFrame(decodedFrame_);
+            av_frame_unref(decodedFrame_);
+        }
+
+        double busyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - busyStart).count();
+        {
+            std::lock_guard<std::mutex> lock(resultMutex_);
+            analysisTime_ += busyTime;
+        }
+
+        if (flushing) {
+            break;
+        }
+    }
+}
+
+void QualityAnalyzer::scoreFrame(const AVFrame* decoded) {
+    // 解码输出按显示顺序排列，优先使用pts定位源帧
+    int64_t pts = decoded->pts != AV_NOPTS_VALUE ? decoded->pts : decodedCount_;
+    ++decodedCount_;
+
+    if (decoded->width != width_ || decoded->height != height_) {
+        std::cerr << "画质评估：解码尺寸与源帧不一致，跳过帧 " << pts << std::endl;
+        return;
+    }
+
+    SourcePlanes source;
+    if (!provider_ || !provider_(pts, source)) {
+        std::cerr << "画质评估：无法获取源帧 " << pts << std::endl;
+        return;
+    }
+
+    // 与源帧比较的解码平面，显示分辨率评估时为放大后的平面
+    const uint8_t* planes[3] = {decoded->data[0], decoded->data[1], decoded->data[2]};
+    int linesizes[3] = {decoded->linesize[0], decoded->linesize[1], decoded->linesize[2]};
+    if (upscale_) {
+        uint8_t* dst[4] = {referenceLayout_.plane(upscaled_.data(), 0), referenceLayout_.plane(upscaled_.data(), 1),
+                           referenceLayout_.plane(upscaled_.data(), 2), nullptr};
+        int dstLinesize[4] = {referenceLayout_.linesize[0], referenceLayout_.linesize[1],
+                              referenceLayout_.linesize[2], 0};
+        sws_scale(sws_, decoded->data, decoded->linesize, 0, height_, dst, dstLinesize);
+        for (int i = 0; i < 3; ++i) {
+            planes[i] = dst[i];
+            linesizes[i] = dstLinesize[i];
+        }
+    }
+
+    const int width = referenceLayout_.width;
+    const int height = referenceLayout_.height;
+    const int uvWidth = width / 2;
+    const int uvHeight = height / 2;
+    const uint64_t lumaPixels = static_cast<uint64_t>(width) * height;
+    const uint64_t chromaPixels = static_cast<uint64_t>(uvWidth) * uvHeight;
+
+    uint64_t sseY = computeSSE(source.data[0], source.linesize[0],
+                               planes[0], linesizes[0], width, height);
+    uint64_t sseU = computeSSE(source.data[1], source.linesize[1],
+                               planes[1], linesizes[1], uvWidth, uvHeight);
+    uint64_t sseV = computeSSE(source.data[2], source.linesize[2],
+                               planes[2], linesizes[2], uvWidth, uvHeight);
+
+    FrameQuality quality;
+    quality.pts = pts;
+    quality.psnrY = sseToPSNR(sseY, lumaPixels);
+    quality.psnrU = sseToPSNR(sseU, chromaPixels);
+    quality.psnrV = sseToPSNR(sseV, chromaPixels);
+    quality.psnr = sseToPSNR(sseY + sseU + sseV, lumaPixels + chromaPixels * 2);
+    quality.ssim = computeSSIM(source.data[0], source.linesize[0],
+                               planes[0], linesizes[0], width, height);
+
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    frameResults_.push_back(quality);
+    sumPsnrY_ += quality.psnrY;
+    sumPsnrU_ += quality.psnrU;
+    sumPsnrV_ += quality.psnrV;
+    sumPsnr_ += quality.psnr;
+    sumSsim_ += quality.ssim;
+}
+
+void QualityAnalyzer::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        while (!packetQueue_.empty()) {
+            AVPacket* packet = packetQueue_.front();
+            packetQueue_.pop();
+            if (packet) {
+                av_packet_free(&packet);
+            }
+        }
+    }
+    if (decoderCtx_) {
+        avcodec_free_context(&decoderCtx_);
+    }
+    if (decodedFrame_) {
+        av_frame_free(&decodedFrame_);
+    }
+    if (sws_) {
+        sws_freeContext(sws_);
+        sws_ = nullptr;
+    }
+    upscale_ = false;
+}
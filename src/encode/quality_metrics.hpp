@@ -0,0 +1,129 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "frame_store.hpp"
+
+struct SwsContext;
+
+// 画质评估器：在独立线程中解码编码后的数据包，并与源帧逐帧计算PSNR/SSIM
+class QualityAnalyzer {
+public:
+    // 源帧的三个平面（YUV420P，显示分辨率）
+    struct SourcePlanes {
+        const uint8_t* data[3]{nullptr, nullptr, nullptr};
+        int linesize[3]{0, 0, 0};
+    };
+
+    // 根据帧序号(pts)获取源帧，评估线程中调用
+    using SourceProvider = std::function<bool(int64_t pts, SourcePlanes& planes)>;
+
+    // 单帧评估结果
+    struct FrameQuality {
+        int64_t pts{0};
+        double psnrY{0.0};
+        double psnrU{0.0};
+        double psnrV{0.0};
+        double psnr{0.0};       // 三个平面合并后的PSNR
+        double ssim{0.0};       // 亮度SSIM
+    };
+
+    // 汇总结果
+    struct Summary {
+        int frames{0};
+        double psnrY{0.0};      // 逐帧平均
+        double psnrU{0.0};
+        double psnrV{0.0};
+        double psnr{0.0};
+        double ssim{0.0};
+        double analysisTime{0.0};  // 评估线程实际工作时间(秒)
+    };
+
+    QualityAnalyzer();
+    ~QualityAnalyzer();
+
+    QualityAnalyzer(const QualityAnalyzer&) = delete;
+    QualityAnalyzer& operator=(const QualityAnalyzer&) = delete;
+
+    // 创建解码器并启动评估线程
+    // referenceWidth/referenceHeight为源帧（显示）分辨率，与编码分辨率不同时解码结果先放大到显示分辨率再比较，
+    // 为0表示与编码分辨率相同
+    bool start(AVCodecID codecId, int width, int height, SourceProvider provider,
+               int referenceWidth = 0, int referenceHeight = 0);
+
+    // 提交编码包（pts需为编码器时间基下的帧序号），只增加引用计数不复制数据
+    // 待评估的数据包达到上限时阻塞，直到评估线程取走一个
+    bool submitPacket(const AVPacket* packet);
+
+    // 刷新解码器，等待评估线程处理完所有数据包
+    Summary finish();
+
+    // 当前累计结果，可在编码过程中调用
+    Summary snapshot() const;
+
+    // 逐帧结果，finish()之后有效
+    const std::vector<FrameQuality>& frameResults() const { return frameResults_; }
+
+    bool isRunning() const { return running_; }
+
+    // 计算两个平面的误差平方和（AVX2/SSE2/标量自动选择）
+    static uint64_t computeSSE(const uint8_t* a, int strideA,
+                               const uint8_t* b, int strideB,
+                               int width, int height);
+
+    // 计算两个平面的平均SSIM（8x8窗口，步长4，与x264一致）
+    static double computeSSIM(const uint8_t* a, int strideA,
+                              const uint8_t* b, int strideB,
+                              int width, int height);
+
+    // 误差平方和转换为PSNR，完全一致时返回100dB
+    static double sseToPSNR(uint64_t sse, uint64_t pixels);
+
+private:
+    void workerFunc();
+    void scoreFrame(const AVFrame* decoded);
+    void cleanup();
+
+    AVCodecContext* decoderCtx_{nullptr};
+    AVFrame* decodedFrame_{nullptr};
+    SourceProvider provider_;
+    int width_{0};
+    int height_{0};
+    int64_t decodedCount_{0};
+
+    // 显示分辨率评估：解码帧放大后的缓冲
+    FrameLayout referenceLayout_;
+    bool upscale_{false};
+    SwsContext* sws_{nullptr};
+    std::vector<uint8_t> upscaled_;
+    bool running_{false};
+
+    // 待解码数据包队列，nullptr表示刷新
+    // 队列有上限，评估跟不上编码时submitPacket阻塞等待，内存占用与序列长度无关
+    static constexpr size_t kMaxQueuedPackets = 64;
+    std::queue<AVPacket*> packetQueue_;
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;   // 队列非空
+    std::condition_variable spaceCv_;   // 队列有空位
+    std::thread workerThread_;
+
+    // 累计结果
+    mutable std::mutex resultMutex_;
+    std::vector<FrameQuality> frameResults_;
+    double sumPsnrY_{0.0};
+    double sumPsnrU_{0.0};
+    double sumPsnrV_{0.0};
+    double sumPsnr_{0.0};
+    double sumSsim_{0.0};
+    double analysisTime_{0.0};
+};
@@ -0,0 +1,333 @@
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <link.h>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdint.h>
+#include <x264.h>
+#include <vpx/vpx_codec.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr size_t kFileSample = 1 << 20;       // 单个文件每处取样的字节数
+constexpr size_t kSequenceSample = 64 << 10;  // 图片序列每个文件取样的字节数
+
+// 结果文件格式版本，字段变化时递增，旧结果自然失效
+constexpr int kFormatVersion = 1;
+
+uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+// 读取文件[offset, offset+size)并累积到键中，返回是否读满
+bool hashRange(int fd, off_t offset, size_t size, ResultCache::KeyBuilder& builder) {
+    std::string buffer(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = pread(fd, &buffer[done], size - done, offset + static_cast<off_t>(done));
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    builder.add("range", buffer);
+    return true;
+}
+
+bool hashFile(const std::string& path, size_t sample, bool sampleMiddleAndEnd, ResultCache::KeyBuilder& builder) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    const int fd = fileno(file);
+    struct stat st{};
+    bool ok = fstat(fd, &st) == 0;
+    const size_t size = ok ? static_cast<size_t>(st.st_size) : 0;
+    builder.add("size", static_cast<long long>(size));
+
+    if (ok && size <= (sampleMiddleAndEnd ? 3 * sample : sample)) {
+        ok = hashRange(fd, 0, size, builder);
+    } else if (ok) {
+        ok = hashRange(fd, 0, sample, builder);
+        if (ok && sampleMiddleAndEnd) {
+            ok = hashRange(fd, static_cast<off_t>((size - sample) / 2), sample, builder) &&
+                 hashRange(fd, static_cast<off_t>(size - sample), sample, builder);
+        }
+    }
+    std::fclose(file);
+    return ok;
+}
+
+std::string computeFingerprint(const std::string& path) {
+    ResultCache::KeyBuilder builder;
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::directory_iterator(path, ec)) {
+            if (entry.is_regular_file(ec)) {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto& file : files) {
+            builder.add("name", file.filename().string());
+            if (!hashFile(file.string(), kSequenceSample, false, builder)) {
+                return {};
+            }
+        }
+        return builder.key();
+    }
+    if (!hashFile(path, kFileSample, true, builder)) {
+        return {};
+    }
+    return builder.key();
+}
+
+// 进程中已加载的共享库中文件名以prefix开头的一个（解析符号链接），如libx264.so.164；未找到时返回空串
+std::string loadedLibrary(const std::string& prefix) {
+    struct Search {
+        const std::string& prefix;
+        std::string path;
+    } search{prefix, {}};
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+        auto& search = *static_cast<Search*>(data);
+        if (!info->dlpi_name || !*info->dlpi_name) {
+            return 0;
+        }
+        const std::string name = fs::path(info->dlpi_name).filename().string();
+        if (name.compare(0, search.prefix.size(), search.prefix) != 0) {
+            return 0;
+        }
+        std::error_code ec;
+        const fs::path resolved = fs::canonical(info->dlpi_name, ec);
+        search.path = ec ? name : resolved.filename().string();
+        return 1;
+    }, &search);
+    return search.path;
+}
+
+}  // namespace
+
+ResultCache::KeyBuilder::KeyBuilder()
+    : low_(kFnvOffset)
+    , high_(mix(kFnvOffset))
+{
+    add("format", static_cast<long long>(kFormatVersion));
+}
+
+void ResultCache::KeyBuilder::update(const void* data, size_t size) {
+    // 两路独立的FNV-1a，第二路对每个字节取反，合起来作为128位键
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        low_ = (low_ ^ bytes[i]) * kFnvPrime;
+        high_ = (high_ ^ static_cast<uint8_t>(~bytes[i])) * kFnvPrime;
+    }
+}
+
+ResultCache::KeyBuilder& ResultCache::KeyBuilder::add(const std::string& name, const std::string& value) {
+    // 名称和值都带长度前缀，避免不同的拼接得到相同的字节序列
+    const uint64_t nameSize = name.size();
+    const uint64_t valueSize = value.size();
+    update(&nameSize, sizeof(nameSize));
+    update(name.data(), name.size());
+    update(&valueSize, sizeof(valueSize));
+    update(value.data(), value.size());
+    return *this;
+}
+
+ResultCache::KeyBuilder& ResultCache::KeyBuilder::add(const std::string& name, const char* value) {
+    return add(name, std::string(value ? value : ""));
+}
+
+ResultCache::KeyBuilder& ResultCache::KeyBuilder::add(const std::string& name, long long value) {
+    return add(name, std::to_string(value));
+}
+
+std::string ResultCache::KeyBuilder::key() const {
+    char text[33];
+    std::snprintf(text, sizeof(text), "%016llx%016llx",
+                  static_cast<unsigned long long>(mix(high_)), static_cast<unsigned long long>(mix(low_)));
+    return text;
+}
+
+ResultCache::ResultCache(std::string directory)
+    : directory_(std::move(directory))
+{
+}
+
+std::string ResultCache::defaultDirectory() {
+    if (const char* xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/videolab/results";
+    }
+    const char* home = getenv("HOME");
+    return home ? std::string(home) + "/.cache/videolab/results" : std::string(".videolab_cache");
+}
+
+std::string ResultCache::path(const std::string& key) const {
+    return directory_ + "/" + key.substr(0, 2) + "/" + key;
+}
+
+bool ResultCache::load(const std::string& key, Fields& fields) const {
+    std::ifstream in(path(key));
+    if (!in) {
+        return false;
+    }
+
+    fields.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        fields.emplace_back(line.substr(0, equals), line.substr(equals + 1));
+    }
+    return !fields.empty();
+}
+
+bool ResultCache::store(const std::string& key, const Fields& fields) const {
+    const std::string target = path(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(target).parent_path(), ec);
+    if (ec) {
+        std::cerr << "无法创建结果缓存目录: " << ec.message() << std::endl;
+        return false;
+    }
+
+    // 临时文件名带进程号，并发写入同一个键时各写各的，重命名是原子的
+    const std::string temporary = target + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        for (const auto& field : fields) {
+            out << field.first << '=' << field.second << '\n';
+        }
+        if (!out.flush()) {
+            fs::remove(temporary, ec);
+            return false;
+        }
+    }
+    fs::rename(temporary, target, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+std::string ResultCache::sourceFingerprint(const std::string& path) {
+    if (path.empty()) {
+        return "synthetic";
+    }
+
+    // 同一进程中按路径、大小和修改时间记住指纹，网格中的每个点不必重复读取输入
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) {
+        return {};
+    }
+    std::ostringstream id;
+    id << path << '|' << st.st_size << '|' << st.st_mtim.tv_sec << '.' << st.st_mtim.tv_nsec;
+
+    static std::mutex mutex;
+    static std::map<std::string, std::string> fingerprints;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = fingerprints.find(id.str());
+        if (it != fingerprints.end()) {
+            return it->second;
+        }
+    }
+
+    const std::string fingerprint = computeFingerprint(path);
+    if (!fingerprint.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        fingerprints[id.str()] = fingerprint;
+    }
+    return fingerprint;
+}
+
+std::string ResultCache::encoderBuild(const std::string& encoder) {
+    std::string build = encoder + " ";
+    if (encoder == "libvpx") {
+        build += vpx_codec_version_str();
+    } else {
+        // libx264/libx265没有运行时版本接口，使用进程中实际加载的库文件名（soname带有build号）
+        const std::string library = loadedLibrary(encoder + ".so");
+        if (!library.empty()) {
+            build += library;
+        } else if (encoder == "libx264") {
+            build += "build " + std::to_string(X264_BUILD);  // 静态链接
+        }
+    }
+
+    // libavcodec的运行时版本和编译选项，升级或换用不同配置的FFmpeg时缓存失效
+    const unsigned version = avcodec_version();
+    KeyBuilder configuration;
+    configuration.add("configuration", avcodec_configuration());
+    return build + " / libavcodec " + std::to_string(AV_VERSION_MAJOR(version)) + "." +
+           std::to_string(AV_VERSION_MINOR(version)) + "." + std::to_string(AV_VERSION_MICRO(version)) +
+           " / " + av_version_info() + " / " + configuration.key();
+}
+
+std::string ResultCache::machine() {
+    static const std::string model = []() {
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 10, "model name") == 0) {
+                const size_t value = line.find_first_not_of(" \t", line.find(':') + 1);
+                return value == std::string::npos ? line : line.substr(value);
+            }
+        }
+        return std::string("unknown");
+    }();
+    return model;
+}
+
+const std::string* ResultCache::find(const Fields& fields, const std::string& name) {
+    for (const auto& field : fields) {
+        if (field.first == name) {
+            return &field.second;
+        }
+    }
+    return nullptr;
+}
+
+bool ResultCache::get(const Fields& fields, const std::string& name, double& value) {
+    const std::string* text = find(fields, name);
+    if (!text) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text->c_str(), &end);
+    return end != text->c_str();
+}
+
+std::string ResultCache::formatDouble(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
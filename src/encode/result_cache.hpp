@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 内容寻址的编码结果缓存：键为完整配置、输入源指纹、编码器版本和CPU型号的哈希
+// 配置、输入和编码器都没有变化时直接返回上次的结果，扩展参数网格时只编码新增的点
+// 每个结果存为一个文本文件 <目录>/<键的前2位>/<键>，先写临时文件再重命名，多个进程同时写入也不会读到半个文件
+class ResultCache {
+public:
+    // 按写入顺序保存的字段，值中不能有换行
+    using Fields = std::vector<std::pair<std::string, std::string>>;
+
+    // 逐项累积缓存键，每项带名称，字段顺序或含义变化时键随之变化
+    class KeyBuilder {
+    public:
+        KeyBuilder();
+
+        KeyBuilder& add(const std::string& name, const std::string& value);
+        KeyBuilder& add(const std::string& name, const char* value);
+        KeyBuilder& add(const std::string& name, long long value);
+        KeyBuilder& add(const std::string& name, int value) { return add(name, static_cast<long long>(value)); }
+        KeyBuilder& add(const std::string& name, bool value) { return add(name, static_cast<long long>(value)); }
+
+        // 128位哈希的十六进制形式
+        std::string key() const;
+
+    private:
+        void update(const void* data, size_t size);
+
+        uint64_t low_;
+        uint64_t high_;
+    };
+
+    explicit ResultCache(std::string directory = defaultDirectory());
+
+    // $XDG_CACHE_HOME/videolab/results，未设置时为~/.cache/videolab/results
+    static std::string defaultDirectory();
+
+    const std::string& directory() const { return directory_; }
+
+    bool load(const std::string& key, Fields& fields) const;
+    bool store(const std::string& key, const Fields& fields) const;
+
+    // 输入源指纹：文件按大小和开头、中间、结尾各1MiB的内容计算，图片序列目录按文件名、大小和每个文件开头64KiB计算
+    // 空路径（合成帧）返回"synthetic"，无法读取时返回空串（不使用缓存）
+    static std::string sourceFingerprint(const std::string& path);
+
+    // 运行时加载的编码器库版本："libx264"、"libx265"或"libvpx"，附带libavcodec的版本和编译选项
+    static std::string encoderBuild(const std::string& encoder);
+
+    // CPU型号，速度指标只在同型号机器之间复用
+    static std::string machine();
+
+    static const std::string* find(const Fields& fields, const std::string& name);
+    static bool get(const Fields& fields, const std::string& name, double& value);
+
+    // 按%.17g格式化，读回后与原值相同
+    static std::string formatDouble(double value);
+
+private:
+    std::string path(const std::string& key) const;
+
+    std::string directory_;
+};
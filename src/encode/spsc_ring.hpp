@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 单生产者/单消费者无锁环形缓冲区
+// 正常情况下只使用原子读写，仅在缓冲区满（生产者）或空（消费者）时才进入互斥锁等待
+template <typename T>
+class SpscRing {
+public:
+    // 容量向上取整为2的幂
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return slots_.size(); }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // 生产者：非阻塞写入，成功时value被移走
+    bool tryPush(T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        wakeIfWaiting(consumerWaiting_);
+        return true;
+    }
+
+    // 消费者：非阻塞读取
+    bool tryPop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        wakeIfWaiting(producerWaiting_);
+        return true;
+    }
+
+    // 生产者：缓冲区满时阻塞，已关闭时返回false
+    bool push(T value) {
+        while (!tryPush(value)) {
+            if (spinUntil([this] {
+                    return tail_.load(std::memory_order_relaxed) -
+                           head_.load(std::memory_order_acquire) < slots_.size();
+                })) {
+                continue;
+            }
+            if (closed()) {
+                return false;
+            }
+            waitFor(producerWaiting_, [this] {
+                return tail_.load(std::memory_order_relaxed) -
+                       head_.load(std::memory_order_acquire) < slots_.size();
+            });
+        }
+        return true;
+    }
+
+    // 消费者：缓冲区空时阻塞，关闭且取空后返回false
+    bool pop(T& value) {
+        while (!tryPop(value)) {
+            if (spinUntil([this] {
+                    return tail_.load(std::memory_order_acquire) !=
+                           head_.load(std::memory_order_relaxed);
+                })) {
+                continue;
+            }
+            if (closed()) {
+                // 关闭前写入的数据在closed_之前可见，再取一次确保不丢失
+                return tryPop(value);
+            }
+            waitFor(consumerWaiting_, [this] {
+                return tail_.load(std::memory_order_acquire) !=
+                       head_.load(std::memory_order_relaxed);
+            });
+        }
+        return true;
+    }
+
+    // 生产者：不再写入，唤醒等待的消费者
+    void close() {
+        closed_.store(true, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+
+    // 重新打开，调用时双方都不能在使用缓冲区
+    void reset() {
+        T discard;
+        while (tryPop(discard)) {
+        }
+        closed_.store(false, std::memory_order_release);
+    }
+
+private:
+    // 阻塞前短暂自旋，对端通常很快就会跟上，避免每次都进入内核等待
+    template <typename Ready>
+    static bool spinUntil(Ready ready) {
+        // 单核机器上自旋只会占用对端的时间片
+        static const int spinCount = std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+        for (int i = 0; i < spinCount; ++i) {
+            if (ready()) {
+                return true;
+            }
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        return false;
+    }
+
+    // 等待方先设置标志再检查条件，通知方先更新位置再检查标志（Dekker式），避免丢失唤醒
+    template <typename Ready>
+    void waitFor(std::atomic<bool>& waiting, Ready ready) {
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return ready() || closed(); });
+        }
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wakeIfWaiting(std::atomic<bool>& waiting) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+
+    static constexpr int kSpinCount = 256;
+
+    std::vector<T> slots_;
+    size_t mask_{0};
+
+    // 读写位置分别独占缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head_{0};  // 消费者位置
+    alignas(64) std::atomic<size_t> tail_{0};  // 生产者位置
+    alignas(64) std::atomic<bool> producerWaiting_{false};
+    std::atomic<bool> consumerWaiting_{false};
+    std::atomic<bool> closed_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
@@ -0,0 +1,162 @@
+#include "sweep_scheduler.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+// 由调度器分配线程数的作业，每个作业至少使用的核心数
+constexpr int kMinAutoThreads = 4;
+
+// 进程启动时（尚未绑定任何作业线程）可用的CPU
+const std::vector<int> kProcessCpus = SweepScheduler::availableCpus();
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+}  // namespace
+
+SweepScheduler::SweepScheduler(Options options)
+    : options_(options) {
+}
+
+std::vector<int> SweepScheduler::availableCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+void SweepScheduler::releaseCurrentThread() {
+    pinCurrentThread(kProcessCpus);
+}
+
+int SweepScheduler::autoThreads(int coreBudget, int autoJobs) {
+    int budget = static_cast<int>(availableCpus().size());
+    if (coreBudget > 0) {
+        budget = std::min(budget, coreBudget);
+    }
+    // 自动分配的作业平分预算，但不少于kMinAutoThreads
+    return autoJobs > 0 ? std::min(budget, std::max(kMinAutoThreads, budget / autoJobs)) : budget;
+}
+
+void SweepScheduler::run(std::vector<Job>& jobs) {
+    if (jobs.empty()) {
+        return;
+    }
+
+    std::vector<int> cpus = availableCpus();
+    if (options_.coreBudget > 0 && static_cast<size_t>(options_.coreBudget) < cpus.size()) {
+        cpus.resize(options_.coreBudget);
+    }
+    const int budget = static_cast<int>(cpus.size());
+
+    int autoJobs = 0;
+    for (const auto& job : jobs) {
+        if (job.threads <= 0) {
+            ++autoJobs;
+        }
+    }
+    const int autoWidth = autoThreads(options_.coreBudget, autoJobs);
+
+    std::vector<int> widths;
+    widths.reserve(jobs.size());
+    for (const auto& job : jobs) {
+        int width = job.threads > 0 ? job.threads : autoWidth;
+        widths.push_back(std::clamp(width, 1, budget));
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<bool> cpuBusy(cpus.size(), false);
+    std::vector<bool> started(jobs.size(), false);
+    int freeCpus = budget;
+    int running = 0;
+    size_t remaining = jobs.size();
+    std::vector<std::thread> workers;
+    workers.reserve(jobs.size());
+
+    std::cout << "并发调度: " << jobs.size() << " 个作业, " << budget << " 个核心" << std::endl;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+        bool launched = false;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (started[i] || widths[i] > freeCpus) {
+                continue;
+            }
+            if (options_.maxJobs > 0 && running >= options_.maxJobs) {
+                break;
+            }
+
+            // 分配编号最小的空闲CPU，相邻编号通常位于同一物理区域
+            std::vector<size_t> slots;
+            for (size_t c = 0; c < cpus.size() && static_cast<int>(slots.size()) < widths[i]; ++c) {
+                if (!cpuBusy[c]) {
+                    slots.push_back(c);
+                    cpuBusy[c] = true;
+                }
+            }
+            freeCpus -= widths[i];
+            started[i] = true;
+            ++running;
+            --remaining;
+            launched = true;
+
+            std::vector<int> jobCpus;
+            for (size_t slot : slots) {
+                jobCpus.push_back(cpus[slot]);
+            }
+
+            workers.emplace_back([&, i, slots, jobCpus]() {
+                if (options_.pinThreads && !pinCurrentThread(jobCpus)) {
+                    std::cerr << "无法绑定作业 " << i << " 到指定CPU" << std::endl;
+                }
+
+                jobs[i].run(widths[i]);
+
+                std::lock_guard<std::mutex> guard(mutex);
+                for (size_t slot : slots) {
+                    cpuBusy[slot] = false;
+                }
+                freeCpus += widths[i];
+                --running;
+                cv.notify_one();
+            });
+        }
+
+        if (remaining > 0 && !launched) {
+            cv.wait(lock);
+        }
+    }
+    lock.unlock();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+// 参数扫描调度器：在给定的CPU核心预算内同时运行多个编码测试
+// 每个作业独占一组互不重叠的CPU，作业线程绑定到这组CPU后再启动编码，编码器创建的线程继承该绑定
+// 写入、画质评估、预读和帧准备等辅助线程启动时调用releaseCurrentThread，不占用作业的CPU
+class SweepScheduler {
+public:
+    struct Options {
+        int coreBudget = 0;      // 可用核心数，0表示使用进程可用的全部CPU
+        int maxJobs = 0;         // 最多同时运行的作业数，0表示不限制
+        bool pinThreads = true;  // 是否将作业绑定到分配的CPU
+    };
+
+    struct Job {
+        int threads = 1;  // 作业需要的线程数，0表示由调度器分配
+        // 运行作业，参数为实际分配的CPU数
+        std::function<void(int threads)> run;
+    };
+
+    explicit SweepScheduler(Options options);
+    SweepScheduler() : SweepScheduler(Options()) {}
+
+    // 运行所有作业，全部完成后返回
+    // 按顺序调度，放不下的作业等待时允许后面较小的作业先运行
+    void run(std::vector<Job>& jobs);
+
+    // 进程当前可用的CPU编号
+    static std::vector<int> availableCpus();
+
+    // 解除调用线程从作业线程继承的绑定，恢复为进程启动时可用的全部CPU；未绑定时不改变
+    static void releaseCurrentThread();
+
+    // 共有autoJobs个由调度器分配线程数的作业时，每个作业分到的CPU数
+    static int autoThreads(int coreBudget, int autoJobs);
+
+private:
+    Options options_;
+};
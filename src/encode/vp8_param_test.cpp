@@ -1,9 +1,10 @@
 #include "vp8_param_test.hpp"
+#include "config_runner.hpp"
 #include <chrono>
 #include <iostream>
-#include <fstream>
-#include <thread>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 const char* VP8ParamTest::presetToString(Preset preset) {
     switch (preset) {
@@ -18,7 +19,7 @@ const char* VP8ParamTest::speedToString(Speed speed) {
     return std::to_string(static_cast<int>(speed)).c_str();
 }
 
-std::string VP8ParamTest::generateOutputPath(const std::string& suffix) {
+std::string VP8ParamTest::generateOutputPath(const std::string& suffix, const char* extension) {
     // 获取当前工作目录
     const char* workDir = getenv("PWD");
     if (!workDir) {
@@ -38,263 +39,79 @@ std::string VP8ParamTest::generateOutputPath(const std::string& suffix) {
     // 生成带时间戳的文件名
     std::string outputFile = outputDir + "/vp8_" +
                             std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) +
-                            "_" + suffix + ".webm";
+                            "_" + suffix + extension;
     
     return outputFile;
 }
 
 VP8ParamTest::VP8ParamTest() = default;
 
-VP8ParamTest::~VP8ParamTest() {
-    cleanup();
-}
-
-bool VP8ParamTest::initEncoder(const TestConfig& config, const std::string& outputFile) {
-    cleanup();
-
-    // 查找VP8编码器
-    const AVCodec* codec = avcodec_find_encoder_by_name("libvpx");
-    if (!codec) {
-        std::cerr << "找不到VP8编码器，请确保已安装libvpx" << std::endl;
-        return false;
-    }
-
-    // 创建编码器上下文
-    codecContext_ = avcodec_alloc_context3(codec);
-    if (!codecContext_) {
-        std::cerr << "无法分配编码器上下文" << std::endl;
-        return false;
-    }
-
-    // 设置基本参数
-    codecContext_->width = config.width;
-    codecContext_->height = config.height;
-    codecContext_->time_base = AVRational{1, config.fps};
-    codecContext_->framerate = AVRational{config.fps, 1};
-    codecContext_->pix_fmt = AV_PIX_FMT_YUV420P;
-    codecContext_->codec_type = AVMEDIA_TYPE_VIDEO;
-    codecContext_->thread_count = config.threads;
-
-    // 设置VP8特定参数
-    av_opt_set(codecContext_->priv_data, "quality", presetToString(config.preset), 0);
-    av_opt_set(codecContext_->priv_data, "speed", speedToString(config.speed), 0);
-    
-    switch (config.rate_control) {
-        case RateControl::CQ:
-            av_opt_set(codecContext_->priv_data, "crf", std::to_string(config.cq_level).c_str(), 0);
-            break;
-        case RateControl::CBR:
-            codecContext_->bit_rate = config.bitrate;
-            codecContext_->rc_min_rate = config.bitrate;
-            codecContext_->rc_max_rate = config.bitrate;
-            codecContext_->rc_buffer_size = config.bitrate;
-            break;
-        case RateControl::VBR:
-            codecContext_->bit_rate = config.bitrate;
-            codecContext_->rc_max_rate = static_cast<int64_t>(config.bitrate * 2);
-            codecContext_->rc_buffer_size = static_cast<int64_t>(config.bitrate * 4);
-            break;
-    }
-
-    codecContext_->qmin = config.qmin;
-    codecContext_->qmax = config.qmax;
-    codecContext_->gop_size = config.keyint;
-
-    // 打开编码器
-    int ret = avcodec_open2(codecContext_, codec, nullptr);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, sizeof(errbuf));
-        std::cerr << "无法打开编码器: " << errbuf << std::endl;
-        return false;
-    }
-
-    // 分配帧和数据包
-    frame_ = av_frame_alloc();
-    if (!frame_) {
-        std::cerr << "无法分配帧" << std::endl;
-        return false;
-    }
-
-    frame_->format = codecContext_->pix_fmt;
-    frame_->width = codecContext_->width;
-    frame_->height = codecContext_->height;
-
-    ret = av_frame_get_buffer(frame_, 0);
-    if (ret < 0) {
-        std::cerr << "无法分配帧缓冲" << std::endl;
-        return false;
-    }
-
-    packet_ = av_packet_alloc();
-    if (!packet_) {
-        std::cerr << "无法分配数据包" << std::endl;
-        return false;
-    }
-
-    // 打开输出文件
-    outputFile_ = fopen(outputFile.c_str(), "wb");
-    if (!outputFile_) {
-        std::cerr << "无法打开输出文件" << std::endl;
-        return false;
-    }
-
-    return true;
-}
-
-bool VP8ParamTest::encodeFrame(const uint8_t* data, int size) {
-    if (!codecContext_ || !frame_ || !packet_ || !outputFile_) {
-        return false;
-    }
-
-    // 复制数据到帧
-    av_image_copy_plane(frame_->data[0], frame_->linesize[0],
-                       data, codecContext_->width,
-                       codecContext_->width, codecContext_->height);
-    
-    av_image_copy_plane(frame_->data[1], frame_->linesize[1],
-                       data + codecContext_->width * codecContext_->height,
-                       codecContext_->width / 2,
-                       codecContext_->width / 2, codecContext_->height / 2);
-    
-    av_image_copy_plane(frame_->data[2], frame_->linesize[2],
-                       data + codecContext_->width * codecContext_->height * 5 / 4,
-                       codecContext_->width / 2,
-                       codecContext_->width / 2, codecContext_->height / 2);
-
-    // 发送帧到编码器
-    int ret = avcodec_send_frame(codecContext_, frame_);
-    if (ret < 0) {
-        return false;
+VP8ParamTest::~VP8ParamTest() = default;
+
+// VP8的参数映射，其余流程（输入、编码循环、输出和指标）由EncoderBackend完成
+struct VP8ParamTest::Traits {
+    using Config = TestConfig;
+    static constexpr const char* kEncoder = "libvpx";
+
+    static EncoderBackend::Options options(const Config& config) {
+        EncoderBackend::Options options;
+        options.width = config.width;
+        options.height = config.height;
+        options.fps = config.fps;
+        options.threads = config.threads;
+        options.frames = config.frames;
+        options.zeroCopy = config.zero_copy;
+        options.measureQuality = config.measure_quality;
+        options.sink = config.sink;
+        options.directOutput = config.direct_output;
+        // 批量写入按目标码率的两倍预分配文件，多分配的部分关闭时截断释放
+        if (config.fps > 0) {
+            options.expectedBytes = static_cast<uint64_t>(config.bitrate) / 8 *
+                                    static_cast<uint64_t>(config.frames) / config.fps * 2;
+        }
+        return options;
     }
 
-    // 接收编码后的数据包
-    while (ret >= 0) {
-        ret = avcodec_receive_packet(codecContext_, packet_);
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            break;
-        } else if (ret < 0) {
-            return false;
-        }
+    static bool configure(AVCodecContext* ctx, const Config& config) {
+        // 设置VP8特定参数
+        av_opt_set(ctx->priv_data, "quality", presetToString(config.preset), 0);
+        av_opt_set(ctx->priv_data, "speed", std::to_string(static_cast<int>(config.speed)).c_str(), 0);
 
-        // 写入数据包到文件
-        if (!addPacketToBuffer(packet_)) {
-            return false;
+        switch (config.rate_control) {
+            case RateControl::CQ:
+                av_opt_set(ctx->priv_data, "crf", std::to_string(config.cq_level).c_str(), 0);
+                break;
+            case RateControl::CBR:
+                ctx->bit_rate = config.bitrate;
+                ctx->rc_min_rate = config.bitrate;
+                ctx->rc_max_rate = config.bitrate;
+                ctx->rc_buffer_size = config.bitrate;
+                break;
+            case RateControl::VBR:
+                ctx->bit_rate = config.bitrate;
+                ctx->rc_max_rate = static_cast<int64_t>(config.bitrate * 2);
+                ctx->rc_buffer_size = static_cast<int64_t>(config.bitrate * 4);
+                break;
         }
 
-        av_packet_unref(packet_);
+        ctx->qmin = config.qmin;
+        ctx->qmax = config.qmax;
+        ctx->gop_size = config.keyint;
+        return true;
     }
-
-    return true;
-}
-
-void VP8ParamTest::cleanup() {
-    if (codecContext_) {
-        avcodec_free_context(&codecContext_);
-    }
-    if (frame_) {
-        av_frame_free(&frame_);
-    }
-    if (packet_) {
-        av_packet_free(&packet_);
-    }
-    if (outputFile_) {
-        fclose(outputFile_);
-        outputFile_ = nullptr;
-    }
-}
+};
 
 bool VP8ParamTest::initFrameCache(const TestConfig& config) {
-    if (framesGenerated_) {
+    if (source_.isOpen()) {
         return true;
     }
 
-    return generateFrames(config);
-}
-
-bool VP8ParamTest::generateFrames(const TestConfig& config) {
-    size_t thread_count = std::thread::hardware_concurrency();
-    if (thread_count == 0) thread_count = 1;
-    
-    if (thread_count > 1) {
-        generateFramesThreaded(config, thread_count);
-    } else {
-        frameCache_.resize(config.frames);
-        for (int i = 0; i < config.frames; ++i) {
-            frameCache_[i] = generateSingleFrame(config.width, config.height, i);
-        }
-    }
-
-    framesGenerated_ = true;
-    return true;
-}
-
-std::vector<uint8_t> VP8ParamTest::generateSingleFrame(int width, int height, int frameIndex) {
-    std::vector<uint8_t> frameData(width * height * 3 / 2);
-    uint8_t* y = frameData.data();
-    uint8_t* u = y + width * height;
-    uint8_t* v = u + (width * height) / 4;
-
-    // 生成YUV测试图案
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            // Y分量：生成移动的图案
-            int pattern = (i + j + frameIndex) % 255;
-            y[i * width + j] = pattern;
-
-            // U和V分量：每4个像素一个色度采样
-            if (i % 2 == 0 && j % 2 == 0) {
-                int uv_i = i / 2;
-                int uv_j = j / 2;
-                u[uv_i * (width/2) + uv_j] = 128 + pattern / 2;
-                v[uv_i * (width/2) + uv_j] = 128 - pattern / 2;
-            }
-        }
-    }
-
-    return frameData;
-}
-
-void VP8ParamTest::generateFramesThreaded(const TestConfig& config, size_t thread_count) {
-    frameCache_.resize(config.frames);
-    
-    std::vector<std::thread> threads;
-    size_t frames_per_thread = config.frames / thread_count;
-    size_t remaining_frames = config.frames % thread_count;
-    
-    size_t start_frame = 0;
-    for (size_t i = 0; i < thread_count; ++i) {
-        size_t thread_frames = frames_per_thread + (i < remaining_frames ? 1 : 0);
-        size_t end_frame = start_frame + thread_frames;
-        
-        threads.emplace_back(frameGenerationWorker,
-                           this, std::ref(config),
-                           start_frame, end_frame);
-        
-        start_frame = end_frame;
-    }
-    
-    for (auto& thread : threads) {
-        thread.join();
-    }
-}
-
-void VP8ParamTest::frameGenerationWorker(
-    VP8ParamTest* self,
-    const TestConfig& config,
-    size_t start_frame,
-    size_t end_frame)
-{
-    for (size_t i = start_frame; i < end_frame; ++i) {
-        self->frameCache_[i] = VP8ParamTest::generateSingleFrame(config.width, config.height, i);
-    }
-}
-
-const uint8_t* VP8ParamTest::getFrameData(size_t frameIndex) const {
-    if (frameIndex >= frameCache_.size()) {
-        return nullptr;
-    }
-    return frameCache_[frameIndex].data();
+    // 非流式输入放入~/frame_cache下的映射文件
+    EncodeSource::Options options;
+    options.directIo = config.direct_io;
+    options.cacheDir = EncodeSource::defaultCacheDir();
+    return source_.open(config.source_path, FrameLayout::yuv420p(config.width, config.height),
+                        config.frames, options);
 }
 
 VP8ParamTest::TestResult VP8ParamTest::runTest(
@@ -306,7 +123,8 @@ VP8ParamTest::TestResult VP8ParamTest::runTest(
 
     // 初始化帧缓存
     if (!test.initFrameCache(config)) {
-        std::cerr << "无法初始化帧缓存" << std::endl;
+        result.error = "无法初始化帧缓存";
+        std::cerr << result.error << std::endl;
         return result;
     }
 
@@ -324,86 +142,256 @@ VP8ParamTest::TestResult VP8ParamTest::runTest(
             break;
     }
     suffix += "_" + std::string(presetToString(config.preset));
-    std::string outputFile = generateOutputPath(suffix);
+    std::string outputFile;
+    if (OutputSink::writesFile(config.sink)) {
+        outputFile = generateOutputPath(suffix, config.sink == OutputSink::Kind::File ? ".ivf" : ".webm");
+        if (outputFile.empty()) {
+            result.error = "无法创建输出文件";
+            return result;
+        }
+    }
 
-    // 初始化编码器
-    if (!test.initEncoder(config, outputFile)) {
-        std::cerr << "无法初始化编码器" << std::endl;
+    // 初始化编码器，画质评估线程直接从输入取源帧
+    EncodeSource& source = test.source_;
+    auto source_planes = [&source](int64_t pts, QualityAnalyzer::SourcePlanes& planes) {
+        return source.planes(pts, planes);
+    };
+    if (!test.encoder_.open<Traits>(config, outputFile, source_planes)) {
+        result.error = "无法初始化编码器";
+        std::cerr << result.error << std::endl;
         return result;
     }
-
-    // 启动写入线程
-    test.startWriterThread();
-
-    // 开始编码
-    auto start_time = std::chrono::high_resolution_clock::now();
-    size_t total_size = 0;
+    result.output_file = outputFile;
 
     for (int i = 0; i < config.frames; ++i) {
-        const uint8_t* frame_data = test.getFrameData(i);
+        const uint8_t* frame_data = source.next(i);
         if (!frame_data) {
-            std::cerr << "无法获取帧 " << i << std::endl;
-            continue;
+            result.error = "无法获取帧 " + std::to_string(i);
+            std::cerr << result.error << std::endl;
+            return result;
         }
 
-        if (!test.encodeFrame(frame_data, config.width * config.height * 3 / 2)) {
-            std::cerr << "编码帧 " << i << " 失败" << std::endl;
-            continue;
+        if (!test.encoder_.encodeFrame(frame_data)) {
+            result.error = "编码帧 " + std::to_string(i) + " 失败";
+            std::cerr << result.error << std::endl;
+            return result;
         }
 
         if (progress_callback) {
-            auto current_time = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                current_time - start_time).count() / 1000.0;
-            
-            result.encoding_time = duration;
-            result.fps = (i + 1) / duration;
-            
+            const auto metrics = test.encoder_.snapshot();
+            result.encoding_time = metrics.encodingTime;
+            result.fps = metrics.fps;
+            result.encoded_bytes = metrics.encodedBytes;
+            result.bitrate = metrics.bitrate;
+            result.psnr = metrics.quality.psnr;
+            result.ssim = metrics.quality.ssim;
+
             progress_callback(i, result);
         }
     }
 
-    // 停止写入线程
-    test.stopWriterThread();
-
-    // 计算结果
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        end_time - start_time).count() / 1000.0;
+    // 刷新编码器缓存的帧
+    if (!test.encoder_.encodeFrame(nullptr)) {
+        result.error = "刷新编码器失败";
+        std::cerr << result.error << std::endl;
+        return result;
+    }
 
-    result.encoding_time = duration;
-    result.fps = config.frames / duration;
-    result.bitrate = (total_size * 8.0) / duration;
+    // 关闭输出（计入编码时间，便于比较各种输出方式）并等待画质评估完成
+    if (!test.encoder_.finish()) {
+        result.error = "写入输出失败";
+        return result;
+    }
 
-    // TODO: 计算PSNR和SSIM
-    result.psnr = 0.0;
-    result.ssim = 0.0;
+    // 计算结果，码率按视频时长而不是编码耗时计算
+    const auto& metrics = test.encoder_.metrics();
+    result.success = true;
+    result.encoding_time = metrics.encodingTime;
+    result.fps = metrics.fps;
+    result.encoded_bytes = metrics.encodedBytes;
+    result.bitrate = metrics.bitrate;
+    result.psnr = metrics.quality.psnr;
+    result.ssim = metrics.quality.ssim;
+    result.psnr_y = metrics.quality.psnrY;
+    result.psnr_u = metrics.quality.psnrU;
+    result.psnr_v = metrics.quality.psnrV;
+    result.quality_time = metrics.quality.analysisTime;
+    result.source_wait_time = source.waitTime();
+    result.latency = metrics.latency;
+    result.output = metrics.output;
 
     return result;
 }
 
+namespace {
+
+void printSweepResult(const VP8ParamTest::TestResult& result) {
+    if (!result.success) {
+        std::cout << "测试失败: " << result.error << std::endl << std::endl;
+        return;
+    }
+    std::cout << "编码时间: " << result.encoding_time << "秒" << std::endl;
+    std::cout << "编码速度: " << result.fps << " fps" << std::endl;
+    std::cout << "实际码率: " << result.bitrate / 1000.0 << " kbps (" << result.encoded_bytes << " 字节)" << std::endl;
+    std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
+    std::cout << "SSIM: " << result.ssim << std::endl;
+    std::cout << std::endl;
+}
+
+// 并发运行和结果缓存，见ConfigRunner
+struct RunnerTraits {
+    using Config = VP8ParamTest::TestConfig;
+    using Result = VP8ParamTest::TestResult;
+
+    // 测试方法或结果字段变化时递增，旧的缓存条目自然失效
+    static constexpr int kResultsVersion = 1;
+
+    static Result run(const Config& config) { return VP8ParamTest::runTest(config); }
+
+    // 缓存键覆盖TestConfig的全部字段，TestConfig增加字段时需要同时加到这里
+    static std::string cacheKey(const Config& config) {
+        const std::string source = ResultCache::sourceFingerprint(config.source_path);
+        if (source.empty()) {
+            return {};
+        }
+
+        ResultCache::KeyBuilder key;
+        key.add("codec", "vp8")
+           .add("results", kResultsVersion)
+           .add("encoder", ResultCache::encoderBuild("libvpx"))
+           .add("machine", ResultCache::machine())
+           .add("source", source)
+           .add("width", config.width)
+           .add("height", config.height)
+           .add("fps", config.fps)
+           .add("frames", config.frames)
+           .add("threads", config.threads)
+           .add("bitrate", config.bitrate)
+           .add("keyint", config.keyint)
+           .add("qmin", config.qmin)
+           .add("qmax", config.qmax)
+           .add("cq_level", config.cq_level)
+           .add("preset", static_cast<int>(config.preset))
+           .add("speed", static_cast<int>(config.speed))
+           .add("rate_control", static_cast<int>(config.rate_control))
+           .add("measure_quality", config.measure_quality)
+           .add("zero_copy", config.zero_copy)
+           .add("direct_io", config.direct_io)
+           .add("sink", OutputSink::kindToString(config.sink))
+           .add("direct_output", config.direct_output);
+        return key.key();
+    }
+
+    static ResultCache::Fields toCacheFields(const Result& result) {
+        return {
+            {"encoding_time", ResultCache::formatDouble(result.encoding_time)},
+            {"fps", ResultCache::formatDouble(result.fps)},
+            {"bitrate", ResultCache::formatDouble(result.bitrate)},
+            {"psnr", ResultCache::formatDouble(result.psnr)},
+            {"ssim", ResultCache::formatDouble(result.ssim)},
+            {"psnr_y", ResultCache::formatDouble(result.psnr_y)},
+            {"psnr_u", ResultCache::formatDouble(result.psnr_u)},
+            {"psnr_v", ResultCache::formatDouble(result.psnr_v)},
+            {"quality_time", ResultCache::formatDouble(result.quality_time)},
+            {"source_wait_time", ResultCache::formatDouble(result.source_wait_time)},
+            {"encoded_bytes", std::to_string(result.encoded_bytes)},
+            {"output_file", result.output_file},
+            {"output.packets", std::to_string(result.output.packets)},
+            {"output.bytes", std::to_string(result.output.bytes)},
+            {"output.file_bytes", std::to_string(result.output.fileBytes)},
+            {"output.open_time", ResultCache::formatDouble(result.output.openTime)},
+            {"output.write_time", ResultCache::formatDouble(result.output.writeTime)},
+            {"output.close_time", ResultCache::formatDouble(result.output.closeTime)},
+            {"output.cpu_time", ResultCache::formatDouble(result.output.cpuTime)},
+            {"output.io_wait_time", ResultCache::formatDouble(result.output.ioWaitTime)},
+            {"output.write", result.output.write.serialize()},
+            {"latency.copy", result.latency.copy.serialize()},
+            {"latency.send", result.latency.send.serialize()},
+            {"latency.receive", result.latency.receive.serialize()},
+            {"latency.total", result.latency.total.serialize()},
+            {"latency.delay", result.latency.delay.serialize()},
+        };
+    }
+
+    static bool fromCacheFields(const ResultCache::Fields& fields, Result& result) {
+        auto histogram = [&fields](const char* name, LatencyHistogram& out) {
+            const std::string* text = ResultCache::find(fields, name);
+            return text && out.deserialize(*text);
+        };
+
+        double encoded_bytes = 0.0;
+        double packets = 0.0;
+        double bytes = 0.0;
+        double file_bytes = 0.0;
+        auto& output = result.output;
+        const std::string* output_file = ResultCache::find(fields, "output_file");
+        const bool ok = ResultCache::get(fields, "encoding_time", result.encoding_time) &&
+                        ResultCache::get(fields, "fps", result.fps) &&
+                        ResultCache::get(fields, "bitrate", result.bitrate) &&
+                        ResultCache::get(fields, "psnr", result.psnr) &&
+                        ResultCache::get(fields, "ssim", result.ssim) &&
+                        ResultCache::get(fields, "psnr_y", result.psnr_y) &&
+                        ResultCache::get(fields, "psnr_u", result.psnr_u) &&
+                        ResultCache::get(fields, "psnr_v", result.psnr_v) &&
+                        ResultCache::get(fields, "quality_time", result.quality_time) &&
+                        ResultCache::get(fields, "source_wait_time", result.source_wait_time) &&
+                        ResultCache::get(fields, "encoded_bytes", encoded_bytes) &&
+                        ResultCache::get(fields, "output.packets", packets) &&
+                        ResultCache::get(fields, "output.bytes", bytes) &&
+                        ResultCache::get(fields, "output.file_bytes", file_bytes) &&
+                        ResultCache::get(fields, "output.open_time", output.openTime) &&
+                        ResultCache::get(fields, "output.write_time", output.writeTime) &&
+                        ResultCache::get(fields, "output.close_time", output.closeTime) &&
+                        ResultCache::get(fields, "output.cpu_time", output.cpuTime) &&
+                        ResultCache::get(fields, "output.io_wait_time", output.ioWaitTime) &&
+                        histogram("output.write", output.write) &&
+                        histogram("latency.copy", result.latency.copy) &&
+                        histogram("latency.send", result.latency.send) &&
+                        histogram("latency.receive", result.latency.receive) &&
+                        histogram("latency.total", result.latency.total) &&
+                        histogram("latency.delay", result.latency.delay) &&
+                        output_file;
+        result.encoded_bytes = static_cast<uint64_t>(encoded_bytes);
+        output.packets = static_cast<uint64_t>(packets);
+        output.bytes = static_cast<uint64_t>(bytes);
+        output.fileBytes = static_cast<uint64_t>(file_bytes);
+        if (output_file) {
+            result.output_file = *output_file;
+        }
+        result.success = ok;
+        return ok;
+    }
+};
+
+}  // namespace
+
+std::vector<VP8ParamTest::TestResult> VP8ParamTest::runConfigs(
+    const std::vector<TestConfig>& configs,
+    int core_budget,
+    const ResultCache* cache)
+{
+    return ConfigRunner::run<RunnerTraits>(configs, core_budget, cache);
+}
+
 std::vector<VP8ParamTest::TestResult> VP8ParamTest::runPresetTest(
     TestConfig base_config,
     const std::string& output_prefix)
 {
-    std::vector<TestResult> results;
     std::vector<Preset> presets = {Preset::BEST, Preset::GOOD, Preset::REALTIME};
 
     std::cout << "\n开始VP8预设测试...\n" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (auto preset : presets) {
-        std::cout << "测试预设: " << presetToString(preset) << std::endl;
-        
         base_config.preset = preset;
-        auto result = runTest(base_config);
-        results.push_back(result);
-        
-        std::cout << "编码时间: " << result.encoding_time << "秒" << std::endl;
-        std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-        std::cout << "实际码率: " << result.bitrate / 1000.0 << " kbps" << std::endl;
-        std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-        std::cout << "SSIM: " << result.ssim << std::endl;
-        std::cout << std::endl;
+        configs.push_back(base_config);
+    }
+
+    auto results = runConfigs(configs);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "测试预设: " << presetToString(presets[i]) << std::endl;
+        printSweepResult(results[i]);
     }
 
     return results;
@@ -413,12 +401,14 @@ std::vector<VP8ParamTest::TestResult> VP8ParamTest::runRateControlTest(
     TestConfig base_config,
     const std::string& output_prefix)
 {
-    std::vector<TestResult> results;
     std::vector<RateControl> modes = {RateControl::CQ, RateControl::CBR, RateControl::VBR};
     std::vector<int> bitrates = {1000000, 2000000, 4000000}; // 1Mbps, 2Mbps, 4Mbps
 
     std::cout << "\n开始VP8码率控制测试...\n" << std::endl;
 
+    std::vector<TestConfig> configs;
+    std::vector<std::string> descriptions;
+
     for (auto mode : modes) {
         std::string mode_str;
         switch (mode) {
@@ -430,39 +420,29 @@ std::vector<VP8ParamTest::TestResult> VP8ParamTest::runRateControlTest(
         if (mode == RateControl::CQ) {
             std::vector<int> cq_levels = {10, 20, 30, 40};
             for (int cq : cq_levels) {
-                std::cout << "测试CQ级别: " << cq << std::endl;
-                
                 base_config.rate_control = mode;
                 base_config.cq_level = cq;
-                auto result = runTest(base_config);
-                results.push_back(result);
-                
-                std::cout << "编码时间: " << result.encoding_time << "秒" << std::endl;
-                std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-                std::cout << "实际码率: " << result.bitrate / 1000.0 << " kbps" << std::endl;
-                std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-                std::cout << "SSIM: " << result.ssim << std::endl;
-                std::cout << std::endl;
+                configs.push_back(base_config);
+                descriptions.push_back("测试CQ级别: " + std::to_string(cq));
             }
         } else {
             for (int bitrate : bitrates) {
-                std::cout << "测试" << mode_str << "码率: " << bitrate / 1000000.0 << "Mbps" << std::endl;
-                
                 base_config.rate_control = mode;
                 base_config.bitrate = bitrate;
-                auto result = runTest(base_config);
-                results.push_back(result);
-                
-                std::cout << "编码时间: " << result.encoding_time << "秒" << std::endl;
-                std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-                std::cout << "实际码率: " << result.bitrate / 1000.0 << " kbps" << std::endl;
-                std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-                std::cout << "SSIM: " << result.ssim << std::endl;
-                std::cout << std::endl;
+                configs.push_back(base_config);
+                descriptions.push_back("测试" + mode_str + "码率: " +
+                                       std::to_string(bitrate / 1000000) + "Mbps");
             }
         }
     }
 
+    auto results = runConfigs(configs);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << descriptions[i] << std::endl;
+        printSweepResult(results[i]);
+    }
+
     return results;
 }
 
@@ -471,77 +451,21 @@ std::vector<VP8ParamTest::TestResult> VP8ParamTest::runQualityTest(
     const std::string& output_prefix,
     const std::vector<int>& quality_values)
 {
-    std::vector<TestResult> results;
-
     std::cout << "\n开始VP8质量参数测试...\n" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (int qp : quality_values) {
-        std::cout << "测试质量参数: " << qp << std::endl;
-        
         base_config.qmin = qp;
         base_config.qmax = qp;
-        auto result = runTest(base_config);
-        results.push_back(result);
-        
-        std::cout << "编码时间: " << result.encoding_time << "秒" << std::endl;
-        std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-        std::cout << "实际码率: " << result.bitrate / 1000.0 << " kbps" << std::endl;
-        std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-        std::cout << "SSIM: " << result.ssim << std::endl;
-        std::cout << std::endl;
+        configs.push_back(base_config);
     }
 
-    return results;
-}
-
-void VP8ParamTest::startWriterThread() {
-    writeBuffer_.done = false;
-    writeBuffer_.writer_thread = std::thread(&VP8ParamTest::writerThreadFunc, this);
-}
+    auto results = runConfigs(configs);
 
-void VP8ParamTest::stopWriterThread() {
-    {
-        std::lock_guard<std::mutex> lock(writeBuffer_.mutex);
-        writeBuffer_.done = true;
-    }
-    writeBuffer_.cv.notify_one();
-    if (writeBuffer_.writer_thread.joinable()) {
-        writeBuffer_.writer_thread.join();
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "测试质量参数: " << quality_values[i] << std::endl;
+        printSweepResult(results[i]);
     }
-}
 
-bool VP8ParamTest::addPacketToBuffer(const AVPacket* packet) {
-    std::vector<uint8_t> data(packet->data, packet->data + packet->size);
-    
-    {
-        std::lock_guard<std::mutex> lock(writeBuffer_.mutex);
-        writeBuffer_.packets.push(std::move(data));
-    }
-    writeBuffer_.cv.notify_one();
-    
-    return true;
+    return results;
 }
-
-void VP8ParamTest::writerThreadFunc() {
-    while (true) {
-        std::vector<uint8_t> packet_data;
-        
-        {
-            std::unique_lock<std::mutex> lock(writeBuffer_.mutex);
-            writeBuffer_.cv.wait(lock, [this]() {
-                return !writeBuffer_.packets.empty() || writeBuffer_.done;
-            });
-            
-            if (writeBuffer_.packets.empty() && writeBuffer_.done) {
-                break;
-            }
-            
-            packet_data = std::move(writeBuffer_.packets.front());
-            writeBuffer_.packets.pop();
-        }
-        
-        if (!packet_data.empty()) {
-            fwrite(packet_data.data(), 1, packet_data.size(), outputFile_);
-        }
-    }
-} 
\ No newline at end of file
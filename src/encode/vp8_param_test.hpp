@@ -3,19 +3,16 @@
 #include <string>
 #include <vector>
 #include <functional>
-#include <memory>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
 #include <libavutil/opt.h>
-#include <libavutil/imgutils.h>
 }
 
+#include "encoder_backend.hpp"
+
+class ResultCache;
+
 class VP8ParamTest {
 public:
     // 预设选项
@@ -59,7 +56,7 @@ public:
         int height = 1080;
         int fps = 30;
         int frames = 300;
-        int threads = 1;
+        int threads = 0;        // 0表示自动：单独运行时由编码器决定，并发运行时按核心预算分配
         int bitrate = 2000000;  // 比特率 (bps)
         int keyint = 250;       // 关键帧间隔
         int qmin = 0;           // 最小量化参数
@@ -68,15 +65,32 @@ public:
         Preset preset = Preset::GOOD;
         Speed speed = Speed::SPEED_0;
         RateControl rate_control = RateControl::VBR;
+        bool measure_quality = true;  // 是否计算PSNR/SSIM
+        bool zero_copy = true;        // 直接提交缓存中的帧，false时逐行复制
+        std::string source_path;      // 图片序列目录或视频文件，为空时使用合成帧；.y4m/.yuv流式读取
+        bool direct_io = false;       // 流式读取时使用O_DIRECT
+        OutputSink::Kind sink = OutputSink::Kind::Mux;  // mux封装为可拖动的WebM，file写IVF
+        bool direct_output = false;   // file/mux输出使用预分配+大块O_DIRECT批量写入（io_uring或pwrite）
     };
 
     // 测试结果
     struct TestResult {
         double encoding_time;    // 编码时间 (秒)
         double fps;             // 编码速度 (帧/秒)
-        double bitrate;         // 实际码率 (bps)
+        double bitrate;         // 实际码率 (bps)，按编码字节数和视频时长(frames/fps)计算
         double psnr;            // PSNR值
         double ssim;            // SSIM值
+        double psnr_y;          // 各平面PSNR
+        double psnr_u;
+        double psnr_v;
+        double quality_time;    // 画质评估耗时 (秒)
+        double source_wait_time;  // 等待流式输入帧就绪的时间 (秒)
+        uint64_t encoded_bytes;   // 编码器输出的码流字节数，不含封装开销
+        EncoderBackend::Latency latency;  // 各阶段耗时和输入到数据包延迟的分布
+        OutputSink::Stats output;  // 输出的字节数和打开/写入/关闭耗时
+        std::string output_file;   // 输出文件路径，null/memory输出时为空
+        bool success = false;      // 全部帧编码、刷新并写入输出
+        std::string error;         // 失败原因
     };
 
     using ProgressCallback = std::function<void(int, const TestResult&)>;
@@ -93,6 +107,14 @@ public:
         ProgressCallback progress_callback = nullptr
     );
 
+    // 并发运行一组配置，按核心预算同时调度多个编码（core_budget为0时使用全部可用CPU）
+    // 结果顺序与configs一致；指定cache时先查缓存，只编码未命中的配置，成功的结果写回缓存
+    static std::vector<TestResult> runConfigs(
+        const std::vector<TestConfig>& configs,
+        int core_budget = 0,
+        const ResultCache* cache = nullptr
+    );
+
     // 运行预设测试
     static std::vector<TestResult> runPresetTest(
         TestConfig base_config,
@@ -116,44 +138,14 @@ public:
     bool initFrameCache(const TestConfig& config);
 
 protected:
-    bool initEncoder(const TestConfig& config, const std::string& outputFile);
-    bool encodeFrame(const uint8_t* data, int size);
-    void cleanup();
-
-    bool generateFrames(const TestConfig& config);
-    const uint8_t* getFrameData(size_t frameIndex) const;
-
-    // 帧生成相关的静态方法
-    static std::vector<uint8_t> generateSingleFrame(int width, int height, int frameIndex);
-    void generateFramesThreaded(const TestConfig& config, size_t thread_count);
-    static void frameGenerationWorker(VP8ParamTest* self, const TestConfig& config,
-                             size_t start_frame, size_t end_frame);
-
-    // 生成输出文件路径
-    static std::string generateOutputPath(const std::string& suffix);
+    // 生成输出文件路径，extension包含点
+    static std::string generateOutputPath(const std::string& suffix, const char* extension = ".webm");
 
 private:
-    // 编码器相关
-    AVCodecContext* codecContext_{nullptr};
-    AVFrame* frame_{nullptr};
-    AVPacket* packet_{nullptr};
-    FILE* outputFile_{nullptr};
-
-    // 帧缓存
-    std::vector<std::vector<uint8_t>> frameCache_;
-    bool framesGenerated_{false};
-
-    // 写入缓冲
-    struct WriteBuffer {
-        std::mutex mutex;
-        std::condition_variable cv;
-        std::queue<std::vector<uint8_t>> packets;
-        bool done{false};
-        std::thread writer_thread;
-    } writeBuffer_;
-
-    void startWriterThread();
-    void stopWriterThread();
-    bool addPacketToBuffer(const AVPacket* packet);
-    void writerThreadFunc();
-}; 
\ No newline at end of file
+    // 编码器后端的参数映射，见EncoderBackend
+    struct Traits;
+
+    // 输入帧：Y4M/原始YUV流式读取，其他来源放入帧缓存（需在编码器之后析构）
+    EncodeSource source_;
+    EncoderBackend encoder_;
+};
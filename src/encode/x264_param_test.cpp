@@ -1,22 +1,51 @@
-#include <filesystem>
 #include "x264_param_test.hpp"
+#include "config_runner.hpp"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <cmath>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <filesystem>
-#include <fstream>
-
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/opt.h>
-#include <libavutil/imgutils.h>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+// 在$PWD/datas下生成输出文件名，失败时返回空串并填写error
+std::string makeOutputFile(const X264ParamTest::TestConfig& config, const std::string& prefix, std::string& error,
+                           const char* extension = ".mp4") {
+    const char* workDir = getenv("PWD");
+    if (!workDir) {
+        error = "无法获取当前工作目录";
+        return {};
+    }
+    
+    std::string outputDir = std::string(workDir) + "/datas";
+    
+    // 确保输出目录存在
+    if (system(("mkdir -p '" + outputDir + "'").c_str()) != 0) {
+        error = "无法创建输出目录: " + outputDir;
+        return {};
+    }
+    
+    return outputDir + "/" + prefix + "_" +
+           std::to_string(config.width) + "x" + std::to_string(config.height) + "_" +
+           std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) +
+           extension;
+}
+
+// 预计的输出大小，用于批量写入时预分配文件
+// ABR/CBR按目标码率估算，其余模式按约20:1的压缩比宽松估算，多分配的部分关闭时截断释放
+uint64_t expectedOutputBytes(const X264ParamTest::TestConfig& config) {
+    const uint64_t frames = static_cast<uint64_t>(std::max(config.frameCount, 0));
+    if ((config.rateControl == X264ParamTest::RateControl::ABR ||
+         config.rateControl == X264ParamTest::RateControl::CBR) && config.fps > 0) {
+        return static_cast<uint64_t>(config.bitrate) / 8 * frames / config.fps * 5 / 4;
+    }
+    return static_cast<uint64_t>(config.width) * config.height * 3 / 2 * frames / 20;
 }
 
+}  // namespace
+
 const char* X264ParamTest::presetToString(Preset preset) {
     switch (preset) {
         case Preset::UltraFast: return "ultrafast";
@@ -49,559 +78,126 @@ const char* X264ParamTest::tuneToString(Tune tune) {
 }
 
 X264ParamTest::X264ParamTest() = default;
-X264ParamTest::~X264ParamTest() {
-    cleanup();
-}
-
-bool X264ParamTest::initEncoder(const TestConfig& config, const std::string& outputFile) {
-    cleanup();
-
-    // 查找编码器
-    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
-    if (!codec) {
-        std::cerr << "找不到x264编码器，请确保已安装libx264" << std::endl;
-        return false;
-    }
-
-    // 创建编码器上下文
-    encoderCtx_ = avcodec_alloc_context3(codec);
-    if (!encoderCtx_) {
-        std::cerr << "无法分配编码器上下文" << std::endl;
-        return false;
-    }
-
-    // 设置基本参数
-    encoderCtx_->width = config.width;
-    encoderCtx_->height = config.height;
-    encoderCtx_->time_base = AVRational{1, 25}; // 固定帧率为25fps
-    encoderCtx_->framerate = AVRational{25, 1};
-    encoderCtx_->pix_fmt = AV_PIX_FMT_YUV420P;
-    encoderCtx_->thread_count = config.threads;
-    encoderCtx_->codec_type = AVMEDIA_TYPE_VIDEO;
-
-    std::cout << "编码器参数设置:" << std::endl;
-    std::cout << "分辨率: " << encoderCtx_->width << "x" << encoderCtx_->height << std::endl;
-    std::cout << "帧率: " << encoderCtx_->framerate.num << "/" << encoderCtx_->framerate.den << std::endl;
-    std::cout << "线程数: " << encoderCtx_->thread_count << std::endl;
-
-    // 设置码率控制
-    switch (config.rateControl) {
-        case RateControl::CRF:
-            std::cout << "使用CRF模式，CRF值: " << config.crf << std::endl;
-            if (av_opt_set_int(encoderCtx_->priv_data, "crf", config.crf, 0) < 0) {
-                std::cerr << "设置CRF值失败" << std::endl;
-                return false;
-            }
-            break;
-        case RateControl::CQP:
-            std::cout << "使用CQP模式，QP值: " << config.qp << std::endl;
-            encoderCtx_->global_quality = config.qp * FF_QP2LAMBDA;
-            encoderCtx_->flags |= AV_CODEC_FLAG_QSCALE;
-            break;
-        case RateControl::ABR:
-            std::cout << "使用ABR模式，目标码率: " << config.bitrate << " bps" << std::endl;
-            encoderCtx_->bit_rate = config.bitrate;
-            break;
-        case RateControl::CBR:
-            std::cout << "使用CBR模式，固定码率: " << config.bitrate << " bps" << std::endl;
-            encoderCtx_->bit_rate = config.bitrate;
-            encoderCtx_->rc_max_rate = config.bitrate;
-            encoderCtx_->rc_min_rate = config.bitrate;
-            encoderCtx_->rc_buffer_size = config.bitrate / 2;
-            break;
-    }
-
-    // 设置预设和调优
-    const char* preset = presetToString(config.preset);
-    const char* tune = tuneToString(config.tune);
-    std::cout << "使用预设: " << preset << std::endl;
-    std::cout << "使用调优: " << (tune ? tune : "none") << std::endl;
-
-    if (av_opt_set(encoderCtx_->priv_data, "preset", preset, 0) < 0) {
-        std::cerr << "设置预设失败" << std::endl;
-        return false;
-    }
-    if (tune && av_opt_set(encoderCtx_->priv_data, "tune", tune, 0) < 0) {
-        std::cerr << "设置调优失败" << std::endl;
-        return false;
-    }
-
-    // 设置GOP参数
-    encoderCtx_->gop_size = config.keyintMax;
-    encoderCtx_->max_b_frames = config.bframes;
-    encoderCtx_->refs = config.refs;
-
-    std::cout << "GOP参数:" << std::endl;
-    std::cout << "关键帧间隔: " << encoderCtx_->gop_size << std::endl;
-    std::cout << "B帧数量: " << encoderCtx_->max_b_frames << std::endl;
-    std::cout << "参考帧数: " << encoderCtx_->refs << std::endl;
-
-    // 打开编码器
-    int ret = avcodec_open2(encoderCtx_, codec, nullptr);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, sizeof(errbuf));
-        std::cerr << "无法打开编码器: " << errbuf << std::endl;
-        return false;
+X264ParamTest::~X264ParamTest() = default;
+
+// x264的参数映射，其余流程（输入、编码循环、节奏、输出和指标）由EncoderBackend完成
+struct X264ParamTest::Traits {
+    using Config = TestConfig;
+    static constexpr const char* kEncoder = "libx264";
+
+    static EncoderBackend::Options options(const Config& config) {
+        EncoderBackend::Options options;
+        options.width = config.width;
+        options.height = config.height;
+        options.fps = config.fps;
+        options.threads = config.threads;
+        options.frames = config.frameCount;
+        options.zeroCopy = config.zeroCopy;
+        options.measureQuality = config.measureQuality;
+        options.displayWidth = config.displayWidth;
+        options.displayHeight = config.displayHeight;
+        options.paced = config.paced;
+        options.frameLatency = true;
+        options.sink = config.sink;
+        options.directOutput = config.directOutput;
+        options.mp4Mode = config.mp4Mode;
+        options.expectedBytes = expectedOutputBytes(config);
+        return options;
     }
-    std::cout << "编码器打开成功" << std::endl;
-
-    // 如果指定了输出文件，创建输出上下文
-    if (!outputFile.empty()) {
-        std::cout << "创建输出文件: " << outputFile << std::endl;
-        formatCtx_ = avformat_alloc_context();
-        if (!formatCtx_) {
-            std::cerr << "无法分配格式上下文" << std::endl;
-            return false;
-        }
 
-        // 根据文件名推断格式
-        formatCtx_->oformat = av_guess_format(nullptr, outputFile.c_str(), nullptr);
-        if (!formatCtx_->oformat) {
-            std::cerr << "无法推断输出格式" << std::endl;
-            return false;
+    static bool configure(AVCodecContext* ctx, const Config& config) {
+        // 设置码率控制
+        switch (config.rateControl) {
+            case RateControl::CRF:
+                if (av_opt_set_int(ctx->priv_data, "crf", config.crf, 0) < 0) {
+                    std::cerr << "设置CRF值失败" << std::endl;
+                    return false;
+                }
+                break;
+            case RateControl::CQP:
+                ctx->global_quality = config.qp * FF_QP2LAMBDA;
+                ctx->flags |= AV_CODEC_FLAG_QSCALE;
+                break;
+            case RateControl::ABR:
+                ctx->bit_rate = config.bitrate;
+                break;
+            case RateControl::CBR:
+                ctx->bit_rate = config.bitrate;
+                ctx->rc_max_rate = config.bitrate;
+                ctx->rc_min_rate = config.bitrate;
+                ctx->rc_buffer_size = config.bitrate / 2;
+                break;
         }
 
-        // 打开输出文件
-        ret = avio_open(&formatCtx_->pb, outputFile.c_str(), AVIO_FLAG_WRITE);
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "无法打开输出文件: " << outputFile << " - " << errbuf << std::endl;
+        // 设置预设和调优
+        if (av_opt_set(ctx->priv_data, "preset", presetToString(config.preset), 0) < 0) {
+            std::cerr << "设置预设失败" << std::endl;
             return false;
         }
-
-        // 创建视频流
-        stream_ = avformat_new_stream(formatCtx_, codec);
-        if (!stream_) {
-            std::cerr << "无法创建视频流" << std::endl;
+        const char* tune = tuneToString(config.tune);
+        if (tune && av_opt_set(ctx->priv_data, "tune", tune, 0) < 0) {
+            std::cerr << "设置调优失败" << std::endl;
             return false;
         }
 
-        // 复制编码器参数到流
-        ret = avcodec_parameters_from_context(stream_->codecpar, encoderCtx_);
-        if (ret < 0) {
-            std::cerr << "无法复制编码器参数到流" << std::endl;
-            return false;
-        }
+        // 设置GOP参数
+        ctx->gop_size = config.keyintMax;
+        ctx->max_b_frames = config.bframes;
+        ctx->refs = config.refs;
 
-        // 写入文件头
-        ret = avformat_write_header(formatCtx_, nullptr);
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "无法写入文件头: " << errbuf << std::endl;
+        // 设置分析参数，覆盖预设中的对应值
+        ctx->me_range = config.meRange;
+        if (av_opt_set(ctx->priv_data, "weightp", config.weightedPred ? "smart" : "none", 0) < 0) {
+            std::cerr << "设置加权预测失败" << std::endl;
             return false;
         }
-        std::cout << "输出文件初始化成功" << std::endl;
-    }
-
-    // 分配帧和包
-    frame_ = av_frame_alloc();
-    packet_ = av_packet_alloc();
-    if (!frame_ || !packet_) {
-        std::cerr << "无法分配帧或包" << std::endl;
-        return false;
-    }
-
-    frame_->format = encoderCtx_->pix_fmt;
-    frame_->width = encoderCtx_->width;
-    frame_->height = encoderCtx_->height;
-
-    ret = av_frame_get_buffer(frame_, 0);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, sizeof(errbuf));
-        std::cerr << "无法分配帧缓冲区: " << errbuf << std::endl;
-        return false;
-    }
-
-    startTime_ = std::chrono::steady_clock::now();
-    frameCount_ = 0;
-
-    // 在成功初始化后启动写入线程
-    if (!outputFile.empty()) {
-        startWriterThread();
-        std::cout << "写入线程已启动" << std::endl;
-    }
-
-    return true;
-}
-
-bool X264ParamTest::encodeFrame(const uint8_t* data, int size) {
-    if (!encoderCtx_ || !frame_ || !packet_) {
-        std::cerr << "编码器未正确初始化" << std::endl;
-        return false;
-    }
-
-    auto totalStart = std::chrono::steady_clock::now();
-    frameStartTime_ = totalStart;
-
-    // 如果data为空，表示刷新编码器
-    if (!data) {
-        std::cout << "刷新编码器缓冲区..." << std::endl;
-        int ret = avcodec_send_frame(encoderCtx_, nullptr);
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "刷新编码器失败: " << errbuf << std::endl;
+        if (av_opt_set(ctx->priv_data, "coder", config.cabac ? "cabac" : "cavlc", 0) < 0) {
+            std::cerr << "设置熵编码失败" << std::endl;
             return false;
         }
-    } else {
-        // 计时：帧数据复制
-        auto copyStart = std::chrono::steady_clock::now();
-        
-        // 复制输入数据到帧
-        int ret = av_frame_make_writable(frame_);
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "无法使帧可写: " << errbuf << std::endl;
+        // 只影响两遍编码的首遍
+        if (av_opt_set_int(ctx->priv_data, "fastfirstpass", config.fastFirstPass ? 1 : 0, 0) < 0) {
+            std::cerr << "设置快速首遍编码失败" << std::endl;
             return false;
         }
-
-        // 复制Y平面
-        for (int i = 0; i < frame_->height; i++) {
-            memcpy(frame_->data[0] + i * frame_->linesize[0],
-                   data + i * frame_->width,
-                   frame_->width);
-        }
-        // 复制U和V平面（假设YUV420P格式）
-        int uvHeight = frame_->height / 2;
-        int uvWidth = frame_->width / 2;
-        uint8_t* uData = const_cast<uint8_t*>(data + frame_->width * frame_->height);
-        uint8_t* vData = const_cast<uint8_t*>(uData + uvWidth * uvHeight);
-
-        for (int i = 0; i < uvHeight; i++) {
-            memcpy(frame_->data[1] + i * frame_->linesize[1],
-                   uData + i * uvWidth,
-                   uvWidth);
-            memcpy(frame_->data[2] + i * frame_->linesize[2],
-                   vData + i * uvWidth,
-                   uvWidth);
-        }
-
-        auto copyEnd = std::chrono::steady_clock::now();
-        double copyTime = std::chrono::duration<double>(copyEnd - copyStart).count();
-
-        frame_->pts = frameCount_++;
-
-        // 发送帧进行编码
-        auto encodeStart = std::chrono::steady_clock::now();
-        ret = avcodec_send_frame(encoderCtx_, frame_);
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "发送帧到编码器失败: " << errbuf << std::endl;
-            return false;
-        }
-        auto encodeSendEnd = std::chrono::steady_clock::now();
-        double encodeSendTime = std::chrono::duration<double>(encodeSendEnd - encodeStart).count();
-
-        // 更新性能指标
-        perfMetrics_.totalFrameCopyTime += copyTime;
-        perfMetrics_.avgFrameCopyTime = perfMetrics_.totalFrameCopyTime / frameCount_;
-        perfMetrics_.maxFrameCopyTime = std::max(perfMetrics_.maxFrameCopyTime, copyTime);
-    }
-
-    // 接收编码后的包
-    bool gotPacket = false;
-    auto receiveStart = std::chrono::steady_clock::now();
-    double totalReceiveTime = 0.0;
-
-    while (true) {
-        auto packetStart = std::chrono::steady_clock::now();
-        int ret = avcodec_receive_packet(encoderCtx_, packet_);
-        if (ret == AVERROR(EAGAIN)) {
-            break;
-        } else if (ret == AVERROR_EOF) {
-            if (!data) {
-                break;
-            }
-            std::cerr << "编码器意外返回EOF" << std::endl;
-            return false;
-        } else if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            std::cerr << "接收编码包失败: " << errbuf << std::endl;
-            return false;
-        }
-
-        auto packetEnd = std::chrono::steady_clock::now();
-        double packetTime = std::chrono::duration<double>(packetEnd - packetStart).count();
-        totalReceiveTime += packetTime;
-
-        gotPacket = true;
-        bitrate_ = (bitrate_ * (frameCount_ - 1) + packet_->size * 8.0 * encoderCtx_->time_base.den / encoderCtx_->time_base.num) / frameCount_;
-
-        // 如果有输出文件，将数据包添加到缓冲区
-        if (formatCtx_) {
-            av_packet_rescale_ts(packet_, encoderCtx_->time_base, stream_->time_base);
-            if (!addPacketToBuffer(packet_)) {
-                std::cerr << "添加包到写入缓冲区失败" << std::endl;
-                return false;
-            }
-        }
-
-        av_packet_unref(packet_);
-    }
-
-    auto totalEnd = std::chrono::steady_clock::now();
-    double totalFrameTime = std::chrono::duration<double>(totalEnd - totalStart).count();
-
-    // 更新性能指标
-    perfMetrics_.totalEncodingTime += totalReceiveTime;
-    perfMetrics_.totalFrames++;
-    perfMetrics_.avgEncodingTimePerFrame = perfMetrics_.totalEncodingTime / perfMetrics_.totalFrames;
-    perfMetrics_.maxEncodingTimePerFrame = std::max(perfMetrics_.maxEncodingTimePerFrame, totalReceiveTime);
-    perfMetrics_.totalFrameTime += totalFrameTime;
-    perfMetrics_.avgTotalTimePerFrame = perfMetrics_.totalFrameTime / perfMetrics_.totalFrames;
-
-    frameTime_ = totalFrameTime;
-    encodingTime_ = std::chrono::duration<double>(totalEnd - startTime_).count();
-    fps_ = frameCount_ / encodingTime_;
-
-    // 每100帧输出一次性能统计
-    if (frameCount_ % 100 == 0) {
-        std::cout << "\n性能统计 (帧 " << frameCount_ << "):" << std::endl;
-        std::cout << "平均帧复制时间: " << std::fixed << std::setprecision(3) 
-                  << perfMetrics_.avgFrameCopyTime * 1000 << " ms" << std::endl;
-        std::cout << "平均编码时间: " << std::fixed << std::setprecision(3) 
-                  << perfMetrics_.avgEncodingTimePerFrame * 1000 << " ms" << std::endl;
-        std::cout << "平均写入时间: " << std::fixed << std::setprecision(3) 
-                  << perfMetrics_.avgWritingTimePerFrame * 1000 << " ms" << std::endl;
-        std::cout << "平均总处理时间: " << std::fixed << std::setprecision(3) 
-                  << perfMetrics_.avgTotalTimePerFrame * 1000 << " ms" << std::endl;
-        std::cout << "当前编码速度: " << std::fixed << std::setprecision(1) 
-                  << fps_ << " fps" << std::endl;
-        std::cout << "实际每帧间隔: " << std::fixed << std::setprecision(3)
-                  << (1000.0 / fps_) << " ms" << std::endl;
-    }
-
-    return true;
-}
-
-void X264ParamTest::cleanup() {
-    // 停止写入线程
-    stopWriterThread();
-    
-    if (formatCtx_) {
-        if (formatCtx_->pb) {
-            avio_closep(&formatCtx_->pb);
-        }
-        avformat_free_context(formatCtx_);
-        formatCtx_ = nullptr;
-    }
-    if (encoderCtx_) {
-        avcodec_free_context(&encoderCtx_);
-    }
-    if (frame_) {
-        av_frame_free(&frame_);
-    }
-    if (packet_) {
-        av_packet_free(&packet_);
-    }
-    stream_ = nullptr;
-}
-
-bool X264ParamTest::initFrameCache(const TestConfig& config) {
-    frameCache_.clear();
-    frameCache_.frame_size = config.width * config.height * 3 / 2;  // YUV420P
-    frameCache_.total_frames = config.frameCount;
-
-    // 计算总内存需求
-    size_t total_memory_needed = frameCache_.frame_size * frameCache_.total_frames;
-    
-    // 使用磁盘缓存以避免内存问题
-    frameCache_.use_disk_cache = true;
-    frameCache_.cache_dir = std::string(getenv("HOME")) + "/frame_cache";
-    std::filesystem::create_directories(frameCache_.cache_dir);
-
-    return generateFrames(config);
-}
-
-std::vector<uint8_t> X264ParamTest::generateSingleFrame(int width, int height, int frameIndex) {
-    std::vector<uint8_t> frameData(width * height * 3 / 2);  // YUV420P
-    
-    // 生成Y平面（亮度）- 使用更简单的模式
-    float time = frameIndex * 0.1f;
-    int pattern_size = 32;  // 增大模式尺寸，减少计算次数
-    
-    #pragma omp parallel for collapse(2)
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            // 简化的条纹模式
-            int stripe = ((x + y + frameIndex * 4) / pattern_size) & 1;
-            
-            // 简化的波浪效果
-            float wave = sin((x + y + frameIndex * 3) * 0.02f) * 64.0f;
-            
-            // 组合效果
-            float value = 128.0f + stripe * 64.0f + wave;
-            frameData[y * width + x] = static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f));
-        }
+        return true;
     }
+};
 
-    // 生成U和V平面（色度）- 使用简化的彩色模式
-    int uvWidth = width / 2;
-    int uvHeight = height / 2;
-    uint8_t* uPlane = frameData.data() + width * height;
-    uint8_t* vPlane = uPlane + uvWidth * uvHeight;
-
-    #pragma omp parallel for collapse(2)
-    for (int y = 0; y < uvHeight; y++) {
-        for (int x = 0; x < uvWidth; x++) {
-            // 简化的色彩变化
-            float colorPhase = (x + y + frameIndex * 2) * 0.1f;
-            
-            // U分量 - 蓝色变化
-            float u_value = 128.0f + 64.0f * sin(colorPhase);
-            
-            // V分量 - 红色变化
-            float v_value = 128.0f + 64.0f * cos(colorPhase);
-            
-            uPlane[y * uvWidth + x] = static_cast<uint8_t>(u_value);
-            vPlane[y * uvWidth + x] = static_cast<uint8_t>(v_value);
-        }
+bool X264ParamTest::initFrameCache(const TestConfig& config, std::function<void(float)> progress) {
+    if (source_.isOpen()) {
+        return true;
     }
 
-    return frameData;
-}
-
-void X264ParamTest::generateFramesThreaded(const TestConfig& config, size_t thread_count) {
-    // 使用系统线程数，但不超过帧数
-    thread_count = std::min(thread_count, frameCache_.total_frames);
-    thread_count = std::max(thread_count, size_t(1));
-
-    // 预分配内存
-    if (!frameCache_.use_disk_cache) {
-        frameCache_.frame_buffer.resize(frameCache_.total_frames);
-        for (auto& frame : frameCache_.frame_buffer) {
-            frame.reserve(frameCache_.frame_size);
-        }
-    }
-
-    std::vector<std::thread> threads;
-    threads.reserve(thread_count);  // 预分配线程数组
-
-    size_t frames_per_thread = frameCache_.total_frames / thread_count;
-    size_t remaining_frames = frameCache_.total_frames % thread_count;
-
-    // 重置生成状态
-    {
-        std::lock_guard<std::mutex> lock(gen_status_.mutex);
-        gen_status_.completed_frames = 0;
-        gen_status_.is_generating = true;
-        gen_status_.total_frames = frameCache_.total_frames;
-        gen_status_.last_progress = 0.0f;
+    std::cout << "开始生成帧数据..." << std::endl;
+    if (!config.sourcePath.empty()) {
+        std::cout << "从输入源解码帧: " << config.sourcePath << std::endl;
     }
-
-    // 启动工作线程
-    size_t start_frame = 0;
-    for (size_t i = 0; i < thread_count; ++i) {
-        size_t thread_frames = frames_per_thread + (i < remaining_frames ? 1 : 0);
-        size_t end_frame = start_frame + thread_frames;
-        
-        threads.emplace_back(&X264ParamTest::frameGenerationWorker, 
-                           this, config, start_frame, end_frame);
-        
-        start_frame = end_frame;
+    const auto start = std::chrono::steady_clock::now();
+
+    // 显示分辨率与编码分辨率不同时，源帧按显示分辨率准备，缩小后编码
+    EncodeSource::Options options;
+    options.directIo = config.directIo;
+    options.cacheDir = EncodeSource::defaultCacheDir();
+    options.displayWidth = config.displayWidth;
+    options.displayHeight = config.displayHeight;
+    if (progress) {
+        options.progress = [progress](size_t completed, size_t total) {
+            progress(std::min(static_cast<float>(completed) / total, 1.0f));
+        };
     }
-
-    // 等待所有线程完成
-    for (auto& thread : threads) {
-        thread.join();
+    if (!source_.open(config.sourcePath, FrameLayout::yuv420p(config.width, config.height),
+                      config.frameCount, options)) {
+        return false;
     }
 
-    // 确保所有帧都已生成
-    {
-        std::lock_guard<std::mutex> lock(gen_status_.mutex);
-        if (gen_status_.completed_frames >= gen_status_.total_frames && 
-            gen_status_.progress_callback && 
-            gen_status_.last_progress < 1.0f) {
-            gen_status_.last_progress = 1.0f;
-            gen_status_.progress_callback(1.0f);
-        }
+    if (!source_.streaming()) {
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "帧生成完成，耗时: " << std::fixed << std::setprecision(2) << elapsed << " 秒" << std::endl;
     }
-
-    gen_status_.is_generating = false;
-}
-
-void X264ParamTest::frameGenerationWorker(
-    X264ParamTest* self,
-    const TestConfig& config,
-    size_t start_frame,
-    size_t end_frame
-) {
-    // 为每个线程预分配一个帧缓冲区，避免重复分配
-    std::vector<uint8_t> frameBuffer;
-    frameBuffer.reserve(self->frameCache_.frame_size);
-
-    for (size_t i = start_frame; i < end_frame; ++i) {
-        frameBuffer = self->generateSingleFrame(config.width, config.height, i);
-        
-        if (self->frameCache_.use_disk_cache) {
-            std::string filename = self->frameCache_.cache_dir + "/frame_" + std::to_string(i) + ".yuv";
-            std::ofstream file(filename, std::ios::binary);
-            file.write(reinterpret_cast<const char*>(frameBuffer.data()), frameBuffer.size());
-        } else {
-            self->frameCache_.frame_buffer[i] = std::move(frameBuffer);
-            frameBuffer.reserve(self->frameCache_.frame_size);  // 重新分配容量
-        }
-
-        // 更新进度
-        {
-            std::lock_guard<std::mutex> lock(self->gen_status_.mutex);
-            size_t completed = ++self->gen_status_.completed_frames;
-            if (self->gen_status_.progress_callback) {
-                float progress = static_cast<float>(completed) / self->gen_status_.total_frames;
-                // 确保进度不超过1.0且只在进度变化时更新
-                progress = std::min(progress, 1.0f);
-                if (progress > self->gen_status_.last_progress) {
-                    self->gen_status_.last_progress = progress;
-                    self->gen_status_.progress_callback(progress);
-                }
-            }
-        }
-    }
-}
-
-bool X264ParamTest::generateFrames(const TestConfig& config) {
-    std::cout << "开始生成帧数据..." << std::endl;
-    auto genStart = std::chrono::steady_clock::now();
-
-    // 使用系统CPU核心数的4倍作为线程数，以充分利用CPU
-    size_t thread_count = std::thread::hardware_concurrency() * 4;
-    generateFramesThreaded(config, thread_count);
-
-    auto genEnd = std::chrono::steady_clock::now();
-    double genTime = std::chrono::duration<double>(genEnd - genStart).count();
-    std::cout << "\n帧生成完成，耗时: " << std::fixed << std::setprecision(2) 
-              << genTime << " 秒" << std::endl;
-
-    frameCache_.is_initialized = true;
     return true;
 }
 
-const uint8_t* X264ParamTest::getFrameData(size_t frameIndex) const {
-    if (!frameCache_.is_initialized || frameIndex >= frameCache_.total_frames) {
-        return nullptr;
-    }
-
-    if (frameCache_.use_disk_cache) {
-        static std::vector<uint8_t> buffer;  // 静态缓冲区避免重复分配
-        buffer.resize(frameCache_.frame_size);
-        
-        std::string filename = frameCache_.cache_dir + "/frame_" + std::to_string(frameIndex) + ".yuv";
-        std::ifstream file(filename, std::ios::binary);
-        file.read(reinterpret_cast<char*>(buffer.data()), frameCache_.frame_size);
-        
-        return buffer.data();
-    } else {
-        return frameCache_.frame_buffer[frameIndex].data();
-    }
-}
-
 X264ParamTest::TestResult X264ParamTest::runTest(
     const TestConfig& config,
     std::function<void(int, const TestResult&)> progressCallback
@@ -612,10 +208,15 @@ X264ParamTest::TestResult X264ParamTest::runTest(
     std::cout << "开始编码测试..." << std::endl;
     std::cout << "配置信息:" << std::endl;
     std::cout << "分辨率: " << config.width << "x" << config.height << std::endl;
+    if (config.displayWidth > 0 && config.displayHeight > 0 &&
+        (config.displayWidth != config.width || config.displayHeight != config.height)) {
+        std::cout << "显示分辨率: " << config.displayWidth << "x" << config.displayHeight << std::endl;
+    }
     std::cout << "帧数: " << config.frameCount << std::endl;
     std::cout << "线程数: " << config.threads << std::endl;
     std::cout << "预设: " << presetToString(config.preset) << std::endl;
     std::cout << "调优: " << (tuneToString(config.tune) ? tuneToString(config.tune) : "none") << std::endl;
+    std::cout << "帧提交: " << (config.zeroCopy ? "零拷贝" : "逐行复制") << std::endl;
 
     // 检查配置参数
     if (config.width <= 0 || config.height <= 0 || config.frameCount <= 0) {
@@ -624,72 +225,74 @@ X264ParamTest::TestResult X264ParamTest::runTest(
         return result;
     }
 
-    // 生成输出文件名
+    // 生成输出文件名，null/memory输出不写文件；原始码流为Annex B格式
     std::string outputFile;
-    const char* workDir = getenv("PWD");
-    if (!workDir) {
-        std::cerr << "无法获取当前工作目录" << std::endl;
-        result.errorMessage = "无法获取当前工作目录";
-        return result;
+    if (OutputSink::writesFile(config.sink)) {
+        const char* extension = config.sink == OutputSink::Kind::File ? ".h264" : ".mp4";
+        outputFile = makeOutputFile(config, "output", result.errorMessage, extension);
+        if (outputFile.empty()) {
+            std::cerr << result.errorMessage << std::endl;
+            return result;
+        }
+        std::cout << "输出文件: " << outputFile << std::endl;
+        // 中途失败时也报告输出文件，分片MP4中已写完的分片仍可分析
+        result.outputFile = outputFile;
     }
-    
-    std::string outputDir = std::string(workDir) + "/datas";
-    
-    // 确保输出目录存在
-    if (system(("mkdir -p '" + outputDir + "'").c_str()) != 0) {
-        std::cerr << "无法创建输出目录: " << outputDir << std::endl;
-        result.errorMessage = "无法创建输出目录";
+
+    // 初始化并生成帧缓存
+    std::cout << "初始化帧缓存..." << std::endl;
+    X264ParamTest test;
+    if (!test.initFrameCache(config)) {
+        result.errorMessage = "初始化帧缓存失败";
+        std::cerr << result.errorMessage << std::endl;
         return result;
     }
-    
-    outputFile = outputDir + "/output_" +
-                std::to_string(config.width) + "x" + std::to_string(config.height) + "_" +
-                std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) +
-                ".mp4";
-    
-    std::cout << "输出文件: " << outputFile << std::endl;
+    std::cout << "帧缓存初始化成功" << std::endl;
+    EncodeSource& source = test.source_;
 
-    X264ParamTest test;
+    // 编码时间从帧缓存就绪、打开编码器时算起，不含解码和缓存输入的时间
+    // 画质评估线程直接从输入取源帧，encoder需在source之前析构
     std::cout << "初始化编码器..." << std::endl;
-    if (!test.initEncoder(config, outputFile)) {
+    EncoderBackend encoder;
+    auto sourcePlanes = [&source](int64_t pts, QualityAnalyzer::SourcePlanes& planes) {
+        return source.planes(pts, planes);
+    };
+    if (!encoder.open<Traits>(config, outputFile, sourcePlanes)) {
         result.errorMessage = "初始化编码器失败";
         std::cerr << result.errorMessage << std::endl;
         return result;
     }
     std::cout << "编码器初始化成功" << std::endl;
 
-    // 初始化并生成帧缓存
-    std::cout << "初始化帧缓存..." << std::endl;
-    if (!test.initFrameCache(config)) {
-        result.errorMessage = "初始化帧缓存失败";
-        std::cerr << result.errorMessage << std::endl;
-        return result;
+    std::cout << "开始编码帧..." << std::endl;
+    if (config.paced && config.fps > 0) {
+        std::cout << "实时节奏输入: " << config.fps << " fps" << std::endl;
     }
-    std::cout << "帧缓存初始化成功" << std::endl;
 
-    std::cout << "开始编码帧..." << std::endl;
-    // 编码所有帧
+    // 编码所有帧，实时节奏输入时由encodeFrame等到每帧的到达时刻
     for (int i = 0; i < config.frameCount; i++) {
-        const uint8_t* frameData = test.getFrameData(i);
+        const uint8_t* frameData = source.next(i);
         if (!frameData) {
             result.errorMessage = "获取帧 " + std::to_string(i) + " 数据失败";
             std::cerr << result.errorMessage << std::endl;
             return result;
         }
 
-        if (!test.encodeFrame(frameData, test.frameCache_.frame_size)) {
+        if (!encoder.encodeFrame(frameData)) {
             result.errorMessage = "编码帧 " + std::to_string(i) + " 失败";
             std::cerr << result.errorMessage << std::endl;
             return result;
         }
 
         if (progressCallback) {
+            const auto metrics = encoder.snapshot();
             TestResult current;
-            current.encodingTime = test.frameTime_;
-            current.fps = test.getFPS();
-            current.bitrate = test.getBitrate();
-            current.psnr = test.getPSNR();
-            current.ssim = test.getSSIM();
+            current.encodingTime = metrics.encodingTime;
+            current.fps = metrics.fps;
+            current.bitrate = metrics.bitrate;
+            current.encodedBytes = metrics.encodedBytes;
+            current.psnr = metrics.quality.psnr;
+            current.ssim = metrics.quality.ssim;
             progressCallback(i + 1, current);
         }
 
@@ -701,45 +304,575 @@ X264ParamTest::TestResult X264ParamTest::runTest(
 
     std::cout << "刷新编码器缓冲区..." << std::endl;
     // 编码完成后，刷新编码器缓冲区
-    if (!test.encodeFrame(nullptr, 0)) {
+    if (!encoder.encodeFrame(nullptr)) {
         result.errorMessage = "刷新编码器失败";
         std::cerr << result.errorMessage << std::endl;
         return result;
     }
 
-    std::cout << "写入文件尾..." << std::endl;
-    // 写入文件尾并关闭文件
-    if (test.formatCtx_ && test.formatCtx_->pb) {
-        // 写入文件尾
-        if (av_write_trailer(test.formatCtx_) < 0) {
-            result.errorMessage = "写入文件尾失败";
-            std::cerr << result.errorMessage << std::endl;
-            return result;
-        }
-        // 关闭输出文件
-        avio_closep(&test.formatCtx_->pb);
+    // 等待写入线程写完所有数据包，写入文件尾并落盘，再等待画质评估完成
+    std::cout << "关闭输出..." << std::endl;
+    if (!encoder.finish()) {
+        result.errorMessage = "写入输出失败";
+        std::cerr << result.errorMessage << std::endl;
+        return result;
     }
 
+    const auto& metrics = encoder.metrics();
+    const auto& quality = metrics.quality;
     result.success = true;
-    result.encodingTime = test.getEncodingTime();
-    result.fps = test.getFPS();
-    result.bitrate = test.getBitrate();
-    result.psnr = test.getPSNR();
-    result.ssim = test.getSSIM();
+    result.encodingTime = metrics.encodingTime;
+    result.fps = metrics.fps;
+    result.bitrate = metrics.bitrate;
+    result.encodedBytes = metrics.encodedBytes;
+    result.psnr = quality.psnr;
+    result.ssim = quality.ssim;
+    result.psnrY = quality.psnrY;
+    result.psnrU = quality.psnrU;
+    result.psnrV = quality.psnrV;
+    result.qualityTime = quality.analysisTime;
+    result.sourceWaitTime = source.waitTime();
+    result.latency = metrics.latency;
+    result.frameDelay = metrics.frameDelay;
+    result.frameLatency = metrics.frameLatency;
+    std::sort(result.frameLatency.begin(), result.frameLatency.end(),
+              [](const EncoderBackend::FrameLatency& a, const EncoderBackend::FrameLatency& b) {
+                  return a.pts < b.pts;
+              });
+    result.pacing = metrics.pacing;
+    result.output = metrics.output;
     result.outputFile = outputFile;
 
     std::cout << "编码完成!" << std::endl;
     std::cout << "编码时间: " << result.encodingTime << "秒" << std::endl;
     std::cout << "平均速度: " << result.fps << " fps" << std::endl;
     std::cout << "平均码率: " << result.bitrate / 1000.0 << " kbps" << std::endl;
+    if (quality.frames > 0) {
+        std::cout << "PSNR: " << result.psnr << " dB (Y " << result.psnrY
+                  << " / U " << result.psnrU << " / V " << result.psnrV << ")" << std::endl;
+        std::cout << "SSIM: " << result.ssim << std::endl;
+        std::cout << "画质评估耗时: " << result.qualityTime << "秒" << std::endl;
+    }
+    if (source.streaming()) {
+        std::cout << "等待输入帧: " << result.sourceWaitTime << "秒" << std::endl;
+    }
+    const auto& latency = result.latency;
+    std::cout << "帧准备: " << latency.copy.format() << std::endl;
+    std::cout << "送入编码器: " << latency.send.format() << std::endl;
+    std::cout << "取出数据包: " << latency.receive.format() << std::endl;
+    if (OutputSink::writesFile(config.sink) || config.sink == OutputSink::Kind::Memory) {
+        std::cout << "写入: " << result.output.write.format() << std::endl;
+    }
+    std::cout << "单帧总计: " << latency.total.format() << std::endl;
+    if (latency.delay.count() > 0) {
+        std::cout << "输入到数据包: " << latency.delay.format() << std::endl;
+        std::cout << "  B帧重排序: " << result.frameDelay.reorder.format() << std::endl;
+        std::cout << "  前瞻缓冲: " << result.frameDelay.lookahead.format() << std::endl;
+        std::cout << "  编码计算: " << result.frameDelay.compute.format() << std::endl;
+    }
+    if (config.sink != OutputSink::Kind::Null) {
+        const auto& output = result.output;
+        std::cout << "输出(" << OutputSink::kindToString(config.sink) << "): "
+                  << output.bytes << " 字节, 打开 " << output.openTime * 1000.0 << " ms, 写入 "
+                  << output.writeTime << " 秒, 关闭 " << output.closeTime * 1000.0 << " ms" << std::endl;
+        std::cout << "写入线程CPU: " << output.cpuTime << " 秒, 输出速度: "
+                  << output.bytesPerSecond() / (1024.0 * 1024.0) << " MiB/s";
+        if (config.directOutput) {
+            std::cout << " (" << (output.ioUring ? "io_uring" : "pwrite")
+                      << (output.directIo ? ", O_DIRECT" : "") << ", 等待写完 " << output.ioWaitTime << " 秒)";
+        }
+        std::cout << std::endl;
+    }
+    if (result.pacing.enabled) {
+        const auto& pacing = result.pacing;
+        std::cout << "错过截止时间: " << pacing.deadlineMisses << "/" << pacing.frames << " 帧 ("
+                  << pacing.missRatio() * 100.0 << "%)" << std::endl;
+        std::cout << "超时: " << pacing.lateness.format() << std::endl;
+        std::cout << "积压: 最多 " << pacing.maxBacklog << " 帧, 结束时 " << pacing.finalBacklog
+                  << " 帧, 增长 " << pacing.backlogGrowth << " 帧/秒" << std::endl;
+        std::cout << "实时判定: " << (pacing.realtime ? "可持续实时" : "无法保持实时") << std::endl;
+    }
+
+    return result;
+}
+
+X264ParamTest::ChunkOutput::~ChunkOutput() {
+    for (AVPacket* packet : packets) {
+        av_packet_free(&packet);
+    }
+    avcodec_parameters_free(&parameters);
+}
+
+void X264ParamTest::encodeChunk(const TestConfig& config, const EncodeSource& source,
+                                size_t first, size_t count, bool globalHeader, ChunkOutput& out) {
+    TestConfig chunkConfig = config;
+    chunkConfig.frameCount = static_cast<int>(count);
+
+    // 独立的编码器实例，数据包留在内存中由runChunks拼接；源帧和画质评估的参考帧都按下标从source读取
+    EncoderBackend::Options options = Traits::options(chunkConfig);
+    options.sink = OutputSink::Kind::Null;
+    options.collectPackets = true;
+    options.globalHeader = globalHeader;
+    options.paced = false;
+
+    EncodeSource::Reader reader(source);
+    auto sourcePlanes = [&reader, first](int64_t pts, QualityAnalyzer::SourcePlanes& planes) {
+        return reader.planes(static_cast<int64_t>(first) + pts, planes);
+    };
+    EncoderBackend encoder;
+    if (!encoder.open(Traits::kEncoder, options,
+                      [&chunkConfig](AVCodecContext* ctx) { return Traits::configure(ctx, chunkConfig); },
+                      std::string(), sourcePlanes)) {
+        out.error = "初始化编码器失败";
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t index = first + i;
+        const uint8_t* data = reader.frame(index);
+        if (!data) {
+            out.error = "获取帧 " + std::to_string(index) + " 数据失败";
+            return;
+        }
+        if (!encoder.encodeFrame(data)) {
+            out.error = "编码帧 " + std::to_string(index) + " 失败";
+            return;
+        }
+    }
+
+    if (!encoder.encodeFrame(nullptr)) {
+        out.error = "刷新编码器失败";
+        return;
+    }
+    if (!encoder.finish()) {
+        out.error = "结束编码失败";
+        return;
+    }
+
+    out.parameters = avcodec_parameters_alloc();
+    if (!out.parameters || avcodec_parameters_from_context(out.parameters, encoder.context()) < 0) {
+        out.error = "无法复制编码器参数";
+        return;
+    }
+    out.timeBase = encoder.context()->time_base;
+    out.metrics = encoder.metrics();
+    out.packets = encoder.takePackets();
+    out.success = true;
+}
+
+X264ParamTest::TestResult X264ParamTest::runChunks(
+    const TestConfig& config,
+    const EncodeSource& source,
+    int chunkFrames,
+    int threadsPerChunk,
+    int coreBudget,
+    const std::string& outputFile
+) {
+    TestResult result;
+    const size_t total = static_cast<size_t>(config.frameCount);
+    const size_t step = static_cast<size_t>(std::max(1, chunkFrames));
+    std::vector<ChunkOutput> outputs((total + step - 1) / step);
+    // 各段的参数集与拼接后的封装格式一致：MP4中放在extradata里
+    const bool globalHeader = OutputSink::needsGlobalHeader(OutputSink::Kind::Mux, outputFile);
+
+    std::vector<SweepScheduler::Job> jobs;
+    jobs.reserve(outputs.size());
+    for (size_t c = 0; c < outputs.size(); ++c) {
+        SweepScheduler::Job job;
+        job.threads = threadsPerChunk;
+        job.run = [&config, &source, &outputs, step, total, globalHeader, c](int threads) {
+            TestConfig chunkConfig = config;
+            chunkConfig.threads = threads;
+            const size_t first = c * step;
+            encodeChunk(chunkConfig, source, first, std::min(step, total - first), globalHeader, outputs[c]);
+        };
+        jobs.push_back(std::move(job));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    SweepScheduler::Options options;
+    options.coreBudget = coreBudget;
+    SweepScheduler(options).run(jobs);
+
+    for (size_t c = 0; c < outputs.size(); ++c) {
+        if (!outputs[c].success) {
+            result.errorMessage = "第 " + std::to_string(c + 1) + " 段: " + outputs[c].error;
+            std::cerr << result.errorMessage << std::endl;
+            return result;
+        }
+    }
+
+    // 各段码流按顺序写入同一个MP4，时间戳平移到段的起始帧
+    AVFormatContext* formatCtx = nullptr;
+    AVStream* stream = nullptr;
+    int ret = avformat_alloc_output_context2(&formatCtx, nullptr, nullptr, outputFile.c_str());
+    if (ret >= 0) {
+        stream = avformat_new_stream(formatCtx, nullptr);
+        ret = stream ? avcodec_parameters_copy(stream->codecpar, outputs.front().parameters) : AVERROR(ENOMEM);
+    }
+    if (ret >= 0) {
+        stream->time_base = outputs.front().timeBase;
+        ret = avio_open(&formatCtx->pb, outputFile.c_str(), AVIO_FLAG_WRITE);
+    }
+    if (ret >= 0) {
+        AVDictionary* options = nullptr;
+        OutputSink::applyMp4Mode(config.mp4Mode, formatCtx, &options);
+        ret = avformat_write_header(formatCtx, &options);
+        av_dict_free(&options);
+    }
+
+    int64_t bytes = 0;
+    int64_t lastDts = AV_NOPTS_VALUE;
+    for (size_t c = 0; c < outputs.size() && ret >= 0; ++c) {
+        // 编码器时间基下每帧一个单位，段内的时间戳从0开始
+        const int64_t offset = static_cast<int64_t>(c * step);
+        for (AVPacket* packet : outputs[c].packets) {
+            packet->pts += offset;
+            packet->dts += offset;
+            if (lastDts != AV_NOPTS_VALUE && packet->dts <= lastDts) {
+                result.errorMessage = "第 " + std::to_string(c + 1) + " 段的解码时间戳与前一段重叠";
+                ret = AVERROR(EINVAL);
+                break;
+            }
+            lastDts = packet->dts;
+            bytes += packet->size;
+            packet->stream_index = stream->index;
+            av_packet_rescale_ts(packet, outputs[c].timeBase, stream->time_base);
+            ret = av_interleaved_write_frame(formatCtx, packet);
+            if (ret < 0) {
+                break;
+            }
+        }
+    }
+    if (ret >= 0) {
+        ret = av_write_trailer(formatCtx);
+    }
+    if (formatCtx) {
+        if (formatCtx->pb) {
+            avio_closep(&formatCtx->pb);
+        }
+        avformat_free_context(formatCtx);
+    }
+    if (ret < 0) {
+        if (result.errorMessage.empty()) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            result.errorMessage = std::string("写入拼接文件失败: ") + errbuf;
+        }
+        std::cerr << result.errorMessage << std::endl;
+        return result;
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const AVRational timeBase = outputs.front().timeBase;
+    result.encodingTime = elapsed;
+    result.fps = total / elapsed;
+    result.bitrate = bytes * 8.0 * timeBase.den / timeBase.num / total;
+    result.encodedBytes = static_cast<uint64_t>(bytes);
+
+    // 各段画质为逐帧平均，按帧数加权合并
+    int qualityFrames = 0;
+    for (size_t c = 0; c < outputs.size(); ++c) {
+        const auto& output = outputs[c];
+        const auto& quality = output.metrics.quality;
+        qualityFrames += quality.frames;
+        result.psnr += quality.psnr * quality.frames;
+        result.ssim += quality.ssim * quality.frames;
+        result.psnrY += quality.psnrY * quality.frames;
+        result.psnrU += quality.psnrU * quality.frames;
+        result.psnrV += quality.psnrV * quality.frames;
+        result.qualityTime += quality.analysisTime;
+        result.latency.merge(output.metrics.latency);
+        result.frameDelay.merge(output.metrics.frameDelay);
+        for (EncoderBackend::FrameLatency latency : output.metrics.frameLatency) {
+            latency.pts += static_cast<int64_t>(c * step);
+            result.frameLatency.push_back(latency);
+        }
+    }
+    std::sort(result.frameLatency.begin(), result.frameLatency.end(),
+              [](const EncoderBackend::FrameLatency& a, const EncoderBackend::FrameLatency& b) {
+                  return a.pts < b.pts;
+              });
+    if (qualityFrames > 0) {
+        result.psnr /= qualityFrames;
+        result.ssim /= qualityFrames;
+        result.psnrY /= qualityFrames;
+        result.psnrU /= qualityFrames;
+        result.psnrV /= qualityFrames;
+    }
+    result.sourceWaitTime = 0.0;
+    result.outputFile = outputFile;
+    result.success = true;
+    return result;
+}
+
+X264ParamTest::ChunkedResult X264ParamTest::runChunkedTest(const TestConfig& config, const ChunkOptions& options) {
+    ChunkedResult result;
+    if (config.width <= 0 || config.height <= 0 || config.frameCount <= 0 || config.keyintMax <= 0) {
+        result.chunked.errorMessage = "无效的视频参数";
+        std::cerr << result.chunked.errorMessage << std::endl;
+        return result;
+    }
+
+    // 段边界落在keyintMax的整数倍上，每段由新的编码器实例从IDR帧开始，GOP不跨段
+    const int gops = std::max(1, options.gopsPerChunk);
+    result.chunkFrames = config.keyintMax * gops;
+    result.chunks = (static_cast<size_t>(config.frameCount) + result.chunkFrames - 1) / result.chunkFrames;
+    std::cout << "分段并行编码: " << config.frameCount << " 帧, 每段 " << result.chunkFrames
+              << " 帧 (" << gops << " 个GOP), 共 " << result.chunks << " 段" << std::endl;
+
+    // 源帧只准备一次，分段编码和单实例编码共用同一份帧缓存
+    X264ParamTest source;
+    if (!source.initFrameCache(config)) {
+        result.chunked.errorMessage = "初始化帧缓存失败";
+        std::cerr << result.chunked.errorMessage << std::endl;
+        return result;
+    }
+
+    const std::string chunkedFile = makeOutputFile(config, "chunked", result.chunked.errorMessage);
+    if (chunkedFile.empty()) {
+        std::cerr << result.chunked.errorMessage << std::endl;
+        return result;
+    }
+    result.chunked = runChunks(config, source.source_, result.chunkFrames, std::max(1, config.threads),
+                               options.coreBudget, chunkedFile);
+    if (!result.chunked.success) {
+        return result;
+    }
+
+    // 对照：同样的帧、同样的计时方式，一个编码器实例使用全部核心预算
+    if (options.compareSingle) {
+        const std::string singleFile = makeOutputFile(config, "single", result.single.errorMessage);
+        if (!singleFile.empty()) {
+            result.single = runChunks(config, source.source_, config.frameCount, 0, options.coreBudget, singleFile);
+        }
+    }
 
+    const TestResult& chunked = result.chunked;
+    const TestResult& single = result.single;
+    std::cout << "\n分段编码: " << result.chunks << " 段, " << std::fixed << std::setprecision(1)
+              << chunked.fps << " fps, 码率 " << chunked.bitrate / 1000.0 << " kbps, PSNR "
+              << std::setprecision(2) << chunked.psnr << " dB, SSIM " << std::setprecision(4) << chunked.ssim
+              << std::endl;
+    std::cout << "输出文件: " << chunked.outputFile << std::endl;
+    if (single.success) {
+        result.speedup = chunked.encodingTime > 0 ? single.encodingTime / chunked.encodingTime : 0.0;
+        result.bitrateCost = single.bitrate > 0 ? (chunked.bitrate / single.bitrate - 1.0) * 100.0 : 0.0;
+        result.psnrCost = single.psnr - chunked.psnr;
+        result.ssimCost = single.ssim - chunked.ssim;
+
+        std::cout << "单实例编码: " << std::setprecision(1) << single.fps << " fps, 码率 "
+                  << single.bitrate / 1000.0 << " kbps, PSNR " << std::setprecision(2) << single.psnr
+                  << " dB, SSIM " << std::setprecision(4) << single.ssim << std::endl;
+        std::cout << "吞吐提升: " << std::setprecision(2) << result.speedup << " 倍, 码率代价: "
+                  << std::showpos << result.bitrateCost << "%, PSNR代价: " << result.psnrCost
+                  << " dB, SSIM代价: " << std::setprecision(4) << result.ssimCost << std::noshowpos
+                  << std::endl;
+    }
     return result;
 }
 
+namespace {
+
+void printSweepResult(const X264ParamTest::TestResult& result) {
+    if (result.success) {
+        std::cout << "编码速度: " << result.fps << " fps" << std::endl;
+        std::cout << "平均码率: " << static_cast<int>(result.bitrate / 1000) << " Kbps" << std::endl;
+        if (result.psnr > 0) std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
+        if (result.ssim > 0) std::cout << "SSIM: " << result.ssim << std::endl;
+        std::cout << "单帧耗时: " << result.latency.total.format() << std::endl;
+    } else {
+        std::cout << "测试失败: " << result.errorMessage << std::endl;
+    }
+}
+
+// runConfigs的单次测试和结果缓存格式，见ConfigRunner
+struct RunnerTraits {
+    using Config = X264ParamTest::TestConfig;
+    using Result = X264ParamTest::TestResult;
+
+    // 测试方法或结果字段变化时递增，旧的缓存条目自然失效
+    static constexpr int kResultsVersion = 1;
+
+    static Result run(const Config& config) { return X264ParamTest::runTest(config); }
+
+    // 缓存键覆盖TestConfig的全部字段，TestConfig增加字段时需要同时加到这里
+    static std::string cacheKey(const Config& config) {
+        const std::string source = ResultCache::sourceFingerprint(config.sourcePath);
+        if (source.empty()) {
+            return {};
+        }
+
+        ResultCache::KeyBuilder key;
+        key.add("codec", "x264")
+           .add("results", kResultsVersion)
+           .add("encoder", ResultCache::encoderBuild("libx264"))
+           .add("machine", ResultCache::machine())
+           .add("source", source)
+           .add("width", config.width)
+           .add("height", config.height)
+           .add("frameCount", config.frameCount)
+           .add("preset", static_cast<int>(config.preset))
+           .add("tune", static_cast<int>(config.tune))
+           .add("threads", config.threads)
+           .add("rateControl", static_cast<int>(config.rateControl))
+           .add("rateValue", config.crf)
+           .add("fps", config.fps)
+           .add("vfr", config.vfr)
+           .add("keyintMax", config.keyintMax)
+           .add("bframes", config.bframes)
+           .add("refs", config.refs)
+           .add("fastFirstPass", config.fastFirstPass)
+           .add("meRange", config.meRange)
+           .add("weightedPred", config.weightedPred)
+           .add("cabac", config.cabac)
+           .add("measureQuality", config.measureQuality)
+           .add("zeroCopy", config.zeroCopy)
+           .add("directIo", config.directIo)
+           .add("displayWidth", config.displayWidth)
+           .add("displayHeight", config.displayHeight)
+           .add("paced", config.paced)
+           .add("sink", OutputSink::kindToString(config.sink))
+           .add("directOutput", config.directOutput)
+           .add("mp4Mode", OutputSink::mp4ModeToString(config.mp4Mode));
+        return key.key();
+    }
+
+    static ResultCache::Fields toCacheFields(const Result& result) {
+        return {
+            {"encodingTime", ResultCache::formatDouble(result.encodingTime)},
+            {"fps", ResultCache::formatDouble(result.fps)},
+            {"bitrate", ResultCache::formatDouble(result.bitrate)},
+            {"psnr", ResultCache::formatDouble(result.psnr)},
+            {"ssim", ResultCache::formatDouble(result.ssim)},
+            {"psnrY", ResultCache::formatDouble(result.psnrY)},
+            {"psnrU", ResultCache::formatDouble(result.psnrU)},
+            {"psnrV", ResultCache::formatDouble(result.psnrV)},
+            {"qualityTime", ResultCache::formatDouble(result.qualityTime)},
+            {"sourceWaitTime", ResultCache::formatDouble(result.sourceWaitTime)},
+            {"encodedBytes", std::to_string(result.encodedBytes)},
+            {"latency.copy", result.latency.copy.serialize()},
+            {"latency.send", result.latency.send.serialize()},
+            {"latency.receive", result.latency.receive.serialize()},
+            {"latency.total", result.latency.total.serialize()},
+            {"latency.delay", result.latency.delay.serialize()},
+            {"frameDelay.reorder", result.frameDelay.reorder.serialize()},
+            {"frameDelay.lookahead", result.frameDelay.lookahead.serialize()},
+            {"frameDelay.compute", result.frameDelay.compute.serialize()},
+            {"pacing.frames", std::to_string(result.pacing.frames)},
+            {"pacing.deadlineMisses", std::to_string(result.pacing.deadlineMisses)},
+            {"pacing.maxBacklog", std::to_string(result.pacing.maxBacklog)},
+            {"pacing.finalBacklog", std::to_string(result.pacing.finalBacklog)},
+            {"pacing.backlogGrowth", ResultCache::formatDouble(result.pacing.backlogGrowth)},
+            {"pacing.lateness", result.pacing.lateness.serialize()},
+            {"pacing.realtime", result.pacing.realtime ? "1" : "0"},
+            {"output.packets", std::to_string(result.output.packets)},
+            {"output.bytes", std::to_string(result.output.bytes)},
+            {"output.fileBytes", std::to_string(result.output.fileBytes)},
+            {"output.openTime", ResultCache::formatDouble(result.output.openTime)},
+            {"output.writeTime", ResultCache::formatDouble(result.output.writeTime)},
+            {"output.closeTime", ResultCache::formatDouble(result.output.closeTime)},
+            {"output.cpuTime", ResultCache::formatDouble(result.output.cpuTime)},
+            {"output.ioWaitTime", ResultCache::formatDouble(result.output.ioWaitTime)},
+            {"output.directIo", result.output.directIo ? "1" : "0"},
+            {"output.ioUring", result.output.ioUring ? "1" : "0"},
+            {"output.write", result.output.write.serialize()},
+            {"outputFile", result.outputFile},
+        };
+    }
+
+    static bool fromCacheFields(const ResultCache::Fields& fields, Result& result) {
+        auto histogram = [&fields](const char* name, LatencyHistogram& histogram) {
+            const std::string* text = ResultCache::find(fields, name);
+            return text && histogram.deserialize(*text);
+        };
+
+        // 逐帧延迟序列不缓存，只恢复分布；节奏统计在paced为false时frames为0
+        double encodedBytes = 0.0;
+        double frames = 0.0;
+        double misses = 0.0;
+        double maxBacklog = 0.0;
+        double finalBacklog = 0.0;
+        double realtime = 0.0;
+        double packets = 0.0;
+        double bytes = 0.0;
+        double fileBytes = 0.0;
+        double directIo = 0.0;
+        double ioUring = 0.0;
+        auto& pacing = result.pacing;
+        auto& output = result.output;
+        const std::string* outputFile = ResultCache::find(fields, "outputFile");
+        const bool ok = ResultCache::get(fields, "encodingTime", result.encodingTime) &&
+                        ResultCache::get(fields, "fps", result.fps) &&
+                        ResultCache::get(fields, "bitrate", result.bitrate) &&
+                        ResultCache::get(fields, "psnr", result.psnr) &&
+                        ResultCache::get(fields, "ssim", result.ssim) &&
+                        ResultCache::get(fields, "psnrY", result.psnrY) &&
+                        ResultCache::get(fields, "psnrU", result.psnrU) &&
+                        ResultCache::get(fields, "psnrV", result.psnrV) &&
+                        ResultCache::get(fields, "qualityTime", result.qualityTime) &&
+                        ResultCache::get(fields, "sourceWaitTime", result.sourceWaitTime) &&
+                        ResultCache::get(fields, "encodedBytes", encodedBytes) &&
+                        histogram("latency.copy", result.latency.copy) &&
+                        histogram("latency.send", result.latency.send) &&
+                        histogram("latency.receive", result.latency.receive) &&
+                        histogram("latency.total", result.latency.total) &&
+                        histogram("latency.delay", result.latency.delay) &&
+                        histogram("frameDelay.reorder", result.frameDelay.reorder) &&
+                        histogram("frameDelay.lookahead", result.frameDelay.lookahead) &&
+                        histogram("frameDelay.compute", result.frameDelay.compute) &&
+                        ResultCache::get(fields, "pacing.frames", frames) &&
+                        ResultCache::get(fields, "pacing.deadlineMisses", misses) &&
+                        ResultCache::get(fields, "pacing.maxBacklog", maxBacklog) &&
+                        ResultCache::get(fields, "pacing.finalBacklog", finalBacklog) &&
+                        ResultCache::get(fields, "pacing.backlogGrowth", pacing.backlogGrowth) &&
+                        ResultCache::get(fields, "pacing.realtime", realtime) &&
+                        histogram("pacing.lateness", pacing.lateness) &&
+                        ResultCache::get(fields, "output.packets", packets) &&
+                        ResultCache::get(fields, "output.bytes", bytes) &&
+                        ResultCache::get(fields, "output.fileBytes", fileBytes) &&
+                        ResultCache::get(fields, "output.openTime", output.openTime) &&
+                        ResultCache::get(fields, "output.writeTime", output.writeTime) &&
+                        ResultCache::get(fields, "output.closeTime", output.closeTime) &&
+                        ResultCache::get(fields, "output.cpuTime", output.cpuTime) &&
+                        ResultCache::get(fields, "output.ioWaitTime", output.ioWaitTime) &&
+                        ResultCache::get(fields, "output.directIo", directIo) &&
+                        ResultCache::get(fields, "output.ioUring", ioUring) &&
+                        histogram("output.write", output.write) &&
+                        outputFile;
+        result.encodedBytes = static_cast<uint64_t>(encodedBytes);
+        pacing.enabled = frames > 0;
+        pacing.frames = static_cast<int>(frames);
+        pacing.deadlineMisses = static_cast<int>(misses);
+        pacing.maxBacklog = static_cast<int>(maxBacklog);
+        pacing.finalBacklog = static_cast<int>(finalBacklog);
+        pacing.realtime = realtime != 0.0;
+        output.packets = static_cast<uint64_t>(packets);
+        output.bytes = static_cast<uint64_t>(bytes);
+        output.fileBytes = static_cast<uint64_t>(fileBytes);
+        output.directIo = directIo != 0.0;
+        output.ioUring = ioUring != 0.0;
+        if (outputFile) {
+            result.outputFile = *outputFile;
+        }
+        result.success = ok;
+        return ok;
+    }
+};
+
+}  // namespace
+
+std::vector<X264ParamTest::TestResult> X264ParamTest::runConfigs(
+    const std::vector<TestConfig>& configs,
+    int coreBudget,
+    const ResultCache* cache
+) {
+    return ConfigRunner::run<RunnerTraits>(configs, coreBudget, cache);
+}
+
 std::vector<X264ParamTest::TestResult> X264ParamTest::runPresetTest(
     int width, int height, int frameCount
 ) {
-    std::vector<TestResult> results;
     std::vector<Preset> presets = {
         Preset::UltraFast, Preset::SuperFast, Preset::VeryFast,
         Preset::Faster, Preset::Fast, Preset::Medium,
@@ -752,33 +885,21 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runPresetTest(
     std::cout << "帧数: " << frameCount << std::endl;
     std::cout << "----------------------------------------" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (auto preset : presets) {
-        std::cout << "\n测试预设: " << presetToString(preset) << std::endl;
-        
         TestConfig config;
         config.width = width;
         config.height = height;
         config.frameCount = frameCount;
         config.preset = preset;
+        configs.push_back(config);
+    }
 
-        auto result = runTest(config, [](int frame, const TestResult& progress) {
-            std::cout << "\r已编码: " << std::setw(4) << frame << " 帧"
-                     << " | FPS: " << std::fixed << std::setprecision(2) << progress.fps
-                     << " | 码率: " << std::setw(8) << static_cast<int>(progress.bitrate / 1000) << " Kbps"
-                     << std::flush;
-        });
-
-        if (result.success) {
-            std::cout << "\n结果:" << std::endl;
-            std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-            std::cout << "平均码率: " << static_cast<int>(result.bitrate / 1000) << " Kbps" << std::endl;
-            if (result.psnr > 0) std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-            if (result.ssim > 0) std::cout << "SSIM: " << result.ssim << std::endl;
-        } else {
-            std::cout << "\n测试失败: " << result.errorMessage << std::endl;
-        }
+    auto results = runConfigs(configs);
 
-        results.push_back(result);
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "\n预设: " << presetToString(presets[i]) << std::endl;
+        printSweepResult(results[i]);
     }
 
     return results;
@@ -789,8 +910,6 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runRateControlTest(
     std::vector<int> values,
     int width, int height, int frameCount
 ) {
-    std::vector<TestResult> results;
-
     std::cout << "\n开始x264码率控制测试...\n" << std::endl;
     std::cout << "测试参数：" << std::endl;
     std::cout << "模式: " << (mode == RateControl::CRF ? "CRF" :
@@ -800,9 +919,8 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runRateControlTest(
     std::cout << "帧数: " << frameCount << std::endl;
     std::cout << "----------------------------------------" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (int value : values) {
-        std::cout << "\n测试值: " << value << std::endl;
-        
         TestConfig config;
         config.width = width;
         config.height = height;
@@ -815,25 +933,14 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runRateControlTest(
             case RateControl::ABR:
             case RateControl::CBR: config.bitrate = value; break;
         }
+        configs.push_back(config);
+    }
 
-        auto result = runTest(config, [](int frame, const TestResult& progress) {
-            std::cout << "\r已编码: " << std::setw(4) << frame << " 帧"
-                     << " | FPS: " << std::fixed << std::setprecision(2) << progress.fps
-                     << " | 码率: " << std::setw(8) << static_cast<int>(progress.bitrate / 1000) << " Kbps"
-                     << std::flush;
-        });
-
-        if (result.success) {
-            std::cout << "\n结果:" << std::endl;
-            std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-            std::cout << "平均码率: " << static_cast<int>(result.bitrate / 1000) << " Kbps" << std::endl;
-            if (result.psnr > 0) std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-            if (result.ssim > 0) std::cout << "SSIM: " << result.ssim << std::endl;
-        } else {
-            std::cout << "\n测试失败: " << result.errorMessage << std::endl;
-        }
+    auto results = runConfigs(configs);
 
-        results.push_back(result);
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "\n测试值: " << values[i] << std::endl;
+        printSweepResult(results[i]);
     }
 
     return results;
@@ -843,8 +950,6 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runQualityTest(
     const TestConfig& baseConfig,
     std::vector<std::pair<std::string, std::vector<bool>>> params
 ) {
-    std::vector<TestResult> results;
-
     std::cout << "\n开始x264质量参数测试...\n" << std::endl;
     std::cout << "基础配置：" << std::endl;
     std::cout << "分辨率: " << baseConfig.width << "x" << baseConfig.height << std::endl;
@@ -852,14 +957,10 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runQualityTest(
     std::cout << "----------------------------------------" << std::endl;
 
     // 生成所有参数组合
-    int totalCombinations = 1;
-    for (const auto& param : params) {
-        totalCombinations *= param.second.size();
-    }
-
-    int combination = 0;
+    std::vector<TestConfig> configs;
+    std::vector<std::string> descriptions;
     std::vector<size_t> indices(params.size(), 0);
-    bool done = false;
+    bool done = params.empty();
 
     while (!done) {
         TestConfig config = baseConfig;
@@ -878,27 +979,8 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runQualityTest(
             // 添加其他参数...
         }
 
-        std::cout << "\n测试组合 " << ++combination << "/" << totalCombinations << ": "
-                 << paramDesc.str() << std::endl;
-
-        auto result = runTest(config, [](int frame, const TestResult& progress) {
-            std::cout << "\r已编码: " << std::setw(4) << frame << " 帧"
-                     << " | FPS: " << std::fixed << std::setprecision(2) << progress.fps
-                     << " | 码率: " << std::setw(8) << static_cast<int>(progress.bitrate / 1000) << " Kbps"
-                     << std::flush;
-        });
-
-        if (result.success) {
-            std::cout << "\n结果:" << std::endl;
-            std::cout << "编码速度: " << result.fps << " fps" << std::endl;
-            std::cout << "平均码率: " << static_cast<int>(result.bitrate / 1000) << " Kbps" << std::endl;
-            if (result.psnr > 0) std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
-            if (result.ssim > 0) std::cout << "SSIM: " << result.ssim << std::endl;
-        } else {
-            std::cout << "\n测试失败: " << result.errorMessage << std::endl;
-        }
-
-        results.push_back(result);
+        configs.push_back(config);
+        descriptions.push_back(paramDesc.str());
 
         // 更新索引
         for (size_t i = 0; i < indices.size(); ++i) {
@@ -913,6 +995,14 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runQualityTest(
         }
     }
 
+    auto results = runConfigs(configs);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "\n测试组合 " << i + 1 << "/" << results.size() << ": "
+                 << descriptions[i] << std::endl;
+        printSweepResult(results[i]);
+    }
+
     return results;
 }
 
@@ -922,112 +1012,25 @@ std::vector<X264ParamTest::TestResult> X264ParamTest::runSceneTest(
     int height,
     int frameCount
 ) {
-    std::vector<TestResult> results;
-    results.reserve(scenes.size());
+    std::vector<TestConfig> configs;
+    configs.reserve(scenes.size());
 
     for (const auto& scene : scenes) {
-        std::cout << "\n测试场景: " << scene.name << std::endl;
-        std::cout << "场景描述: " << scene.description << std::endl;
-
         // 使用场景配置，但更新分辨率和帧数
         auto config = scene.config;
         config.width = width;
         config.height = height;
         config.frameCount = frameCount;
-
-        // 运行测试
-        auto result = runTest(config, [](int progress, const TestResult& current) {
-            std::cout << "进度: " << progress << "% - "
-                     << "当前速度: " << current.fps << " fps" << std::endl;
-        });
-
-        results.push_back(result);
+        configs.push_back(config);
     }
 
-    return results;
-}
-
-void X264ParamTest::startWriterThread() {
-    writeBuffer_.finished = false;
-    writeBuffer_.writer_thread = std::thread(&X264ParamTest::writerThreadFunc, this);
-}
+    auto results = runConfigs(configs);
 
-void X264ParamTest::stopWriterThread() {
-    {
-        std::lock_guard<std::mutex> lock(writeBuffer_.mutex);
-        writeBuffer_.finished = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << "\n测试场景: " << scenes[i].name << std::endl;
+        std::cout << "场景描述: " << scenes[i].description << std::endl;
+        printSweepResult(results[i]);
     }
-    writeBuffer_.cv.notify_one();
-    if (writeBuffer_.writer_thread.joinable()) {
-        writeBuffer_.writer_thread.join();
-    }
-}
 
-bool X264ParamTest::addPacketToBuffer(const AVPacket* packet) {
-    PacketData pkt_data;
-    pkt_data.size = packet->size;
-    pkt_data.data = new uint8_t[packet->size];
-    memcpy(pkt_data.data, packet->data, packet->size);
-    pkt_data.pts = packet->pts;
-    pkt_data.dts = packet->dts;
-    pkt_data.stream_index = packet->stream_index;
-    pkt_data.flags = packet->flags;
-    pkt_data.duration = packet->duration;
-
-    {
-        std::unique_lock<std::mutex> lock(writeBuffer_.mutex);
-        // 如果缓冲区满了，等待写入线程处理
-        while (writeBuffer_.packets.size() >= WriteBuffer::MAX_PACKETS) {
-            writeBuffer_.cv.wait(lock);
-        }
-        writeBuffer_.packets.push_back(std::move(pkt_data));
-    }
-    writeBuffer_.cv.notify_one();
-    return true;
+    return results;
 }
-
-void X264ParamTest::writerThreadFunc() {
-    while (true) {
-        PacketData pkt_data;
-        bool should_exit = false;
-        {
-            std::unique_lock<std::mutex> lock(writeBuffer_.mutex);
-            while (writeBuffer_.packets.empty() && !writeBuffer_.finished) {
-                writeBuffer_.cv.wait(lock);
-            }
-            
-            if (writeBuffer_.packets.empty() && writeBuffer_.finished) {
-                break;
-            }
-            
-            if (!writeBuffer_.packets.empty()) {
-                pkt_data = std::move(writeBuffer_.packets.front());
-                writeBuffer_.packets.erase(writeBuffer_.packets.begin());
-            }
-        }
-        writeBuffer_.cv.notify_one();  // 通知可能在等待的生产者
-
-        if (formatCtx_ && formatCtx_->pb) {
-            AVPacket pkt = {0};
-            av_init_packet(&pkt);
-            pkt.data = pkt_data.data;
-            pkt.size = pkt_data.size;
-            pkt.pts = pkt_data.pts;
-            pkt.dts = pkt_data.dts;
-            pkt.stream_index = pkt_data.stream_index;
-            pkt.flags = pkt_data.flags;
-            pkt.duration = pkt_data.duration;
-
-            auto writeStart = std::chrono::steady_clock::now();
-            int ret = av_interleaved_write_frame(formatCtx_, &pkt);
-            auto writeEnd = std::chrono::steady_clock::now();
-            
-            double writeTime = std::chrono::duration<double>(writeEnd - writeStart).count();
-            perfMetrics_.totalWritingTime += writeTime;
-            perfMetrics_.maxWritingTimePerFrame = std::max(
-                perfMetrics_.maxWritingTimePerFrame, writeTime);
-        }
-        
-        delete[] pkt_data.data;
-    }
-} 
\ No newline at end of file
@@ -4,15 +4,14 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/opt.h>
-#include <libavutil/imgutils.h>
 }
 
 #include <string>
+#include <vector>
 #include <functional>
-#include <thread>
-#include <mutex>
-#include <queue>
-#include <condition_variable>
+#include "encoder_backend.hpp"
+
+class ResultCache;
 
 class X264ParamTest {
 public:
@@ -59,7 +58,7 @@ public:
         // 基本编码参数
         Preset preset;
         Tune tune;
-        int threads;
+        int threads;      // 0表示自动：单独运行时由libx264决定，并发运行时按核心预算分配
 
         // 码率控制参数
         RateControl rateControl;
@@ -84,13 +83,40 @@ public:
         bool weightedPred;   // 加权预测
         bool cabac;          // CABAC熵编码
 
+        // 画质评估
+        bool measureQuality;  // 编码时在独立线程中解码并计算PSNR/SSIM
+
+        // 帧提交方式
+        bool zeroCopy;        // 直接把缓存中的帧交给编码器，false时逐行复制（用于对比）
+
+        // 输入源：图片序列目录或视频文件，为空时使用合成帧
+        // .y4m/.yuv文件不预先缓存，由预读线程流式读取
+        std::string sourcePath;
+        bool directIo;        // 流式读取时使用O_DIRECT，避免页缓存影响测试结果
+
+        // 显示分辨率，0表示与编码分辨率相同
+        // 不同时源帧按显示分辨率准备，缩小到width×height后编码，画质在放大回显示分辨率后评估
+        int displayWidth;
+        int displayHeight;
+
+        // 实时节奏输入：按fps的墙钟时刻逐帧放入编码器，统计每帧是否在下一帧到达前编完
+        // false时帧以最快速度送入（吞吐测试）
+        bool paced;
+
+        // 输出方式：null只测编码器，memory/file/mux依次加上复制、写盘和封装
+        OutputSink::Kind sink;
+        // file/mux输出改用批量写入：fallocate预分配，合并为大块对齐缓冲区后以O_DIRECT经io_uring写入
+        bool directOutput;
+        // MP4封装方式：fragmented每个GOP一个分片，只追加写入，中断时已写完的部分仍可播放和分析
+        OutputSink::Mp4Mode mp4Mode;
+
         TestConfig() 
             : width(1920)
             , height(1080)
             , frameCount(300)
             , preset(Preset::Medium)
             , tune(Tune::None)
-            , threads(1)
+            , threads(0)
             , rateControl(RateControl::CRF)
             , crf(23)
             , fps(30)
@@ -102,20 +128,38 @@ public:
             , meRange(16)
             , weightedPred(true)
             , cabac(true)
+            , measureQuality(true)
+            , zeroCopy(true)
+            , directIo(false)
+            , displayWidth(0)
+            , displayHeight(0)
+            , paced(false)
+            , sink(OutputSink::Kind::Mux)
+            , directOutput(false)
+            , mp4Mode(OutputSink::Mp4Mode::Standard)
         {}
     };
 
     struct TestResult {
         double encodingTime{0.0};    // 编码时间
         double fps{0.0};            // 编码速度
-        double bitrate{0.0};        // 实际码率
+        double bitrate{0.0};        // 实际码率(bps)，按码流字节数和视频时长(frames/fps)计算
         double psnr{0.0};          // 峰值信噪比
         double ssim{0.0};          // 结构相似度
+        double psnrY{0.0};         // 亮度PSNR
+        double psnrU{0.0};         // 色度U PSNR
+        double psnrV{0.0};         // 色度V PSNR
+        double qualityTime{0.0};   // 画质评估线程耗时
+        double sourceWaitTime{0.0};  // 等待流式输入帧就绪的时间
+        uint64_t encodedBytes{0};    // 编码器输出的码流字节数，不含封装开销
+        EncoderBackend::Latency latency;        // 各阶段耗时和输入到数据包延迟的分布
+        EncoderBackend::FrameDelay frameDelay;  // 输入到数据包延迟的分解
+        std::vector<EncoderBackend::FrameLatency> frameLatency;  // 逐帧延迟，按pts排列；结果来自缓存时为空
+        EncoderBackend::PacingStats pacing;     // 实时节奏输入的统计，config.paced为false时enabled为false
+        OutputSink::Stats output;    // 输出的字节数和打开/写入/关闭耗时
         bool success{false};
         std::string errorMessage;
-        std::string outputFile;     // 输出文件路径
-
-        TestResult() = default;
+        std::string outputFile;     // 输出文件路径，null/memory输出时为空
     };
 
     // 预定义场景配置
@@ -128,21 +172,9 @@ public:
     X264ParamTest();
     ~X264ParamTest();
 
-    // 初始化编码器
-    bool initEncoder(const TestConfig& config, const std::string& outputFile = "");
-    
-    // 编码单帧
-    bool encodeFrame(const uint8_t* data, int size);
-    
-    // 获取性能数据
-    double getEncodingTime() const { return encodingTime_; }
-    double getFPS() const { return fps_; }
-    double getBitrate() const { return bitrate_; }
-    double getPSNR() const { return psnr_; }
-    double getSSIM() const { return ssim_; }
-    
-    // 清理资源
-    void cleanup();
+    // 准备输入帧：Y4M/原始YUV流式读取，其他来源放入~/frame_cache下的帧缓存
+    // progress为准备进度(0-1)，在准备线程中调用
+    bool initFrameCache(const TestConfig& config, std::function<void(float)> progress = nullptr);
 
     // 运行单次参数测试
     static TestResult runTest(
@@ -150,6 +182,43 @@ public:
         std::function<void(int, const TestResult&)> progressCallback = nullptr
     );
 
+    // 并发运行一组配置，按核心预算同时调度多个编码（coreBudget为0时使用全部可用CPU）
+    // 结果顺序与configs一致；指定cache时先查缓存，只编码未命中的配置，成功的结果写回缓存
+    static std::vector<TestResult> runConfigs(
+        const std::vector<TestConfig>& configs,
+        int coreBudget = 0,
+        const ResultCache* cache = nullptr
+    );
+
+    // 按GOP分段并行编码的参数
+    struct ChunkOptions {
+        int gopsPerChunk;     // 每段包含的GOP数（keyintMax帧为一个GOP）
+        int coreBudget;       // 并发编码使用的核心数，0表示全部可用CPU
+        bool compareSingle;   // 在同一份帧缓存上再做一次单实例编码，报告吞吐和码率/画质代价
+
+        ChunkOptions()
+            : gopsPerChunk(1)
+            , coreBudget(0)
+            , compareSingle(true)
+        {}
+    };
+
+    struct ChunkedResult {
+        TestResult chunked;       // 分段编码的整体结果，码率和画质按全部帧计算
+        TestResult single;        // 单实例编码的结果，未比较时success为false
+        size_t chunks{0};         // 段数
+        int chunkFrames{0};       // 每段帧数（最后一段可能更短）
+        double speedup{0.0};      // 单实例编码时间 / 分段编码时间
+        double bitrateCost{0.0};  // 分段编码码率相对单实例的增加(%)
+        double psnrCost{0.0};     // PSNR相对单实例的下降(dB)
+        double ssimCost{0.0};     // SSIM相对单实例的下降
+    };
+
+    // 按GOP分段并行编码：帧范围按keyintMax对齐切成若干闭合GOP的段，每段由独立的编码器实例编码，
+    // 在核心预算内并发运行，各段码流平移时间戳后按顺序拼接为一个MP4
+    // 每段使用config.threads个线程（不大于0时为1），单实例编码使用全部预算
+    static ChunkedResult runChunkedTest(const TestConfig& config, const ChunkOptions& options);
+
     // 运行预设对比测试
     static std::vector<TestResult> runPresetTest(
         int width = 1920,
@@ -223,118 +292,36 @@ public:
         int frameCount = 300
     );
 
-    // 写入缓冲相关
-    struct PacketData {
-        uint8_t* data;
-        int size;
-        int64_t pts;
-        int64_t dts;
-        int stream_index;
-        int flags;
-        int duration;
+private:
+    // 编码器后端的参数映射，见EncoderBackend
+    struct Traits;
+
+    // 分段编码中一个段的输出
+    struct ChunkOutput {
+        std::vector<AVPacket*> packets;          // 编码器时间基下的数据包，时间戳从0开始
+        AVCodecParameters* parameters{nullptr};  // 用于创建输出流
+        AVRational timeBase{1, 25};
+        EncoderBackend::Metrics metrics;         // 逐帧延迟的pts从0开始
+        std::string error;
+        bool success{false};
+
+        ~ChunkOutput();
     };
 
-    struct WriteBuffer {
-        static const size_t MAX_PACKETS = 300;  // 缓冲区最大包数量
-        std::vector<PacketData> packets;
-        std::mutex mutex;
-        std::condition_variable cv;
-        bool finished{false};
-        std::thread writer_thread;
-        
-        WriteBuffer() : packets() {
-            packets.reserve(MAX_PACKETS);
-        }
-    } writeBuffer_;
-
-    // 写入线程相关
-    void startWriterThread();
-    void stopWriterThread();
-    void writerThreadFunc();
-    bool addPacketToBuffer(const AVPacket* packet);
-
-    // 帧缓存相关
-    struct FrameCache {
-        bool is_initialized{false};
-        bool use_disk_cache{false};
-        std::string cache_dir;
-        std::vector<std::vector<uint8_t>> frame_buffer;  // 内存中的帧缓存
-        size_t frame_size{0};  // 每帧的大小
-        size_t total_frames{0};  // 总帧数
-        
-        void clear() {
-            frame_buffer.clear();
-            is_initialized = false;
-        }
-    } frameCache_;
-
-    // 帧生成和缓存相关函数
-    bool initFrameCache(const TestConfig& config);
-    bool generateFrames(const TestConfig& config);
-    std::vector<uint8_t> generateSingleFrame(int width, int height, int frameIndex);
-    const uint8_t* getFrameData(size_t frameIndex) const;
-
-    // 帧生成相关
-    struct FrameGenerationStatus {
-        bool is_generating{false};
-        size_t completed_frames{0};
-        size_t total_frames{0};
-        float last_progress{0.0f};
-        std::mutex mutex;
-        std::function<void(float)> progress_callback;
-    } gen_status_;
-
-    // 多线程帧生成
-    void generateFramesThreaded(const TestConfig& config, size_t thread_count);
-    static void frameGenerationWorker(
-        X264ParamTest* self,
-        const TestConfig& config,
-        size_t start_frame,
-        size_t end_frame
-    );
+    // 在source上编码第[first, first+count)帧，数据包收集到out中
+    // globalHeader为拼接输出的封装格式是否要求全局头，见OutputSink::needsGlobalHeader
+    static void encodeChunk(const TestConfig& config, const EncodeSource& source,
+                            size_t first, size_t count, bool globalHeader, ChunkOutput& out);
 
-private:
-    // 编码器上下文
-    AVCodecContext* encoderCtx_{nullptr};
-    AVFrame* frame_{nullptr};
-    AVPacket* packet_{nullptr};
-    
-    // 输出文件相关
-    AVFormatContext* formatCtx_{nullptr};
-    AVStream* stream_{nullptr};
-    
-    // 性能测试相关
-    std::chrono::steady_clock::time_point startTime_;
-    std::chrono::steady_clock::time_point frameStartTime_;
-    int frameCount_{0};
-    double encodingTime_{0.0};
-    double frameTime_{0.0};
-    double fps_{0.0};
-    double bitrate_{0.0};
-    double psnr_{0.0};
-    double ssim_{0.0};
-
-    // 性能监控
-    struct PerformanceMetrics {
-        double totalEncodingTime{0.0};    // 总编码时间
-        double totalWritingTime{0.0};     // 总写入时间
-        double totalFrameGenTime{0.0};    // 总帧生成时间
-        double totalFrameCopyTime{0.0};   // 总帧复制时间
-        double totalFrameTime{0.0};       // 总帧处理时间
-        int totalFrames{0};               // 总帧数
-        double avgEncodingTimePerFrame{0.0}; // 平均每帧编码时间
-        double avgWritingTimePerFrame{0.0};  // 平均每帧写入时间
-        double avgFrameGenTimePerFrame{0.0}; // 平均每帧生成时间
-        double avgFrameCopyTime{0.0};        // 平均每帧复制时间
-        double avgTotalTimePerFrame{0.0};    // 平均每帧总时间
-        double maxEncodingTimePerFrame{0.0}; // 最大单帧编码时间
-        double maxWritingTimePerFrame{0.0};  // 最大单帧写入时间
-        double maxFrameGenTimePerFrame{0.0}; // 最大单帧生成时间
-        double maxFrameCopyTime{0.0};        // 最大单帧复制时间
-    } perfMetrics_;
+    // 以chunkFrames帧为一段并发编码source中的全部帧，拼接写入outputFile
+    static TestResult runChunks(const TestConfig& config, const EncodeSource& source, int chunkFrames,
+                                int threadsPerChunk, int coreBudget, const std::string& outputFile);
 
     // 将预设枚举转换为字符串
     static const char* presetToString(Preset preset);
     // 将调优模式枚举转换为字符串
     static const char* tuneToString(Tune tune);
-}; 
\ No newline at end of file
+
+    // 输入帧（需在编码器之后析构）
+    EncodeSource source_;
+};
@@ -1,7 +1,11 @@
 #include "x265_param_test.hpp"
+#include "config_runner.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
-#include <random>
+#include <algorithm>
 #include <sstream>
 
 const char* X265ParamTest::presetToString(Preset preset) {
@@ -33,174 +37,255 @@ const char* X265ParamTest::tuneToString(Tune tune) {
     }
 }
 
-X265ParamTest::X265ParamTest() = default;
-X265ParamTest::~X265ParamTest() {
-    cleanup();
-}
-
-bool X265ParamTest::initEncoder(const TestConfig& config) {
-    cleanup();
+namespace {
 
-    // 查找编码器
-    const AVCodec* codec = avcodec_find_encoder_by_name("libx265");
-    if (!codec) {
-        std::cerr << "找不到x265编码器" << std::endl;
-        return false;
-    }
-
-    // 创建编码器上下文
-    encoderCtx_ = avcodec_alloc_context3(codec);
-    if (!encoderCtx_) {
-        std::cerr << "无法创建编码器上下文" << std::endl;
-        return false;
+void printSweepResult(const X265ParamTest::TestResult& result) {
+    if (result.success) {
+        std::cout << "编码速度: " << std::fixed << std::setprecision(2) << result.fps << " fps"
+                  << " | 码率: " << static_cast<int>(result.bitrate / 1000) << " Kbps" << std::endl;
+        if (result.psnr > 0) std::cout << "PSNR: " << result.psnr << " dB" << std::endl;
+        if (result.ssim > 0) std::cout << "SSIM: " << result.ssim << std::endl;
+    } else {
+        std::cout << "测试失败: " << result.errorMessage << std::endl;
     }
+}
 
-    // 设置基本参数
-    encoderCtx_->width = config.width;
-    encoderCtx_->height = config.height;
-    encoderCtx_->time_base = AVRational{1, config.fps};
-    encoderCtx_->framerate = AVRational{config.fps, 1};
-    encoderCtx_->pix_fmt = AV_PIX_FMT_YUV420P;
-    encoderCtx_->thread_count = config.threads;
-
-    // 设置x265特定参数
-    av_opt_set(encoderCtx_->priv_data, "preset", presetToString(config.preset), 0);
-    if (const char* tune = tuneToString(config.tune)) {
-        av_opt_set(encoderCtx_->priv_data, "tune", tune, 0);
+// 输出文件放在当前目录的datas下，extension包含点
+std::string makeOutputFile(const char* extension) {
+    const char* workDir = getenv("PWD");
+    if (!workDir) {
+        std::cerr << "无法获取当前工作目录" << std::endl;
+        return {};
     }
 
-    // 设置码率控制参数
-    switch (config.rateControl) {
-        case RateControl::CRF:
-            av_opt_set_int(encoderCtx_->priv_data, "crf", config.crf, 0);
-            break;
-        case RateControl::CQP:
-            av_opt_set_int(encoderCtx_->priv_data, "qp", config.qp, 0);
-            break;
-        case RateControl::ABR:
-            encoderCtx_->bit_rate = config.bitrate * 1000;
-            break;
-        case RateControl::CBR:
-            encoderCtx_->bit_rate = config.bitrate * 1000;
-            encoderCtx_->rc_max_rate = config.bitrate * 1000;
-            encoderCtx_->rc_min_rate = config.bitrate * 1000;
-            encoderCtx_->rc_buffer_size = config.bitrate * 1000;
-            break;
+    std::string outputDir = std::string(workDir) + "/datas";
+    if (system(("mkdir -p '" + outputDir + "'").c_str()) != 0) {
+        std::cerr << "无法创建输出目录: " << outputDir << std::endl;
+        return {};
     }
 
-    // 设置x265特有参数
-    std::string x265_params;
-    if (!config.bFrames) {
-        x265_params += "bframes=0:";
-    } else {
-        x265_params += "bframes=" + std::to_string(config.bFrameCount) + ":";
-    }
-    x265_params += "weightp=" + std::to_string(config.weightedPred ? 1 : 0) + ":";
-    x265_params += "keyint=" + std::to_string(config.keyintMax) + ":";
-    x265_params += "ref=" + std::to_string(config.refFrames) + ":";
-    x265_params += "aq-mode=" + std::to_string(config.aqMode ? 1 : 0) + ":";
-    x265_params += "aq-strength=" + std::to_string(config.aqStrength) + ":";
-    x265_params += "psy-rd=" + std::to_string(config.psyRd ? config.psyRdStrength : 0.0);
-
-    av_opt_set(encoderCtx_->priv_data, "x265-params", x265_params.c_str(), 0);
-
-    // 打开编码器
-    int ret = avcodec_open2(encoderCtx_, codec, nullptr);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, sizeof(errbuf));
-        std::cerr << "无法打开编码器: " << errbuf << std::endl;
-        return false;
-    }
+    return outputDir + "/x265_" +
+           std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + extension;
+}
 
-    // 分配帧和包
-    frame_ = av_frame_alloc();
-    packet_ = av_packet_alloc();
-    if (!frame_ || !packet_) {
-        std::cerr << "无法分配帧或包" << std::endl;
-        return false;
-    }
+// 并发运行和结果缓存，见ConfigRunner
+struct RunnerTraits {
+    using Config = X265ParamTest::TestConfig;
+    using Result = X265ParamTest::TestResult;
 
-    frame_->format = encoderCtx_->pix_fmt;
-    frame_->width = encoderCtx_->width;
-    frame_->height = encoderCtx_->height;
+    // 测试方法或结果字段变化时递增，旧的缓存条目自然失效
+    static constexpr int kResultsVersion = 1;
 
-    ret = av_frame_get_buffer(frame_, 0);
-    if (ret < 0) {
-        std::cerr << "无法分配帧缓冲区" << std::endl;
-        return false;
-    }
+    static Result run(const Config& config) { return X265ParamTest::runTest(config); }
 
-    startTime_ = std::chrono::steady_clock::now();
-    frameCount_ = 0;
-    return true;
-}
+    // 缓存键覆盖TestConfig的全部字段，TestConfig增加字段时需要同时加到这里
+    static std::string cacheKey(const Config& config) {
+        const std::string source = ResultCache::sourceFingerprint(config.sourcePath);
+        if (source.empty()) {
+            return {};
+        }
 
-bool X265ParamTest::encodeFrame(const uint8_t* data, int size) {
-    if (!encoderCtx_ || !frame_ || !packet_) {
-        return false;
+        ResultCache::KeyBuilder key;
+        key.add("codec", "x265")
+           .add("results", kResultsVersion)
+           .add("encoder", ResultCache::encoderBuild("libx265"))
+           .add("machine", ResultCache::machine())
+           .add("source", source)
+           .add("width", config.width)
+           .add("height", config.height)
+           .add("frameCount", config.frameCount)
+           .add("preset", static_cast<int>(config.preset))
+           .add("tune", static_cast<int>(config.tune))
+           .add("threads", config.threads)
+           .add("fps", config.fps)
+           .add("rateControl", static_cast<int>(config.rateControl))
+           .add("crf", config.crf)
+           .add("qp", config.qp)
+           .add("bitrate", config.bitrate)
+           .add("bFrames", config.bFrames)
+           .add("bFrameCount", config.bFrameCount)
+           .add("weightedPred", config.weightedPred)
+           .add("keyintMax", config.keyintMax)
+           .add("refFrames", config.refFrames)
+           .add("aqMode", config.aqMode)
+           .add("aqStrength", config.aqStrength)
+           .add("psyRd", config.psyRd)
+           .add("psyRdStrength", ResultCache::formatDouble(config.psyRdStrength))
+           .add("measureQuality", config.measureQuality)
+           .add("zeroCopy", config.zeroCopy)
+           .add("directIo", config.directIo)
+           .add("sink", OutputSink::kindToString(config.sink))
+           .add("directOutput", config.directOutput);
+        return key.key();
     }
 
-    // 复制输入数据到帧
-    av_frame_make_writable(frame_);
-    for (int i = 0; i < frame_->height; i++) {
-        memcpy(frame_->data[0] + i * frame_->linesize[0],
-               data + i * frame_->width,
-               frame_->width);
+    static ResultCache::Fields toCacheFields(const Result& result) {
+        return {
+            {"encodingTime", ResultCache::formatDouble(result.encodingTime)},
+            {"fps", ResultCache::formatDouble(result.fps)},
+            {"bitrate", ResultCache::formatDouble(result.bitrate)},
+            {"psnr", ResultCache::formatDouble(result.psnr)},
+            {"ssim", ResultCache::formatDouble(result.ssim)},
+            {"psnrY", ResultCache::formatDouble(result.psnrY)},
+            {"psnrU", ResultCache::formatDouble(result.psnrU)},
+            {"psnrV", ResultCache::formatDouble(result.psnrV)},
+            {"qualityTime", ResultCache::formatDouble(result.qualityTime)},
+            {"sourceWaitTime", ResultCache::formatDouble(result.sourceWaitTime)},
+            {"encodedBytes", std::to_string(result.encodedBytes)},
+            {"latency.copy", result.latency.copy.serialize()},
+            {"latency.send", result.latency.send.serialize()},
+            {"latency.receive", result.latency.receive.serialize()},
+            {"latency.total", result.latency.total.serialize()},
+            {"latency.delay", result.latency.delay.serialize()},
+            {"output.packets", std::to_string(result.output.packets)},
+            {"output.bytes", std::to_string(result.output.bytes)},
+            {"output.fileBytes", std::to_string(result.output.fileBytes)},
+            {"output.openTime", ResultCache::formatDouble(result.output.openTime)},
+            {"output.writeTime", ResultCache::formatDouble(result.output.writeTime)},
+            {"output.closeTime", ResultCache::formatDouble(result.output.closeTime)},
+            {"output.cpuTime", ResultCache::formatDouble(result.output.cpuTime)},
+            {"output.ioWaitTime", ResultCache::formatDouble(result.output.ioWaitTime)},
+            {"output.directIo", result.output.directIo ? "1" : "0"},
+            {"output.ioUring", result.output.ioUring ? "1" : "0"},
+            {"output.write", result.output.write.serialize()},
+            {"outputFile", result.outputFile},
+        };
     }
-    // 复制U和V平面（假设YUV420P格式）
-    int uvHeight = frame_->height / 2;
-    int uvWidth = frame_->width / 2;
-    uint8_t* uData = const_cast<uint8_t*>(data + frame_->width * frame_->height);
-    uint8_t* vData = const_cast<uint8_t*>(uData + uvWidth * uvHeight);
-
-    for (int i = 0; i < uvHeight; i++) {
-        memcpy(frame_->data[1] + i * frame_->linesize[1],
-               uData + i * uvWidth,
-               uvWidth);
-        memcpy(frame_->data[2] + i * frame_->linesize[2],
-               vData + i * uvWidth,
-               uvWidth);
-    }
-
-    frame_->pts = frameCount_++;
 
-    // 编码帧
-    int ret = avcodec_send_frame(encoderCtx_, frame_);
-    if (ret < 0) {
-        return false;
+    static bool fromCacheFields(const ResultCache::Fields& fields, Result& result) {
+        auto histogram = [&fields](const char* name, LatencyHistogram& histogram) {
+            const std::string* text = ResultCache::find(fields, name);
+            return text && histogram.deserialize(*text);
+        };
+
+        double encodedBytes = 0.0;
+        double packets = 0.0;
+        double bytes = 0.0;
+        double fileBytes = 0.0;
+        double directIo = 0.0;
+        double ioUring = 0.0;
+        auto& output = result.output;
+        const bool ok = ResultCache::get(fields, "encodingTime", result.encodingTime) &&
+                        ResultCache::get(fields, "fps", result.fps) &&
+                        ResultCache::get(fields, "bitrate", result.bitrate) &&
+                        ResultCache::get(fields, "psnr", result.psnr) &&
+                        ResultCache::get(fields, "ssim", result.ssim) &&
+                        ResultCache::get(fields, "psnrY", result.psnrY) &&
+                        ResultCache::get(fields, "psnrU", result.psnrU) &&
+                        ResultCache::get(fields, "psnrV", result.psnrV) &&
+                        ResultCache::get(fields, "qualityTime", result.qualityTime) &&
+                        ResultCache::get(fields, "sourceWaitTime", result.sourceWaitTime) &&
+                        ResultCache::get(fields, "encodedBytes", encodedBytes) &&
+                        histogram("latency.copy", result.latency.copy) &&
+                        histogram("latency.send", result.latency.send) &&
+                        histogram("latency.receive", result.latency.receive) &&
+                        histogram("latency.total", result.latency.total) &&
+                        histogram("latency.delay", result.latency.delay) &&
+                        ResultCache::get(fields, "output.packets", packets) &&
+                        ResultCache::get(fields, "output.bytes", bytes) &&
+                        ResultCache::get(fields, "output.fileBytes", fileBytes) &&
+                        ResultCache::get(fields, "output.openTime", output.openTime) &&
+                        ResultCache::get(fields, "output.writeTime", output.writeTime) &&
+                        ResultCache::get(fields, "output.closeTime", output.closeTime) &&
+                        ResultCache::get(fields, "output.cpuTime", output.cpuTime) &&
+                        ResultCache::get(fields, "output.ioWaitTime", output.ioWaitTime) &&
+                        ResultCache::get(fields, "output.directIo", directIo) &&
+                        ResultCache::get(fields, "output.ioUring", ioUring) &&
+                        histogram("output.write", output.write);
+        result.encodedBytes = static_cast<uint64_t>(encodedBytes);
+        output.packets = static_cast<uint64_t>(packets);
+        output.bytes = static_cast<uint64_t>(bytes);
+        output.fileBytes = static_cast<uint64_t>(fileBytes);
+        output.directIo = directIo != 0.0;
+        output.ioUring = ioUring != 0.0;
+        if (const std::string* outputFile = ResultCache::find(fields, "outputFile")) {
+            result.outputFile = *outputFile;
+        }
+        result.success = ok;
+        return ok;
+    }
+};
+
+}  // namespace
+
+// x265的参数映射，其余流程（输入、编码循环、输出和指标）由EncoderBackend完成
+struct X265ParamTest::Traits {
+    using Config = TestConfig;
+    static constexpr const char* kEncoder = "libx265";
+
+    static EncoderBackend::Options options(const Config& config) {
+        EncoderBackend::Options options;
+        options.width = config.width;
+        options.height = config.height;
+        options.fps = config.fps;
+        options.threads = config.threads;
+        options.frames = config.frameCount;
+        options.zeroCopy = config.zeroCopy;
+        options.measureQuality = config.measureQuality;
+        options.sink = config.sink;
+        options.directOutput = config.directOutput;
+        // ABR/CBR按目标码率的两倍预分配，其余模式不预分配
+        if ((config.rateControl == RateControl::ABR || config.rateControl == RateControl::CBR) && config.fps > 0) {
+            options.expectedBytes = static_cast<uint64_t>(config.bitrate) * 125 *
+                                    static_cast<uint64_t>(std::max(config.frameCount, 0)) / config.fps * 2;
+        }
+        return options;
     }
 
-    while (ret >= 0) {
-        ret = avcodec_receive_packet(encoderCtx_, packet_);
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            break;
-        } else if (ret < 0) {
+    static bool configure(AVCodecContext* ctx, const Config& config) {
+        // 设置x265特定参数
+        if (av_opt_set(ctx->priv_data, "preset", presetToString(config.preset), 0) < 0) {
             return false;
         }
+        if (const char* tune = tuneToString(config.tune)) {
+            av_opt_set(ctx->priv_data, "tune", tune, 0);
+        }
 
-        bitrate_ = (bitrate_ * (frameCount_ - 1) + packet_->size * 8.0 * encoderCtx_->time_base.den / encoderCtx_->time_base.num) / frameCount_;
-        av_packet_unref(packet_);
-    }
-
-    auto now = std::chrono::steady_clock::now();
-    encodingTime_ = std::chrono::duration<double>(now - startTime_).count();
-    fps_ = frameCount_ / encodingTime_;
+        // 设置码率控制参数
+        switch (config.rateControl) {
+            case RateControl::CRF:
+                av_opt_set_int(ctx->priv_data, "crf", config.crf, 0);
+                break;
+            case RateControl::CQP:
+                av_opt_set_int(ctx->priv_data, "qp", config.qp, 0);
+                break;
+            case RateControl::ABR:
+                ctx->bit_rate = config.bitrate * 1000;
+                break;
+            case RateControl::CBR:
+                ctx->bit_rate = config.bitrate * 1000;
+                ctx->rc_max_rate = config.bitrate * 1000;
+                ctx->rc_min_rate = config.bitrate * 1000;
+                ctx->rc_buffer_size = config.bitrate * 1000;
+                break;
+        }
 
-    return true;
-}
+        // 设置x265特有参数
+        std::string x265_params;
+        if (!config.bFrames) {
+            x265_params += "bframes=0:";
+        } else {
+            x265_params += "bframes=" + std::to_string(config.bFrameCount) + ":";
+        }
+        x265_params += "weightp=" + std::to_string(config.weightedPred ? 1 : 0) + ":";
+        x265_params += "keyint=" + std::to_string(config.keyintMax) + ":";
+        x265_params += "ref=" + std::to_string(config.refFrames) + ":";
+        x265_params += "aq-mode=" + std::to_string(config.aqMode ? 1 : 0) + ":";
+        x265_params += "aq-strength=" + std::to_string(config.aqStrength) + ":";
+        x265_params += "psy-rd=" + std::to_string(config.psyRd ? config.psyRdStrength : 0.0);
+
+        // libx265忽略thread_count，线程预算通过线程池大小和帧并行数传入
+        // 帧并行数参照x265按核心数的默认值，只在预算内取
+        if (config.threads > 0) {
+            const int frameThreads = config.threads >= 32 ? 6 : config.threads >= 16 ? 5
+                                   : config.threads >= 8 ? 3 : config.threads >= 4 ? 2 : 1;
+            x265_params += ":pools=" + std::to_string(config.threads);
+            x265_params += ":frame-threads=" + std::to_string(frameThreads);
+        }
 
-void X265ParamTest::cleanup() {
-    if (encoderCtx_) {
-        avcodec_free_context(&encoderCtx_);
-    }
-    if (frame_) {
-        av_frame_free(&frame_);
-    }
-    if (packet_) {
-        av_packet_free(&packet_);
+        return av_opt_set(ctx->priv_data, "x265-params", x265_params.c_str(), 0) >= 0;
     }
-}
+};
 
 X265ParamTest::TestResult X265ParamTest::runTest(
     const TestConfig& config,
@@ -209,53 +294,104 @@ X265ParamTest::TestResult X265ParamTest::runTest(
     TestResult result;
     result.success = false;
 
-    X265ParamTest test;
-    if (!test.initEncoder(config)) {
-        result.errorMessage = "初始化编码器失败";
+    // 输入帧按编码器需要的行宽对齐，未指定输入时生成合成帧，非流式输入放入~/frame_cache下的映射文件
+    EncodeSource::Options sourceOptions;
+    sourceOptions.directIo = config.directIo;
+    sourceOptions.cacheDir = EncodeSource::defaultCacheDir();
+    EncodeSource source;
+    if (!source.open(config.sourcePath, FrameLayout::yuv420p(config.width, config.height),
+                     config.frameCount, sourceOptions)) {
+        result.errorMessage = "无法加载输入帧";
         return result;
     }
 
-    // 生成测试数据（灰阶渐变）
-    std::vector<uint8_t> testData(config.width * config.height * 3 / 2);  // YUV420P
-    for (int i = 0; i < config.height; i++) {
-        for (int j = 0; j < config.width; j++) {
-            testData[i * config.width + j] = (i + j) % 256;  // Y
+    // file输出HEVC裸码流，mux封装为MP4
+    std::string outputFile;
+    if (OutputSink::writesFile(config.sink)) {
+        outputFile = makeOutputFile(config.sink == OutputSink::Kind::File ? ".hevc" : ".mp4");
+        if (outputFile.empty()) {
+            result.errorMessage = "无法创建输出文件";
+            return result;
         }
+        result.outputFile = outputFile;
+    }
+
+    // 画质评估线程直接从输入取源帧，encoder需在source之前析构
+    EncoderBackend encoder;
+    auto sourcePlanes = [&source](int64_t pts, QualityAnalyzer::SourcePlanes& planes) {
+        return source.planes(pts, planes);
+    };
+    if (!encoder.open<Traits>(config, outputFile, sourcePlanes)) {
+        result.errorMessage = "初始化编码器失败";
+        return result;
     }
-    // 填充U和V平面
-    int uvSize = config.width * config.height / 4;
-    std::fill_n(testData.begin() + config.width * config.height, uvSize, 128);      // U
-    std::fill_n(testData.begin() + config.width * config.height + uvSize, uvSize, 128);  // V
 
     // 编码所有帧
     for (int i = 0; i < config.frameCount; i++) {
-        if (!test.encodeFrame(testData.data(), testData.size())) {
+        const uint8_t* data = source.next(i);
+        if (!data) {
+            result.errorMessage = "无法获取帧 " + std::to_string(i);
+            return result;
+        }
+        if (!encoder.encodeFrame(data)) {
             result.errorMessage = "编码帧失败";
             return result;
         }
 
         if (progressCallback && (i % 30 == 0 || i == config.frameCount - 1)) {
+            const auto metrics = encoder.snapshot();
             TestResult current;
-            current.fps = test.getFPS();
-            current.bitrate = test.getBitrate();
+            current.fps = metrics.fps;
+            current.bitrate = metrics.bitrate;
+            current.encodedBytes = metrics.encodedBytes;
+            current.psnr = metrics.quality.psnr;
+            current.ssim = metrics.quality.ssim;
             progressCallback((i + 1) * 100 / config.frameCount, current);
         }
     }
 
+    // 刷新编码器缓存的帧
+    if (!encoder.encodeFrame(nullptr)) {
+        result.errorMessage = "刷新编码器失败";
+        return result;
+    }
+
+    // 关闭输出并等待画质评估完成
+    if (!encoder.finish()) {
+        result.errorMessage = "写入输出失败";
+        return result;
+    }
+
+    const auto& metrics = encoder.metrics();
     result.success = true;
-    result.encodingTime = test.getEncodingTime();
-    result.fps = test.getFPS();
-    result.bitrate = test.getBitrate();
-    result.psnr = test.getPSNR();
-    result.ssim = test.getSSIM();
+    result.encodingTime = metrics.encodingTime;
+    result.fps = metrics.fps;
+    result.bitrate = metrics.bitrate;
+    result.encodedBytes = metrics.encodedBytes;
+    result.psnr = metrics.quality.psnr;
+    result.ssim = metrics.quality.ssim;
+    result.psnrY = metrics.quality.psnrY;
+    result.psnrU = metrics.quality.psnrU;
+    result.psnrV = metrics.quality.psnrV;
+    result.qualityTime = metrics.quality.analysisTime;
+    result.sourceWaitTime = source.waitTime();
+    result.latency = metrics.latency;
+    result.output = metrics.output;
 
     return result;
 }
 
+std::vector<X265ParamTest::TestResult> X265ParamTest::runConfigs(
+    const std::vector<TestConfig>& configs,
+    int coreBudget,
+    const ResultCache* cache
+) {
+    return ConfigRunner::run<RunnerTraits>(configs, coreBudget, cache);
+}
+
 std::vector<X265ParamTest::TestResult> X265ParamTest::runPresetTest(
     int width, int height, int frameCount, int fps
 ) {
-    std::vector<TestResult> results;
     std::vector<Preset> presets = {
         Preset::UltraFast, Preset::SuperFast, Preset::VeryFast,
         Preset::Faster, Preset::Fast, Preset::Medium,
@@ -269,27 +405,26 @@ std::vector<X265ParamTest::TestResult> X265ParamTest::runPresetTest(
     std::cout << "帧率: " << fps << " fps" << std::endl;
     std::cout << "----------------------------------------" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (auto preset : presets) {
-        std::cout << "\n测试预设: " << presetToString(preset) << std::endl;
-        
         TestConfig config;
         config.width = width;
         config.height = height;
         config.frameCount = frameCount;
         config.preset = preset;
         config.fps = fps;  // 使用传入的fps参数
+        configs.push_back(config);
+    }
 
-        auto result = runTest(config, [](int frame, const TestResult& progress) {
-            std::cout << "\r已编码: " << std::setw(4) << frame << " 帧"
-                     << " | FPS: " << std::fixed << std::setprecision(2) << progress.fps
-                     << " | 码率: " << std::setw(8) << static_cast<int>(progress.bitrate / 1000) << " Kbps"
-                     << std::flush;
-        });
+    auto all = runConfigs(configs);
 
-        if (result.success) {
-            results.push_back(result);
+    std::vector<TestResult> results;
+    for (size_t i = 0; i < all.size(); ++i) {
+        std::cout << "\n测试预设: " << presetToString(presets[i]) << std::endl;
+        printSweepResult(all[i]);
+        if (all[i].success) {
+            results.push_back(all[i]);
         }
-        std::cout << std::endl;
     }
 
     return results;
@@ -300,8 +435,6 @@ std::vector<X265ParamTest::TestResult> X265ParamTest::runRateControlTest(
     const std::vector<int>& values,
     int width, int height, int frameCount, int fps
 ) {
-    std::vector<TestResult> results;
-
     std::cout << "\n开始x265码率控制测试...\n" << std::endl;
     std::cout << "测试参数：" << std::endl;
     std::cout << "分辨率: " << width << "x" << height << std::endl;
@@ -309,6 +442,7 @@ std::vector<X265ParamTest::TestResult> X265ParamTest::runRateControlTest(
     std::cout << "帧率: " << fps << " fps" << std::endl;
     std::cout << "----------------------------------------" << std::endl;
 
+    std::vector<TestConfig> configs;
     for (int value : values) {
         TestConfig config;
         config.width = width;
@@ -320,31 +454,39 @@ std::vector<X265ParamTest::TestResult> X265ParamTest::runRateControlTest(
         switch (mode) {
             case RateControl::CRF:
                 config.crf = value;
-                std::cout << "\n测试CRF: " << value << std::endl;
                 break;
             case RateControl::CQP:
                 config.qp = value;
-                std::cout << "\n测试QP: " << value << std::endl;
                 break;
             case RateControl::ABR:
             case RateControl::CBR:
                 config.bitrate = value;
-                std::cout << "\n测试码率: " << value << " kbps" << std::endl;
                 break;
         }
+        configs.push_back(config);
+    }
 
-        auto result = runTest(config, [](int frame, const TestResult& progress) {
-            std::cout << "\r已编码: " << std::setw(4) << frame << " 帧"
-                     << " | FPS: " << std::fixed << std::setprecision(2) << progress.fps
-                     << " | 码率: " << std::setw(8) << static_cast<int>(progress.bitrate / 1000) << " Kbps"
-                     << std::flush;
-        });
+    auto all = runConfigs(configs);
 
-        if (result.success) {
-            results.push_back(result);
+    std::vector<TestResult> results;
+    for (size_t i = 0; i < all.size(); ++i) {
+        switch (mode) {
+            case RateControl::CRF:
+                std::cout << "\n测试CRF: " << values[i] << std::endl;
+                break;
+            case RateControl::CQP:
+                std::cout << "\n测试QP: " << values[i] << std::endl;
+                break;
+            case RateControl::ABR:
+            case RateControl::CBR:
+                std::cout << "\n测试码率: " << values[i] << " kbps" << std::endl;
+                break;
+        }
+        printSweepResult(all[i]);
+        if (all[i].success) {
+            results.push_back(all[i]);
         }
-        std::cout << std::endl;
     }
 
     return results;
-} 
\ No newline at end of file
+}
@@ -10,10 +10,12 @@ extern "C" {
 #include <libavutil/imgutils.h>
 }
 
-#include <chrono>
-#include <memory>
 #include <vector>
 
+#include "encoder_backend.hpp"
+
+class ResultCache;
+
 class X265ParamTest {
 public:
     // 编码预设
@@ -76,6 +78,13 @@ public:
         int aqStrength;         // 自适应量化强度
         bool psyRd;            // 心理视觉优化
         double psyRdStrength;   // 心理视觉优化强度
+
+        bool measureQuality;    // 是否计算PSNR/SSIM
+        bool zeroCopy;          // 直接提交源帧，false时逐行复制（用于对比）
+        std::string sourcePath; // 图片序列目录或视频文件，为空时使用合成帧；.y4m/.yuv流式读取
+        bool directIo;          // 流式读取时使用O_DIRECT
+        OutputSink::Kind sink;  // 数据包去向，默认丢弃；file写HEVC裸码流，mux封装为MP4
+        bool directOutput;      // file/mux输出使用预分配+大块O_DIRECT批量写入
         
         TestConfig() 
             : width(1920)
@@ -98,44 +107,47 @@ public:
             , aqStrength(1)
             , psyRd(true)
             , psyRdStrength(1.0)
+            , measureQuality(true)
+            , zeroCopy(true)
+            , directIo(false)
+            , sink(OutputSink::Kind::Null)
+            , directOutput(false)
         {}
     };
 
     struct TestResult {
-        double encodingTime;    // 编码时间
-        double fps;            // 编码速度
-        double bitrate;        // 实际码率
-        double psnr;          // 峰值信噪比
-        double ssim;          // 结构相似度
-        bool success;
+        double encodingTime{0.0};    // 编码时间
+        double fps{0.0};            // 编码速度
+        double bitrate{0.0};        // 实际码率
+        double psnr{0.0};          // 峰值信噪比
+        double ssim{0.0};          // 结构相似度
+        double psnrY{0.0};         // 各平面PSNR
+        double psnrU{0.0};
+        double psnrV{0.0};
+        double qualityTime{0.0};   // 画质评估耗时
+        double sourceWaitTime{0.0};  // 等待流式输入帧就绪的时间
+        uint64_t encodedBytes{0};    // 编码器输出的码流字节数，不含封装开销
+        EncoderBackend::Latency latency;  // 各阶段耗时和输入到数据包延迟的分布
+        OutputSink::Stats output;    // 输出的字节数和打开/写入/关闭耗时
+        bool success{false};
         std::string errorMessage;
+        std::string outputFile;     // 输出文件路径，null/memory输出时为空
     };
 
-    X265ParamTest();
-    ~X265ParamTest();
-
-    // 初始化编码器
-    bool initEncoder(const TestConfig& config);
-    
-    // 编码单帧
-    bool encodeFrame(const uint8_t* data, int size);
-    
-    // 获取性能数据
-    double getEncodingTime() const { return encodingTime_; }
-    double getFPS() const { return fps_; }
-    double getBitrate() const { return bitrate_; }
-    double getPSNR() const { return psnr_; }
-    double getSSIM() const { return ssim_; }
-    
-    // 清理资源
-    void cleanup();
-
     // 运行单次参数测试
     static TestResult runTest(
         const TestConfig& config,
         std::function<void(int, const TestResult&)> progressCallback = nullptr
     );
 
+    // 并发运行一组配置，按核心预算同时调度多个编码（coreBudget为0时使用全部可用CPU）
+    // 结果顺序与configs一致；指定cache时先查缓存，只编码未命中的配置，成功的结果写回缓存
+    static std::vector<TestResult> runConfigs(
+        const std::vector<TestConfig>& configs,
+        int coreBudget = 0,
+        const ResultCache* cache = nullptr
+    );
+
     // 运行预设测试
     static std::vector<TestResult> runPresetTest(
         int width = 1920,
@@ -155,19 +167,8 @@ public:
     );
 
 private:
-    // 编码器上下文
-    AVCodecContext* encoderCtx_{nullptr};
-    AVFrame* frame_{nullptr};
-    AVPacket* packet_{nullptr};
-    
-    // 性能测试相关
-    std::chrono::steady_clock::time_point startTime_;
-    int frameCount_{0};
-    double encodingTime_{0.0};
-    double fps_{0.0};
-    double bitrate_{0.0};
-    double psnr_{0.0};
-    double ssim_{0.0};
+    // 编码器后端的参数映射，见EncoderBackend
+    struct Traits;
 
     // 将预设枚举转换为字符串
     static const char* presetToString(Preset preset);
@@ -0,0 +1,385 @@
+#include "yuv_stream_reader.hpp"
+#include "sweep_scheduler.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// O_DIRECT要求偏移、长度和缓冲区地址按逻辑块对齐
+constexpr size_t kBlockSize = 4096;
+constexpr size_t kChunkSize = 8 << 20;
+
+uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+bool hasExtension(const std::string& path, const char* ext) {
+    const size_t len = std::strlen(ext);
+    if (path.size() < len) {
+        return false;
+    }
+    return std::equal(path.end() - len, path.end(), ext, [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+    });
+}
+
+// 完整读取size字节，返回实际读到的字节数，出错时返回-1
+ssize_t preadFully(int fd, uint8_t* dst, size_t size, uint64_t offset) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = pread(fd, dst + total, size - total, static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+}  // namespace
+
+YuvStreamReader::YuvStreamReader() = default;
+
+YuvStreamReader::~YuvStreamReader() {
+    close();
+}
+
+bool YuvStreamReader::isStreamable(const std::string& path) {
+    return hasExtension(path, ".y4m") || hasExtension(path, ".yuv");
+}
+
+bool YuvStreamReader::open(const std::string& path, const FrameLayout& layout, size_t frameCount,
+                           const Options& options) {
+    close();
+
+    layout_ = layout;
+    options_ = options;
+    options_.bufferCount = std::max<size_t>(options_.bufferCount, 2);
+    totalFrames_ = frameCount;
+    packedSize_ = 0;
+    for (int i = 0; i < 3; ++i) {
+        packedSize_ += static_cast<size_t>(layout_.planeWidth(i)) * layout_.planeHeight(i);
+    }
+
+    bufferedFd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (bufferedFd_ < 0) {
+        std::cerr << "无法打开输入文件: " << path << " (" << std::strerror(errno) << ")" << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(bufferedFd_, &st) != 0) {
+        std::cerr << "无法获取文件大小: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    if (hasExtension(path, ".y4m")) {
+        if (!parseY4MHeader()) {
+            close();
+            return false;
+        }
+    } else {
+        dataOffset_ = 0;
+        frameHeader_ = 0;
+    }
+    frameStride_ = frameHeader_ + packedSize_;
+
+    const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+    fileFrames_ = fileSize > dataOffset_ ? (fileSize - dataOffset_) / frameStride_ : 0;
+    if (fileFrames_ == 0) {
+        std::cerr << "输入文件中没有完整的帧: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    if (options_.directIo) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        directIo_ = fd_ >= 0;
+        if (!directIo_) {
+            std::cerr << "文件系统不支持O_DIRECT，改用posix_fadvise" << std::endl;
+        }
+    }
+    if (fd_ < 0) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            close();
+            return false;
+        }
+    }
+    if (!directIo_) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    chunk_ = static_cast<uint8_t*>(std::aligned_alloc(kBlockSize, kChunkSize));
+    const size_t slotSize = (layout_.size + FrameLayout::kAlign - 1) / FrameLayout::kAlign * FrameLayout::kAlign;
+    free_ = std::make_unique<SpscRing<size_t>>(options_.bufferCount);
+    filled_ = std::make_unique<SpscRing<size_t>>(options_.bufferCount);
+    for (size_t i = 0; i < options_.bufferCount; ++i) {
+        slots_.push_back(static_cast<uint8_t*>(std::aligned_alloc(FrameLayout::kAlign, slotSize)));
+        if (!slots_.back()) {
+            std::cerr << "无法分配帧缓冲区" << std::endl;
+            close();
+            return false;
+        }
+        free_->tryPush(i);
+    }
+    if (!chunk_) {
+        std::cerr << "无法分配读取缓冲区" << std::endl;
+        close();
+        return false;
+    }
+
+    std::cout << "流式读取: " << path << ", " << fileFrames_ << " 帧, "
+              << options_.bufferCount << " 个缓冲区"
+              << (directIo_ ? ", O_DIRECT" : "") << std::endl;
+
+    stop_ = false;
+    readerThread_ = std::thread(&YuvStreamReader::readerFunc, this);
+    return true;
+}
+
+void YuvStreamReader::close() {
+    stop_ = true;
+    if (free_) {
+        free_->close();
+    }
+    if (filled_) {
+        filled_->close();
+    }
+    if (readerThread_.joinable()) {
+        readerThread_.join();
+    }
+
+    for (uint8_t* slot : slots_) {
+        std::free(slot);
+    }
+    slots_.clear();
+    std::free(chunk_);
+    chunk_ = nullptr;
+    chunkOffset_ = 0;
+    chunkBytes_ = 0;
+    free_.reset();
+    filled_.reset();
+    current_ = SIZE_MAX;
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (bufferedFd_ >= 0) {
+        ::close(bufferedFd_);
+        bufferedFd_ = -1;
+    }
+    directIo_ = false;
+    fileFrames_ = 0;
+    framesRead_ = 0;
+    readNanos_ = 0;
+    waitNanos_ = 0;
+}
+
+bool YuvStreamReader::parseY4MHeader() {
+    char buffer[1024];
+    ssize_t n = preadFully(bufferedFd_, reinterpret_cast<uint8_t*>(buffer), sizeof(buffer), 0);
+    const char* end = n > 0 ? static_cast<const char*>(std::memchr(buffer, '\n', n)) : nullptr;
+    if (!end || std::strncmp(buffer, "YUV4MPEG2 ", 10) != 0) {
+        std::cerr << "无效的Y4M文件头" << std::endl;
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    std::string colorspace = "420jpeg";
+    std::istringstream header(std::string(static_cast<const char*>(buffer) + 10, end));
+    std::string token;
+    while (header >> token) {
+        switch (token[0]) {
+            case 'W': width = std::atoi(token.c_str() + 1); break;
+            case 'H': height = std::atoi(token.c_str() + 1); break;
+            case 'C': colorspace = token.substr(1); break;
+            default: break;
+        }
+    }
+
+    if (colorspace != "420" && colorspace != "420jpeg" &&
+        colorspace != "420mpeg2" && colorspace != "420paldv") {
+        std::cerr << "不支持的Y4M色彩格式: C" << colorspace << "，只支持4:2:0 8bit" << std::endl;
+        return false;
+    }
+    if (width != layout_.width || height != layout_.height) {
+        std::cerr << "Y4M尺寸 " << width << "x" << height << " 与配置 "
+                  << layout_.width << "x" << layout_.height << " 不一致" << std::endl;
+        return false;
+    }
+
+    // 帧头可以带参数，以第一帧的帧头长度为准
+    dataOffset_ = static_cast<uint64_t>(end - buffer) + 1;
+    n = preadFully(bufferedFd_, reinterpret_cast<uint8_t*>(buffer), sizeof(buffer), dataOffset_);
+    end = n > 0 ? static_cast<const char*>(std::memchr(buffer, '\n', n)) : nullptr;
+    if (!end || std::strncmp(buffer, "FRAME", 5) != 0) {
+        std::cerr << "无效的Y4M帧头" << std::endl;
+        return false;
+    }
+    frameHeader_ = static_cast<uint64_t>(end - buffer) + 1;
+    return true;
+}
+
+void YuvStreamReader::readerFunc() {
+    // 预读不占用编码作业绑定的CPU
+    SweepScheduler::releaseCurrentThread();
+    for (size_t i = 0; i < totalFrames_ && !stop_; ++i) {
+        size_t slot;
+        if (!free_->pop(slot)) {
+            break;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t offset = frameOffset(i) + frameHeader_;
+        uint8_t* dst = slots_[slot];
+        bool ok = true;
+
+        // 文件中的平面紧密排列，逐行复制到按layout对齐的缓冲区
+        for (int p = 0; p < 3 && ok; ++p) {
+            const int width = layout_.planeWidth(p);
+            const int height = layout_.planeHeight(p);
+            uint8_t* plane = layout_.plane(dst, p);
+            for (int y = 0; y < height && ok; ++y) {
+                ok = readSequential(offset, plane + static_cast<size_t>(y) * layout_.linesize[p], width);
+                offset += width;
+            }
+        }
+        readNanos_ += elapsedNanos(start);
+
+        if (!ok) {
+            std::cerr << "读取第 " << i << " 帧失败" << std::endl;
+            break;
+        }
+        ++framesRead_;
+        if (!filled_->push(slot)) {
+            break;
+        }
+    }
+    filled_->close();
+}
+
+bool YuvStreamReader::readSequential(uint64_t offset, uint8_t* dst, size_t size) {
+    while (size > 0) {
+        if (offset < chunkOffset_ || offset >= chunkOffset_ + chunkBytes_) {
+            if (!loadChunk(offset)) {
+                return false;
+            }
+        }
+        const size_t pos = static_cast<size_t>(offset - chunkOffset_);
+        const size_t n = std::min(size, chunkBytes_ - pos);
+        std::memcpy(dst, chunk_ + pos, n);
+        dst += n;
+        offset += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool YuvStreamReader::loadChunk(uint64_t offset) {
+    // 已读完的块不会再用到（循环时除外），从页缓存中丢弃，避免挤占编码器的内存
+    if (!directIo_ && chunkBytes_ > 0) {
+        posix_fadvise(fd_, static_cast<off_t>(chunkOffset_), static_cast<off_t>(chunkBytes_),
+                      POSIX_FADV_DONTNEED);
+    }
+
+    const uint64_t aligned = offset & ~static_cast<uint64_t>(kBlockSize - 1);
+    size_t total = 0;
+    while (total < kChunkSize) {
+        ssize_t n = pread(fd_, chunk_ + total, kChunkSize - total, static_cast<off_t>(aligned + total));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && directIo_ && errno == EINVAL && total == 0) {
+            // 文件系统接受了O_DIRECT但不支持对齐读取，改用普通读取
+            std::cerr << "O_DIRECT读取失败，改用posix_fadvise" << std::endl;
+            int flags = fcntl(fd_, F_GETFL);
+            if (flags >= 0 && fcntl(fd_, F_SETFL, flags & ~O_DIRECT) == 0) {
+                directIo_ = false;
+                posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+                continue;
+            }
+        }
+        if (n <= 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+        // O_DIRECT在文件末尾返回不足一块的数据，此后的偏移不再对齐
+        if (directIo_ && total % kBlockSize != 0) {
+            break;
+        }
+    }
+
+    chunkOffset_ = aligned;
+    chunkBytes_ = total;
+    return offset < chunkOffset_ + chunkBytes_;
+}
+
+const uint8_t* YuvStreamReader::next() {
+    if (!filled_) {
+        return nullptr;
+    }
+
+    // 上一帧已提交给编码器，归还槽位
+    if (current_ != SIZE_MAX) {
+        free_->push(current_);
+        current_ = SIZE_MAX;
+    }
+
+    size_t slot;
+    if (!filled_->tryPop(slot)) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = filled_->pop(slot);
+        waitNanos_ += elapsedNanos(start);
+        if (!ok) {
+            return nullptr;
+        }
+    }
+    current_ = slot;
+    return slots_[slot];
+}
+
+bool YuvStreamReader::readFrameAt(size_t index, uint8_t* dst) const {
+    if (bufferedFd_ < 0 || fileFrames_ == 0) {
+        return false;
+    }
+
+    thread_local std::vector<uint8_t> packed;
+    packed.resize(packedSize_);
+    ssize_t n = preadFully(bufferedFd_, packed.data(), packedSize_, frameOffset(index) + frameHeader_);
+    if (n != static_cast<ssize_t>(packedSize_)) {
+        return false;
+    }
+    layout_.copyFromPacked(dst, packed.data());
+    return true;
+}
+
+YuvStreamReader::Stats YuvStreamReader::stats() const {
+    Stats stats;
+    stats.framesRead = framesRead_;
+    stats.waitTime = waitNanos_ / 1e9;
+    stats.readTime = readNanos_ / 1e9;
+    stats.directIo = directIo_;
+    return stats;
+}
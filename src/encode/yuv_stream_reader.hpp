@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_store.hpp"
+#include "spsc_ring.hpp"
+
+// Y4M/原始YUV流式输入：预读线程把帧依次读入少量对齐缓冲区，内存占用与序列长度无关
+// 只支持yuv420p，尺寸必须与layout一致
+class YuvStreamReader {
+public:
+    struct Options {
+        size_t bufferCount = 4;   // 环形缓冲帧数
+        bool directIo = false;    // 使用O_DIRECT绕过页缓存，文件系统不支持时退回posix_fadvise
+    };
+
+    struct Stats {
+        size_t framesRead{0};     // 预读线程读入的帧数
+        double waitTime{0.0};     // 编码线程等待帧就绪的总时间(秒)
+        double readTime{0.0};     // 预读线程读取和排列数据的总时间(秒)
+        bool directIo{false};     // 实际是否使用了O_DIRECT
+    };
+
+    YuvStreamReader();
+    ~YuvStreamReader();
+
+    YuvStreamReader(const YuvStreamReader&) = delete;
+    YuvStreamReader& operator=(const YuvStreamReader&) = delete;
+
+    // 按扩展名判断是否为可流式读取的文件（.y4m/.yuv）
+    static bool isStreamable(const std::string& path);
+
+    // 打开文件并启动预读线程，共输出frameCount帧，文件帧数不足时从头循环
+    bool open(const std::string& path, const FrameLayout& layout, size_t frameCount,
+              const Options& options);
+    bool open(const std::string& path, const FrameLayout& layout, size_t frameCount) {
+        return open(path, layout, frameCount, Options());
+    }
+
+    void close();
+
+    // 按顺序取下一帧（按layout排列），未就绪时阻塞并计入等待时间
+    // 返回的帧在下一次调用之前有效，读完后返回nullptr
+    const uint8_t* next();
+
+    // 绕过预读缓冲直接读取第index帧到dst（按layout排列），可在其他线程中调用
+    bool readFrameAt(size_t index, uint8_t* dst) const;
+
+    bool isOpen() const { return fd_ >= 0; }
+    size_t fileFrames() const { return fileFrames_; }
+    Stats stats() const;
+
+private:
+    // 解析Y4M文件头，确定第一帧的位置和每帧头的长度
+    bool parseY4MHeader();
+
+    void readerFunc();
+
+    // 顺序读取文件中[offset, offset+size)的数据，按块对齐读入暂存区后复制
+    bool readSequential(uint64_t offset, uint8_t* dst, size_t size);
+    bool loadChunk(uint64_t offset);
+
+    uint64_t frameOffset(size_t index) const {
+        return dataOffset_ + static_cast<uint64_t>(index % fileFrames_) * frameStride_;
+    }
+
+    FrameLayout layout_;
+    Options options_;
+    int fd_{-1};            // 预读线程使用，可能带O_DIRECT
+    int bufferedFd_{-1};    // readFrameAt使用的普通描述符
+    std::atomic<bool> directIo_{false};
+
+    uint64_t dataOffset_{0};    // 第一帧数据（含帧头）的位置
+    uint64_t frameHeader_{0};   // 每帧前的"FRAME\n"长度，原始YUV为0
+    uint64_t frameStride_{0};   // 相邻两帧的间隔
+    size_t packedSize_{0};      // 一帧紧密排列的数据大小
+    size_t fileFrames_{0};
+    size_t totalFrames_{0};
+
+    // 块对齐的暂存区
+    uint8_t* chunk_{nullptr};
+    uint64_t chunkOffset_{0};
+    size_t chunkBytes_{0};
+
+    // 帧缓冲区：free_为空闲槽位，filled_为已读入的槽位
+    std::vector<uint8_t*> slots_;
+    std::unique_ptr<SpscRing<size_t>> free_;
+    std::unique_ptr<SpscRing<size_t>> filled_;
+    size_t current_{SIZE_MAX};  // 编码线程当前持有的槽位
+
+    std::thread readerThread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> framesRead_{0};
+    std::atomic<uint64_t> readNanos_{0};
+    uint64_t waitNanos_{0};
+};
@@ -7,8 +7,53 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/dict.h>
+#include <libavutil/mem.h>
 }
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// 内存AVIOContext的数据源
+struct MemoryReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+};
+
+int readMemory(void* opaque, uint8_t* buf, int bufSize) {
+    auto* reader = static_cast<MemoryReader*>(opaque);
+    const size_t n = std::min(static_cast<size_t>(bufSize), reader->size - reader->pos);
+    if (n == 0) {
+        return AVERROR_EOF;
+    }
+    memcpy(buf, reader->data + reader->pos, n);
+    reader->pos += n;
+    return static_cast<int>(n);
+}
+
+int64_t seekMemory(void* opaque, int64_t offset, int whence) {
+    auto* reader = static_cast<MemoryReader*>(opaque);
+    if (whence == AVSEEK_SIZE) {
+        return static_cast<int64_t>(reader->size);
+    }
+    int64_t target = offset;
+    if ((whence & ~AVSEEK_FORCE) == SEEK_CUR) {
+        target += static_cast<int64_t>(reader->pos);
+    } else if ((whence & ~AVSEEK_FORCE) == SEEK_END) {
+        target += static_cast<int64_t>(reader->size);
+    }
+    if (target < 0 || target > static_cast<int64_t>(reader->size)) {
+        return AVERROR(EINVAL);
+    }
+    reader->pos = static_cast<size_t>(target);
+    return target;
+}
+
+}  // namespace
+
 MP4Parser::Impl::~Impl() {
     if (formatCtx) {
         avformat_close_input(&formatCtx);
@@ -72,6 +117,31 @@ std::vector<MP4Parser::BoxInfo> MP4Parser::getBoxes() const
     return boxes;
 }
 
+std::vector<MP4Parser::BoxInfo> MP4Parser::parseBuffer(const uint8_t* data, size_t size)
+{
+    static constexpr int kBufferSize = 32 * 1024;
+
+    std::vector<BoxInfo> boxes;
+    MemoryReader reader{data, size, 0};
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kBufferSize));
+    if (!buffer) {
+        return boxes;
+    }
+    AVIOContext* pb = avio_alloc_context(buffer, kBufferSize, 0, &reader, readMemory, nullptr, seekMemory);
+    if (!pb) {
+        av_free(buffer);
+        return boxes;
+    }
+
+    MP4Parser parser;
+    parser.parseBoxes(pb, 0, &boxes);
+
+    // 缓冲可能已被AVIOContext重新分配，按上下文中的指针释放
+    av_freep(&pb->buffer);
+    avio_context_free(&pb);
+    return boxes;
+}
+
 void MP4Parser::parseBoxes(AVIOContext* pb, int level, std::vector<BoxInfo>* boxes) const
 {
     while (!avio_feof(pb)) {
@@ -63,6 +63,9 @@ public:
     void close();
 
     std::vector<BoxInfo> getBoxes() const;
+
+    // 解析内存中的box结构，不经过avformat探测（用于基准测试和已读入内存的片段）
+    static std::vector<BoxInfo> parseBuffer(const uint8_t* data, size_t size);
     VideoInfo getVideoInfo() const;
     AudioInfo getAudioInfo() const;
     std::map<std::string, std::string> getMetadata() const;
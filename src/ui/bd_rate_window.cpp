@@ -0,0 +1,202 @@
+#include "bd_rate_window.hpp"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDir>
+#include <cmath>
+
+BdRateWindow::BdRateWindow(QWidget* parent)
+    : QWidget(parent)
+{
+    setupUI();
+    setupConnections();
+}
+
+QWidget* BdRateWindow::createSetGroup(const QString& title, ResultSet& set)
+{
+    auto* group = new QGroupBox(title, this);
+    auto* layout = new QGridLayout(group);
+
+    set.pathEdit = new QLineEdit(this);
+    set.pathEdit->setPlaceholderText(tr("导出的编码历史或参数扫描CSV"));
+    set.browseButton = new QPushButton(tr("浏览..."), this);
+    set.groupCombo = new QComboBox(this);
+    set.groupCombo->addItem(tr("全部记录"));
+
+    layout->addWidget(new QLabel(tr("文件:")), 0, 0);
+    layout->addWidget(set.pathEdit, 0, 1);
+    layout->addWidget(set.browseButton, 0, 2);
+    layout->addWidget(new QLabel(tr("选取:")), 1, 0);
+    layout->addWidget(set.groupCombo, 1, 1, 1, 2);
+    return group;
+}
+
+void BdRateWindow::setupUI()
+{
+    auto* mainLayout = new QVBoxLayout(this);
+    mainLayout->setContentsMargins(6, 6, 6, 6);
+    mainLayout->setSpacing(6);
+
+    auto* setsLayout = new QHBoxLayout();
+    setsLayout->addWidget(createSetGroup(tr("锚点"), anchor_));
+    setsLayout->addWidget(createSetGroup(tr("测试"), test_));
+    mainLayout->addLayout(setsLayout);
+
+    auto* buttonLayout = new QHBoxLayout();
+    compareButton_ = new QPushButton(tr("计算BD-rate"), this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(compareButton_);
+    mainLayout->addLayout(buttonLayout);
+
+    resultTable_ = new QTableWidget(2, 5, this);
+    resultTable_->setHorizontalHeaderLabels({
+        tr("BD-rate(%)"),
+        tr("BD-质量"),
+        tr("质量重叠区间"),
+        tr("码率重叠区间(kbps)"),
+        tr("点数(锚点/测试)")
+    });
+    resultTable_->setVerticalHeaderLabels({tr("PSNR"), tr("SSIM")});
+    resultTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultTable_->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    mainLayout->addWidget(resultTable_);
+
+    summaryLabel_ = new QLabel(this);
+    summaryLabel_->setWordWrap(true);
+    summaryLabel_->setText(tr("BD-rate为负表示测试组在相同质量下节省码率；每组至少需要2个码率点，建议4个以上"));
+    mainLayout->addWidget(summaryLabel_);
+    mainLayout->addStretch();
+}
+
+void BdRateWindow::setupConnections()
+{
+    connect(anchor_.browseButton, &QPushButton::clicked, this, [this]() { browse(anchor_); });
+    connect(test_.browseButton, &QPushButton::clicked, this, [this]() { browse(test_); });
+    connect(anchor_.pathEdit, &QLineEdit::editingFinished, this, [this]() { loadSet(anchor_); });
+    connect(test_.pathEdit, &QLineEdit::editingFinished, this, [this]() { loadSet(test_); });
+    connect(compareButton_, &QPushButton::clicked, this, &BdRateWindow::onCompare);
+}
+
+void BdRateWindow::browse(ResultSet& set)
+{
+    // 测试组默认使用锚点所在目录，方便从同一份历史记录中选两组
+    QString dir = set.pathEdit->text();
+    if (dir.isEmpty()) {
+        dir = anchor_.pathEdit->text().isEmpty() ? QDir::homePath() : anchor_.pathEdit->text();
+    }
+
+    QString fileName = QFileDialog::getOpenFileName(this,
+        tr("选择结果文件"), dir, tr("CSV文件 (*.csv);;所有文件 (*)"));
+    if (!fileName.isEmpty()) {
+        set.pathEdit->setText(fileName);
+        loadSet(set);
+    }
+}
+
+bool BdRateWindow::loadSet(ResultSet& set)
+{
+    const QString path = set.pathEdit->text();
+    if (path.isEmpty()) {
+        return false;
+    }
+    if (path == set.loadedPath) {
+        return true;
+    }
+
+    std::string error;
+    if (!set.table.loadCsv(path.toStdString(), &error)) {
+        set.loadedPath.clear();
+        QMessageBox::warning(this, tr("错误"), QString::fromStdString(error));
+        return false;
+    }
+    set.loadedPath = path;
+
+    // 分组条件：每个"列=值"一项，选中后只用匹配的行拟合曲线
+    set.groupCombo->clear();
+    set.groupCombo->addItem(tr("全部记录"));
+    for (const auto& group : set.table.groupColumns()) {
+        const QString column = QString::fromStdString(group.first);
+        for (const auto& value : group.second) {
+            const QString text = QString::fromStdString(value);
+            set.groupCombo->addItem(QString("%1 = %2").arg(column, text), QStringList{column, text});
+        }
+    }
+    return true;
+}
+
+void BdRateWindow::onCompare()
+{
+    if (!loadSet(anchor_) || !loadSet(test_)) {
+        QMessageBox::warning(this, tr("错误"), tr("请先选择锚点和测试的结果文件"));
+        return;
+    }
+
+    auto selection = [](const ResultSet& set) {
+        const QStringList data = set.groupCombo->currentData().toStringList();
+        return data.size() == 2
+            ? std::make_pair(data[0].toStdString(), data[1].toStdString())
+            : std::make_pair(std::string(), std::string());
+    };
+    const auto anchorGroup = selection(anchor_);
+    const auto testGroup = selection(test_);
+
+    using Metric = RateQualityTable::Metric;
+    const auto anchorPsnr = anchor_.table.curve(Metric::PSNR, anchorGroup.first, anchorGroup.second);
+    const auto testPsnr = test_.table.curve(Metric::PSNR, testGroup.first, testGroup.second);
+    const auto anchorSsim = anchor_.table.curve(Metric::SSIM, anchorGroup.first, anchorGroup.second);
+    const auto testSsim = test_.table.curve(Metric::SSIM, testGroup.first, testGroup.second);
+
+    const BdRate::Result psnr = BdRate::compare(anchorPsnr, testPsnr);
+    const BdRate::Result ssim = BdRate::compare(anchorSsim, testSsim);
+    fillResultRow(0, "PSNR", psnr, anchorPsnr.size(), testPsnr.size());
+    fillResultRow(1, "SSIM", ssim, anchorSsim.size(), testSsim.size());
+
+    // 摘要：码率节省和编码耗时比，如"节省7.0%码率，每帧编码耗时为锚点的2.1倍"
+    const BdRate::Result& primary = psnr.valid ? psnr : ssim;
+    if (!primary.valid) {
+        summaryLabel_->setText(tr("无法计算: %1").arg(QString::fromStdString(primary.error)));
+        return;
+    }
+
+    QString summary = tr("相同%1下，测试组%2 %3% 码率")
+        .arg(QString(psnr.valid ? "PSNR" : "SSIM"))
+        .arg(primary.rate <= 0 ? tr("节省") : tr("多用"))
+        .arg(std::abs(primary.rate), 0, 'f', 2);
+
+    const double anchorTime = anchor_.table.secondsPerFrame(anchorGroup.first, anchorGroup.second);
+    const double testTime = test_.table.secondsPerFrame(testGroup.first, testGroup.second);
+    if (anchorTime > 0 && testTime > 0) {
+        summary += tr("，每帧编码耗时为锚点的 %1×").arg(testTime / anchorTime, 0, 'f', 2);
+    }
+    summaryLabel_->setText(summary);
+}
+
+void BdRateWindow::fillResultRow(int row, const QString& metric, const BdRate::Result& result,
+                                 size_t anchorPoints, size_t testPoints)
+{
+    const QString points = QString("%1 / %2").arg(anchorPoints).arg(testPoints);
+    if (!result.valid) {
+        resultTable_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(result.error)));
+        for (int column = 1; column < 4; ++column) {
+            resultTable_->setItem(row, column, new QTableWidgetItem("-"));
+        }
+        resultTable_->setItem(row, 4, new QTableWidgetItem(points));
+        return;
+    }
+
+    // PSNR以dB为单位，SSIM取值在0-1之间，需要更多小数位
+    const bool psnr = metric == "PSNR";
+    const int precision = psnr ? 3 : 5;
+    resultTable_->setItem(row, 0, new QTableWidgetItem(QString::number(result.rate, 'f', 2)));
+    resultTable_->setItem(row, 1, new QTableWidgetItem(
+        QString("%1%2").arg(result.quality, 0, 'f', precision).arg(QString(psnr ? " dB" : ""))));
+    resultTable_->setItem(row, 2, new QTableWidgetItem(QString("%1 - %2")
+        .arg(result.qualityLow, 0, 'f', precision).arg(result.qualityHigh, 0, 'f', precision)));
+    resultTable_->setItem(row, 3, new QTableWidgetItem(QString("%1 - %2")
+        .arg(result.bitrateLow, 0, 'f', 0).arg(result.bitrateHigh, 0, 'f', 0)));
+    resultTable_->setItem(row, 4, new QTableWidgetItem(points));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include "encode/bd_rate.hpp"
+
+// BD-rate对比：从两份导出的历史记录（或同一份中的两组配置）计算BD-rate/BD-PSNR/BD-SSIM
+class BdRateWindow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit BdRateWindow(QWidget* parent = nullptr);
+    ~BdRateWindow() override = default;
+
+private slots:
+    void onCompare();
+
+private:
+    // 一组结果：CSV文件及选出曲线的分组条件
+    struct ResultSet {
+        QLineEdit* pathEdit{nullptr};
+        QPushButton* browseButton{nullptr};
+        QComboBox* groupCombo{nullptr};
+        RateQualityTable table;
+        QString loadedPath;
+    };
+
+    void setupUI();
+    void setupConnections();
+    QWidget* createSetGroup(const QString& title, ResultSet& set);
+    void browse(ResultSet& set);
+    bool loadSet(ResultSet& set);
+    void fillResultRow(int row, const QString& metric, const BdRate::Result& result,
+                       size_t anchorPoints, size_t testPoints);
+
+    ResultSet anchor_;
+    ResultSet test_;
+    QPushButton* compareButton_{nullptr};
+    QTableWidget* resultTable_{nullptr};
+    QLabel* summaryLabel_{nullptr};
+};
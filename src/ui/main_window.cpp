@@ -9,6 +9,7 @@ MainWindow::MainWindow(QWidget *parent)
     , aacConfigWindow_(new AACConfigWindow(this))
     , mp4ConfigWindow_(new MP4ConfigWindow(this))
     , vlcPlayerWindow_(new VLCPlayerWindow(this))
+    , bdRateWindow_(new BdRateWindow(this))
 {
     setupUI();
 }
@@ -29,6 +30,7 @@ void MainWindow::setupUI()
     tabWidget_->addTab(aacConfigWindow_, "AAC");
     tabWidget_->addTab(mp4ConfigWindow_, "MP4");
     tabWidget_->addTab(vlcPlayerWindow_, "VLC播放器");
+    tabWidget_->addTab(bdRateWindow_, "BD-rate对比");
 
     mainLayout->addWidget(tabWidget_);
 
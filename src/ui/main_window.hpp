@@ -7,6 +7,7 @@
 #include "aac_config_window.hpp"
 #include "mp4_config_window.hpp"
 #include "vlc_player_window.hpp"
+#include "bd_rate_window.hpp"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -25,4 +26,5 @@ private:
     AACConfigWindow* aacConfigWindow_{nullptr};
     MP4ConfigWindow* mp4ConfigWindow_{nullptr};
     VLCPlayerWindow* vlcPlayerWindow_{nullptr};
+    BdRateWindow* bdRateWindow_{nullptr};
 }; 
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <QScrollBar>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 #include <QVideoWidget>
 #include <QMediaPlayer>
 #include <QTimer>
@@ -17,6 +18,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QTextStream>
 
 VP8ConfigWindow::VP8ConfigWindow(QWidget *parent)
@@ -74,7 +76,8 @@ void VP8ConfigWindow::setupUI()
     }
     
     threadsSpinBox_ = new QSpinBox(this);
-    threadsSpinBox_->setRange(1, QThread::idealThreadCount());
+    threadsSpinBox_->setRange(0, QThread::idealThreadCount());
+    threadsSpinBox_->setSpecialValueText(tr("自动"));
     threadsSpinBox_->setValue(QThread::idealThreadCount());
     
     basicLayout->addWidget(new QLabel(tr("预设:")), 0, 0);
@@ -291,37 +294,11 @@ void VP8ConfigWindow::createConnections()
     connect(clearHistoryButton_, &QPushButton::clicked, this, &VP8ConfigWindow::clearEncodingHistory);
     connect(exportHistoryButton_, &QPushButton::clicked, this, &VP8ConfigWindow::exportEncodingHistory);
     
-    // 加载历史记录
-    QFile file(QDir::homePath() + "/.vp8_encoding_history.json");
-    if (file.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        file.close();
-        
-        if (doc.isArray()) {
-            QJsonArray array = doc.array();
-            for (const auto& value : array) {
-                QJsonObject obj = value.toObject();
-                VP8EncodingRecord record;
-                record.timestamp = QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate);
-                record.width = obj["width"].toInt();
-                record.height = obj["height"].toInt();
-                record.preset = obj["preset"].toString();
-                record.speed = obj["speed"].toInt();
-                record.rateControl = obj["rateControl"].toString();
-                record.rateValue = obj["rateValue"].toInt();
-                record.keyint = obj["keyint"].toInt();
-                record.qmin = obj["qmin"].toInt();
-                record.qmax = obj["qmax"].toInt();
-                record.encodingTime = obj["encodingTime"].toDouble();
-                record.fps = obj["fps"].toDouble();
-                record.bitrate = obj["bitrate"].toDouble();
-                record.psnr = obj["psnr"].toDouble();
-                record.ssim = obj["ssim"].toDouble();
-                encodingHistory_.push_back(record);
-            }
-            updateHistoryTable();
-        }
-    }
+    // 窗口显示后再读取历史，不阻塞启动
+    QTimer::singleShot(0, this, [this]() {
+        importLegacyHistory();
+        updateHistoryTable();
+    });
 }
 
 void VP8ConfigWindow::onStartEncoding()
@@ -384,6 +361,12 @@ void VP8ConfigWindow::onStartEncoding()
         
         // 编码完成后，在主线程中更新UI
         QMetaObject::invokeMethod(this, [this, result, config]() {
+            if (!result.success) {
+                appendLog(tr("\n编码失败：%1\n").arg(QString::fromStdString(result.error)));
+                onEncodingFinished();
+                return;
+            }
+
             QString summary = QString(
                 "\n编码完成！\n"
                 "总编码时间: %1 秒\n"
@@ -398,26 +381,13 @@ void VP8ConfigWindow::onStartEncoding()
                 .arg(result.ssim, 0, 'f', 3);
             appendLog(summary);
 
+            if (!result.output_file.empty()) {
+                currentOutputFile_ = QString::fromStdString(result.output_file);
+            }
+
             // 添加到历史记录
-            VP8EncodingRecord record;
-            record.timestamp = QDateTime::currentDateTime();
-            record.width = config.width;
-            record.height = config.height;
-            record.frameCount = config.frames;
-            record.preset = presetCombo_->currentText();
-            record.speed = speedCombo_->currentIndex();
-            record.threads = config.threads;
-            record.rateControl = rateControlCombo_->currentText();
-            record.rateValue = rateValueSpinBox_->value();
-            record.keyint = config.keyint;
-            record.qmin = config.qmin;
-            record.qmax = config.qmax;
-            record.encodingTime = result.encoding_time;
-            record.fps = result.fps;
-            record.bitrate = result.bitrate;
-            record.psnr = result.psnr;
-            record.ssim = result.ssim;
-            record.outputFile = currentOutputFile_;
+            HistoryStore::Record record = HistoryStore::fromVp8(config, result);
+            record.setOutputFile(result.output_file);
             
             addEncodingRecord(record);
             onEncodingFinished();
@@ -518,20 +488,23 @@ void VP8ConfigWindow::onSceneConfigChanged(int index)
 
 void VP8ConfigWindow::onPlayVideo()
 {
-    // 查找 datas 目录下最新的 webm 文件
-    QDir dataDir("datas");
-    if (!dataDir.exists()) {
-        QMessageBox::warning(this, tr("错误"), tr("datas目录不存在"));
-        return;
-    }
+    // 优先播放本次编码的输出，否则查找 datas 目录下最新的 webm/ivf 文件
+    if (currentOutputFile_.isEmpty() || !QFileInfo::exists(currentOutputFile_)) {
+        QDir dataDir("datas");
+        if (!dataDir.exists()) {
+            QMessageBox::warning(this, tr("错误"), tr("datas目录不存在"));
+            return;
+        }
 
-    QFileInfoList files = dataDir.entryInfoList(QStringList() << "vp8_*.webm", QDir::Files, QDir::Time);
-    if (files.isEmpty()) {
-        QMessageBox::warning(this, tr("错误"), tr("没有找到可播放的视频文件"));
-        return;
-    }
+        QFileInfoList files = dataDir.entryInfoList(QStringList() << "vp8_*.webm" << "vp8_*.ivf",
+                                                    QDir::Files, QDir::Time);
+        if (files.isEmpty()) {
+            QMessageBox::warning(this, tr("错误"), tr("没有找到可播放的视频文件"));
+            return;
+        }
 
-    currentOutputFile_ = files.first().absoluteFilePath();
+        currentOutputFile_ = files.first().absoluteFilePath();
+    }
 
     if (mediaPlayer_->playbackState() != QMediaPlayer::PlayingState) {
         mediaPlayer_->setSource(QUrl::fromLocalFile(currentOutputFile_));
@@ -608,45 +581,53 @@ void VP8ConfigWindow::onGenerateFrames()
     }
 }
 
-void VP8ConfigWindow::addEncodingRecord(const VP8EncodingRecord& record)
+void VP8ConfigWindow::addEncodingRecord(const HistoryStore::Record& record)
 {
-    encodingHistory_.push_back(record);
+    if (!history_.append(record)) {
+        appendLog(tr("无法写入编码历史: %1").arg(QString::fromStdString(history_.path())));
+    }
     updateHistoryTable();
-    saveHistoryToFile();
 }
 
 void VP8ConfigWindow::updateHistoryTable()
 {
-    historyTable_->setRowCount(encodingHistory_.size());
+    // 表格只显示最近的记录，更早的记录保留在历史文件中，可以导出
+    constexpr size_t kMaxRows = 1000;
+    HistoryStore::Filter filter;
+    filter.codec = static_cast<int>(HistoryStore::Codec::VP8);
+    const std::vector<uint32_t> indices = history_.query(filter, kMaxRows);
+
+    historyTable_->setRowCount(static_cast<int>(indices.size()));
     
-    for (size_t i = 0; i < encodingHistory_.size(); ++i) {
-        const auto& record = encodingHistory_[i];
+    for (size_t i = 0; i < indices.size(); ++i) {
+        const HistoryStore::Record& record = history_.at(indices[i]);
+        const bool cq = record.rateControl == static_cast<uint8_t>(VP8ParamTest::RateControl::CQ);
         int col = 0;
         
         // 时间
         historyTable_->setItem(i, col++, new QTableWidgetItem(
-            record.timestamp.toString("yyyy-MM-dd hh:mm:ss")));
+            QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("yyyy-MM-dd hh:mm:ss")));
         
         // 分辨率
         historyTable_->setItem(i, col++, new QTableWidgetItem(
             QString("%1x%2").arg(record.width).arg(record.height)));
         
         // 预设
-        historyTable_->setItem(i, col++, new QTableWidgetItem(record.preset));
+        historyTable_->setItem(i, col++, new QTableWidgetItem(presetCombo_->itemText(record.preset)));
         
         // 速度
         historyTable_->setItem(i, col++, new QTableWidgetItem(
-            QString::number(record.speed)));
+            QString::number(record.tune)));
         
         // 码率控制
-        historyTable_->setItem(i, col++, new QTableWidgetItem(record.rateControl));
+        historyTable_->setItem(i, col++, new QTableWidgetItem(rateControlCombo_->itemText(record.rateControl)));
         
         // 码率/CQ
         QString rateStr;
-        if (record.rateControl.contains("CQ")) {
+        if (cq) {
             rateStr = QString("CQ %1").arg(record.rateValue);
         } else {
-            rateStr = QString("%1 kbps").arg(record.rateValue);
+            rateStr = QString("%1 kbps").arg(record.rateValue / 1000);
         }
         historyTable_->setItem(i, col++, new QTableWidgetItem(rateStr));
         
@@ -672,9 +653,8 @@ void VP8ConfigWindow::updateHistoryTable()
 
 void VP8ConfigWindow::clearEncodingHistory()
 {
-    encodingHistory_.clear();
+    history_.erase(static_cast<int>(HistoryStore::Codec::VP8));
     updateHistoryTable();
-    saveHistoryToFile();
 }
 
 void VP8ConfigWindow::exportEncodingHistory()
@@ -697,23 +677,27 @@ void VP8ConfigWindow::exportEncodingHistory()
     QTextStream out(&file);
     
     // 写入表头
-    out << "时间,分辨率,预设,速度,码率控制,码率/CQ,编码时间,编码速度,PSNR,SSIM\n";
-    
-    // 写入数据
-    for (const auto& record : encodingHistory_) {
-        out << record.timestamp.toString("yyyy-MM-dd hh:mm:ss") << ",";
+    out << "时间,分辨率,预设,速度,码率控制,码率/CQ,编码时间,编码速度,码率(kbps),PSNR,SSIM\n";
+    
+    // 写入数据，导出历史文件中全部的VP8记录
+    HistoryStore::Filter filter;
+    filter.codec = static_cast<int>(HistoryStore::Codec::VP8);
+    for (uint32_t index : history_.query(filter)) {
+        const HistoryStore::Record& record = history_.at(index);
+        out << QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("yyyy-MM-dd hh:mm:ss") << ",";
         out << record.width << "x" << record.height << ",";
-        out << record.preset << ",";
-        out << record.speed << ",";
-        out << record.rateControl << ",";
-        if (record.rateControl.contains("CQ")) {
+        out << presetCombo_->itemText(record.preset) << ",";
+        out << record.tune << ",";
+        out << rateControlCombo_->itemText(record.rateControl) << ",";
+        if (record.rateControl == static_cast<uint8_t>(VP8ParamTest::RateControl::CQ)) {
             out << "CQ " << record.rateValue;
         } else {
-            out << record.rateValue << " kbps";
+            out << record.rateValue / 1000 << " kbps";
         }
         out << ",";
         out << QString::number(record.encodingTime, 'f', 1) << ",";
         out << QString::number(record.fps, 'f', 1) << ",";
+        out << QString::number(record.bitrate / 1000.0, 'f', 0) << ",";
         out << QString::number(record.psnr, 'f', 2) << ",";
         out << QString::number(record.ssim, 'f', 4) << "\n";
     }
@@ -722,38 +706,49 @@ void VP8ConfigWindow::exportEncodingHistory()
     QMessageBox::information(this, tr("成功"), tr("编码历史已成功导出"));
 }
 
-void VP8ConfigWindow::saveHistoryToFile()
+void VP8ConfigWindow::importLegacyHistory()
 {
-    QFile file(QDir::homePath() + "/.vp8_encoding_history.json");
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "无法保存编码历史到文件";
+    // 旧版本把历史保存在~/.vp8_encoding_history.json，导入一次后改名，不再读取
+    const QString legacyPath = QDir::homePath() + "/.vp8_encoding_history.json";
+    QFile file(legacyPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+    if (!doc.isArray()) {
         return;
     }
     
-    QJsonArray array;
-    for (const auto& record : encodingHistory_) {
-        QJsonObject obj;
-        obj["timestamp"] = record.timestamp.toString(Qt::ISODate);
-        obj["width"] = record.width;
-        obj["height"] = record.height;
-        obj["preset"] = record.preset;
-        obj["speed"] = record.speed;
-        obj["rateControl"] = record.rateControl;
-        obj["rateValue"] = record.rateValue;
-        obj["keyint"] = record.keyint;
-        obj["qmin"] = record.qmin;
-        obj["qmax"] = record.qmax;
-        obj["encodingTime"] = record.encodingTime;
-        obj["fps"] = record.fps;
-        obj["bitrate"] = record.bitrate;
-        obj["psnr"] = record.psnr;
-        obj["ssim"] = record.ssim;
-        array.append(obj);
+    for (const auto& value : doc.array()) {
+        QJsonObject obj = value.toObject();
+        HistoryStore::Record record;
+        record.codec = static_cast<uint8_t>(HistoryStore::Codec::VP8);
+        record.timestamp = QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate).toMSecsSinceEpoch();
+        record.width = static_cast<uint16_t>(obj["width"].toInt());
+        record.height = static_cast<uint16_t>(obj["height"].toInt());
+        record.preset = static_cast<uint8_t>(std::max(0, presetCombo_->findText(obj["preset"].toString())));
+        record.tune = static_cast<uint8_t>(obj["speed"].toInt());
+        record.rateControl = static_cast<uint8_t>(std::max(0, rateControlCombo_->findText(obj["rateControl"].toString())));
+        // 旧记录的码率以kbps保存
+        const bool cq = obj["rateControl"].toString().contains("CQ");
+        record.rateValue = cq ? obj["rateValue"].toInt() : obj["rateValue"].toInt() * 1000;
+        record.keyint = obj["keyint"].toInt();
+        record.qmin = obj["qmin"].toInt();
+        record.qmax = obj["qmax"].toInt();
+        record.encodingTime = obj["encodingTime"].toDouble();
+        record.fps = obj["fps"].toDouble();
+        record.bitrate = obj["bitrate"].toDouble();
+        record.psnr = obj["psnr"].toDouble();
+        record.ssim = obj["ssim"].toDouble();
+        if (!history_.append(record)) {
+            appendLog(tr("导入旧的编码历史失败"));
+            return;
+        }
     }
     
-    QJsonDocument doc(array);
-    file.write(doc.toJson());
-    file.close();
+    QFile::rename(legacyPath, legacyPath + ".imported");
+    appendLog(tr("已导入旧的编码历史: %1 条").arg(doc.array().size()));
 }
 
 void VP8ConfigWindow::updateUIFromConfig(const VP8ParamTest::TestConfig& config)
@@ -20,36 +20,10 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include "encode/history_store.hpp"
 #include "encode/vp8_param_test.hpp"
 #include <thread>
 
-// 历史记录结构体
-struct VP8EncodingRecord {
-    // 输入参数
-    int width;
-    int height;
-    int frameCount;
-    QString preset;     // best/good/realtime
-    int speed;         // 0-16
-    int threads;
-    QString rateControl;
-    int rateValue;     // bitrate或CQ值
-    int keyint;        // 关键帧间隔
-    int qmin;          // 最小量化参数
-    int qmax;          // 最大量化参数
-    
-    // 编码结果
-    double encodingTime;
-    double fps;
-    double bitrate;
-    double psnr;
-    double ssim;
-    QString outputFile;
-    
-    // 时间戳
-    QDateTime timestamp;
-};
-
 class VP8ConfigWindow : public QMainWindow {
     Q_OBJECT
 
@@ -71,7 +45,7 @@ public Q_SLOTS:
     void appendLog(const QString& text);
     void onEncodingFinished();
     void onGenerateFrames();
-    void addEncodingRecord(const VP8EncodingRecord& record);
+    void addEncodingRecord(const HistoryStore::Record& record);
     void clearEncodingHistory();
     void exportEncodingHistory();
 
@@ -81,7 +55,7 @@ private:
     void updateUIFromConfig(const VP8ParamTest::TestConfig& config);
     VP8ParamTest::TestConfig getConfigFromUI() const;
     void updateHistoryTable();
-    void saveHistoryToFile();
+    void importLegacyHistory();
 
     // 基本参数控件
     QComboBox* presetCombo_{};      // best/good/realtime
@@ -122,5 +96,5 @@ private:
     QTableWidget* historyTable_{};
     QPushButton* clearHistoryButton_{};
     QPushButton* exportHistoryButton_{};
-    std::vector<VP8EncodingRecord> encodingHistory_;
+    HistoryStore history_;  // 持久化的编码历史，与x264窗口和命令行共用
 }; 
\ No newline at end of file
@@ -29,6 +29,9 @@ X264ConfigWindow::X264ConfigWindow(QWidget *parent)
     // 设置默认配置
     X264ParamTest::TestConfig defaultConfig;
     updateUIFromConfig(defaultConfig);
+
+    // 窗口显示后再读取历史，不阻塞启动
+    QTimer::singleShot(0, this, &X264ConfigWindow::loadEncodingHistory);
 }
 
 X264ConfigWindow::~X264ConfigWindow() {
@@ -75,7 +78,8 @@ void X264ConfigWindow::setupUI()
     });
     
     threadsSpinBox_ = new QSpinBox(this);
-    threadsSpinBox_->setRange(1, 128);
+    threadsSpinBox_->setRange(0, 128);
+    threadsSpinBox_->setSpecialValueText(tr("自动"));
     
     basicLayout->addWidget(new QLabel(tr("预设:")), 0, 0);
     basicLayout->addWidget(presetCombo_, 0, 1);
@@ -101,6 +105,24 @@ void X264ConfigWindow::setupUI()
     videoLayout->addWidget(heightSpinBox_, 1, 1);
     videoLayout->addWidget(new QLabel(tr("帧数:")), 2, 0);
     videoLayout->addWidget(frameCountSpinBox_, 2, 1);
+
+    // 输入源：合成图案或真实内容（图片序列目录/视频文件）
+    sourceCombo_ = new QComboBox(this);
+    sourceCombo_->setEditable(true);
+    sourceCombo_->addItem(tr("合成图案"), QString());
+    sourceCombo_->addItem("datas/frames", QString("datas/frames"));
+    auto* browseSourceButton = new QPushButton(tr("浏览..."), this);
+    connect(browseSourceButton, &QPushButton::clicked, this, [this]() {
+        QString fileName = QFileDialog::getOpenFileName(this, tr("选择输入视频"), "datas",
+            tr("视频文件 (*.mp4 *.mkv *.webm *.mov *.h264 *.y4m);;所有文件 (*)"));
+        if (!fileName.isEmpty()) {
+            sourceCombo_->setEditText(fileName);
+        }
+    });
+
+    videoLayout->addWidget(new QLabel(tr("输入源:")), 3, 0);
+    videoLayout->addWidget(sourceCombo_, 3, 1);
+    videoLayout->addWidget(browseSourceButton, 3, 2);
     
     // 码率控制组
     auto* rateGroup = new QGroupBox(tr("码率控制"), this);
@@ -149,12 +171,14 @@ void X264ConfigWindow::setupUI()
     meRangeSpinBox_->setRange(4, 64);
     weightedPredCheckBox_ = new QCheckBox(tr("加权预测"), this);
     cabacCheckBox_ = new QCheckBox(tr("CABAC熵编码"), this);
+    zeroCopyCheckBox_ = new QCheckBox(tr("零拷贝提交帧"), this);
     
     qualityLayout->addWidget(fastFirstPassCheckBox_, 0, 0, 1, 2);
     qualityLayout->addWidget(new QLabel(tr("运动估计范围:")), 1, 0);
     qualityLayout->addWidget(meRangeSpinBox_, 1, 1);
     qualityLayout->addWidget(weightedPredCheckBox_, 2, 0, 1, 2);
     qualityLayout->addWidget(cabacCheckBox_, 3, 0, 1, 2);
+    qualityLayout->addWidget(zeroCopyCheckBox_, 4, 0, 1, 2);
     
     // 添加所有组到左侧布局
     leftLayout->addWidget(basicGroup);
@@ -298,6 +322,9 @@ void X264ConfigWindow::setupUI()
     historyButtonLayout->addWidget(exportHistoryButton_);
     historyButtonLayout->addStretch();
     
+    historySummaryLabel_ = new QLabel(this);
+    historyButtonLayout->addWidget(historySummaryLabel_);
+
     historyLayout->addWidget(historyTable_);
     historyLayout->addLayout(historyButtonLayout);
     
@@ -409,30 +436,7 @@ void X264ConfigWindow::onStartEncoding()
                 appendLog(summary);
 
                 // 添加到历史记录
-                EncodingRecord record;
-                record.timestamp = QDateTime::currentDateTime();
-                record.width = config.width;
-                record.height = config.height;
-                record.frameCount = config.frameCount;
-                record.preset = presetCombo_->currentText();
-                record.tune = tuneCombo_->currentText();
-                record.threads = config.threads;
-                record.rateControl = rateControlCombo_->currentText();
-                record.rateValue = rateValueSpinBox_->value();
-                record.keyintMax = config.keyintMax;
-                record.bframes = config.bframes;
-                record.refs = config.refs;
-                record.fastFirstPass = config.fastFirstPass;
-                record.meRange = config.meRange;
-                record.weightedPred = config.weightedPred;
-                record.cabac = config.cabac;
-                record.encodingTime = result.encodingTime;
-                record.fps = result.fps;
-                record.bitrate = result.bitrate;
-                record.psnr = result.psnr;
-                record.ssim = result.ssim;
-                record.outputFile = currentOutputFile_;
-                
+                HistoryStore::Record record = HistoryStore::fromX264(config, result);
                 addEncodingRecord(record);
             } else {
                 appendLog(tr("\n编码失败：%1\n").arg(QString::fromStdString(result.errorMessage)));
@@ -598,6 +602,12 @@ void X264ConfigWindow::updateUIFromConfig(const X264ParamTest::TestConfig& confi
     meRangeSpinBox_->setValue(config.meRange);
     weightedPredCheckBox_->setChecked(config.weightedPred);
     cabacCheckBox_->setChecked(config.cabac);
+    zeroCopyCheckBox_->setChecked(config.zeroCopy);
+    if (config.sourcePath.empty()) {
+        sourceCombo_->setCurrentIndex(0);
+    } else {
+        sourceCombo_->setEditText(QString::fromStdString(config.sourcePath));
+    }
 }
 
 X264ParamTest::TestConfig X264ConfigWindow::getConfigFromUI() const
@@ -634,6 +644,13 @@ X264ParamTest::TestConfig X264ConfigWindow::getConfigFromUI() const
     config.meRange = meRangeSpinBox_->value();
     config.weightedPred = weightedPredCheckBox_->isChecked();
     config.cabac = cabacCheckBox_->isChecked();
+    config.zeroCopy = zeroCopyCheckBox_->isChecked();
+
+    // 第一项为合成图案，其余为输入路径
+    QString source = sourceCombo_->currentText();
+    if (source != sourceCombo_->itemText(0)) {
+        config.sourcePath = source.toStdString();
+    }
     
     return config;
 }
@@ -697,7 +714,7 @@ void X264ConfigWindow::onGenerateFrames()
     // 创建后台线程进行帧生成
     std::thread([this, config]() {
         X264ParamTest test;
-        test.gen_status_.progress_callback = [this](float progress) {
+        auto progressCallback = [this](float progress) {
             static auto lastUpdateTime = std::chrono::steady_clock::now();
             auto now = std::chrono::steady_clock::now();
             static int lastPercent = -1;
@@ -736,7 +753,7 @@ void X264ConfigWindow::onGenerateFrames()
 
         auto start_time = std::chrono::steady_clock::now();
 
-        if (test.initFrameCache(config)) {
+        if (test.initFrameCache(config, progressCallback)) {
             auto end_time = std::chrono::steady_clock::now();
             double duration = std::chrono::duration<double>(end_time - start_time).count();
             
@@ -767,37 +784,89 @@ void X264ConfigWindow::setupHistoryUI()
     connect(exportHistoryButton_, &QPushButton::clicked, this, &X264ConfigWindow::exportEncodingHistory);
 }
 
-void X264ConfigWindow::addEncodingRecord(const EncodingRecord& record)
+void X264ConfigWindow::addEncodingRecord(const HistoryStore::Record& record)
+{
+    HistoryStore::Record stored = record;
+    if (stored.timestamp == 0) {
+        stored.timestamp = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    // 写入持久化历史
+    if (!history_.append(stored)) {
+        appendLog(tr("无法写入编码历史: %1\n").arg(QString::fromStdString(history_.path())));
+    }
+
+    appendHistoryRow(stored);
+    updateHistorySummary();
+}
+
+void X264ConfigWindow::loadEncodingHistory()
+{
+    // 表格只显示最近的记录，更早的记录保留在历史文件中，可以导出
+    constexpr size_t kMaxRows = 1000;
+    HistoryStore::Filter filter;
+    filter.codec = static_cast<int>(HistoryStore::Codec::X264);
+
+    historyTable_->setUpdatesEnabled(false);
+    historyTable_->setRowCount(0);
+    for (uint32_t index : history_.query(filter, kMaxRows)) {
+        appendHistoryRow(history_.at(index));
+    }
+    historyTable_->setUpdatesEnabled(true);
+    updateHistorySummary();
+
+    // 历史加载后，切换预设时更新统计
+    connect(presetCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &X264ConfigWindow::updateHistorySummary, Qt::UniqueConnection);
+}
+
+void X264ConfigWindow::appendHistoryRow(const HistoryStore::Record& record)
 {
-    // 添加到历史记录向量
-    encodingHistory_.push_back(record);
-    
-    // 添加到表格
     int row = historyTable_->rowCount();
     historyTable_->insertRow(row);
-    
-    // 设置单元格内容
+
+    // 设置单元格内容，枚举按下拉框的顺序换算为文本
     historyTable_->setItem(row, 0, new QTableWidgetItem(QString("%1×%2").arg(record.width).arg(record.height)));  // 使用×而不是x
     historyTable_->setItem(row, 1, new QTableWidgetItem(QString::number(record.frameCount)));
-    historyTable_->setItem(row, 2, new QTableWidgetItem(presetCombo_->currentText()));  // 使用当前预设文本
-    historyTable_->setItem(row, 3, new QTableWidgetItem(tuneCombo_->currentText()));    // 使用当前调优文本
+    historyTable_->setItem(row, 2, new QTableWidgetItem(presetCombo_->itemText(record.preset)));
+    historyTable_->setItem(row, 3, new QTableWidgetItem(tuneCombo_->itemText(record.tune)));
     historyTable_->setItem(row, 4, new QTableWidgetItem(QString::number(record.threads)));
-    historyTable_->setItem(row, 5, new QTableWidgetItem(record.rateControl));
+    historyTable_->setItem(row, 5, new QTableWidgetItem(rateControlCombo_->itemText(record.rateControl)));
     historyTable_->setItem(row, 6, new QTableWidgetItem(QString::number(record.rateValue)));
-    historyTable_->setItem(row, 7, new QTableWidgetItem(QString::number(record.keyintMax)));
+    historyTable_->setItem(row, 7, new QTableWidgetItem(QString::number(record.keyint)));
     historyTable_->setItem(row, 8, new QTableWidgetItem(QString::number(record.bframes)));
     historyTable_->setItem(row, 9, new QTableWidgetItem(QString::number(record.refs)));
     historyTable_->setItem(row, 10, new QTableWidgetItem(QString::number(record.encodingTime, 'f', 2)));
     historyTable_->setItem(row, 11, new QTableWidgetItem(QString::number(record.fps, 'f', 1)));
     historyTable_->setItem(row, 12, new QTableWidgetItem(QString::number(record.bitrate / 1000.0, 'f', 0)));
     historyTable_->setItem(row, 13, new QTableWidgetItem(QString("%1/%2").arg(record.psnr, 0, 'f', 2).arg(record.ssim, 0, 'f', 3)));
+    historyTable_->item(row, 0)->setToolTip(QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("yyyy-MM-dd hh:mm:ss"));
+}
+
+void X264ConfigWindow::updateHistorySummary()
+{
+    // 当前预设下的统计，走预设索引
+    HistoryStore::Filter filter;
+    filter.codec = static_cast<int>(HistoryStore::Codec::X264);
+    const size_t total = history_.aggregate(filter).count;
+    filter.preset = presetCombo_->currentIndex();
+    const HistoryStore::Aggregate current = history_.aggregate(filter);
+
+    historySummaryLabel_->setText(tr("共 %1 条记录；预设 %2: %3 条，平均 %4 fps，%5 kbps，PSNR %6")
+        .arg(total)
+        .arg(presetCombo_->currentText())
+        .arg(current.count)
+        .arg(current.meanFps, 0, 'f', 1)
+        .arg(current.meanBitrate / 1000.0, 0, 'f', 0)
+        .arg(current.meanPsnr, 0, 'f', 2));
 }
 
 void X264ConfigWindow::clearEncodingHistory()
 {
     if (QMessageBox::question(this, tr("确认"), tr("确定要清除所有历史记录吗？")) == QMessageBox::Yes) {
-        encodingHistory_.clear();
+        history_.erase(static_cast<int>(HistoryStore::Codec::X264));
         historyTable_->setRowCount(0);
+        updateHistorySummary();
     }
 }
 
@@ -821,16 +890,19 @@ void X264ConfigWindow::exportEncodingHistory()
     // 写入表头
     out << "分辨率,帧数,预设,调优,线程数,码率控制,码率/QP值,关键帧间隔,B帧数,参考帧数,编码时间(s),速度(fps),码率(kbps),PSNR,SSIM\n";
     
-    // 写入数据
-    for (const auto& record : encodingHistory_) {
+    // 写入数据，导出历史文件中全部的x264记录
+    HistoryStore::Filter filter;
+    filter.codec = static_cast<int>(HistoryStore::Codec::X264);
+    for (uint32_t index : history_.query(filter)) {
+        const HistoryStore::Record& record = history_.at(index);
         out << record.width << "×" << record.height << ","  // 使用×而不是x
             << record.frameCount << ","
-            << record.preset << ","
-            << record.tune << ","
+            << presetCombo_->itemText(record.preset) << ","
+            << tuneCombo_->itemText(record.tune) << ","
             << record.threads << ","
-            << record.rateControl << ","
+            << rateControlCombo_->itemText(record.rateControl) << ","
             << record.rateValue << ","
-            << record.keyintMax << ","
+            << record.keyint << ","
             << record.bframes << ","
             << record.refs << ","
             << QString::number(record.encodingTime, 'f', 2) << ","
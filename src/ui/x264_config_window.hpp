@@ -20,40 +20,10 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include "encode/history_store.hpp"
 #include "encode/x264_param_test.hpp"
 #include <thread>
 
-// 历史记录结构体
-struct EncodingRecord {
-    // 输入参数
-    int width;
-    int height;
-    int frameCount;
-    QString preset;
-    QString tune;
-    int threads;
-    QString rateControl;
-    int rateValue;
-    int keyintMax;      // 关键帧间隔
-    int bframes;        // B帧数量
-    int refs;          // 参考帧数
-    bool fastFirstPass; // 快速首遍编码
-    int meRange;       // 运动估计范围
-    bool weightedPred; // 加权预测
-    bool cabac;        // CABAC熵编码
-    
-    // 编码结果
-    double encodingTime;
-    double fps;
-    double bitrate;
-    double psnr;
-    double ssim;
-    QString outputFile;
-    
-    // 时间戳
-    QDateTime timestamp;
-};
-
 class X264ConfigWindow : public QMainWindow {
     Q_OBJECT
 
@@ -74,7 +44,10 @@ public Q_SLOTS:
     void appendLog(const QString& text);
     void onEncodingFinished();
     void onGenerateFrames();
-    void addEncodingRecord(const EncodingRecord& record);
+    void addEncodingRecord(const HistoryStore::Record& record);
+    void loadEncodingHistory();
+    void appendHistoryRow(const HistoryStore::Record& record);
+    void updateHistorySummary();
     void clearEncodingHistory();
     void exportEncodingHistory();
 
@@ -103,6 +76,8 @@ private:
     QSpinBox* meRangeSpinBox_{};
     QCheckBox* weightedPredCheckBox_{};
     QCheckBox* cabacCheckBox_{};
+    QCheckBox* zeroCopyCheckBox_{};
+    QComboBox* sourceCombo_{};
     QComboBox* sceneConfigCombo_{};
 
     // 编码控制控件
@@ -130,5 +105,6 @@ private:
     QTableWidget* historyTable_{};
     QPushButton* clearHistoryButton_{};
     QPushButton* exportHistoryButton_{};
-    std::vector<EncodingRecord> encodingHistory_;
+    QLabel* historySummaryLabel_{};
+    HistoryStore history_;  // 持久化的编码历史，与VP8窗口和命令行共用
 }; 
\ No newline at end of file
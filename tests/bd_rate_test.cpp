@@ -0,0 +1,140 @@
+// BdRate对已知答案的曲线的计算结果；RateQualityTable读取参数扫描CSV时参数列与指标列同名应取指标列
+#include "cli/result_writer.hpp"
+#include "encode/bd_rate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* message) {
+    if (!condition) {
+        std::cerr << "失败: " << message << std::endl;
+        ++failures;
+    }
+}
+
+bool near(double a, double b, double tolerance = 1e-9) {
+    return std::fabs(a - b) <= tolerance * std::max(1.0, std::fabs(b));
+}
+
+// 每倍码率提高slope dB的对数线性曲线，插值在log(码率)上是精确的
+std::vector<BdRate::Point> logLinearCurve(double rateScale, double qualityShift, double slope = 5.0) {
+    std::vector<BdRate::Point> points;
+    for (double kbps : {1000.0, 2000.0, 4000.0, 8000.0}) {
+        BdRate::Point point;
+        point.bitrate = kbps * rateScale;
+        point.quality = 30.0 + slope * std::log2(kbps / 1000.0) + qualityShift;
+        points.push_back(point);
+    }
+    return points;
+}
+
+// 相同质量下码率都乘以0.9：BD-rate为-10%，同码率下质量高5·log2(1/0.9) dB
+void testScaledBitrate() {
+    const auto result = BdRate::compare(logLinearCurve(1.0, 0.0), logLinearCurve(0.9, 0.0));
+    check(result.valid, "码率缩放的曲线可比较");
+    check(near(result.rate, -10.0, 1e-6), "码率缩放0.9时BD-rate为-10%");
+    check(near(result.quality, 5.0 * std::log2(1.0 / 0.9), 1e-6), "码率缩放0.9时BD-PSNR约0.760 dB");
+    check(near(result.bitrateLow, 1000.0, 1e-6) && near(result.bitrateHigh, 7200.0, 1e-6), "码率重叠区间");
+}
+
+// 质量整体提高0.5 dB、斜率5 dB/倍码率：相同质量所需码率为2^-0.1倍
+void testQualityShift() {
+    const auto result = BdRate::compare(logLinearCurve(1.0, 0.0), logLinearCurve(1.0, 0.5));
+    check(result.valid, "质量平移的曲线可比较");
+    check(near(result.rate, (std::pow(2.0, -0.1) - 1.0) * 100.0, 1e-6), "质量提高0.5 dB时BD-rate约-6.70%");
+    check(near(result.quality, 0.5, 1e-6), "质量提高0.5 dB时BD-PSNR为0.5 dB");
+    check(near(result.qualityLow, 30.5, 1e-6) && near(result.qualityHigh, 45.0, 1e-6), "质量重叠区间");
+}
+
+void testErrors() {
+    // 码率区间不重叠
+    auto result = BdRate::compare(logLinearCurve(1.0, 0.0), logLinearCurve(100.0, 0.0));
+    check(!result.valid && !result.error.empty(), "码率区间不重叠时报错");
+
+    // 码率区间重叠而质量区间不重叠
+    result = BdRate::compare(logLinearCurve(1.0, 0.0), logLinearCurve(1.0, 100.0));
+    check(!result.valid && !result.error.empty(), "质量区间不重叠时报错");
+
+    // 一个点，以及码率相同（合并为一个点）的两个点
+    std::vector<BdRate::Point> single = {{1000.0, 30.0}};
+    result = BdRate::compare(logLinearCurve(1.0, 0.0), single);
+    check(!result.valid && !result.error.empty(), "少于2个点时报错");
+    std::vector<BdRate::Point> sameRate = {{1000.0, 30.0}, {1000.0, 31.0}};
+    result = BdRate::compare(sameRate, logLinearCurve(1.0, 0.0));
+    check(!result.valid && !result.error.empty(), "码率相同的点合并后少于2个点时报错");
+
+    // 码率非正的点被忽略
+    std::vector<BdRate::Point> invalid = {{0.0, 30.0}, {-1.0, 35.0}, {2000.0, 35.0}};
+    result = BdRate::compare(logLinearCurve(1.0, 0.0), invalid);
+    check(!result.valid, "忽略码率非正的点后少于2个点时报错");
+}
+
+SweepRunner::Row makeRow(const char* bitrate, double measuredBitrate, double fps, double psnr) {
+    SweepRunner::Row row;
+    row.point.run = "vp8-vbr";
+    row.point.codec = "vp8";
+    row.point.params = {{"bitrate", bitrate}, {"fps", "30"}};
+    row.success = true;
+    row.outputFile = "out.webm";
+    row.metrics = {{"encoding_time", 1.0}, {"fps", fps}, {"bitrate", measuredBitrate},
+                   {"psnr", psnr}, {"ssim", 0.95}};
+    return row;
+}
+
+// 扫描结果写成CSV后读回，码率和速度应来自指标列而不是目标码率和配置帧率
+void testSweepCsvCollision() {
+    std::ostringstream csv;
+    ResultWriter::writeCsv(csv, {makeRow("1000000", 1100000.0, 120.0, 36.0),
+                                 makeRow("2000000", 2300000.0, 80.0, 39.0)});
+
+    RateQualityTable table;
+    std::string error;
+    check(table.parseCsv(csv.str(), &error), "解析扫描CSV");
+    check(table.rows().size() == 2, "扫描CSV行数");
+    if (table.rows().size() != 2) {
+        return;
+    }
+    check(near(table.rows()[0].bitrate, 1100.0), "码率取自指标列(kbps)");
+    check(near(table.rows()[1].bitrate, 2300.0), "第二行码率取自指标列");
+    check(near(table.rows()[0].secondsPerFrame, 1.0 / 120.0), "速度取自指标列");
+    check(near(table.secondsPerFrame(), (1.0 / 120.0 + 1.0 / 80.0) / 2), "平均每帧耗时");
+
+    // 目标码率参数仍可作为分组条件
+    const auto points = table.curve(RateQualityTable::Metric::PSNR, "bitrate", "2000000");
+    check(points.size() == 1 && near(points[0].bitrate, 2300.0) && near(points[0].quality, 39.0),
+          "按参数列分组选出曲线");
+}
+
+// 编码历史导出的CSV没有output_file列，按列名直接查找
+void testHistoryCsv() {
+    RateQualityTable table;
+    check(table.parseCsv("时间,码率(kbps),PSNR,SSIM,速度(fps)\n"
+                         "2024-01-01,1500,37.5,0.96,60\n"),
+          "解析历史CSV");
+    check(table.rows().size() == 1 && near(table.rows()[0].bitrate, 1500.0) &&
+          near(table.rows()[0].psnr, 37.5) && near(table.rows()[0].secondsPerFrame, 1.0 / 60.0),
+          "历史CSV的码率、PSNR和速度");
+}
+
+}  // namespace
+
+int main() {
+    testScaledBitrate();
+    testQualityShift();
+    testErrors();
+    testSweepCsvCollision();
+    testHistoryCsv();
+    if (failures > 0) {
+        std::cerr << failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "全部通过" << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+// 分片MP4输出重新打开后能完整解码：moov在第一个数据包之前写出，解码器配置必须来自编码器的extradata
+// 系统的FFmpeg没有libx264时跳过
+#include "encode/x264_param_test.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+constexpr int kSkip = 77;
+constexpr int kFrames = 30;
+
+int failures = 0;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "失败: " << message << std::endl;
+        ++failures;
+    }
+}
+
+X264ParamTest::TestConfig fragmentedConfig() {
+    X264ParamTest::TestConfig config;
+    config.width = 160;
+    config.height = 96;
+    config.frameCount = kFrames;
+    config.preset = X264ParamTest::Preset::UltraFast;
+    config.keyintMax = 10;
+    config.threads = 1;
+    config.measureQuality = false;
+    config.sink = OutputSink::Kind::Mux;
+    config.mp4Mode = OutputSink::Mp4Mode::Fragmented;
+    return config;
+}
+
+// 打开文件，检查视频流带有解码器配置，解码全部数据包，返回解出的帧数，失败时返回-1
+int decodeFrames(const std::string& path) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "无法打开: " << path << std::endl;
+        return -1;
+    }
+
+    int frames = -1;
+    AVCodecContext* codecCtx = nullptr;
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    const int streamIndex = avformat_find_stream_info(formatCtx, nullptr) >= 0
+        ? av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0)
+        : -1;
+    const AVCodecParameters* parameters = streamIndex >= 0 ? formatCtx->streams[streamIndex]->codecpar : nullptr;
+    const AVCodec* codec = parameters ? avcodec_find_decoder(parameters->codec_id) : nullptr;
+    if (!parameters || parameters->extradata_size <= 0) {
+        std::cerr << "视频流没有解码器配置: " << path << std::endl;
+    } else if (codec && packet && frame && (codecCtx = avcodec_alloc_context3(codec)) &&
+               avcodec_parameters_to_context(codecCtx, parameters) >= 0 &&
+               avcodec_open2(codecCtx, codec, nullptr) >= 0) {
+        frames = 0;
+        bool ok = true;
+        auto drain = [&]() {
+            while (avcodec_receive_frame(codecCtx, frame) >= 0) {
+                ++frames;
+            }
+        };
+        while (ok && av_read_frame(formatCtx, packet) >= 0) {
+            if (packet->stream_index == streamIndex) {
+                ok = avcodec_send_packet(codecCtx, packet) >= 0;
+                drain();
+            }
+            av_packet_unref(packet);
+        }
+        if (ok && avcodec_send_packet(codecCtx, nullptr) >= 0) {
+            drain();
+        } else {
+            std::cerr << "解码失败: " << path << std::endl;
+            frames = -1;
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return frames;
+}
+
+void testSingle() {
+    const auto result = X264ParamTest::runTest(fragmentedConfig());
+    check(result.success, "单实例编码分片MP4: " + result.errorMessage);
+    if (result.success) {
+        check(decodeFrames(result.outputFile) == kFrames, "单实例分片MP4应解出全部帧");
+        std::remove(result.outputFile.c_str());
+    }
+}
+
+// 各段编码器只收集数据包，拼接时写入的参数集同样需要在extradata中
+void testChunked() {
+    X264ParamTest::ChunkOptions options;
+    options.gopsPerChunk = 1;
+    options.coreBudget = 2;
+    options.compareSingle = false;
+    const auto result = X264ParamTest::runChunkedTest(fragmentedConfig(), options);
+    check(result.chunked.success, "分段编码分片MP4: " + result.chunked.errorMessage);
+    if (result.chunked.success) {
+        check(decodeFrames(result.chunked.outputFile) == kFrames, "分段拼接的分片MP4应解出全部帧");
+        std::remove(result.chunked.outputFile.c_str());
+    }
+}
+
+}  // namespace
+
+int main() {
+    if (!avcodec_find_encoder_by_name("libx264")) {
+        std::cout << "FFmpeg未启用libx264，跳过" << std::endl;
+        return kSkip;
+    }
+
+    testSingle();
+    testChunked();
+    if (failures > 0) {
+        std::cerr << failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "全部通过" << std::endl;
+    return 0;
+}